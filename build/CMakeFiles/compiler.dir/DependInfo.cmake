@@ -0,0 +1,65 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/ast/ast.cpp" "CMakeFiles/compiler.dir/src/ast/ast.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ast/ast.cpp.o.d"
+  "/root/repo/src/ast/ast_walker.cpp" "CMakeFiles/compiler.dir/src/ast/ast_walker.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ast/ast_walker.cpp.o.d"
+  "/root/repo/src/backend/ir_interpreter.cpp" "CMakeFiles/compiler.dir/src/backend/ir_interpreter.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/backend/ir_interpreter.cpp.o.d"
+  "/root/repo/src/backend/ir_module.cpp" "CMakeFiles/compiler.dir/src/backend/ir_module.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/backend/ir_module.cpp.o.d"
+  "/root/repo/src/backend/ir_parser.cpp" "CMakeFiles/compiler.dir/src/backend/ir_parser.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/backend/ir_parser.cpp.o.d"
+  "/root/repo/src/backend/linear_scan.cpp" "CMakeFiles/compiler.dir/src/backend/linear_scan.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/backend/linear_scan.cpp.o.d"
+  "/root/repo/src/backend/x86_64_backend.cpp" "CMakeFiles/compiler.dir/src/backend/x86_64_backend.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/backend/x86_64_backend.cpp.o.d"
+  "/root/repo/src/backend/x86_64_isel.cpp" "CMakeFiles/compiler.dir/src/backend/x86_64_isel.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/backend/x86_64_isel.cpp.o.d"
+  "/root/repo/src/compiler/compile_cache.cpp" "CMakeFiles/compiler.dir/src/compiler/compile_cache.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/compiler/compile_cache.cpp.o.d"
+  "/root/repo/src/compiler/compiler.cpp" "CMakeFiles/compiler.dir/src/compiler/compiler.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/compiler/compiler.cpp.o.d"
+  "/root/repo/src/compiler/incremental.cpp" "CMakeFiles/compiler.dir/src/compiler/incremental.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/compiler/incremental.cpp.o.d"
+  "/root/repo/src/error/error.cpp" "CMakeFiles/compiler.dir/src/error/error.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/error/error.cpp.o.d"
+  "/root/repo/src/ir/abi.cpp" "CMakeFiles/compiler.dir/src/ir/abi.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/abi.cpp.o.d"
+  "/root/repo/src/ir/block_counters.cpp" "CMakeFiles/compiler.dir/src/ir/block_counters.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/block_counters.cpp.o.d"
+  "/root/repo/src/ir/block_profile.cpp" "CMakeFiles/compiler.dir/src/ir/block_profile.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/block_profile.cpp.o.d"
+  "/root/repo/src/ir/call_graph.cpp" "CMakeFiles/compiler.dir/src/ir/call_graph.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/call_graph.cpp.o.d"
+  "/root/repo/src/ir/data_layout.cpp" "CMakeFiles/compiler.dir/src/ir/data_layout.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/data_layout.cpp.o.d"
+  "/root/repo/src/ir/effect_analysis.cpp" "CMakeFiles/compiler.dir/src/ir/effect_analysis.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/effect_analysis.cpp.o.d"
+  "/root/repo/src/ir/ir_emitter.cpp" "CMakeFiles/compiler.dir/src/ir/ir_emitter.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_emitter.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_abi.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_abi.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_abi.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_array_init.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_array_init.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_array_init.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_builtins.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_builtins.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_builtins.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_complex_exprs.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_complex_exprs.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_complex_exprs.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_control_flow.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_control_flow.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_control_flow.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_expressions.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_expressions.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_expressions.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_helpers.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_helpers.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_helpers.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_loop_opt.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_loop_opt.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_loop_opt.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_main.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_main.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_main.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_statements.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_statements.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_statements.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_units.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_units.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_units.cpp.o.d"
+  "/root/repo/src/ir/ir_generator_vectorize.cpp" "CMakeFiles/compiler.dir/src/ir/ir_generator_vectorize.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/ir_generator_vectorize.cpp.o.d"
+  "/root/repo/src/ir/static_storage.cpp" "CMakeFiles/compiler.dir/src/ir/static_storage.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/static_storage.cpp.o.d"
+  "/root/repo/src/ir/type_mapper.cpp" "CMakeFiles/compiler.dir/src/ir/type_mapper.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/type_mapper.cpp.o.d"
+  "/root/repo/src/ir/value_manager.cpp" "CMakeFiles/compiler.dir/src/ir/value_manager.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/ir/value_manager.cpp.o.d"
+  "/root/repo/src/lexer/lexer.cpp" "CMakeFiles/compiler.dir/src/lexer/lexer.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/lexer/lexer.cpp.o.d"
+  "/root/repo/src/parser/parser.cpp" "CMakeFiles/compiler.dir/src/parser/parser.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/parser/parser.cpp.o.d"
+  "/root/repo/src/pre_processor/pre_processor.cpp" "CMakeFiles/compiler.dir/src/pre_processor/pre_processor.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/pre_processor/pre_processor.cpp.o.d"
+  "/root/repo/src/semantic/const_evaluate.cpp" "CMakeFiles/compiler.dir/src/semantic/const_evaluate.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/semantic/const_evaluate.cpp.o.d"
+  "/root/repo/src/semantic/name_resolution.cpp" "CMakeFiles/compiler.dir/src/semantic/name_resolution.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/semantic/name_resolution.cpp.o.d"
+  "/root/repo/src/semantic/semantic.cpp" "CMakeFiles/compiler.dir/src/semantic/semantic.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/semantic/semantic.cpp.o.d"
+  "/root/repo/src/semantic/type_check.cpp" "CMakeFiles/compiler.dir/src/semantic/type_check.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/semantic/type_check.cpp.o.d"
+  "/root/repo/src/semantic/type_check_units.cpp" "CMakeFiles/compiler.dir/src/semantic/type_check_units.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/semantic/type_check_units.cpp.o.d"
+  "/root/repo/src/semantic/type_resolve.cpp" "CMakeFiles/compiler.dir/src/semantic/type_resolve.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/semantic/type_resolve.cpp.o.d"
+  "/root/repo/src/tool/fd_writer.cpp" "CMakeFiles/compiler.dir/src/tool/fd_writer.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/tool/fd_writer.cpp.o.d"
+  "/root/repo/src/tool/number.cpp" "CMakeFiles/compiler.dir/src/tool/number.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/tool/number.cpp.o.d"
+  "/root/repo/src/tool/sha256.cpp" "CMakeFiles/compiler.dir/src/tool/sha256.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/tool/sha256.cpp.o.d"
+  "/root/repo/src/tool/thread_pool.cpp" "CMakeFiles/compiler.dir/src/tool/thread_pool.cpp.o" "gcc" "CMakeFiles/compiler.dir/src/tool/thread_pool.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,103 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/compiler.dir/src/ast/ast.cpp.o"
+  "CMakeFiles/compiler.dir/src/ast/ast.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ast/ast_walker.cpp.o"
+  "CMakeFiles/compiler.dir/src/ast/ast_walker.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/backend/ir_interpreter.cpp.o"
+  "CMakeFiles/compiler.dir/src/backend/ir_interpreter.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/backend/ir_module.cpp.o"
+  "CMakeFiles/compiler.dir/src/backend/ir_module.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/backend/ir_parser.cpp.o"
+  "CMakeFiles/compiler.dir/src/backend/ir_parser.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/backend/linear_scan.cpp.o"
+  "CMakeFiles/compiler.dir/src/backend/linear_scan.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/backend/x86_64_backend.cpp.o"
+  "CMakeFiles/compiler.dir/src/backend/x86_64_backend.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/backend/x86_64_isel.cpp.o"
+  "CMakeFiles/compiler.dir/src/backend/x86_64_isel.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/compiler/compile_cache.cpp.o"
+  "CMakeFiles/compiler.dir/src/compiler/compile_cache.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/compiler/compiler.cpp.o"
+  "CMakeFiles/compiler.dir/src/compiler/compiler.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/compiler/incremental.cpp.o"
+  "CMakeFiles/compiler.dir/src/compiler/incremental.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/error/error.cpp.o"
+  "CMakeFiles/compiler.dir/src/error/error.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/abi.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/abi.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/block_counters.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/block_counters.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/block_profile.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/block_profile.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/call_graph.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/call_graph.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/data_layout.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/data_layout.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/effect_analysis.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/effect_analysis.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_emitter.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_emitter.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_abi.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_abi.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_array_init.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_array_init.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_builtins.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_builtins.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_complex_exprs.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_complex_exprs.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_control_flow.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_control_flow.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_expressions.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_expressions.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_helpers.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_helpers.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_loop_opt.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_loop_opt.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_main.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_main.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_statements.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_statements.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_units.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_units.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_vectorize.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/ir_generator_vectorize.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/static_storage.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/static_storage.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/type_mapper.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/type_mapper.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/ir/value_manager.cpp.o"
+  "CMakeFiles/compiler.dir/src/ir/value_manager.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/lexer/lexer.cpp.o"
+  "CMakeFiles/compiler.dir/src/lexer/lexer.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/parser/parser.cpp.o"
+  "CMakeFiles/compiler.dir/src/parser/parser.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/pre_processor/pre_processor.cpp.o"
+  "CMakeFiles/compiler.dir/src/pre_processor/pre_processor.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/semantic/const_evaluate.cpp.o"
+  "CMakeFiles/compiler.dir/src/semantic/const_evaluate.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/semantic/name_resolution.cpp.o"
+  "CMakeFiles/compiler.dir/src/semantic/name_resolution.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/semantic/semantic.cpp.o"
+  "CMakeFiles/compiler.dir/src/semantic/semantic.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/semantic/type_check.cpp.o"
+  "CMakeFiles/compiler.dir/src/semantic/type_check.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/semantic/type_check_units.cpp.o"
+  "CMakeFiles/compiler.dir/src/semantic/type_check_units.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/semantic/type_resolve.cpp.o"
+  "CMakeFiles/compiler.dir/src/semantic/type_resolve.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/tool/fd_writer.cpp.o"
+  "CMakeFiles/compiler.dir/src/tool/fd_writer.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/tool/number.cpp.o"
+  "CMakeFiles/compiler.dir/src/tool/number.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/tool/sha256.cpp.o"
+  "CMakeFiles/compiler.dir/src/tool/sha256.cpp.o.d"
+  "CMakeFiles/compiler.dir/src/tool/thread_pool.cpp.o"
+  "CMakeFiles/compiler.dir/src/tool/thread_pool.cpp.o.d"
+  "libcompiler.a"
+  "libcompiler.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/compiler.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
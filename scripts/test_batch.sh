@@ -0,0 +1,168 @@
+#!/bin/bash
+
+# 批量编译测试：--batch 写出的每个文件必须与单独编译该程序的输出逐字节相同，
+# 编译失败的程序不留输出文件，诊断与单独编译相同；多线程（--jobs）与单线程相同
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+COMPILER="${COMPILER:-$ROOT_DIR/build/code}"
+TEST_DIR="${1:-$ROOT_DIR/testcases/semantic/valid}"
+INVALID_DIR="$ROOT_DIR/testcases/semantic/invalid"
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# 颜色定义
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+TOTAL=0
+PASSED=0
+FAILED=0
+
+pass() {
+    echo -e "${GREEN}✅ PASS${NC}"
+    PASSED=$((PASSED + 1))
+}
+
+fail() {
+    echo -e "${RED}❌ FAIL${NC} ($1)"
+    FAILED=$((FAILED + 1))
+}
+
+# 去掉批量编译最后的吞吐量报告，只留诊断
+strip_report() {
+    grep -v -e '^batch: ' -e '^  .* programs/s, ' "$1"
+}
+
+# check_outputs <输出目录> <扩展名> [单独编译的选项...]
+# 每个程序的输出文件都要与单独编译的 stdout 相同
+check_outputs() {
+    local out_dir="$1"
+    local ext="$2"
+    shift 2
+    local test_file name
+    for test_file in "$TEST_DIR"/*.rs; do
+        name=$(basename "$test_file" .rs)
+        "$COMPILER" "$@" < "$test_file" > "$TMP_DIR/single.$ext" 2> /dev/null
+        if ! cmp -s "$TMP_DIR/single.$ext" "$out_dir/$name.$ext"; then
+            echo "$name.$ext 与单独编译的输出不同"
+            return 1
+        fi
+    done
+    return 0
+}
+
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}  批量编译测试 (--batch vs 单独编译)${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo ""
+
+# 目录输入，LLVM IR
+TOTAL=$((TOTAL + 1))
+echo -e "${BLUE}[测试 $TOTAL] --batch=<目录>${NC}"
+if ! "$COMPILER" --batch="$TEST_DIR" --out-dir="$TMP_DIR/dir" 2> "$TMP_DIR/dir.log"; then
+    fail "批量编译失败"
+    cat "$TMP_DIR/dir.log"
+elif check_outputs "$TMP_DIR/dir" ll; then
+    pass
+else
+    fail "输出不一致"
+fi
+
+# 清单输入，汇编；相对路径相对于清单所在目录
+TOTAL=$((TOTAL + 1))
+echo -e "${BLUE}[测试 $TOTAL] --batch=<清单> --emit=asm${NC}"
+mkdir -p "$TMP_DIR/manifest"
+cp "$TEST_DIR"/*.rs "$TMP_DIR/manifest/"
+{
+    echo "# 清单中的注释和空行被跳过"
+    echo ""
+    for test_file in "$TEST_DIR"/*.rs; do
+        basename "$test_file"
+    done
+} > "$TMP_DIR/manifest/programs.txt"
+if ! "$COMPILER" --batch="$TMP_DIR/manifest/programs.txt" --out-dir="$TMP_DIR/asm" --emit=asm \
+    2> "$TMP_DIR/asm.log"; then
+    fail "批量编译失败"
+    cat "$TMP_DIR/asm.log"
+elif check_outputs "$TMP_DIR/asm" s --emit=asm; then
+    pass
+else
+    fail "输出不一致"
+fi
+
+# 混有编译失败的程序：批量返回 1，失败的程序没有输出文件，诊断与单独编译相同
+TOTAL=$((TOTAL + 1))
+echo -e "${BLUE}[测试 $TOTAL] 编译失败的程序${NC}"
+mkdir -p "$TMP_DIR/mixed"
+cp "$TEST_DIR"/*.rs "$TMP_DIR/mixed/"
+: > "$TMP_DIR/expected.log"
+for test_file in "$INVALID_DIR"/*.rs; do
+    cp "$test_file" "$TMP_DIR/mixed/invalid_$(basename "$test_file")"
+done
+for test_file in "$TMP_DIR/mixed"/*.rs; do
+    if ! "$COMPILER" < "$test_file" > /dev/null 2> "$TMP_DIR/single.log"; then
+        cat "$TMP_DIR/single.log" >> "$TMP_DIR/expected.log"
+        echo "$test_file: compilation failed" >> "$TMP_DIR/expected.log"
+    fi
+done
+"$COMPILER" --batch="$TMP_DIR/mixed" --out-dir="$TMP_DIR/mixed_out" 2> "$TMP_DIR/mixed.log"
+rc=$?
+if [ "$rc" -ne 1 ]; then
+    fail "退出码 $rc，预期 1"
+elif ls "$TMP_DIR/mixed_out"/invalid_*.ll > /dev/null 2>&1; then
+    fail "编译失败的程序留下了输出文件"
+elif ! diff <(strip_report "$TMP_DIR/mixed.log") "$TMP_DIR/expected.log" > "$TMP_DIR/diff.log"; then
+    fail "诊断与单独编译不同"
+    head -20 "$TMP_DIR/diff.log"
+elif check_outputs "$TMP_DIR/mixed_out" ll; then
+    pass
+else
+    fail "输出不一致"
+fi
+
+# 多线程：输出文件和诊断（顺序也包括在内）与单线程相同
+for jobs in 4 0; do
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] --jobs=$jobs${NC}"
+    "$COMPILER" --batch="$TMP_DIR/mixed" --out-dir="$TMP_DIR/jobs$jobs" --jobs=$jobs \
+        2> "$TMP_DIR/jobs$jobs.log"
+    rc=$?
+    if [ "$rc" -ne 1 ]; then
+        fail "退出码 $rc，预期 1"
+    elif ! diff -r "$TMP_DIR/mixed_out" "$TMP_DIR/jobs$jobs" > "$TMP_DIR/diff.log"; then
+        fail "输出文件与 --jobs=1 不同"
+        head -20 "$TMP_DIR/diff.log"
+    elif ! diff <(strip_report "$TMP_DIR/mixed.log") <(strip_report "$TMP_DIR/jobs$jobs.log") \
+        > "$TMP_DIR/diff.log"; then
+        fail "诊断与 --jobs=1 不同"
+        head -20 "$TMP_DIR/diff.log"
+    else
+        pass
+    fi
+done
+
+# 扩展性基准自己检查各线程数的输出一致
+TOTAL=$((TOTAL + 1))
+echo -e "${BLUE}[测试 $TOTAL] --scaling --jobs=4${NC}"
+if "$COMPILER" --batch="$TEST_DIR" --scaling --jobs=4 > /dev/null 2> "$TMP_DIR/scaling.log"; then
+    pass
+else
+    fail "各线程数的输出不一致"
+    cat "$TMP_DIR/scaling.log"
+fi
+
+# 输出统计
+echo ""
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}           测试结果统计${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${GREEN}✅ 通过:${NC} $PASSED"
+echo -e "${RED}❌ 失败:${NC} $FAILED"
+echo -e "${BLUE}📊 总计:${NC} $TOTAL"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
@@ -0,0 +1,152 @@
+#!/bin/bash
+
+# 编译缓存测试：未命中和命中时的输出、诊断和退出码都必须与不加 --cache 时逐字节相同，
+# --cache-stats 的计数与实际的命中、未命中、存入和淘汰一致
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+COMPILER="${COMPILER:-$ROOT_DIR/build/code}"
+TEST_DIR="${1:-$ROOT_DIR/testcases/semantic/valid}"
+INVALID_DIR="$ROOT_DIR/testcases/semantic/invalid"
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# 颜色定义
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+TOTAL=0
+PASSED=0
+FAILED=0
+
+pass() {
+    echo -e "${GREEN}✅ PASS${NC}"
+    PASSED=$((PASSED + 1))
+}
+
+fail() {
+    echo -e "${RED}❌ FAIL${NC} ($1)"
+    FAILED=$((FAILED + 1))
+}
+
+# 生成输出远大于 64 KB 的程序，命中时要分多块拷贝
+generate_program() {
+    local count="$1"
+    for i in $(seq 1 "$count"); do
+        cat << EOF
+fn f$i(n: i32) -> i32 {
+    let mut s: i32 = n;
+    let mut k: i32 = 0;
+    while (k < $i) {
+        s = s + k * $i;
+        k += 1;
+    }
+    return s;
+}
+
+EOF
+    done
+    echo "fn main() {"
+    echo "    let mut total: i32 = 0;"
+    for i in $(seq 1 "$count"); do
+        echo "    total = (total + f$i($i)) % 1000007;"
+    done
+    echo "    printlnInt(total);"
+    echo "    exit(0);"
+    echo "}"
+}
+
+# compile_to <前缀> <输入文件> <选项...>：stdout、stderr、退出码分别写到 <前缀>.out/.err/.rc
+compile_to() {
+    local prefix="$1"
+    local input="$2"
+    shift 2
+    "$COMPILER" "$@" < "$input" > "$prefix.out" 2> "$prefix.err"
+    echo $? > "$prefix.rc"
+}
+
+# same <前缀1> <前缀2>
+same() {
+    cmp -s "$1.out" "$2.out" && cmp -s "$1.err" "$2.err" && cmp -s "$1.rc" "$2.rc"
+}
+
+# check_stats <缓存目录> <预期的 --cache-stats 开头>
+check_stats() {
+    local stats
+    stats=$("$COMPILER" --cache="$1" --cache-stats 2>&1)
+    if [[ "$stats" == "$2"* ]]; then
+        pass
+    else
+        fail "预期 \"$2...\"，实际 \"$stats\""
+    fi
+}
+
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}  编译缓存测试 (命中/未命中 vs 不加缓存)${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo ""
+
+generate_program 1000 > "$TMP_DIR/large.rs"
+CACHE="$TMP_DIR/cache"
+count=0
+
+# 能编译的和编译失败的程序都会存入缓存
+for test_file in "$TEST_DIR"/*.rs "$INVALID_DIR"/*.rs "$TMP_DIR/large.rs"; do
+    name=$(basename "$test_file" .rs)
+    for emit in llvm asm; do
+        TOTAL=$((TOTAL + 1))
+        echo -e "${BLUE}[测试 $TOTAL] $name --emit=$emit${NC}"
+        count=$((count + 1))
+        compile_to "$TMP_DIR/plain" "$test_file" --emit=$emit
+        compile_to "$TMP_DIR/miss" "$test_file" --emit=$emit --cache="$CACHE"
+        compile_to "$TMP_DIR/hit" "$test_file" --emit=$emit --cache="$CACHE"
+        if ! same "$TMP_DIR/plain" "$TMP_DIR/miss"; then
+            fail "未命中时与不加缓存不同"
+        elif ! same "$TMP_DIR/plain" "$TMP_DIR/hit"; then
+            fail "命中时与不加缓存不同"
+        else
+            pass
+        fi
+    done
+done
+
+# 内容相同的程序（如 if.rs 和 if2.rs）共用一个条目，第一次编译后一个就命中
+unique=$(md5sum "$TEST_DIR"/*.rs "$INVALID_DIR"/*.rs "$TMP_DIR/large.rs" | cut -d' ' -f1 | sort -u | wc -l)
+misses=$((unique * 2))
+hits=$((count * 2 - misses))
+rate=$(awk -v h=$hits -v m=$misses 'BEGIN { printf "%.1f", 100 * h / (h + m) }')
+TOTAL=$((TOTAL + 1))
+echo -e "${BLUE}[测试 $TOTAL] --cache-stats${NC}"
+check_stats "$CACHE" "cache: $hits hits, $misses misses ($rate% hit rate), $misses stores, 0 evictions; $misses entries,"
+
+# 上限为 0 时每个条目存入后立即被淘汰，下次仍未命中，输出不变
+TOTAL=$((TOTAL + 1))
+echo -e "${BLUE}[测试 $TOTAL] --cache-max-mb=0${NC}"
+test_file="$TMP_DIR/large.rs"
+compile_to "$TMP_DIR/plain" "$test_file"
+compile_to "$TMP_DIR/first" "$test_file" --cache="$TMP_DIR/small" --cache-max-mb=0
+compile_to "$TMP_DIR/second" "$test_file" --cache="$TMP_DIR/small" --cache-max-mb=0
+if same "$TMP_DIR/plain" "$TMP_DIR/first" && same "$TMP_DIR/plain" "$TMP_DIR/second"; then
+    pass
+else
+    fail "淘汰后的输出与不加缓存不同"
+fi
+
+TOTAL=$((TOTAL + 1))
+echo -e "${BLUE}[测试 $TOTAL] 淘汰计数${NC}"
+check_stats "$TMP_DIR/small" "cache: 0 hits, 2 misses (0.0% hit rate), 2 stores, 2 evictions; 0 entries, 0 bytes"
+
+# 输出统计
+echo ""
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}           测试结果统计${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${GREEN}✅ 通过:${NC} $PASSED"
+echo -e "${RED}❌ 失败:${NC} $FAILED"
+echo -e "${BLUE}📊 总计:${NC} $TOTAL"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
@@ -0,0 +1,71 @@
+#!/bin/bash
+
+# 诊断输出测试：诊断在报告时立即打印，后面的阶段崩溃也不会丢失
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+COMPILER="${COMPILER:-$ROOT_DIR/build/code}"
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# 颜色定义
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+TOTAL=0
+PASSED=0
+FAILED=0
+
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}  诊断输出测试${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo ""
+
+# check_stderr <名称> <输入文件> <预期 stderr>
+check_stderr() {
+    local name="$1"
+    local input="$2"
+    local expected="$3"
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] $name${NC}"
+    "$COMPILER" < "$input" > /dev/null 2> "$TMP_DIR/stderr"
+    local rc=$?
+    # 只比较诊断行，崩溃时 shell 打印的信息不在其中
+    if [ "$rc" -ne 0 ] && [ "$(grep -E '^(Error|Warning)' "$TMP_DIR/stderr")" == "$expected" ]; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASSED=$((PASSED + 1))
+    else
+        echo -e "${RED}❌ FAIL${NC} (退出码 $rc)"
+        echo "预期:"
+        echo "$expected"
+        echo "实际:"
+        cat "$TMP_DIR/stderr"
+        FAILED=$((FAILED + 1))
+    fi
+    echo ""
+}
+
+# block.rs 报告 4 个语法错误后在后面的阶段崩溃，这些错误必须已经打印
+check_stderr "parser/block.rs: 崩溃前的语法错误" "$ROOT_DIR/testcases/parser/block.rs" \
+"Error at line 2, column 6: Expected '(' after 'if'.
+Error at line 3, column 5: Expect ':' after field name.
+Error at line 3, column 12: Expect ',' after field value.
+Error at line 3, column 12: Expect field name or index in struct initializer."
+
+# 有词法错误时只报告词法错误，即使 Parser 先遇到了语法错误
+check_stderr "lexer/0.rs: 只报告词法错误" "$ROOT_DIR/testcases/lexer/0.rs" \
+"Error at line 1, column 6: Unrecognized character '@'"
+
+# 输出统计
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}           测试结果统计${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${GREEN}✅ 通过:${NC} $PASSED"
+echo -e "${RED}❌ 失败:${NC} $FAILED"
+echo -e "${BLUE}📊 总计:${NC} $TOTAL"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
@@ -0,0 +1,163 @@
+#!/bin/bash
+
+# 增量编译测试：每次编辑后用同一个 --incremental 目录重新编译，
+# 输出、诊断和退出码必须与不加 --incremental 的完整编译逐字节相同，
+# 并且只重新生成变了的函数
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+COMPILER="${COMPILER:-$ROOT_DIR/build/code}"
+TEST_DIR="${1:-$ROOT_DIR/testcases/semantic/valid}"
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# 颜色定义
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+TOTAL=0
+PASSED=0
+FAILED=0
+
+pass() {
+    echo -e "${GREEN}✅ PASS${NC}"
+    PASSED=$((PASSED + 1))
+}
+
+fail() {
+    echo -e "${RED}❌ FAIL${NC} ($1)"
+    FAILED=$((FAILED + 1))
+}
+
+# 生成有 N 个函数的程序
+generate_program() {
+    local count="$1"
+    echo "struct Point {"
+    echo "    x: i32,"
+    echo "    y: i32,"
+    echo "}"
+    for i in $(seq 1 "$count"); do
+        cat << EOF
+
+fn f$i(p: &Point, n: i32) -> i32 {
+    let mut s: i32 = n + p.x * $i;
+    let mut k: i32 = 0;
+    while (k < 8) {
+        s = s + k;
+        k += 1;
+    }
+    return s + p.y;
+}
+EOF
+    done
+    echo ""
+    echo "fn main() {"
+    echo "    let p: Point = Point { x: 1, y: 2 };"
+    echo "    let mut total: i32 = 0;"
+    for i in $(seq 1 "$count"); do
+        echo "    total = (total + f$i(&p, $i)) % 1000007;"
+    done
+    echo "    printlnInt(total);"
+    echo "    exit(0);"
+    echo "}"
+}
+
+# insert_after <文件> <第几个> <行>：在第 N 个以 { 结尾的 fn 行之后插入一行
+insert_after() {
+    awk -v target="$2" -v text="$3" '
+        { print }
+        /^[ \t]*fn .*\{[ \t]*$/ && ++seen == target { print text }' "$1"
+}
+
+# check_edit <名称> <源码文件>
+# 用增量目录 $INC 编译，与完整编译比较
+check_edit() {
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] $1${NC}"
+    "$COMPILER" < "$2" > "$TMP_DIR/full.out" 2> "$TMP_DIR/full.err"
+    local full_rc=$?
+    "$COMPILER" --incremental="$INC" < "$2" > "$TMP_DIR/inc.out" 2> "$TMP_DIR/inc.err"
+    local inc_rc=$?
+    if [ "$inc_rc" -ne "$full_rc" ]; then
+        fail "退出码 $inc_rc，完整编译为 $full_rc"
+    elif ! cmp -s "$TMP_DIR/full.out" "$TMP_DIR/inc.out"; then
+        fail "输出与完整编译不同"
+    elif ! cmp -s "$TMP_DIR/full.err" "$TMP_DIR/inc.err"; then
+        fail "诊断与完整编译不同"
+        diff "$TMP_DIR/full.err" "$TMP_DIR/inc.err" | head -10
+    else
+        pass
+    fi
+}
+
+# check_stats <名称> <源码文件> <预期的 --incremental-stats>
+# 编译一次并检查复用和生成的函数数，再与完整编译比较输出
+check_stats() {
+    local stats
+    stats=$("$COMPILER" --incremental="$INC" --incremental-stats < "$2" 2>&1 > "$TMP_DIR/inc.out")
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] $1${NC}"
+    if [ "$stats" != "$3" ]; then
+        fail "预期 \"$3\"，实际 \"$stats\""
+    elif ! "$COMPILER" < "$2" 2> /dev/null | cmp -s - "$TMP_DIR/inc.out"; then
+        fail "输出与完整编译不同"
+    else
+        pass
+    fi
+}
+
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}  增量编译测试 (编辑后 vs 完整编译)${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo ""
+
+# testcases 中的每个程序：依次编辑每个函数体，中间还有一次类型错误
+for test_file in "$TEST_DIR"/*.rs; do
+    name=$(basename "$test_file" .rs)
+    INC="$TMP_DIR/$name.inc"
+    check_edit "$name: 首次编译" "$test_file"
+    check_edit "$name: 未修改" "$test_file"
+    functions=$(grep -c '^[[:space:]]*fn .*{[[:space:]]*$' "$test_file")
+    for i in $(seq 1 "$functions"); do
+        insert_after "$test_file" "$i" "    let edited: i32 = $i;" > "$TMP_DIR/edited.rs"
+        check_edit "$name: 编辑第 $i 个函数" "$TMP_DIR/edited.rs"
+    done
+    insert_after "$test_file" 1 "    let edited: bool = 1;" > "$TMP_DIR/edited.rs"
+    check_edit "$name: 类型错误" "$TMP_DIR/edited.rs"
+    check_edit "$name: 改回原样" "$test_file"
+done
+
+# 生成的程序：检查重新生成的函数数
+INC="$TMP_DIR/functions.inc"
+generate_program 200 > "$TMP_DIR/functions.rs"
+check_stats "200 个函数: 首次编译" "$TMP_DIR/functions.rs" \
+    "incremental: 0 functions reused, 201 generated"
+check_stats "200 个函数: 未修改" "$TMP_DIR/functions.rs" \
+    "incremental: 201 functions reused, 0 generated"
+insert_after "$TMP_DIR/functions.rs" 5 "    let scale: i32 = 3;" > "$TMP_DIR/body.rs"
+check_stats "200 个函数: 编辑 f5 的函数体" "$TMP_DIR/body.rs" \
+    "incremental: 200 functions reused, 1 generated"
+(echo ""; echo ""; cat "$TMP_DIR/body.rs") > "$TMP_DIR/blank.rs"
+check_stats "200 个函数: 开头插入空行" "$TMP_DIR/blank.rs" \
+    "incremental: 201 functions reused, 0 generated"
+sed 's/^    y: i32,$/    y: i32,\n    z: i32,/; s/Point { x: 1, y: 2 }/Point { x: 1, y: 2, z: 3 }/' \
+    "$TMP_DIR/blank.rs" > "$TMP_DIR/struct.rs"
+check_stats "200 个函数: 结构体加字段" "$TMP_DIR/struct.rs" \
+    "incremental: 0 functions reused, 201 generated"
+insert_after "$TMP_DIR/struct.rs" 7 "    printInt(0);" > "$TMP_DIR/effect.rs"
+check_edit "200 个函数: f7 开始打印（调用点属性改变）" "$TMP_DIR/effect.rs"
+
+# 输出统计
+echo ""
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}           测试结果统计${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${GREEN}✅ 通过:${NC} $PASSED"
+echo -e "${RED}❌ 失败:${NC} $FAILED"
+echo -e "${BLUE}📊 总计:${NC} $TOTAL"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
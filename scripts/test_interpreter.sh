@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# IR 解释器测试：--run（以及 --run --counts）的输出和退出码
+# 必须与 lli 执行默认 LLVM IR 的结果一致
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+COMPILER="${COMPILER:-$ROOT_DIR/build/code}"
+TEST_DIR="${1:-$ROOT_DIR/testcases/semantic/valid}"
+# 超时的程序（如 loop.rs 的死循环）两边都以 124 退出
+TIME_LIMIT=5
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# 颜色定义
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+TOTAL=0
+PASSED=0
+FAILED=0
+
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}  IR 解释器测试 (--run vs lli)${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo ""
+
+for test_file in "$TEST_DIR"/*.rs; do
+    name=$(basename "$test_file" .rs)
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] $name${NC}"
+
+    if ! "$COMPILER" < "$test_file" > "$TMP_DIR/$name.ll" 2> "$TMP_DIR/$name.log"; then
+        echo -e "${RED}❌ FAIL${NC} (生成 LLVM IR 失败)"
+        cat "$TMP_DIR/$name.log"
+        FAILED=$((FAILED + 1))
+        continue
+    fi
+    timeout "$TIME_LIMIT" lli "$TMP_DIR/$name.ll" < /dev/null > "$TMP_DIR/$name.expected"
+    expected_rc=$?
+
+    timeout "$TIME_LIMIT" "$COMPILER" --run < "$test_file" > "$TMP_DIR/$name.run"
+    run_rc=$?
+    timeout "$TIME_LIMIT" "$COMPILER" --run --counts < "$test_file" \
+        > "$TMP_DIR/$name.counts" 2> "$TMP_DIR/$name.counts_log"
+    counts_rc=$?
+
+    reason=""
+    if [ "$run_rc" -ne "$expected_rc" ] || ! cmp -s "$TMP_DIR/$name.expected" "$TMP_DIR/$name.run"; then
+        reason="--run 与 lli 不一致 (退出码: lli $expected_rc, --run $run_rc)"
+        diff "$TMP_DIR/$name.expected" "$TMP_DIR/$name.run" | head -20
+    elif [ "$counts_rc" -ne "$expected_rc" ] || ! cmp -s "$TMP_DIR/$name.expected" "$TMP_DIR/$name.counts"; then
+        reason="--run --counts 改变了程序的输出 (退出码 $counts_rc)"
+        diff "$TMP_DIR/$name.expected" "$TMP_DIR/$name.counts" | head -20
+    elif [ "$counts_rc" -ne 124 ] && ! grep -q '^total instructions: [0-9]' "$TMP_DIR/$name.counts_log"; then
+        reason="--counts 没有打印指令统计"
+    fi
+
+    if [ -z "$reason" ]; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASSED=$((PASSED + 1))
+    else
+        echo -e "${RED}❌ FAIL${NC} ($reason)"
+        FAILED=$((FAILED + 1))
+    fi
+done
+
+# 输出统计
+echo ""
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}           测试结果统计${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${GREEN}✅ 通过:${NC} $PASSED"
+echo -e "${RED}❌ 失败:${NC} $FAILED"
+echo -e "${BLUE}📊 总计:${NC} $TOTAL"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
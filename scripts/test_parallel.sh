@@ -0,0 +1,154 @@
+#!/bin/bash
+
+# 并行编译测试：多线程类型检查函数体（--check-threads）、生成函数 IR（--ir-threads）时，
+# 输出、诊断和退出码必须与串行逐字节相同
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+COMPILER="${COMPILER:-$ROOT_DIR/build/code}"
+TEST_DIR="${1:-$ROOT_DIR/testcases/semantic/valid}"
+INVALID_DIR="$ROOT_DIR/testcases/semantic/invalid"
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# 颜色定义
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+TOTAL=0
+PASSED=0
+FAILED=0
+
+# 生成有 N 个函数的程序，让线程池里的单元多于线程
+generate_program() {
+    local count="$1"
+    echo "struct Point {"
+    echo "    x: i32,"
+    echo "    y: i32,"
+    echo "}"
+    for i in $(seq 1 "$count"); do
+        cat << EOF
+
+fn f$i(p: &Point, n: i32) -> i32 {
+    let mut a: [i32; 8] = [0; 8];
+    let mut k: usize = 0;
+    let mut s: i32 = n;
+    while (k < 8) {
+        a[k] = p.x * $i + k as i32;
+        s = s + a[k];
+        k += 1;
+    }
+    if (s % 2 == 0) {
+        s = s / 2;
+    } else {
+        s = s * 3 + p.y;
+    }
+    return s;
+}
+EOF
+    done
+    echo ""
+    echo "fn main() {"
+    echo "    let p: Point = Point { x: 1, y: 2 };"
+    echo "    let mut total: i32 = 0;"
+    for i in $(seq 1 "$count"); do
+        echo "    total = (total + f$i(&p, $i)) % 1000007;"
+    done
+    echo "    printlnInt(total);"
+    echo "    exit(0);"
+    echo "}"
+}
+
+# 每十个函数加一个类型错误，错误信息各不相同，诊断的顺序因此可以比较
+add_type_errors() {
+    awk '{ print }
+        /^fn f[0-9]*0\(/ {
+            match($0, /f[0-9]+/)
+            size = substr($0, RSTART + 1, RLENGTH - 1)
+            print "    let bad: [bool; " size "] = [n; " size "];"
+        }' "$1"
+}
+
+# check_same <输入文件> <并行选项...>
+# 与不带这些选项（串行）编译比较 stdout、stderr 和退出码
+check_same() {
+    local input="$1"
+    shift
+    local emit serial_rc parallel_rc
+    for emit in llvm asm; do
+        "$COMPILER" --emit=$emit < "$input" > "$TMP_DIR/serial.out" 2> "$TMP_DIR/serial.err"
+        serial_rc=$?
+        "$COMPILER" --emit=$emit "$@" < "$input" > "$TMP_DIR/parallel.out" 2> "$TMP_DIR/parallel.err"
+        parallel_rc=$?
+        if [ "$parallel_rc" -ne "$serial_rc" ]; then
+            echo "--emit=$emit $*: 退出码 $parallel_rc，串行为 $serial_rc"
+            return 1
+        fi
+        if ! cmp -s "$TMP_DIR/serial.out" "$TMP_DIR/parallel.out"; then
+            echo "--emit=$emit $*: 输出与串行不同"
+            return 1
+        fi
+        if ! cmp -s "$TMP_DIR/serial.err" "$TMP_DIR/parallel.err"; then
+            echo "--emit=$emit $*: 诊断与串行不同"
+            diff "$TMP_DIR/serial.err" "$TMP_DIR/parallel.err" | head -10
+            return 1
+        fi
+    done
+    return 0
+}
+
+# run_test <名称> <输入文件> <并行选项...>
+run_test() {
+    local name="$1"
+    shift
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] $name${NC}"
+    if check_same "$@"; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASSED=$((PASSED + 1))
+    else
+        echo -e "${RED}❌ FAIL${NC}"
+        FAILED=$((FAILED + 1))
+    fi
+}
+
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}  并行编译测试 (多线程 vs 串行)${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo ""
+
+generate_program 300 > "$TMP_DIR/functions.rs"
+
+add_type_errors "$TMP_DIR/functions.rs" > "$TMP_DIR/type_errors.rs"
+
+for threads in 4 0; do
+    for test_file in "$TEST_DIR"/*.rs; do
+        run_test "$(basename "$test_file" .rs) --ir-threads=$threads" "$test_file" \
+            --ir-threads=$threads
+    done
+    run_test "300 个函数 --ir-threads=$threads" "$TMP_DIR/functions.rs" --ir-threads=$threads
+
+    for test_file in "$TEST_DIR"/*.rs "$INVALID_DIR"/*.rs; do
+        run_test "$(basename "$test_file" .rs) --check-threads=$threads" "$test_file" \
+            --check-threads=$threads
+    done
+    run_test "300 个函数 --check-threads=$threads --ir-threads=$threads" \
+        "$TMP_DIR/functions.rs" --check-threads=$threads --ir-threads=$threads
+    run_test "30 个类型错误 --check-threads=$threads" "$TMP_DIR/type_errors.rs" \
+        --check-threads=$threads
+done
+
+# 输出统计
+echo ""
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}           测试结果统计${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${GREEN}✅ 通过:${NC} $PASSED"
+echo -e "${RED}❌ 失败:${NC} $FAILED"
+echo -e "${BLUE}📊 总计:${NC} $TOTAL"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
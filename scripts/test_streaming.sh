@@ -0,0 +1,143 @@
+#!/bin/bash
+
+# 流式输出测试：命令行驱动边生成边写出的 LLVM IR，无论写到文件还是管道，
+# 必须与一次生成整个模块（--batch 写出的文件）逐字节相同；写失败时返回 1
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+COMPILER="${COMPILER:-$ROOT_DIR/build/code}"
+TEST_DIR="${1:-$ROOT_DIR/testcases/semantic/valid}"
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# 颜色定义
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+TOTAL=0
+PASSED=0
+FAILED=0
+
+pass() {
+    echo -e "${GREEN}✅ PASS${NC}"
+    PASSED=$((PASSED + 1))
+}
+
+fail() {
+    echo -e "${RED}❌ FAIL${NC} ($1)"
+    FAILED=$((FAILED + 1))
+}
+
+# 生成有 N 个函数的程序，单元数远多于流式生成的窗口（每个线程 4 个单元）；
+# 常量数组在不同窗口的函数间共用同一个常量全局
+generate_program() {
+    local count="$1"
+    for i in $(seq 1 "$count"); do
+        cat << EOF
+fn f$i(n: i32) -> i32 {
+    let a: [i32; 4] = [$i, n, $i, n];
+    let table: [i32; 4] = [1, 2, 3, $((i % 7))];
+    return a[0] + a[1] * a[2] - a[3] + table[(n % 4) as usize];
+}
+
+EOF
+    done
+    echo "fn main() {"
+    echo "    let mut total: i32 = 0;"
+    for i in $(seq 1 "$count"); do
+        echo "    total = (total + f$i($i)) % 1000007;"
+    done
+    echo "    printlnInt(total);"
+    echo "    exit(0);"
+    echo "}"
+}
+
+# 生成只有一个大 main 的程序：它的 IR 是一整个大于 64 KB 的片段，不经缓冲直接写出
+generate_large_function() {
+    local count="$1"
+    echo "fn main() {"
+    echo "    let mut total: i32 = 0;"
+    for i in $(seq 1 "$count"); do
+        echo "    total = (total + $i * 3) % 1000007;"
+    done
+    echo "    printlnInt(total);"
+    echo "    exit(0);"
+    echo "}"
+}
+
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}  流式输出测试 (stdout vs 整个模块)${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo ""
+
+mkdir -p "$TMP_DIR/programs"
+cp "$TEST_DIR"/*.rs "$TMP_DIR/programs/"
+generate_program 300 > "$TMP_DIR/programs/generated_functions.rs"
+generate_large_function 3000 > "$TMP_DIR/programs/generated_large_function.rs"
+
+# --batch 不走 sink，写出的是一次生成的整个模块
+if ! "$COMPILER" --batch="$TMP_DIR/programs" --out-dir="$TMP_DIR/module" 2> "$TMP_DIR/batch.log"; then
+    echo -e "${RED}批量编译失败${NC}"
+    cat "$TMP_DIR/batch.log"
+    exit 1
+fi
+
+for test_file in "$TMP_DIR/programs"/*.rs; do
+    name=$(basename "$test_file" .rs)
+    for threads in 1 4; do
+        TOTAL=$((TOTAL + 1))
+        echo -e "${BLUE}[测试 $TOTAL] $name --ir-threads=$threads${NC}"
+        if ! "$COMPILER" --ir-threads=$threads < "$test_file" > "$TMP_DIR/stream.ll" 2> /dev/null; then
+            fail "编译失败"
+        elif ! cmp -s "$TMP_DIR/module/$name.ll" "$TMP_DIR/stream.ll"; then
+            fail "流式输出与整个模块不同"
+        else
+            pass
+        fi
+    done
+done
+
+# 写到管道时 write(2) 可能只写出一部分，剩下的要接着写
+for name in generated_functions generated_large_function; do
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] $name 写到管道${NC}"
+    "$COMPILER" < "$TMP_DIR/programs/$name.rs" 2> /dev/null | cat > "$TMP_DIR/pipe.ll"
+    if [ "${PIPESTATUS[0]}" -ne 0 ]; then
+        fail "编译失败"
+    elif ! cmp -s "$TMP_DIR/module/$name.ll" "$TMP_DIR/pipe.ll"; then
+        fail "经管道的输出与整个模块不同"
+    else
+        pass
+    fi
+done
+
+# 写失败时报错并返回 1
+if [ -w /dev/full ]; then
+    TOTAL=$((TOTAL + 1))
+    echo -e "${BLUE}[测试 $TOTAL] 写到 /dev/full${NC}"
+    "$COMPILER" < "$TMP_DIR/programs/generated_large_function.rs" > /dev/full 2> "$TMP_DIR/full.log"
+    rc=$?
+    if [ "$rc" -ne 1 ]; then
+        fail "退出码 $rc，预期 1"
+    elif ! grep -q "^Error: cannot write output$" "$TMP_DIR/full.log"; then
+        fail "没有报告写失败"
+        cat "$TMP_DIR/full.log"
+    else
+        pass
+    fi
+fi
+
+# 输出统计
+echo ""
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${BLUE}           测试结果统计${NC}"
+echo -e "${BLUE}=========================================${NC}"
+echo -e "${GREEN}✅ 通过:${NC} $PASSED"
+echo -e "${RED}❌ 失败:${NC} $FAILED"
+echo -e "${BLUE}📊 总计:${NC} $TOTAL"
+
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
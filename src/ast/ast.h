@@ -37,6 +37,9 @@ struct Stmt : public Node {
 
 struct Item : public Node {
     std::shared_ptr<Symbol> resolved_symbol;
+    // Tokens [token_begin, token_end) of the item in the parser's input
+    size_t token_begin = 0;
+    size_t token_end = 0;
     virtual void accept(ItemVisitor *visitor) = 0;
 };
 
@@ -409,6 +412,7 @@ struct FnDecl : public Item {
     std::vector<std::shared_ptr<FnParam>> params;
     std::optional<std::shared_ptr<TypeNode>> return_type;
     std::optional<std::shared_ptr<BlockStmt>> body;
+    size_t body_token_begin = 0; // Token of the body's '{' (token_end if there is no body)
 
     FnDecl(Token name, std::vector<std::shared_ptr<FnParam>> params,
            std::optional<std::shared_ptr<TypeNode>> return_type,
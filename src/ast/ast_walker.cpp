@@ -0,0 +1,135 @@
+#include "ast_walker.h"
+
+void AstWalker::walk(Expr *expr) {
+    if (!expr) {
+        return;
+    }
+    // ReturnExpr is not dispatched by Expr::accept
+    if (auto ret = dynamic_cast<ReturnExpr *>(expr)) {
+        walk(ret->return_stmt.get());
+        return;
+    }
+    expr->accept(this);
+}
+
+void AstWalker::walk(Stmt *stmt) {
+    if (stmt) {
+        stmt->accept(this);
+    }
+}
+
+void AstWalker::visit(ArrayLiteralExpr *node) {
+    for (auto &elem : node->elements) {
+        walk(elem.get());
+    }
+}
+
+void AstWalker::visit(ArrayInitializerExpr *node) {
+    walk(node->value.get());
+    walk(node->size.get());
+}
+
+void AstWalker::visit(UnaryExpr *node) { walk(node->right.get()); }
+
+void AstWalker::visit(BinaryExpr *node) {
+    walk(node->left.get());
+    walk(node->right.get());
+}
+
+void AstWalker::visit(CallExpr *node) {
+    walk(node->callee.get());
+    for (auto &arg : node->arguments) {
+        walk(arg.get());
+    }
+}
+
+void AstWalker::visit(IfExpr *node) {
+    walk(node->condition.get());
+    walk(node->then_branch.get());
+    if (node->else_branch.has_value()) {
+        walk(node->else_branch.value().get());
+    }
+}
+
+void AstWalker::visit(LoopExpr *node) { walk(node->body.get()); }
+
+void AstWalker::visit(WhileExpr *node) {
+    walk(node->condition.get());
+    walk(node->body.get());
+}
+
+void AstWalker::visit(IndexExpr *node) {
+    walk(node->object.get());
+    walk(node->index.get());
+}
+
+void AstWalker::visit(FieldAccessExpr *node) { walk(node->object.get()); }
+
+void AstWalker::visit(AssignmentExpr *node) {
+    walk(node->target.get());
+    walk(node->value.get());
+}
+
+void AstWalker::visit(CompoundAssignmentExpr *node) {
+    walk(node->target.get());
+    walk(node->value.get());
+}
+
+void AstWalker::visit(ReferenceExpr *node) { walk(node->expression.get()); }
+
+void AstWalker::visit(StructInitializerExpr *node) {
+    for (auto &field : node->fields) {
+        walk(field->value.get());
+    }
+}
+
+void AstWalker::visit(GroupingExpr *node) { walk(node->expression.get()); }
+
+void AstWalker::visit(TupleExpr *node) {
+    for (auto &elem : node->elements) {
+        walk(elem.get());
+    }
+}
+
+void AstWalker::visit(AsExpr *node) { walk(node->expression.get()); }
+
+void AstWalker::visit(MatchExpr *node) {
+    walk(node->scrutinee.get());
+    for (auto &arm : node->arms) {
+        if (arm->guard.has_value()) {
+            walk(arm->guard.value().get());
+        }
+        walk(arm->body.get());
+    }
+}
+
+void AstWalker::visit(BlockExpr *node) { walk(node->block_stmt.get()); }
+
+void AstWalker::visit(BlockStmt *node) {
+    for (auto &stmt : node->statements) {
+        walk(stmt.get());
+    }
+    if (node->final_expr.has_value()) {
+        walk(node->final_expr.value().get());
+    }
+}
+
+void AstWalker::visit(ExprStmt *node) { walk(node->expression.get()); }
+
+void AstWalker::visit(LetStmt *node) {
+    if (node->initializer.has_value()) {
+        walk(node->initializer.value().get());
+    }
+}
+
+void AstWalker::visit(ReturnStmt *node) {
+    if (node->value.has_value()) {
+        walk(node->value.value().get());
+    }
+}
+
+void AstWalker::visit(BreakStmt *node) {
+    if (node->value.has_value()) {
+        walk(node->value.value().get());
+    }
+}
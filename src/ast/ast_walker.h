@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ast.h"
+#include "visit.h"
+
+/**
+ * AstWalker - Recursive AST traversal with no-op actions
+ *
+ * Visits every expression and statement below the starting node in source
+ * order. Analyses override only the visit methods they care about and call
+ * the base implementation to keep descending.
+ *
+ * Items nested in function bodies (ItemStmt) are not entered: a nested fn
+ * is a separate function and is analysed on its own.
+ */
+class AstWalker : public ExprVisitor<void>, public StmtVisitor {
+  public:
+    virtual void walk(Expr *expr);
+    virtual void walk(Stmt *stmt);
+
+    void visit(LiteralExpr *node) override {}
+    void visit(ArrayLiteralExpr *node) override;
+    void visit(ArrayInitializerExpr *node) override;
+    void visit(VariableExpr *node) override {}
+    void visit(UnaryExpr *node) override;
+    void visit(BinaryExpr *node) override;
+    void visit(CallExpr *node) override;
+    void visit(IfExpr *node) override;
+    void visit(LoopExpr *node) override;
+    void visit(WhileExpr *node) override;
+    void visit(IndexExpr *node) override;
+    void visit(FieldAccessExpr *node) override;
+    void visit(AssignmentExpr *node) override;
+    void visit(CompoundAssignmentExpr *node) override;
+    void visit(ReferenceExpr *node) override;
+    void visit(UnderscoreExpr *node) override {}
+    void visit(StructInitializerExpr *node) override;
+    void visit(UnitExpr *node) override {}
+    void visit(GroupingExpr *node) override;
+    void visit(TupleExpr *node) override;
+    void visit(AsExpr *node) override;
+    void visit(MatchExpr *node) override;
+    void visit(PathExpr *node) override {}
+    void visit(BlockExpr *node) override;
+
+    void visit(BlockStmt *node) override;
+    void visit(ExprStmt *node) override;
+    void visit(LetStmt *node) override;
+    void visit(ReturnStmt *node) override;
+    void visit(BreakStmt *node) override;
+    void visit(ContinueStmt *node) override {}
+    void visit(ItemStmt *node) override {}
+};
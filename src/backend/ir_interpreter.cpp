@@ -0,0 +1,1042 @@
+#include "ir_interpreter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+uint64_t align_up(uint64_t value, uint64_t align) { return (value + align - 1) / align * align; }
+
+uint64_t mask(uint64_t value, unsigned bits) {
+    return bits >= 64 ? value : value & ((uint64_t(1) << bits) - 1);
+}
+
+int64_t sign_extend(uint64_t value, unsigned bits) {
+    if (bits >= 64) {
+        return static_cast<int64_t>(value);
+    }
+    uint64_t sign = uint64_t(1) << (bits - 1);
+    return static_cast<int64_t>((mask(value, bits) ^ sign) - sign);
+}
+
+unsigned scalar_bits(const IRType *type) { return type->is_int() ? type->bits : 64; }
+
+std::string opcode_name(const IRInstruction &instr) {
+    switch (instr.opcode) {
+    case IROpcode::ALLOCA:
+        return "alloca";
+    case IROpcode::LOAD:
+        return "load";
+    case IROpcode::STORE:
+        return "store";
+    case IROpcode::BINARY:
+    case IROpcode::CAST:
+        return instr.op;
+    case IROpcode::ICMP:
+        return "icmp";
+    case IROpcode::GEP:
+        return "getelementptr";
+    case IROpcode::PHI:
+        return "phi";
+    case IROpcode::CALL:
+        return "call";
+    case IROpcode::SELECT:
+        return "select";
+    case IROpcode::INSERT_VALUE:
+        return "insertvalue";
+    case IROpcode::EXTRACT_VALUE:
+        return "extractvalue";
+    case IROpcode::INSERT_ELEMENT:
+        return "insertelement";
+    case IROpcode::SHUFFLE_VECTOR:
+        return "shufflevector";
+    case IROpcode::RET:
+        return "ret";
+    case IROpcode::BR:
+    case IROpcode::COND_BR:
+        return "br";
+    case IROpcode::UNREACHABLE:
+        return "unreachable";
+    }
+    return "?";
+}
+
+void print_table(std::ostream &out, const std::string &title,
+                 const std::map<std::string, uint64_t> &counts, uint64_t total) {
+    std::vector<std::pair<std::string, uint64_t>> rows(counts.begin(), counts.end());
+    std::stable_sort(rows.begin(), rows.end(),
+                     [](const auto &a, const auto &b) { return a.second > b.second; });
+    out << std::left << std::setw(24) << title << std::right << std::setw(14) << "count"
+        << std::setw(9) << "%" << "\n";
+    for (const auto &[name, count] : rows) {
+        double percent = total ? 100.0 * static_cast<double>(count) / static_cast<double>(total)
+                               : 0.0;
+        out << "  " << std::left << std::setw(22) << name << std::right << std::setw(14) << count
+            << std::setw(8) << std::fixed << std::setprecision(1) << percent << "%\n";
+    }
+}
+
+} // namespace
+
+void InstructionCounts::print(std::ostream &out) const {
+    out << "total instructions: " << total << "\n";
+    print_table(out, "opcode", by_opcode, total);
+    print_table(out, "function", by_function, total);
+}
+
+// ---------------------------------------------------------------------------
+// Decoding
+// ---------------------------------------------------------------------------
+
+bool IRInterpreter::run(std::istream &input, std::ostream &output, int &exit_code) {
+    try {
+        load_module();
+    } catch (const Unsupported &error) {
+        error_reporter_.report_error("IR interpreter: " + error.message);
+        return false;
+    }
+
+    bool ok = true;
+    try {
+        execute(input, output, exit_code);
+    } catch (const Trap &error) {
+        error_reporter_.report_error("IR interpreter: " + error.message);
+        ok = false;
+    }
+    output.flush();
+    collect_counts();
+    return ok;
+}
+
+void IRInterpreter::load_module() {
+    functions_.clear();
+    global_addresses_.clear();
+    counter_ids_.clear();
+    counter_names_.clear();
+    memory_.assign(NULL_PAGE, 0);
+    files_.clear();
+    main_function_ = -1;
+
+    for (const auto &global : module_.globals) {
+        global_addresses_[global.name] = add_constant(global.data, global.align);
+    }
+
+    phi_counter_ = counter("phi");
+    functions_.resize(module_.functions.size());
+    for (size_t i = 0; i < module_.functions.size(); ++i) {
+        const IRFunction &source = module_.functions[i];
+        functions_[i].source = &source;
+        if (source.name == "main" && !source.is_declaration) {
+            main_function_ = static_cast<int>(i);
+        }
+    }
+    for (auto &function : functions_) {
+        if (!function.source->is_declaration) {
+            decode_function(*function.source, function);
+        }
+    }
+    if (main_function_ < 0) {
+        throw Unsupported{"module has no @main"};
+    }
+
+    stack_base_ = align_up(memory_.size(), 16);
+    memory_.resize(stack_base_);
+}
+
+uint64_t IRInterpreter::add_constant(const std::vector<uint8_t> &bytes, size_t align) {
+    uint64_t addr = align_up(memory_.size(), std::max<size_t>(align, 1));
+    memory_.resize(addr + bytes.size());
+    std::copy(bytes.begin(), bytes.end(), memory_.begin() + static_cast<ptrdiff_t>(addr));
+    return addr;
+}
+
+int IRInterpreter::counter(const std::string &name) {
+    auto [it, inserted] = counter_ids_.emplace(name, static_cast<int>(counter_names_.size()));
+    if (inserted) {
+        counter_names_.push_back(name);
+    }
+    return it->second;
+}
+
+void IRInterpreter::unsupported(const IRInstruction &instr, const std::string &what) {
+    throw Unsupported{"unsupported " + what + " at IR line " + std::to_string(instr.line)};
+}
+
+void IRInterpreter::decode_function(const IRFunction &source, Function &function) {
+    // Registers: parameters first, then every result in textual order
+    std::map<std::string, int> locals;
+    auto add_register = [&](const std::string &name, const IRType *type) {
+        int reg = function.registers++;
+        locals[name] = reg;
+        if (type && (type->is_aggregate() || type->is_vector())) {
+            function.frame_bytes = align_up(function.frame_bytes, type->align);
+            function.aggregates.push_back({reg, function.frame_bytes});
+            function.frame_bytes += type->size;
+        }
+        return reg;
+    };
+    for (const auto &param : source.params) {
+        int reg = add_register(param.name, param.type);
+        bool by_value = param.type->is_aggregate() || param.type->is_vector();
+        function.params.push_back({reg, by_value ? param.type->size : 0});
+    }
+    for (const auto &block : source.blocks) {
+        for (const auto &instr : block.instructions) {
+            if (!instr.result.empty()) {
+                // An alloca yields a pointer, its type is the allocated one
+                add_register(instr.result,
+                             instr.opcode == IROpcode::ALLOCA ? nullptr : instr.type);
+            }
+        }
+    }
+
+    function.blocks.resize(source.blocks.size());
+    for (size_t b = 0; b < source.blocks.size(); ++b) {
+        Block &block = function.blocks[b];
+        for (const auto &instr : source.blocks[b].instructions) {
+            if (instr.opcode == IROpcode::PHI) {
+                Phi phi;
+                phi.result = locals.at(instr.result);
+                phi.size = instr.type->is_scalar() ? 0 : instr.type->size;
+                for (size_t k = 0; k < instr.operands.size(); ++k) {
+                    phi.incoming.push_back({source.block_index(instr.labels[k]),
+                                            decode_value(instr.operands[k], locals)});
+                }
+                block.phis.push_back(std::move(phi));
+                continue;
+            }
+            block.instrs.emplace_back();
+            decode_instruction(instr, source, locals, block.instrs.back());
+        }
+    }
+}
+
+IRInterpreter::Arg IRInterpreter::decode_value(const IRValue &value,
+                                               const std::map<std::string, int> &locals) {
+    Arg arg;
+    switch (value.kind) {
+    case IRValue::Kind::LOCAL: {
+        auto it = locals.find(value.name);
+        if (it == locals.end()) {
+            throw Unsupported{"use of undefined value %" + value.name};
+        }
+        arg.is_reg = true;
+        arg.value = static_cast<uint64_t>(it->second);
+        break;
+    }
+    case IRValue::Kind::GLOBAL: {
+        auto it = global_addresses_.find(value.name);
+        if (it == global_addresses_.end()) {
+            throw Unsupported{"address of @" + value.name + " is not supported"};
+        }
+        arg.value = it->second;
+        break;
+    }
+    case IRValue::Kind::INT:
+        arg.value = mask(static_cast<uint64_t>(value.value), scalar_bits(value.type));
+        break;
+    case IRValue::Kind::UNDEF:
+    case IRValue::Kind::ZERO:
+        if (!value.type->is_scalar()) {
+            arg.value = add_constant(std::vector<uint8_t>(value.type->size, 0), value.type->align);
+        }
+        break;
+    case IRValue::Kind::VECTOR: {
+        std::vector<uint8_t> bytes(value.type->size, 0);
+        size_t lane_size = value.type->element->size;
+        for (size_t i = 0; i < value.elements.size(); ++i) {
+            uint64_t lane = static_cast<uint64_t>(value.elements[i].value);
+            std::memcpy(bytes.data() + i * lane_size, &lane, lane_size);
+        }
+        arg.value = add_constant(bytes, value.type->align);
+        break;
+    }
+    }
+    return arg;
+}
+
+void IRInterpreter::decode_instruction(const IRInstruction &source, const IRFunction &function,
+                                       const std::map<std::string, int> &locals, Instr &instr) {
+    instr.line = source.line;
+    instr.counter = counter(opcode_name(source));
+    instr.result = source.result.empty() ? -1 : locals.at(source.result);
+    for (const auto &operand : source.operands) {
+        if (source.opcode != IROpcode::GEP) {
+            instr.args.push_back(decode_value(operand, locals));
+        }
+    }
+    const IRType *type = source.type;
+
+    switch (source.opcode) {
+    case IROpcode::ALLOCA:
+        instr.op = Op::ALLOCA;
+        instr.size = type->size;
+        instr.offset = static_cast<int64_t>(type->align);
+        break;
+    case IROpcode::LOAD:
+        instr.op = type->is_scalar() ? Op::LOAD : Op::LOAD_AGGREGATE;
+        instr.size = type->size;
+        instr.bits = type->is_scalar() ? scalar_bits(type) : 0;
+        break;
+    case IROpcode::STORE: {
+        const IRType *value_type = source.operands[0].type;
+        instr.op = value_type->is_scalar() ? Op::STORE : Op::STORE_AGGREGATE;
+        instr.size = value_type->size;
+        break;
+    }
+    case IROpcode::BINARY: {
+        static const std::map<std::string, Op> ops = {
+            {"add", Op::ADD},   {"sub", Op::SUB},   {"mul", Op::MUL},   {"sdiv", Op::SDIV},
+            {"udiv", Op::UDIV}, {"srem", Op::SREM}, {"urem", Op::UREM}, {"shl", Op::SHL},
+            {"lshr", Op::LSHR}, {"ashr", Op::ASHR}, {"and", Op::AND},   {"or", Op::OR},
+            {"xor", Op::XOR}};
+        auto it = ops.find(source.op);
+        if (it == ops.end()) {
+            unsupported(source, "operator '" + source.op + "'");
+        }
+        if (type->is_vector()) {
+            instr.op = Op::VECTOR_BINARY;
+            instr.from = static_cast<unsigned>(it->second);
+            instr.bits = scalar_bits(type->element);
+            instr.size = type->size;
+            instr.element_size = type->element->size;
+        } else {
+            instr.op = it->second;
+            instr.bits = scalar_bits(type);
+        }
+        break;
+    }
+    case IROpcode::ICMP: {
+        static const std::map<std::string, Predicate> predicates = {
+            {"eq", Predicate::EQ},   {"ne", Predicate::NE},   {"slt", Predicate::SLT},
+            {"sle", Predicate::SLE}, {"sgt", Predicate::SGT}, {"sge", Predicate::SGE},
+            {"ult", Predicate::ULT}, {"ule", Predicate::ULE}, {"ugt", Predicate::UGT},
+            {"uge", Predicate::UGE}};
+        auto it = predicates.find(source.op);
+        if (it == predicates.end() || !source.operands[0].type->is_scalar()) {
+            unsupported(source, "icmp");
+        }
+        instr.op = Op::ICMP;
+        instr.predicate = it->second;
+        instr.bits = scalar_bits(source.operands[0].type);
+        break;
+    }
+    case IROpcode::CAST:
+        if (!type->is_scalar()) {
+            unsupported(source, "cast of a non-scalar");
+        }
+        instr.bits = scalar_bits(type);
+        instr.from = scalar_bits(source.operands[0].type);
+        if (source.op == "zext") {
+            instr.op = Op::ZEXT;
+        } else if (source.op == "bitcast") {
+            instr.op = Op::COPY;
+        } else if (source.op == "sext") {
+            instr.op = Op::SEXT;
+        } else if (source.op == "trunc") {
+            instr.op = Op::TRUNC;
+        } else {
+            unsupported(source, "cast '" + source.op + "'");
+        }
+        break;
+    case IROpcode::GEP: {
+        instr.op = Op::GEP;
+        instr.args.push_back(decode_value(source.operands[0], locals));
+        const IRType *current = source.source_type;
+        for (size_t k = 1; k < source.operands.size(); ++k) {
+            const IRValue &index = source.operands[k];
+            int64_t stride;
+            if (k == 1) {
+                stride = static_cast<int64_t>(current->size);
+            } else if (current->kind == IRType::Kind::STRUCT) {
+                size_t field = static_cast<size_t>(index.value);
+                instr.offset += static_cast<int64_t>(current->element_offset(field));
+                current = current->element_type(field);
+                continue;
+            } else {
+                current = current->element;
+                stride = static_cast<int64_t>(current->size);
+            }
+            if (index.kind == IRValue::Kind::INT) {
+                instr.offset += index.value * stride;
+            } else {
+                instr.terms.push_back(
+                    {decode_value(index, locals), scalar_bits(index.type), stride});
+            }
+        }
+        break;
+    }
+    case IROpcode::CALL: {
+        const std::string &callee = source.op;
+        if (callee == "printf") {
+            instr.op = Op::PRINTF;
+        } else if (callee == "scanf") {
+            instr.op = Op::SCANF;
+        } else if (callee == "fopen") {
+            instr.op = Op::FOPEN;
+        } else if (callee == "fprintf") {
+            instr.op = Op::FPRINTF;
+        } else if (callee == "fclose") {
+            instr.op = Op::FCLOSE;
+        } else if (callee == "exit") {
+            instr.op = Op::EXIT;
+        } else if (callee.rfind("llvm.memcpy.", 0) == 0) {
+            instr.op = Op::MEMCPY;
+        } else if (callee.rfind("llvm.memset.", 0) == 0) {
+            instr.op = Op::MEMSET;
+        } else if (callee.rfind("llvm.lifetime.", 0) == 0) {
+            instr.op = Op::NOP;
+        } else {
+            const IRFunction *target = module_.find_function(callee);
+            if (!target || target->is_declaration) {
+                unsupported(source, "call to external function @" + callee);
+            }
+            instr.op = Op::CALL;
+            instr.target = static_cast<int>(target - module_.functions.data());
+            instr.size = type->is_scalar() || type->is_void() ? 0 : type->size;
+        }
+        break;
+    }
+    case IROpcode::SELECT:
+        instr.op = type->is_scalar() ? Op::SELECT : Op::SELECT_AGGREGATE;
+        instr.size = type->size;
+        break;
+    case IROpcode::INSERT_VALUE:
+    case IROpcode::EXTRACT_VALUE: {
+        const IRType *current = source.operands[0].type;
+        for (int64_t index : source.indices) {
+            instr.offset += static_cast<int64_t>(current->element_offset(index));
+            current = current->element_type(index);
+        }
+        instr.size = source.operands[0].type->size;
+        instr.element_size = current->size;
+        instr.bits = current->is_scalar() ? scalar_bits(current) : 0;
+        if (source.opcode == IROpcode::INSERT_VALUE) {
+            instr.op = Op::INSERT_VALUE;
+            instr.indirect = !current->is_scalar();
+        } else {
+            instr.op = current->is_scalar() ? Op::EXTRACT_VALUE : Op::EXTRACT_AGGREGATE;
+        }
+        break;
+    }
+    case IROpcode::INSERT_ELEMENT:
+        instr.op = Op::INSERT_ELEMENT;
+        instr.size = type->size;
+        instr.element_size = type->element->size;
+        break;
+    case IROpcode::SHUFFLE_VECTOR:
+        instr.op = Op::SHUFFLE_VECTOR;
+        instr.size = type->size;
+        instr.element_size = type->element->size;
+        instr.offset = static_cast<int64_t>(source.operands[0].type->count);
+        instr.lanes = source.indices;
+        break;
+    case IROpcode::RET:
+        instr.op = source.operands.empty() || source.operands[0].type->is_scalar()
+                       ? Op::RET
+                       : Op::RET_AGGREGATE;
+        instr.size = source.operands.empty() ? 0 : source.operands[0].type->size;
+        break;
+    case IROpcode::BR:
+        instr.op = Op::BR;
+        instr.target = function.block_index(source.labels[0]);
+        break;
+    case IROpcode::COND_BR:
+        instr.op = Op::COND_BR;
+        instr.target = function.block_index(source.labels[0]);
+        instr.other = function.block_index(source.labels[1]);
+        break;
+    case IROpcode::UNREACHABLE:
+        instr.op = Op::UNREACHABLE;
+        break;
+    case IROpcode::PHI:
+        unsupported(source, "phi after the start of a block");
+    }
+    if ((instr.op == Op::BR || instr.op == Op::COND_BR) &&
+        (instr.target < 0 || (instr.op == Op::COND_BR && instr.other < 0))) {
+        unsupported(source, "branch to an unknown label");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Execution
+// ---------------------------------------------------------------------------
+
+void IRInterpreter::execute(std::istream &input, std::ostream &output, int &exit_code) {
+    opcode_counts_.assign(counter_names_.size(), 0);
+    function_counts_.assign(functions_.size(), 0);
+    registers_.clear();
+    frames_.clear();
+    stack_pointer_ = stack_base_;
+
+    std::vector<uint64_t> no_args(functions_[main_function_].params.size(), 0);
+    enter(main_function_, no_args, -1, nullptr);
+
+    while (!frames_.empty()) {
+        Frame &frame = frames_.back();
+        const Instr &instr = functions_[frame.function].blocks[frame.block].instrs[frame.ip++];
+        ++opcode_counts_[instr.counter];
+        ++function_counts_[frame.function];
+        uint64_t *regs = registers_.data() + frame.base;
+        auto value = [regs](const Arg &arg) { return arg.is_reg ? regs[arg.value] : arg.value; };
+
+        switch (instr.op) {
+        case Op::ALLOCA:
+            regs[instr.result] =
+                allocate_stack(instr.size, static_cast<uint64_t>(instr.offset));
+            break;
+        case Op::LOAD:
+            regs[instr.result] = mask(load(value(instr.args[0]), instr.size, instr), instr.bits);
+            break;
+        case Op::LOAD_AGGREGATE:
+            copy(regs[instr.result], value(instr.args[0]), instr.size, instr);
+            break;
+        case Op::STORE:
+            store(value(instr.args[1]), value(instr.args[0]), instr.size, instr);
+            break;
+        case Op::STORE_AGGREGATE:
+            copy(value(instr.args[1]), value(instr.args[0]), instr.size, instr);
+            break;
+        case Op::ADD:
+        case Op::SUB:
+        case Op::MUL:
+        case Op::SDIV:
+        case Op::UDIV:
+        case Op::SREM:
+        case Op::UREM:
+        case Op::SHL:
+        case Op::LSHR:
+        case Op::ASHR:
+        case Op::AND:
+        case Op::OR:
+        case Op::XOR:
+            regs[instr.result] = binary(instr.op, instr.bits, value(instr.args[0]),
+                                        value(instr.args[1]), instr);
+            break;
+        case Op::VECTOR_BINARY: {
+            uint64_t dst = regs[instr.result];
+            uint64_t lhs = value(instr.args[0]);
+            uint64_t rhs = value(instr.args[1]);
+            uint64_t lane = instr.element_size;
+            for (uint64_t at = 0; at < instr.size; at += lane) {
+                uint64_t result = binary(static_cast<Op>(instr.from), instr.bits,
+                                         load(lhs + at, lane, instr), load(rhs + at, lane, instr),
+                                         instr);
+                store(dst + at, result, lane, instr);
+            }
+            break;
+        }
+        case Op::ICMP: {
+            uint64_t lhs = value(instr.args[0]);
+            uint64_t rhs = value(instr.args[1]);
+            int64_t slhs = sign_extend(lhs, instr.bits);
+            int64_t srhs = sign_extend(rhs, instr.bits);
+            bool result = false;
+            switch (instr.predicate) {
+            case Predicate::EQ:
+                result = lhs == rhs;
+                break;
+            case Predicate::NE:
+                result = lhs != rhs;
+                break;
+            case Predicate::SLT:
+                result = slhs < srhs;
+                break;
+            case Predicate::SLE:
+                result = slhs <= srhs;
+                break;
+            case Predicate::SGT:
+                result = slhs > srhs;
+                break;
+            case Predicate::SGE:
+                result = slhs >= srhs;
+                break;
+            case Predicate::ULT:
+                result = lhs < rhs;
+                break;
+            case Predicate::ULE:
+                result = lhs <= rhs;
+                break;
+            case Predicate::UGT:
+                result = lhs > rhs;
+                break;
+            case Predicate::UGE:
+                result = lhs >= rhs;
+                break;
+            }
+            regs[instr.result] = result;
+            break;
+        }
+        case Op::ZEXT:
+        case Op::COPY:
+            regs[instr.result] = value(instr.args[0]);
+            break;
+        case Op::SEXT:
+            regs[instr.result] = mask(
+                static_cast<uint64_t>(sign_extend(value(instr.args[0]), instr.from)), instr.bits);
+            break;
+        case Op::TRUNC:
+            regs[instr.result] = mask(value(instr.args[0]), instr.bits);
+            break;
+        case Op::GEP: {
+            uint64_t addr = value(instr.args[0]) + static_cast<uint64_t>(instr.offset);
+            for (const auto &term : instr.terms) {
+                addr += static_cast<uint64_t>(sign_extend(value(term.index), term.bits) *
+                                              term.stride);
+            }
+            regs[instr.result] = addr;
+            break;
+        }
+        case Op::CALL: {
+            call_args_.clear();
+            for (const auto &arg : instr.args) {
+                call_args_.push_back(value(arg));
+            }
+            enter(instr.target, call_args_, instr.result, &instr); // Invalidates frame/regs
+            break;
+        }
+        case Op::PRINTF: {
+            uint64_t written = call_printf(instr, regs, output);
+            if (instr.result >= 0) {
+                regs[instr.result] = mask(written, 32);
+            }
+            break;
+        }
+        case Op::SCANF: {
+            uint64_t read = call_scanf(instr, regs, input);
+            if (instr.result >= 0) {
+                regs[instr.result] = mask(read, 32);
+            }
+            break;
+        }
+        case Op::FOPEN: {
+            uint64_t handle = call_fopen(instr, regs);
+            if (instr.result >= 0) {
+                regs[instr.result] = handle;
+            }
+            break;
+        }
+        case Op::FPRINTF: {
+            std::ofstream &file = *files_[file_index(value(instr.args[0]), instr)];
+            std::string text = format_printf(instr, regs, 1);
+            file << text;
+            if (instr.result >= 0) {
+                regs[instr.result] = mask(file ? text.size() : static_cast<uint64_t>(-1), 32);
+            }
+            break;
+        }
+        case Op::FCLOSE: {
+            auto &file = files_[file_index(value(instr.args[0]), instr)];
+            file->close();
+            bool failed = file->fail();
+            file.reset();
+            if (instr.result >= 0) {
+                regs[instr.result] = mask(failed ? static_cast<uint64_t>(-1) : 0, 32);
+            }
+            break;
+        }
+        case Op::EXIT:
+            exit_code = static_cast<int>(sign_extend(value(instr.args[0]), 32));
+            frames_.clear();
+            return;
+        case Op::MEMCPY:
+            copy(value(instr.args[0]), value(instr.args[1]), value(instr.args[2]), instr);
+            break;
+        case Op::MEMSET: {
+            uint64_t size = value(instr.args[2]);
+            if (size > 0) {
+                std::memset(address(value(instr.args[0]), size, instr),
+                            static_cast<int>(value(instr.args[1])), size);
+            }
+            break;
+        }
+        case Op::NOP:
+            break;
+        case Op::SELECT:
+            regs[instr.result] =
+                value(instr.args[0]) & 1 ? value(instr.args[1]) : value(instr.args[2]);
+            break;
+        case Op::SELECT_AGGREGATE:
+            copy(regs[instr.result],
+                 value(instr.args[0]) & 1 ? value(instr.args[1]) : value(instr.args[2]),
+                 instr.size, instr);
+            break;
+        case Op::INSERT_VALUE: {
+            uint64_t dst = regs[instr.result];
+            copy(dst, value(instr.args[0]), instr.size, instr);
+            uint64_t at = dst + static_cast<uint64_t>(instr.offset);
+            if (instr.indirect) {
+                copy(at, value(instr.args[1]), instr.element_size, instr);
+            } else {
+                store(at, value(instr.args[1]), instr.element_size, instr);
+            }
+            break;
+        }
+        case Op::EXTRACT_VALUE:
+            regs[instr.result] =
+                mask(load(value(instr.args[0]) + static_cast<uint64_t>(instr.offset),
+                          instr.element_size, instr),
+                     instr.bits);
+            break;
+        case Op::EXTRACT_AGGREGATE:
+            copy(regs[instr.result], value(instr.args[0]) + static_cast<uint64_t>(instr.offset),
+                 instr.element_size, instr);
+            break;
+        case Op::INSERT_ELEMENT: {
+            uint64_t dst = regs[instr.result];
+            uint64_t lane = value(instr.args[2]);
+            if (lane >= instr.size / instr.element_size) {
+                trap(instr, "insertelement index " + std::to_string(lane) + " out of range");
+            }
+            copy(dst, value(instr.args[0]), instr.size, instr);
+            store(dst + lane * instr.element_size, value(instr.args[1]), instr.element_size,
+                  instr);
+            break;
+        }
+        case Op::SHUFFLE_VECTOR: {
+            uint64_t dst = regs[instr.result];
+            uint64_t lhs = value(instr.args[0]);
+            uint64_t rhs = value(instr.args[1]);
+            uint64_t lane = instr.element_size;
+            for (size_t i = 0; i < instr.lanes.size(); ++i) {
+                int64_t pick = instr.lanes[i];
+                uint64_t result = 0;
+                if (pick >= 0 && pick < instr.offset) {
+                    result = load(lhs + static_cast<uint64_t>(pick) * lane, lane, instr);
+                } else if (pick >= instr.offset) {
+                    result = load(rhs + static_cast<uint64_t>(pick - instr.offset) * lane, lane,
+                                  instr);
+                }
+                store(dst + i * lane, result, lane, instr);
+            }
+            break;
+        }
+        case Op::RET:
+        case Op::RET_AGGREGATE: {
+            uint64_t result = instr.args.empty() ? 0 : value(instr.args[0]);
+            Frame done = frame;
+            frames_.pop_back();
+            if (frames_.empty()) {
+                exit_code = static_cast<int>(sign_extend(result, 32));
+                return;
+            }
+            if (done.caller_result >= 0) {
+                uint64_t &dst = registers_[frames_.back().base + done.caller_result];
+                if (instr.op == Op::RET_AGGREGATE) {
+                    copy(dst, result, instr.size, instr);
+                } else {
+                    dst = result;
+                }
+            }
+            registers_.resize(done.base);
+            stack_pointer_ = done.stack;
+            break;
+        }
+        case Op::BR:
+            jump(frame, instr.target, instr);
+            break;
+        case Op::COND_BR:
+            jump(frame, value(instr.args[0]) & 1 ? instr.target : instr.other, instr);
+            break;
+        case Op::UNREACHABLE:
+            trap(instr, "reached unreachable");
+        }
+    }
+}
+
+void IRInterpreter::enter(int function, const std::vector<uint64_t> &args, int caller_result,
+                          const Instr *call) {
+    const Function &callee = functions_[function];
+    if (frames_.size() >= CALL_DEPTH_LIMIT) {
+        throw Trap{"call stack overflow entering @" + callee.source->name};
+    }
+
+    Frame frame;
+    frame.function = function;
+    frame.base = registers_.size();
+    frame.stack = stack_pointer_;
+    frame.caller_result = caller_result;
+    registers_.resize(frame.base + static_cast<size_t>(callee.registers), 0);
+
+    uint64_t slots = allocate_stack(callee.frame_bytes, 16);
+    for (const auto &[reg, offset] : callee.aggregates) {
+        registers_[frame.base + reg] = slots + offset;
+    }
+    for (size_t i = 0; i < callee.params.size(); ++i) {
+        const auto &[reg, bytes] = callee.params[i];
+        if (bytes > 0) {
+            copy(registers_[frame.base + reg], args[i], bytes, *call);
+        } else {
+            registers_[frame.base + reg] = args[i];
+        }
+    }
+    frames_.push_back(frame);
+}
+
+void IRInterpreter::jump(Frame &frame, int target, const Instr &branch) {
+    int from = frame.block;
+    frame.block = target;
+    frame.ip = 0;
+
+    const auto &phis = functions_[frame.function].blocks[target].phis;
+    if (phis.empty()) {
+        return;
+    }
+    opcode_counts_[phi_counter_] += phis.size();
+    function_counts_[frame.function] += phis.size();
+
+    // All phis read their incoming values before any of them is written
+    uint64_t *regs = registers_.data() + frame.base;
+    phi_values_.clear();
+    phi_bytes_.clear();
+    for (const auto &phi : phis) {
+        auto it = std::find_if(phi.incoming.begin(), phi.incoming.end(),
+                               [from](const auto &incoming) { return incoming.first == from; });
+        if (it == phi.incoming.end()) {
+            trap(branch, "phi has no value for the predecessor block");
+        }
+        uint64_t incoming = it->second.is_reg ? regs[it->second.value] : it->second.value;
+        if (phi.size == 0) {
+            phi_values_.push_back(incoming);
+            continue;
+        }
+        phi_values_.push_back(phi_bytes_.size());
+        const uint8_t *bytes = address(incoming, phi.size, branch);
+        phi_bytes_.insert(phi_bytes_.end(), bytes, bytes + phi.size);
+    }
+    for (size_t i = 0; i < phis.size(); ++i) {
+        if (phis[i].size == 0) {
+            regs[phis[i].result] = phi_values_[i];
+        } else {
+            std::memcpy(address(regs[phis[i].result], phis[i].size, branch),
+                        phi_bytes_.data() + phi_values_[i], phis[i].size);
+        }
+    }
+}
+
+uint64_t IRInterpreter::allocate_stack(uint64_t size, uint64_t align) {
+    uint64_t addr = align_up(stack_pointer_, std::max<uint64_t>(align, 1));
+    uint64_t end = addr + size;
+    if (end - stack_base_ > STACK_LIMIT) {
+        throw Trap{"stack overflow"};
+    }
+    if (end > memory_.size()) {
+        memory_.resize(std::min(std::max(end, 2 * memory_.size()), stack_base_ + STACK_LIMIT));
+    }
+    stack_pointer_ = end;
+    return addr;
+}
+
+uint8_t *IRInterpreter::address(uint64_t addr, uint64_t size, const Instr &instr) {
+    if (addr < NULL_PAGE || addr > memory_.size() || size > memory_.size() - addr) {
+        std::ostringstream message;
+        message << "invalid access of " << size << " bytes at address 0x" << std::hex << addr;
+        trap(instr, message.str());
+    }
+    return memory_.data() + addr;
+}
+
+uint64_t IRInterpreter::load(uint64_t addr, uint64_t size, const Instr &instr) {
+    uint64_t value = 0;
+    std::memcpy(&value, address(addr, size, instr), size);
+    return value;
+}
+
+void IRInterpreter::store(uint64_t addr, uint64_t value, uint64_t size, const Instr &instr) {
+    std::memcpy(address(addr, size, instr), &value, size);
+}
+
+void IRInterpreter::copy(uint64_t dst, uint64_t src, uint64_t size, const Instr &instr) {
+    if (size == 0 || dst == src) {
+        return;
+    }
+    uint8_t *to = address(dst, size, instr);
+    std::memmove(to, address(src, size, instr), size);
+}
+
+uint64_t IRInterpreter::binary(Op op, unsigned bits, uint64_t lhs, uint64_t rhs,
+                               const Instr &instr) {
+    uint64_t result = 0;
+    switch (op) {
+    case Op::ADD:
+        result = lhs + rhs;
+        break;
+    case Op::SUB:
+        result = lhs - rhs;
+        break;
+    case Op::MUL:
+        result = lhs * rhs;
+        break;
+    case Op::SDIV:
+    case Op::SREM: {
+        int64_t a = sign_extend(lhs, bits);
+        int64_t b = sign_extend(rhs, bits);
+        if (b == 0) {
+            trap(instr, "division by zero");
+        }
+        if (b == -1 && a == sign_extend(uint64_t(1) << (bits - 1), bits)) {
+            trap(instr, "signed division overflow");
+        }
+        result = static_cast<uint64_t>(op == Op::SDIV ? a / b : a % b);
+        break;
+    }
+    case Op::UDIV:
+    case Op::UREM:
+        if (rhs == 0) {
+            trap(instr, "division by zero");
+        }
+        result = op == Op::UDIV ? lhs / rhs : lhs % rhs;
+        break;
+    case Op::SHL:
+        result = rhs >= bits ? 0 : lhs << rhs;
+        break;
+    case Op::LSHR:
+        result = rhs >= bits ? 0 : lhs >> rhs;
+        break;
+    case Op::ASHR: {
+        int64_t a = sign_extend(lhs, bits);
+        result = static_cast<uint64_t>(rhs >= bits ? (a < 0 ? -1 : 0) : a >> rhs);
+        break;
+    }
+    case Op::AND:
+        result = lhs & rhs;
+        break;
+    case Op::OR:
+        result = lhs | rhs;
+        break;
+    case Op::XOR:
+        result = lhs ^ rhs;
+        break;
+    default:
+        trap(instr, "not a binary operator");
+    }
+    return mask(result, bits);
+}
+
+std::string IRInterpreter::read_string(uint64_t addr, const Instr &instr) {
+    std::string text;
+    for (char c; (c = static_cast<char>(*address(addr, 1, instr))) != '\0'; ++addr) {
+        text += c;
+    }
+    return text;
+}
+
+std::string IRInterpreter::format_printf(const Instr &instr, const uint64_t *regs,
+                                         size_t format_arg) {
+    auto value = [regs](const Arg &arg) { return arg.is_reg ? regs[arg.value] : arg.value; };
+    std::string format = read_string(value(instr.args[format_arg]), instr);
+    std::string text;
+    size_t next = format_arg + 1;
+    for (size_t i = 0; i < format.size(); ++i) {
+        if (format[i] != '%') {
+            text += format[i];
+            continue;
+        }
+        size_t end = i + 1;
+        int longs = 0;
+        while (end < format.size() && format[end] == 'l' && longs < 2) {
+            ++longs;
+            ++end;
+        }
+        char conversion = end < format.size() ? format[end] : '\0';
+        if (conversion == '%' && longs == 0) {
+            text += '%';
+        } else if ((conversion == 'd' || conversion == 'u' || conversion == 's') &&
+                   next < instr.args.size() && (conversion != 's' || longs == 0)) {
+            uint64_t arg = value(instr.args[next++]);
+            unsigned bits = longs == 0 ? 32 : 64;
+            if (conversion == 'd') {
+                text += std::to_string(sign_extend(arg, bits));
+            } else if (conversion == 'u') {
+                text += std::to_string(mask(arg, bits));
+            } else {
+                text += read_string(arg, instr);
+            }
+        } else {
+            trap(instr, "unsupported printf format \"" + format + "\"");
+        }
+        i = end;
+    }
+    return text;
+}
+
+uint64_t IRInterpreter::call_printf(const Instr &instr, const uint64_t *regs,
+                                    std::ostream &output) {
+    std::string text = format_printf(instr, regs, 0);
+    output << text;
+    return text.size();
+}
+
+uint64_t IRInterpreter::call_fopen(const Instr &instr, const uint64_t *regs) {
+    auto value = [regs](const Arg &arg) { return arg.is_reg ? regs[arg.value] : arg.value; };
+    std::string path = read_string(value(instr.args[0]), instr);
+    std::string mode = read_string(value(instr.args[1]), instr);
+    std::ios::openmode open_mode = std::ios::out;
+    if (mode == "a") {
+        open_mode |= std::ios::app;
+    } else if (mode != "w") {
+        trap(instr, "unsupported fopen mode \"" + mode + "\"");
+    }
+    auto file = std::make_unique<std::ofstream>(path, open_mode);
+    if (!*file) {
+        return 0; // NULL, like a failed fopen
+    }
+    files_.push_back(std::move(file));
+    return files_.size(); // Handles are indices + 1, so never NULL
+}
+
+size_t IRInterpreter::file_index(uint64_t handle, const Instr &instr) const {
+    if (handle == 0 || handle > files_.size() || !files_[handle - 1]) {
+        trap(instr, "invalid FILE pointer");
+    }
+    return handle - 1;
+}
+
+uint64_t IRInterpreter::call_scanf(const Instr &instr, const uint64_t *regs,
+                                   std::istream &input) {
+    auto value = [regs](const Arg &arg) { return arg.is_reg ? regs[arg.value] : arg.value; };
+    std::string format = read_string(value(instr.args[0]), instr);
+    uint64_t assigned = 0;
+    size_t next = 1;
+    for (size_t i = 0; i < format.size(); ++i) {
+        if (format[i] == ' ') {
+            continue;
+        }
+        if (format[i] != '%' || i + 1 >= format.size() || format[i + 1] != 'd' ||
+            next >= instr.args.size()) {
+            trap(instr, "unsupported scanf format \"" + format + "\"");
+        }
+        ++i;
+        int32_t number = 0;
+        if (!(input >> number)) {
+            // Like scanf: EOF before the first conversion returns -1
+            return assigned == 0 && input.eof() ? static_cast<uint64_t>(-1) : assigned;
+        }
+        store(value(instr.args[next++]), static_cast<uint32_t>(number), 4, instr);
+        ++assigned;
+    }
+    return assigned;
+}
+
+void IRInterpreter::trap(const Instr &instr, const std::string &message) const {
+    std::string where =
+        frames_.empty() ? "" : " in @" + functions_[frames_.back().function].source->name;
+    throw Trap{message + where + " (IR line " + std::to_string(instr.line) + ")"};
+}
+
+void IRInterpreter::collect_counts() {
+    counts_ = InstructionCounts();
+    for (size_t i = 0; i < opcode_counts_.size(); ++i) {
+        if (opcode_counts_[i] > 0) {
+            counts_.by_opcode[counter_names_[i]] = opcode_counts_[i];
+            counts_.total += opcode_counts_[i];
+        }
+    }
+    for (size_t i = 0; i < function_counts_.size(); ++i) {
+        if (function_counts_[i] > 0) {
+            counts_.by_function[functions_[i].source->name] = function_counts_[i];
+        }
+    }
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "../error/error.h"
+#include "ir_module.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * InstructionCounts - Dynamic instruction counts of one interpreter run
+ *
+ * Opcodes are counted under their IR name ("add", "load", "icmp", "call",
+ * "phi", ...). Every executed instruction is also charged to the function
+ * whose body it belongs to; callees are not included in the caller's count.
+ */
+struct InstructionCounts {
+    std::map<std::string, uint64_t> by_opcode;
+    std::map<std::string, uint64_t> by_function;
+    uint64_t total = 0;
+
+    /**
+     * Print both tables, most executed first
+     */
+    void print(std::ostream &out) const;
+};
+
+/**
+ * IRInterpreter - Executes an IRModule without LLVM
+ *
+ * Core responsibilities:
+ * 1. Decode every function once into a compact form (register numbers,
+ *    block indices, folded GEP offsets, resolved callees)
+ * 2. Run @main on an explicit frame stack, so deep recursion in the
+ *    program does not recurse in the interpreter
+ * 3. Provide the C functions the builtins lower to: printf ("%d" formats
+ *    of printInt/printlnInt), scanf (getInt) and exit, plus the
+ *    llvm.memcpy/memset/lifetime intrinsics and the fopen/fprintf/fclose
+ *    of the block counter dump (write-only files)
+ * 4. Count executed instructions per opcode and per function
+ *
+ * Memory model:
+ * - One byte-addressed memory: a reserved null page, then globals, then
+ *   constant aggregate operands, then the stack
+ * - Pointers are addresses into that memory; every load and store is
+ *   bounds-checked, so a wild access traps instead of corrupting the host
+ * - Scalars are kept zero-extended to their width in 64-bit registers
+ * - Aggregate and vector values live in per-frame stack slots and their
+ *   registers hold the slot address
+ *
+ * Traps (division by zero, out-of-bounds access, unreachable, stack
+ * overflow) stop the run and are reported with the function and IR line.
+ *
+ * Example:
+ *   IRInterpreter interpreter(module, errors);
+ *   int exit_code = 0;
+ *   if (interpreter.run(std::cin, std::cout, exit_code)) {
+ *       interpreter.counts().print(std::cerr);
+ *   }
+ */
+class IRInterpreter {
+  public:
+    IRInterpreter(const IRModule &module, ErrorReporter &error_reporter)
+        : module_(module), error_reporter_(error_reporter) {}
+
+    /**
+     * Run @main
+     * @param input Standard input of the program (getInt)
+     * @param output Standard output of the program (printInt/printlnInt)
+     * @param exit_code Receives the return value of main or the argument of exit()
+     * @return false if the module cannot be run or the program trapped
+     */
+    bool run(std::istream &input, std::ostream &output, int &exit_code);
+
+    /**
+     * Counts of the last run (also filled when it trapped)
+     */
+    const InstructionCounts &counts() const { return counts_; }
+
+  private:
+    static constexpr uint64_t NULL_PAGE = 64;                  // Addresses below trap
+    static constexpr uint64_t STACK_LIMIT = uint64_t(1) << 30; // Bytes of stack
+    static constexpr size_t CALL_DEPTH_LIMIT = 1 << 20;
+
+    enum class Op : uint8_t {
+        ALLOCA, LOAD, LOAD_AGGREGATE, STORE, STORE_AGGREGATE,
+        ADD, SUB, MUL, SDIV, UDIV, SREM, UREM, SHL, LSHR, ASHR, AND, OR, XOR,
+        VECTOR_BINARY, ICMP, ZEXT, SEXT, TRUNC, COPY, GEP,
+        CALL, PRINTF, SCANF, FOPEN, FPRINTF, FCLOSE, EXIT, MEMCPY, MEMSET, NOP,
+        SELECT, SELECT_AGGREGATE, INSERT_VALUE, EXTRACT_VALUE, EXTRACT_AGGREGATE,
+        INSERT_ELEMENT, SHUFFLE_VECTOR, RET, RET_AGGREGATE, BR, COND_BR, UNREACHABLE,
+    };
+
+    enum class Predicate : uint8_t { EQ, NE, SLT, SLE, SGT, SGE, ULT, ULE, UGT, UGE };
+
+    /**
+     * A decoded operand: a register of the current frame or an immediate
+     * (integer constant, global address or address of a pooled constant)
+     */
+    struct Arg {
+        bool is_reg = false;
+        uint64_t value = 0;
+    };
+
+    struct GepTerm {
+        Arg index;
+        unsigned bits = 64; // Width of the index, sign-extended
+        int64_t stride = 0;
+    };
+
+    struct Instr {
+        Op op = Op::UNREACHABLE;
+        Predicate predicate = Predicate::EQ;
+        bool indirect = false;     // INSERT_VALUE: the element is an aggregate held by address
+        unsigned bits = 0;         // Width of the scalar operation (per lane for vectors)
+        unsigned from = 0;         // SEXT: source width; VECTOR_BINARY: the scalar Op
+        int result = -1;           // Result register, -1 if none
+        uint64_t size = 0;         // Bytes loaded, stored, allocated or copied
+        uint64_t element_size = 0; // Bytes of the element or lane accessed
+        int64_t offset = 0;        // ALLOCA: alignment; GEP: constant part; element offset;
+                                   // SHUFFLE_VECTOR: lanes of the first operand
+        int target = -1;           // CALL: function; BR/COND_BR: (true) block
+        int other = -1;            // COND_BR: false block
+        int counter = 0;           // Index into the opcode counters
+        int line = 0;              // IR line, for traps
+        std::vector<Arg> args;
+        std::vector<GepTerm> terms; // GEP
+        std::vector<int64_t> lanes; // SHUFFLE_VECTOR mask, -1 for undef
+    };
+
+    struct Phi {
+        int result = -1;
+        uint64_t size = 0; // Aggregate bytes, 0 for scalars
+        std::vector<std::pair<int, Arg>> incoming; // (predecessor block, value)
+    };
+
+    struct Block {
+        std::vector<Phi> phis;
+        std::vector<Instr> instrs;
+    };
+
+    struct Function {
+        const IRFunction *source = nullptr;
+        int registers = 0;
+        std::vector<std::pair<int, uint64_t>> params;     // (register, aggregate bytes or 0)
+        std::vector<std::pair<int, uint64_t>> aggregates; // (register, frame slot offset)
+        uint64_t frame_bytes = 0;                         // Aggregate slot area
+        std::vector<Block> blocks;
+    };
+
+    struct Frame {
+        int function = 0;
+        int block = 0;
+        size_t ip = 0;
+        size_t base = 0;         // First register in registers_
+        uint64_t stack = 0;      // Stack pointer at entry, restored on return
+        int caller_result = -1;  // Register of the caller receiving the return value
+    };
+
+    struct Trap {
+        std::string message;
+    };
+
+    struct Unsupported {
+        std::string message;
+    };
+
+    const IRModule &module_;
+    ErrorReporter &error_reporter_;
+
+    std::vector<Function> functions_;
+    std::map<std::string, uint64_t> global_addresses_;
+    std::map<std::string, int> counter_ids_;
+    std::vector<std::string> counter_names_;
+
+    std::vector<uint8_t> memory_;
+    uint64_t stack_base_ = 0;
+    uint64_t stack_pointer_ = 0;
+    std::vector<uint64_t> registers_;
+    std::vector<Frame> frames_;
+    std::vector<uint64_t> call_args_;  // Scratch for CALL
+    std::vector<uint64_t> phi_values_; // Scratch for phis, read before any is written
+    std::vector<uint8_t> phi_bytes_;
+    std::vector<std::unique_ptr<std::ofstream>> files_; // fopen'ed files, null once closed
+    int main_function_ = -1;
+    int phi_counter_ = 0;
+    std::vector<uint64_t> opcode_counts_;
+    std::vector<uint64_t> function_counts_;
+    InstructionCounts counts_;
+
+    // Decoding
+    void load_module();
+    uint64_t add_constant(const std::vector<uint8_t> &bytes, size_t align);
+    void decode_function(const IRFunction &source, Function &function);
+    void decode_instruction(const IRInstruction &source, const IRFunction &function,
+                            const std::map<std::string, int> &locals, Instr &instr);
+    Arg decode_value(const IRValue &value, const std::map<std::string, int> &locals);
+    int counter(const std::string &name);
+    [[noreturn]] static void unsupported(const IRInstruction &instr, const std::string &what);
+
+    // Execution
+    void execute(std::istream &input, std::ostream &output, int &exit_code);
+    void enter(int function, const std::vector<uint64_t> &args, int caller_result,
+               const Instr *call);
+    void jump(Frame &frame, int target, const Instr &branch);
+    uint64_t allocate_stack(uint64_t size, uint64_t align);
+    uint8_t *address(uint64_t addr, uint64_t size, const Instr &instr);
+    uint64_t load(uint64_t addr, uint64_t size, const Instr &instr);
+    void store(uint64_t addr, uint64_t value, uint64_t size, const Instr &instr);
+    void copy(uint64_t dst, uint64_t src, uint64_t size, const Instr &instr);
+    uint64_t binary(Op op, unsigned bits, uint64_t lhs, uint64_t rhs, const Instr &instr);
+    std::string read_string(uint64_t addr, const Instr &instr);
+    std::string format_printf(const Instr &instr, const uint64_t *regs, size_t format_arg);
+    uint64_t call_printf(const Instr &instr, const uint64_t *regs, std::ostream &output);
+    uint64_t call_scanf(const Instr &instr, const uint64_t *regs, std::istream &input);
+    uint64_t call_fopen(const Instr &instr, const uint64_t *regs);
+    size_t file_index(uint64_t handle, const Instr &instr) const;
+    [[noreturn]] void trap(const Instr &instr, const std::string &message) const;
+    void collect_counts();
+};
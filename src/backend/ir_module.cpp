@@ -0,0 +1,158 @@
+#include "ir_module.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+size_t align_to(size_t value, size_t align) { return (value + align - 1) / align * align; }
+
+std::string type_key(const IRType *type) {
+    return std::to_string(reinterpret_cast<uintptr_t>(type));
+}
+
+} // namespace
+
+size_t IRType::element_offset(size_t index) const {
+    if (kind == Kind::STRUCT) {
+        return offsets.at(index);
+    }
+    return index * element->size;
+}
+
+const IRType *IRType::element_type(size_t index) const {
+    if (kind == Kind::STRUCT) {
+        return fields.at(index);
+    }
+    return element;
+}
+
+int IRFunction::block_index(const std::string &label) const {
+    if (block_indices_.size() != blocks.size()) {
+        block_indices_.clear();
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            block_indices_[blocks[i].label] = static_cast<int>(i);
+        }
+    }
+    auto it = block_indices_.find(label);
+    return it != block_indices_.end() ? it->second : -1;
+}
+
+IRType *IRModule::intern(const std::string &key, IRType type) {
+    auto it = interned_.find(key);
+    if (it != interned_.end()) {
+        return it->second;
+    }
+    types_.push_back(std::make_unique<IRType>(std::move(type)));
+    IRType *result = types_.back().get();
+    interned_[key] = result;
+    return result;
+}
+
+const IRType *IRModule::void_type() {
+    IRType type;
+    type.kind = IRType::Kind::VOID;
+    return intern("void", type);
+}
+
+const IRType *IRModule::label_type() {
+    IRType type;
+    type.kind = IRType::Kind::LABEL;
+    return intern("label", type);
+}
+
+const IRType *IRModule::int_type(unsigned bits) {
+    IRType type;
+    type.kind = IRType::Kind::INT;
+    type.bits = bits;
+    type.size = bits <= 8 ? 1 : align_to(bits, 8) / 8;
+    type.align = type.size;
+    return intern("i" + std::to_string(bits), type);
+}
+
+const IRType *IRModule::pointer_to(const IRType *pointee) {
+    IRType type;
+    type.kind = IRType::Kind::PTR;
+    type.element = pointee;
+    type.size = 8;
+    type.align = 8;
+    return intern("p" + type_key(pointee), type);
+}
+
+const IRType *IRModule::array_of(const IRType *element, size_t count) {
+    IRType type;
+    type.kind = IRType::Kind::ARRAY;
+    type.element = element;
+    type.count = count;
+    type.size = element->size * count;
+    type.align = element->align;
+    return intern("a" + std::to_string(count) + "x" + type_key(element), type);
+}
+
+const IRType *IRModule::vector_of(const IRType *element, size_t count) {
+    IRType type;
+    type.kind = IRType::Kind::VECTOR;
+    type.element = element;
+    type.count = count;
+    type.size = element->size * count;
+    type.align = type.size;
+    return intern("v" + std::to_string(count) + "x" + type_key(element), type);
+}
+
+const IRType *IRModule::struct_of(const std::vector<const IRType *> &fields) {
+    std::string key = "s";
+    for (const auto *field : fields) {
+        key += type_key(field) + ",";
+    }
+    IRType type;
+    type.kind = IRType::Kind::STRUCT;
+    type.fields = fields;
+    compute_struct_layout(&type);
+    return intern(key, type);
+}
+
+IRType *IRModule::named_struct(const std::string &name) {
+    IRType type;
+    type.kind = IRType::Kind::STRUCT;
+    type.name = name;
+    type.defined = false;
+    return intern("%" + name, type);
+}
+
+void IRModule::define_struct(IRType *type, const std::vector<const IRType *> &fields) {
+    type->fields = fields;
+    type->defined = true;
+    compute_struct_layout(type);
+}
+
+void IRModule::compute_struct_layout(IRType *type) {
+    size_t offset = 0;
+    size_t align = 1;
+    type->offsets.clear();
+    for (const auto *field : type->fields) {
+        offset = align_to(offset, field->align);
+        type->offsets.push_back(offset);
+        offset += field->size;
+        align = std::max(align, field->align);
+    }
+    type->size = align_to(offset, align);
+    type->align = align;
+}
+
+const IRFunction *IRModule::find_function(const std::string &name) const {
+    for (const auto &function : functions) {
+        if (function.name == name) {
+            return &function;
+        }
+    }
+    return nullptr;
+}
+
+const IRGlobal *IRModule::find_global(const std::string &name) const {
+    for (const auto &global : globals) {
+        if (global.name == name) {
+            return &global;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * IRType - A parsed LLVM type
+ *
+ * Types are interned by IRModule, so two types are equal iff their pointers
+ * are equal. Sizes follow the x86-64 datalayout (DataLayout::LLVM_DATALAYOUT):
+ * i1/i8 take 1 byte, pointers 8, aggregates use natural alignment.
+ */
+struct IRType {
+    enum class Kind { VOID, INT, PTR, ARRAY, VECTOR, STRUCT, LABEL };
+
+    Kind kind = Kind::VOID;
+    unsigned bits = 0;                  // INT
+    const IRType *element = nullptr;    // PTR pointee, ARRAY/VECTOR element
+    size_t count = 0;                   // ARRAY/VECTOR length
+    std::vector<const IRType *> fields; // STRUCT
+    std::vector<size_t> offsets;        // STRUCT field offsets
+    std::string name;                   // Named STRUCT without '%' (e.g., "Point")
+    size_t size = 0;
+    size_t align = 1;
+    bool defined = true; // false for a named struct referenced before its definition
+
+    bool is_int() const { return kind == Kind::INT; }
+    bool is_ptr() const { return kind == Kind::PTR; }
+    bool is_void() const { return kind == Kind::VOID; }
+    bool is_vector() const { return kind == Kind::VECTOR; }
+    bool is_aggregate() const { return kind == Kind::ARRAY || kind == Kind::STRUCT; }
+    bool is_scalar() const { return kind == Kind::INT || kind == Kind::PTR; }
+
+    /**
+     * Offset of element `index` of an array, vector or struct
+     */
+    size_t element_offset(size_t index) const;
+
+    /**
+     * Type of element `index` of an array, vector or struct
+     */
+    const IRType *element_type(size_t index) const;
+};
+
+/**
+ * IRValue - An instruction operand
+ */
+struct IRValue {
+    enum class Kind { LOCAL, GLOBAL, INT, UNDEF, ZERO, VECTOR };
+
+    Kind kind = Kind::UNDEF;
+    const IRType *type = nullptr;
+    std::string name;              // LOCAL/GLOBAL name without sigil
+    int64_t value = 0;             // INT (true = 1, false = 0, null = 0)
+    std::vector<IRValue> elements; // VECTOR constant
+
+    bool is_local() const { return kind == Kind::LOCAL; }
+    bool is_constant() const { return kind == Kind::INT || kind == Kind::ZERO; }
+};
+
+enum class IROpcode {
+    ALLOCA,
+    LOAD,
+    STORE,
+    BINARY,
+    ICMP,
+    CAST,
+    GEP,
+    PHI,
+    CALL,
+    SELECT,
+    INSERT_VALUE,
+    EXTRACT_VALUE,
+    INSERT_ELEMENT,
+    SHUFFLE_VECTOR,
+    RET,
+    BR,
+    COND_BR,
+    UNREACHABLE,
+};
+
+/**
+ * IRInstruction - One parsed instruction
+ *
+ * Operand conventions per opcode:
+ * - ALLOCA:         type = allocated type
+ * - LOAD:           type = loaded type; operands = {ptr}
+ * - STORE:          operands = {value, ptr}
+ * - BINARY:         op = "add"/"sdiv"/...; operands = {lhs, rhs}
+ * - ICMP:           op = predicate; operands = {lhs, rhs}
+ * - CAST:           op = "zext"/"sext"/"trunc"/"bitcast"; operands = {value}
+ * - GEP:            source_type = indexed type; operands = {ptr, indices...}
+ * - PHI:            operands[i] flows in from labels[i]
+ * - CALL:           op = callee; operands = arguments
+ * - SELECT:         operands = {cond, true value, false value}
+ * - INSERT_VALUE:   operands = {aggregate, element}; indices = path
+ * - EXTRACT_VALUE:  operands = {aggregate}; indices = path
+ * - INSERT_ELEMENT: operands = {vector, element, index}
+ * - SHUFFLE_VECTOR: operands = {lhs, rhs}; indices = mask
+ * - RET:            operands = {} or {value}
+ * - BR:             labels = {target}
+ * - COND_BR:        operands = {cond}; labels = {true target, false target}
+ * `type` is the result type for instructions with a result.
+ */
+struct IRInstruction {
+    IROpcode opcode = IROpcode::UNREACHABLE;
+    std::string result; // Without '%', empty if the instruction has no result
+    std::string op;
+    const IRType *type = nullptr;
+    const IRType *source_type = nullptr;
+    std::vector<IRValue> operands;
+    std::vector<std::string> labels;
+    std::vector<int64_t> indices;
+    int line = 0; // Line in the IR text, for diagnostics
+
+    bool is_terminator() const {
+        return opcode == IROpcode::RET || opcode == IROpcode::BR ||
+               opcode == IROpcode::COND_BR || opcode == IROpcode::UNREACHABLE;
+    }
+};
+
+struct IRBlock {
+    std::string label;
+    std::vector<IRInstruction> instructions;
+};
+
+struct IRParam {
+    const IRType *type = nullptr;
+    std::string name;
+};
+
+struct IRFunction {
+    std::string name;
+    const IRType *return_type = nullptr;
+    std::vector<IRParam> params;
+    bool is_vararg = false;
+    bool is_declaration = false;
+    std::vector<IRBlock> blocks; // blocks[0] is the entry block
+
+    /**
+     * Index of the block with a label, -1 if there is none
+     */
+    int block_index(const std::string &label) const;
+
+  private:
+    mutable std::map<std::string, int> block_indices_;
+};
+
+/**
+ * IRGlobal - A global variable with its initializer flattened to bytes
+ */
+struct IRGlobal {
+    std::string name;
+    const IRType *type = nullptr;
+    bool is_constant = false;
+    bool is_zero = true; // All bytes are zero (goes to .bss unless constant)
+    std::vector<uint8_t> data;
+    size_t align = 1;
+};
+
+/**
+ * IRModule - A parsed LLVM IR module
+ *
+ * Owns all types. Functions and globals keep their textual order.
+ */
+class IRModule {
+  public:
+    std::vector<IRGlobal> globals;
+    std::vector<IRFunction> functions;
+
+    const IRType *void_type();
+    const IRType *int_type(unsigned bits);
+    const IRType *pointer_to(const IRType *pointee);
+    const IRType *array_of(const IRType *element, size_t count);
+    const IRType *vector_of(const IRType *element, size_t count);
+    const IRType *struct_of(const std::vector<const IRType *> &fields);
+    const IRType *label_type();
+
+    /**
+     * Get a named struct, creating an undefined placeholder on first use
+     * @param name Name without '%'
+     */
+    IRType *named_struct(const std::string &name);
+
+    /**
+     * Set the fields of a named struct and compute its layout
+     */
+    void define_struct(IRType *type, const std::vector<const IRType *> &fields);
+
+    const IRFunction *find_function(const std::string &name) const;
+    const IRGlobal *find_global(const std::string &name) const;
+
+  private:
+    std::vector<std::unique_ptr<IRType>> types_;
+    std::map<std::string, IRType *> interned_;
+
+    IRType *intern(const std::string &key, IRType type);
+    static void compute_struct_layout(IRType *type);
+};
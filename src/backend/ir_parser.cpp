@@ -0,0 +1,681 @@
+#include "ir_parser.h"
+
+#include <cctype>
+#include <set>
+
+namespace {
+
+struct ParseError {
+    std::string message;
+};
+
+bool is_name_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$' ||
+           c == '-';
+}
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+std::string decode_string(std::string_view text) {
+    std::string result;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 2 < text.size() && hex_digit(text[i + 1]) >= 0 &&
+            hex_digit(text[i + 2]) >= 0) {
+            result += static_cast<char>(hex_digit(text[i + 1]) * 16 + hex_digit(text[i + 2]));
+            i += 2;
+        } else if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] == '\\') {
+            result += '\\';
+            ++i;
+        } else {
+            result += text[i];
+        }
+    }
+    return result;
+}
+
+const std::set<std::string> BINARY_OPS = {"add",  "sub",  "mul", "sdiv", "udiv", "srem", "urem",
+                                          "and",  "or",   "xor", "shl",  "ashr", "lshr"};
+const std::set<std::string> CAST_OPS = {"zext", "sext", "trunc", "bitcast", "ptrtoint", "inttoptr"};
+
+bool is_type_word(const std::string &word) {
+    return word == "void" || word == "label" ||
+           (word.size() > 1 && word[0] == 'i' &&
+            word.find_first_not_of("0123456789", 1) == std::string::npos);
+}
+
+const std::set<std::string> VALUE_WORDS = {"true", "false", "null", "undef", "poison",
+                                           "zeroinitializer"};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Tokens
+// ---------------------------------------------------------------------------
+
+void IRParser::tokenize(std::string_view line) {
+    tokens_.clear();
+    pos_ = 0;
+    size_t i = 0;
+    while (i < line.size()) {
+        char c = line[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+            continue;
+        }
+        if (c == ';') {
+            break;
+        }
+
+        Token token;
+        if (c == '%' || c == '@' || c == '!') {
+            token.kind = c == '%'   ? Token::Kind::LOCAL
+                         : c == '@' ? Token::Kind::GLOBAL
+                                    : Token::Kind::METADATA;
+            size_t start = ++i;
+            if (i < line.size() && line[i] == '"') {
+                size_t end = line.find('"', i + 1);
+                token.text = std::string(line.substr(i + 1, end - i - 1));
+                i = end + 1;
+            } else {
+                while (i < line.size() && is_name_char(line[i])) {
+                    ++i;
+                }
+                token.text = std::string(line.substr(start, i - start));
+            }
+        } else if (c == 'c' && i + 1 < line.size() && line[i + 1] == '"') {
+            size_t end = line.find('"', i + 2);
+            token.kind = Token::Kind::STRING;
+            token.text = decode_string(line.substr(i + 2, end - i - 2));
+            i = end + 1;
+        } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                   (c == '-' && i + 1 < line.size() &&
+                    std::isdigit(static_cast<unsigned char>(line[i + 1])))) {
+            size_t start = i++;
+            while (i < line.size() && std::isdigit(static_cast<unsigned char>(line[i]))) {
+                ++i;
+            }
+            if (i < line.size() && line[i] == ':') {
+                // Numeric block label
+                token.kind = Token::Kind::WORD;
+            } else {
+                token.kind = Token::Kind::INT;
+            }
+            token.text = std::string(line.substr(start, i - start));
+            token.value = token.kind == Token::Kind::INT ? std::stoll(token.text) : 0;
+        } else if (line.substr(i, 3) == "...") {
+            token.kind = Token::Kind::WORD;
+            token.text = "...";
+            i += 3;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '.') {
+            size_t start = i;
+            while (i < line.size() && is_name_char(line[i])) {
+                ++i;
+            }
+            token.kind = Token::Kind::WORD;
+            token.text = std::string(line.substr(start, i - start));
+        } else {
+            token.kind = Token::Kind::PUNCT;
+            token.text = std::string(1, c);
+            ++i;
+        }
+        tokens_.push_back(std::move(token));
+    }
+}
+
+const IRParser::Token &IRParser::peek(size_t offset) const {
+    static const Token end_token;
+    return pos_ + offset < tokens_.size() ? tokens_[pos_ + offset] : end_token;
+}
+
+IRParser::Token IRParser::next() {
+    if (pos_ >= tokens_.size()) {
+        fail("unexpected end of line");
+    }
+    return tokens_[pos_++];
+}
+
+bool IRParser::accept(const std::string &punct_or_word) {
+    const Token &token = peek();
+    if ((token.kind == Token::Kind::PUNCT || token.kind == Token::Kind::WORD) &&
+        token.text == punct_or_word) {
+        ++pos_;
+        return true;
+    }
+    return false;
+}
+
+void IRParser::expect(const std::string &punct_or_word) {
+    if (!accept(punct_or_word)) {
+        fail("expected '" + punct_or_word + "', found '" + peek().text + "'");
+    }
+}
+
+bool IRParser::at_end() const { return pos_ >= tokens_.size(); }
+
+void IRParser::fail(const std::string &message) const { throw ParseError{message}; }
+
+// ---------------------------------------------------------------------------
+// Types and constants
+// ---------------------------------------------------------------------------
+
+void IRParser::resolve_struct(const std::string &name) {
+    IRType *type = module_->named_struct(name);
+    auto body = struct_bodies_.find(name);
+    if (type->defined || body == struct_bodies_.end()) {
+        return;
+    }
+
+    std::vector<Token> saved_tokens = std::move(tokens_);
+    size_t saved_pos = pos_;
+    std::string text = body->second;
+    struct_bodies_.erase(body);
+
+    tokenize(text);
+    std::vector<const IRType *> fields;
+    expect("{");
+    if (!accept("}")) {
+        do {
+            fields.push_back(parse_type());
+        } while (accept(","));
+        expect("}");
+    }
+    module_->define_struct(type, fields);
+
+    tokens_ = std::move(saved_tokens);
+    pos_ = saved_pos;
+}
+
+const IRType *IRParser::parse_type() {
+    const IRType *type = nullptr;
+    Token token = next();
+
+    if (token.kind == Token::Kind::WORD && token.text == "void") {
+        type = module_->void_type();
+    } else if (token.kind == Token::Kind::WORD && token.text == "label") {
+        type = module_->label_type();
+    } else if (token.kind == Token::Kind::WORD && token.text.size() > 1 && token.text[0] == 'i' &&
+               std::isdigit(static_cast<unsigned char>(token.text[1]))) {
+        type = module_->int_type(static_cast<unsigned>(std::stoul(token.text.substr(1))));
+    } else if (token.kind == Token::Kind::LOCAL) {
+        resolve_struct(token.text);
+        type = module_->named_struct(token.text);
+    } else if (token.kind == Token::Kind::PUNCT && (token.text == "[" || token.text == "<")) {
+        Token count = next();
+        if (count.kind != Token::Kind::INT) {
+            fail("expected element count");
+        }
+        expect("x");
+        const IRType *element = parse_type();
+        if (token.text == "[") {
+            expect("]");
+            type = module_->array_of(element, static_cast<size_t>(count.value));
+        } else {
+            expect(">");
+            type = module_->vector_of(element, static_cast<size_t>(count.value));
+        }
+    } else if (token.kind == Token::Kind::PUNCT && token.text == "{") {
+        std::vector<const IRType *> fields;
+        if (!accept("}")) {
+            do {
+                fields.push_back(parse_type());
+            } while (accept(","));
+            expect("}");
+        }
+        type = module_->struct_of(fields);
+    } else {
+        fail("expected type, found '" + token.text + "'");
+    }
+
+    while (accept("*")) {
+        type = module_->pointer_to(type);
+    }
+    return type;
+}
+
+void IRParser::skip_parens() {
+    int depth = 0;
+    do {
+        Token token = next();
+        if (token.kind == Token::Kind::PUNCT && token.text == "(") {
+            ++depth;
+        } else if (token.kind == Token::Kind::PUNCT && token.text == ")") {
+            --depth;
+        }
+    } while (depth > 0);
+}
+
+void IRParser::skip_attributes() {
+    while (peek().kind == Token::Kind::WORD && !VALUE_WORDS.count(peek().text) &&
+           !is_type_word(peek().text) && peek().text != "...") {
+        std::string word = next().text;
+        if (peek().kind == Token::Kind::PUNCT && peek().text == "(") {
+            skip_parens();
+        } else if ((word == "align" || word == "dereferenceable") &&
+                   peek().kind == Token::Kind::INT) {
+            next();
+        }
+    }
+}
+
+IRValue IRParser::parse_value(const IRType *type) {
+    IRValue value;
+    value.type = type;
+    Token token = next();
+
+    switch (token.kind) {
+    case Token::Kind::LOCAL:
+        value.kind = IRValue::Kind::LOCAL;
+        value.name = token.text;
+        return value;
+    case Token::Kind::GLOBAL:
+        value.kind = IRValue::Kind::GLOBAL;
+        value.name = token.text;
+        return value;
+    case Token::Kind::INT:
+        value.kind = IRValue::Kind::INT;
+        value.value = token.value;
+        return value;
+    case Token::Kind::WORD:
+        if (token.text == "true" || token.text == "false" || token.text == "null") {
+            value.kind = IRValue::Kind::INT;
+            value.value = token.text == "true" ? 1 : 0;
+            return value;
+        }
+        if (token.text == "undef" || token.text == "poison") {
+            value.kind = IRValue::Kind::UNDEF;
+            return value;
+        }
+        if (token.text == "zeroinitializer") {
+            value.kind = IRValue::Kind::ZERO;
+            return value;
+        }
+        break;
+    case Token::Kind::PUNCT:
+        if (token.text == "<") {
+            value.kind = IRValue::Kind::VECTOR;
+            do {
+                value.elements.push_back(parse_typed_value());
+            } while (accept(","));
+            expect(">");
+            return value;
+        }
+        break;
+    default:
+        break;
+    }
+    fail("expected value, found '" + token.text + "'");
+}
+
+IRValue IRParser::parse_typed_value() {
+    const IRType *type = parse_type();
+    skip_attributes();
+    return parse_value(type);
+}
+
+void IRParser::parse_constant(const IRType *type, std::vector<uint8_t> &data, size_t offset,
+                              bool &is_zero) {
+    const Token &token = peek();
+    if (token.kind == Token::Kind::WORD &&
+        (token.text == "zeroinitializer" || token.text == "undef")) {
+        next();
+        return;
+    }
+
+    if (type->is_int() || type->is_ptr()) {
+        IRValue value = parse_value(type);
+        if (value.kind != IRValue::Kind::INT) {
+            fail("unsupported global initializer");
+        }
+        uint64_t bits = static_cast<uint64_t>(value.value);
+        for (size_t i = 0; i < type->size; ++i) {
+            data[offset + i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+        is_zero = is_zero && bits == 0;
+        return;
+    }
+
+    if (token.kind == Token::Kind::STRING) {
+        std::string bytes = next().text;
+        for (size_t i = 0; i < bytes.size() && i < type->size; ++i) {
+            data[offset + i] = static_cast<uint8_t>(bytes[i]);
+            is_zero = is_zero && bytes[i] == 0;
+        }
+        return;
+    }
+
+    std::string close = type->kind == IRType::Kind::ARRAY    ? "]"
+                        : type->kind == IRType::Kind::VECTOR ? ">"
+                                                             : "}";
+    expect(close == "]" ? "[" : close == ">" ? "<" : "{");
+    size_t index = 0;
+    if (!accept(close)) {
+        do {
+            const IRType *element = parse_type();
+            parse_constant(element, data, offset + type->element_offset(index), is_zero);
+            ++index;
+        } while (accept(","));
+        expect(close);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Top level
+// ---------------------------------------------------------------------------
+
+void IRParser::parse_global(IRGlobal &global) {
+    global.name = next().text;
+    expect("=");
+    while (peek().kind == Token::Kind::WORD && peek().text != "global" &&
+           peek().text != "constant") {
+        next();
+    }
+    global.is_constant = next().text == "constant";
+    global.type = parse_type();
+    global.align = global.type->align;
+    global.data.assign(global.type->size, 0);
+    global.is_zero = true;
+    parse_constant(global.type, global.data, 0, global.is_zero);
+    while (accept(",")) {
+        if (accept("align")) {
+            global.align = static_cast<size_t>(next().value);
+        } else {
+            next();
+        }
+    }
+}
+
+void IRParser::parse_function_header(IRFunction &function, bool is_definition) {
+    skip_attributes();
+    function.return_type = parse_type();
+    function.name = next().text;
+    function.is_declaration = !is_definition;
+    expect("(");
+    if (!accept(")")) {
+        do {
+            if (accept("...")) {
+                function.is_vararg = true;
+                break;
+            }
+            IRParam param;
+            param.type = parse_type();
+            skip_attributes();
+            if (peek().kind == Token::Kind::LOCAL) {
+                param.name = next().text;
+            }
+            function.params.push_back(param);
+        } while (accept(","));
+        expect(")");
+    }
+}
+
+void IRParser::parse_call(IRInstruction &instr) {
+    instr.opcode = IROpcode::CALL;
+    skip_attributes();
+    instr.type = parse_type();
+    if (peek().kind == Token::Kind::PUNCT && peek().text == "(") {
+        skip_parens(); // Function type of a vararg callee
+    }
+    Token callee = next();
+    if (callee.kind != Token::Kind::GLOBAL) {
+        fail("indirect calls are not supported");
+    }
+    instr.op = callee.text;
+    expect("(");
+    if (!accept(")")) {
+        do {
+            instr.operands.push_back(parse_typed_value());
+        } while (accept(","));
+        expect(")");
+    }
+}
+
+void IRParser::parse_instruction(IRInstruction &instr) {
+    if (peek().kind == Token::Kind::LOCAL && peek(1).text == "=") {
+        instr.result = next().text;
+        next();
+    }
+
+    Token opcode = next();
+    const std::string &name = opcode.text;
+
+    if (name == "alloca") {
+        instr.opcode = IROpcode::ALLOCA;
+        instr.type = parse_type();
+    } else if (name == "load") {
+        instr.opcode = IROpcode::LOAD;
+        accept("volatile");
+        instr.type = parse_type();
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+    } else if (name == "store") {
+        instr.opcode = IROpcode::STORE;
+        accept("volatile");
+        instr.operands.push_back(parse_typed_value());
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+    } else if (BINARY_OPS.count(name)) {
+        instr.opcode = IROpcode::BINARY;
+        instr.op = name;
+        while (accept("nsw") || accept("nuw") || accept("exact")) {
+        }
+        instr.type = parse_type();
+        instr.operands.push_back(parse_value(instr.type));
+        expect(",");
+        instr.operands.push_back(parse_value(instr.type));
+    } else if (name == "icmp") {
+        instr.opcode = IROpcode::ICMP;
+        instr.op = next().text;
+        const IRType *type = parse_type();
+        instr.operands.push_back(parse_value(type));
+        expect(",");
+        instr.operands.push_back(parse_value(type));
+        instr.type = type->is_vector() ? module_->vector_of(module_->int_type(1), type->count)
+                                       : module_->int_type(1);
+    } else if (CAST_OPS.count(name)) {
+        instr.opcode = IROpcode::CAST;
+        instr.op = name;
+        instr.operands.push_back(parse_typed_value());
+        expect("to");
+        instr.type = parse_type();
+    } else if (name == "getelementptr") {
+        instr.opcode = IROpcode::GEP;
+        accept("inbounds");
+        instr.source_type = parse_type();
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+        while (accept(",")) {
+            instr.operands.push_back(parse_typed_value());
+        }
+        // Result type: pointer to the type reached by the indices after the first
+        const IRType *type = instr.source_type;
+        for (size_t i = 2; i < instr.operands.size(); ++i) {
+            const IRValue &index = instr.operands[i];
+            if (type->kind == IRType::Kind::STRUCT) {
+                type = type->element_type(static_cast<size_t>(index.value));
+            } else {
+                type = type->element;
+            }
+        }
+        instr.type = module_->pointer_to(type);
+    } else if (name == "phi") {
+        instr.opcode = IROpcode::PHI;
+        instr.type = parse_type();
+        do {
+            expect("[");
+            instr.operands.push_back(parse_value(instr.type));
+            expect(",");
+            instr.labels.push_back(next().text);
+            expect("]");
+        } while (accept(","));
+    } else if (name == "call" || name == "tail" || name == "musttail" || name == "notail") {
+        if (name != "call") {
+            expect("call");
+        }
+        parse_call(instr);
+    } else if (name == "select") {
+        instr.opcode = IROpcode::SELECT;
+        instr.operands.push_back(parse_typed_value());
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+        instr.type = instr.operands[1].type;
+    } else if (name == "insertvalue" || name == "extractvalue") {
+        instr.opcode = name == "insertvalue" ? IROpcode::INSERT_VALUE : IROpcode::EXTRACT_VALUE;
+        instr.operands.push_back(parse_typed_value());
+        if (instr.opcode == IROpcode::INSERT_VALUE) {
+            expect(",");
+            instr.operands.push_back(parse_typed_value());
+        }
+        const IRType *type = instr.operands[0].type;
+        while (accept(",")) {
+            if (peek().kind != Token::Kind::INT) {
+                break;
+            }
+            int64_t index = next().value;
+            instr.indices.push_back(index);
+            type = type->element_type(static_cast<size_t>(index));
+        }
+        instr.type = instr.opcode == IROpcode::INSERT_VALUE ? instr.operands[0].type : type;
+    } else if (name == "insertelement") {
+        instr.opcode = IROpcode::INSERT_ELEMENT;
+        instr.operands.push_back(parse_typed_value());
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+        instr.type = instr.operands[0].type;
+    } else if (name == "shufflevector") {
+        instr.opcode = IROpcode::SHUFFLE_VECTOR;
+        instr.operands.push_back(parse_typed_value());
+        expect(",");
+        instr.operands.push_back(parse_typed_value());
+        expect(",");
+        IRValue mask = parse_typed_value();
+        for (size_t i = 0; i < mask.type->count; ++i) {
+            int64_t lane = 0;
+            if (mask.kind == IRValue::Kind::VECTOR) {
+                lane = mask.elements[i].kind == IRValue::Kind::INT ? mask.elements[i].value : 0;
+            }
+            instr.indices.push_back(lane);
+        }
+        instr.type = module_->vector_of(instr.operands[0].type->element, mask.type->count);
+    } else if (name == "ret") {
+        instr.opcode = IROpcode::RET;
+        if (!accept("void")) {
+            instr.operands.push_back(parse_typed_value());
+        }
+    } else if (name == "br") {
+        if (accept("label")) {
+            instr.opcode = IROpcode::BR;
+            instr.labels.push_back(next().text);
+        } else {
+            instr.opcode = IROpcode::COND_BR;
+            instr.operands.push_back(parse_typed_value());
+            expect(",");
+            expect("label");
+            instr.labels.push_back(next().text);
+            expect(",");
+            expect("label");
+            instr.labels.push_back(next().text);
+        }
+    } else if (name == "unreachable") {
+        instr.opcode = IROpcode::UNREACHABLE;
+    } else {
+        fail("unsupported instruction '" + name + "'");
+    }
+
+    if (!instr.type) {
+        instr.type = module_->void_type();
+    }
+}
+
+bool IRParser::parse(std::string_view text, IRModule &module) {
+    module_ = &module;
+    struct_bodies_.clear();
+    bool ok = true;
+
+    std::vector<std::string_view> lines;
+    for (size_t start = 0; start <= text.size();) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        lines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+
+    // Collect struct definitions first, they may be used before they are defined
+    for (size_t i = 0; i < lines.size(); ++i) {
+        tokenize(lines[i]);
+        if (peek().kind == Token::Kind::LOCAL && peek(1).text == "=" && peek(2).text == "type") {
+            size_t body = lines[i].find('{');
+            if (body != std::string_view::npos) {
+                struct_bodies_[peek().text] = std::string(lines[i].substr(body));
+            }
+        }
+    }
+
+    IRFunction *function = nullptr;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        line_ = static_cast<int>(i) + 1;
+        try {
+            tokenize(lines[i]);
+            if (at_end()) {
+                continue;
+            }
+            const Token &first = peek();
+
+            if (function) {
+                if (first.kind == Token::Kind::PUNCT && first.text == "}") {
+                    function = nullptr;
+                } else if (peek(1).text == ":" &&
+                           (first.kind == Token::Kind::WORD || first.kind == Token::Kind::INT)) {
+                    function->blocks.push_back({first.text, {}});
+                } else {
+                    if (function->blocks.empty()) {
+                        function->blocks.push_back({"", {}});
+                    }
+                    IRInstruction instr;
+                    instr.line = line_;
+                    parse_instruction(instr);
+                    function->blocks.back().instructions.push_back(std::move(instr));
+                }
+                continue;
+            }
+
+            if (first.kind == Token::Kind::LOCAL && peek(1).text == "=") {
+                resolve_struct(first.text);
+            } else if (first.kind == Token::Kind::GLOBAL) {
+                IRGlobal global;
+                parse_global(global);
+                module.globals.push_back(std::move(global));
+            } else if (first.kind == Token::Kind::WORD &&
+                       (first.text == "declare" || first.text == "define")) {
+                next();
+                IRFunction parsed;
+                parse_function_header(parsed, first.text == "define");
+                module.functions.push_back(std::move(parsed));
+                if (!module.functions.back().is_declaration) {
+                    function = &module.functions.back();
+                }
+            }
+            // target, source_filename, attributes and metadata lines are ignored
+        } catch (const ParseError &error) {
+            error_reporter_.report_error("IR parse error: " + error.message, line_);
+            ok = false;
+        }
+    }
+    return ok;
+}
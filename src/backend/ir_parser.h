@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../error/error.h"
+#include "ir_module.h"
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * IRParser - Parses the LLVM IR text produced by IRGenerator
+ *
+ * Core responsibilities:
+ * 1. Read struct type definitions, globals, declarations and definitions
+ * 2. Resolve named struct types regardless of definition order
+ * 3. Flatten global initializers to bytes
+ *
+ * Supported subset (everything IREmitter emits):
+ * - Types: void, iN, pointers, arrays, vectors, literal and named structs
+ * - Instructions: alloca, load, store, binary operators, icmp, zext/sext/
+ *   trunc/bitcast, getelementptr, phi, call, select, insertvalue,
+ *   extractvalue, insertelement, shufflevector, ret, br, unreachable
+ * - Constants: integers, true/false, null, undef, zeroinitializer,
+ *   constant vectors, c"..." strings, array and struct initializers
+ *
+ * Ignored: comments, target/source_filename lines, attribute groups,
+ * function/parameter attributes, alignment and metadata attachments.
+ *
+ * Example:
+ *   ErrorReporter errors;
+ *   IRModule module;
+ *   if (IRParser(errors).parse(llvm_ir, module)) { ... }
+ */
+class IRParser {
+  public:
+    explicit IRParser(ErrorReporter &error_reporter) : error_reporter_(error_reporter) {}
+
+    /**
+     * Parse a module
+     * @param text LLVM IR text
+     * @param module Receives types, globals and functions
+     * @return false if any line could not be parsed (errors are reported)
+     */
+    bool parse(std::string_view text, IRModule &module);
+
+  private:
+    struct Token {
+        enum class Kind { LOCAL, GLOBAL, INT, WORD, STRING, METADATA, PUNCT, END };
+        Kind kind = Kind::END;
+        std::string text; // Name without sigil, word, decoded string or punctuation
+        int64_t value = 0;
+    };
+
+    ErrorReporter &error_reporter_;
+    IRModule *module_ = nullptr;
+    std::vector<Token> tokens_;
+    size_t pos_ = 0;
+    int line_ = 0;
+
+    // Named struct bodies by name, resolved on first use
+    std::map<std::string, std::string> struct_bodies_;
+    std::map<std::string, int> struct_lines_;
+
+    void tokenize(std::string_view line);
+    const Token &peek(size_t offset = 0) const;
+    Token next();
+    bool accept(const std::string &punct_or_word);
+    void expect(const std::string &punct_or_word);
+    bool at_end() const;
+    [[noreturn]] void fail(const std::string &message) const;
+
+    void resolve_struct(const std::string &name);
+    const IRType *parse_type();
+    void skip_attributes();
+    void skip_parens();
+    IRValue parse_value(const IRType *type);
+    IRValue parse_typed_value();
+    void parse_constant(const IRType *type, std::vector<uint8_t> &data, size_t offset,
+                        bool &is_zero);
+
+    void parse_global(IRGlobal &global);
+    void parse_function_header(IRFunction &function, bool is_definition);
+    void parse_instruction(IRInstruction &instr);
+    void parse_call(IRInstruction &instr);
+};
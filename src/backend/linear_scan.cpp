@@ -0,0 +1,63 @@
+#include "linear_scan.h"
+
+#include <algorithm>
+#include <set>
+
+void LinearScan::allocate(std::vector<LiveInterval> &intervals) const {
+    std::vector<LiveInterval *> order;
+    for (auto &interval : intervals) {
+        interval.reg = -1;
+        order.push_back(&interval);
+    }
+    std::sort(order.begin(), order.end(), [](const LiveInterval *a, const LiveInterval *b) {
+        return a->start != b->start ? a->start < b->start : a->vreg < b->vreg;
+    });
+
+    auto by_end = [](const LiveInterval *a, const LiveInterval *b) {
+        return a->end != b->end ? a->end < b->end : a->vreg < b->vreg;
+    };
+    std::set<LiveInterval *, decltype(by_end)> active(by_end);
+    std::set<int> used;
+
+    for (LiveInterval *current : order) {
+        // Expire intervals that end at or before the current start
+        while (!active.empty() && (*active.begin())->end <= current->start) {
+            used.erase((*active.begin())->reg);
+            active.erase(active.begin());
+        }
+
+        std::vector<int> pool = callee_saved_;
+        if (!current->crosses_call) {
+            pool.insert(pool.begin(), caller_saved_.begin(), caller_saved_.end());
+        }
+
+        int free_reg = -1;
+        for (int reg : pool) {
+            if (!used.count(reg)) {
+                free_reg = reg;
+                break;
+            }
+        }
+        if (free_reg >= 0) {
+            current->reg = free_reg;
+            used.insert(free_reg);
+            active.insert(current);
+            continue;
+        }
+
+        // Spill the active interval with the furthest end whose register fits
+        LiveInterval *victim = nullptr;
+        for (auto it = active.rbegin(); it != active.rend(); ++it) {
+            if (std::find(pool.begin(), pool.end(), (*it)->reg) != pool.end()) {
+                victim = *it;
+                break;
+            }
+        }
+        if (victim && victim->end > current->end) {
+            current->reg = victim->reg;
+            victim->reg = -1;
+            active.erase(victim);
+            active.insert(current);
+        }
+    }
+}
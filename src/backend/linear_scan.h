@@ -0,0 +1,50 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+/**
+ * LiveInterval - Lifetime of one virtual register
+ *
+ * Positions are instruction numbers. A value is live from its first
+ * definition to its last use (a single range, holes are not tracked).
+ */
+struct LiveInterval {
+    int vreg = -1;
+    int start = 0;
+    int end = 0;
+    bool crosses_call = false; // A call lies strictly between start and end
+
+    int reg = -1; // Assigned register, -1 if spilled
+};
+
+/**
+ * LinearScan - Linear-scan register allocation (Poletto & Sarkar)
+ *
+ * Core responsibilities:
+ * 1. Visit intervals by increasing start, keeping the active ones sorted by end
+ * 2. Free the registers of intervals that ended
+ * 3. When no register is free, spill the interval that ends furthest away
+ *
+ * Register classes:
+ * - Intervals that cross a call only get callee-saved registers
+ * - Other intervals prefer caller-saved registers, which cost nothing to use
+ *
+ * An interval ending at the position where another starts may share its
+ * register: instruction selection reads every operand before writing the
+ * result.
+ */
+class LinearScan {
+  public:
+    LinearScan(std::vector<int> caller_saved, std::vector<int> callee_saved)
+        : caller_saved_(std::move(caller_saved)), callee_saved_(std::move(callee_saved)) {}
+
+    /**
+     * Assign registers, setting `reg` of every interval (-1 when spilled)
+     */
+    void allocate(std::vector<LiveInterval> &intervals) const;
+
+  private:
+    std::vector<int> caller_saved_;
+    std::vector<int> callee_saved_;
+};
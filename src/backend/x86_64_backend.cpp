@@ -0,0 +1,883 @@
+#include "x86_64_backend.h"
+
+#include <algorithm>
+#include <climits>
+#include <set>
+
+namespace {
+
+const X86Reg ARGUMENT_REGS[] = {X86Reg::RDI, X86Reg::RSI, X86Reg::RDX,
+                                X86Reg::RCX, X86Reg::R8,  X86Reg::R9};
+constexpr int ARGUMENT_REG_COUNT = 6;
+
+int64_t align_up(int64_t value, int64_t align) { return (value + align - 1) / align * align; }
+
+/**
+ * Bit set over virtual registers, for the liveness dataflow
+ */
+class VRegSet {
+  public:
+    explicit VRegSet(size_t size = 0) : words_((size + 63) / 64, 0) {}
+
+    void insert(int vreg) { words_[vreg / 64] |= uint64_t(1) << (vreg % 64); }
+    void erase(int vreg) { words_[vreg / 64] &= ~(uint64_t(1) << (vreg % 64)); }
+    bool contains(int vreg) const { return (words_[vreg / 64] >> (vreg % 64)) & 1; }
+
+    // this |= other, returns true if this changed
+    bool unite(const VRegSet &other) {
+        bool changed = false;
+        for (size_t i = 0; i < words_.size(); ++i) {
+            uint64_t merged = words_[i] | other.words_[i];
+            changed = changed || merged != words_[i];
+            words_[i] = merged;
+        }
+        return changed;
+    }
+
+    // this = gen | (out & ~kill)
+    bool assign_transfer(const VRegSet &gen, const VRegSet &out, const VRegSet &kill) {
+        bool changed = false;
+        for (size_t i = 0; i < words_.size(); ++i) {
+            uint64_t value = gen.words_[i] | (out.words_[i] & ~kill.words_[i]);
+            changed = changed || value != words_[i];
+            words_[i] = value;
+        }
+        return changed;
+    }
+
+    template <typename F> void for_each(F f) const {
+        for (size_t i = 0; i < words_.size(); ++i) {
+            uint64_t word = words_[i];
+            while (word) {
+                int bit = __builtin_ctzll(word);
+                f(static_cast<int>(i * 64 + bit));
+                word &= word - 1;
+            }
+        }
+    }
+
+  private:
+    std::vector<uint64_t> words_;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Module
+// ---------------------------------------------------------------------------
+
+bool X86Backend::generate(std::string &assembly) {
+    out_.str("");
+    out_.clear();
+    try {
+        out_ << "\t.text\n";
+        int index = 0;
+        for (const auto &function : module_.functions) {
+            if (!function.is_declaration) {
+                lower_function(function, index++);
+            }
+        }
+        emit_globals();
+        out_ << "\t.section\t.note.GNU-stack,\"\",@progbits\n";
+    } catch (const Unsupported &error) {
+        error_reporter_.report_error("x86-64 backend: " + error.message);
+        return false;
+    }
+    assembly = out_.str();
+    return true;
+}
+
+std::string X86Backend::symbol_name(const std::string &ir_name) {
+    // Private IR globals (.str.int) become assembler-local labels
+    return ir_name.empty() || ir_name[0] != '.' ? ir_name : ".L" + ir_name;
+}
+
+void X86Backend::emit_globals() {
+    for (const auto &global : module_.globals) {
+        std::string name = symbol_name(global.name);
+        size_t size = global.data.size();
+        bool in_bss = global.is_zero && !global.is_constant;
+
+        out_ << "\t"
+             << (global.is_constant ? ".section\t.rodata" : in_bss ? ".bss" : ".data") << "\n";
+        int log2_align = 0;
+        while ((size_t(1) << (log2_align + 1)) <= global.align) {
+            ++log2_align;
+        }
+        out_ << "\t.p2align\t" << log2_align << "\n";
+        out_ << "\t.type\t" << name << ",@object\n";
+        out_ << name << ":\n";
+
+        if (in_bss || size == 0) {
+            out_ << "\t.zero\t" << std::max<size_t>(size, 1) << "\n";
+        } else {
+            // Runs of zeros as .zero, everything else as .byte lines
+            size_t i = 0;
+            while (i < size) {
+                size_t zeros = 0;
+                while (i + zeros < size && global.data[i + zeros] == 0) {
+                    ++zeros;
+                }
+                if (zeros >= 8 || i + zeros == size) {
+                    if (zeros > 0) {
+                        out_ << "\t.zero\t" << zeros << "\n";
+                    }
+                    i += zeros;
+                    continue;
+                }
+                out_ << "\t.byte\t";
+                size_t end = std::min(size, i + 16);
+                for (size_t j = i; j < end; ++j) {
+                    out_ << (j > i ? "," : "") << static_cast<int>(global.data[j]);
+                }
+                out_ << "\n";
+                i = end;
+            }
+        }
+        out_ << "\t.size\t" << name << ", " << std::max<size_t>(size, 1) << "\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Functions
+// ---------------------------------------------------------------------------
+
+std::string X86Backend::block_label(int index) const {
+    return ".LBB" + std::to_string(function_index_) + "_" + std::to_string(index);
+}
+
+std::string X86Backend::fallthrough_label() const {
+    if (current_block_ < 0) {
+        return "";
+    }
+    for (size_t b = current_block_ + 1; b < function_->blocks.size(); ++b) {
+        if (forward_[b] == static_cast<int>(b)) {
+            return block_label(static_cast<int>(b));
+        }
+    }
+    return "";
+}
+
+bool X86Backend::returns_in_memory(const IRType *type) const {
+    return (type->is_aggregate() || type->is_vector()) && type->size > 16;
+}
+
+bool X86Backend::lowers_to_call(const IRInstruction &instr) const {
+    auto is_large = [](const IRType *type) {
+        return (type->is_aggregate() || type->is_vector()) && type->size > INLINE_COPY_LIMIT;
+    };
+
+    switch (instr.opcode) {
+    case IROpcode::CALL:
+        if (instr.op.rfind("llvm.lifetime.", 0) == 0) {
+            return false;
+        }
+        if (instr.op.rfind("llvm.memcpy.", 0) == 0 || instr.op.rfind("llvm.memset.", 0) == 0) {
+            const IRValue &length = instr.operands.at(2);
+            bool inline_fill = instr.op.rfind("llvm.memset.", 0) != 0 ||
+                               instr.operands.at(1).kind == IRValue::Kind::INT;
+            return !(length.kind == IRValue::Kind::INT && inline_fill &&
+                     static_cast<size_t>(length.value) <= INLINE_COPY_LIMIT);
+        }
+        return true;
+    case IROpcode::LOAD:
+    case IROpcode::INSERT_VALUE:
+    case IROpcode::EXTRACT_VALUE:
+        return is_large(instr.type);
+    case IROpcode::STORE:
+        return is_large(instr.operands.at(0).type);
+    case IROpcode::RET:
+        return !instr.operands.empty() && returns_in_memory(instr.operands[0].type) &&
+               is_large(instr.operands[0].type);
+    default:
+        return false;
+    }
+}
+
+void X86Backend::unsupported(const IRInstruction &instr, const std::string &what) const {
+    throw Unsupported{what + " (function @" + function_->name + ", IR line " +
+                      std::to_string(instr.line) + ")"};
+}
+
+int64_t X86Backend::allocate_slot(size_t size, size_t align) {
+    align = std::clamp<size_t>(align, 1, 16);
+    frame_depth_ = align_up(frame_depth_ + static_cast<int64_t>(std::max<size_t>(size, 1)),
+                            static_cast<int64_t>(align));
+    return frame_depth_;
+}
+
+int X86Backend::new_vreg(const IRType *type) {
+    VReg vreg;
+    vreg.type = type;
+    vreg.interval.vreg = static_cast<int>(vregs_.size());
+    vreg.interval.start = INT_MAX;
+    vreg.interval.end = INT_MIN;
+    vregs_.push_back(vreg);
+    return vreg.interval.vreg;
+}
+
+void X86Backend::lower_function(const IRFunction &function, int index) {
+    function_ = &function;
+    function_index_ = index;
+    values_.clear();
+    use_counts_.clear();
+    vregs_.clear();
+    param_vregs_.clear();
+    successors_.clear();
+    positions_.clear();
+    call_positions_.clear();
+    edge_labels_.clear();
+    used_callee_saved_.clear();
+    frame_depth_ = 0;
+    callee_save_bytes_ = 0;
+    outgoing_bytes_ = 0;
+    sret_depth_ = -1;
+
+    classify_values();
+    allocate_registers();
+
+    std::string name = symbol_name(function.name);
+    out_ << "\n\t.p2align\t4\n";
+    if (function.name == "main") {
+        out_ << "\t.globl\tmain\n";
+    }
+    out_ << "\t.type\t" << name << ",@function\n";
+    out_ << name << ":\n";
+
+    emit_prologue();
+    for (size_t b = 0; b < function.blocks.size(); ++b) {
+        if (forward_[b] == static_cast<int>(b)) {
+            emit_block(static_cast<int>(b));
+        }
+    }
+    for (const auto &[edge, label] : edge_labels_) {
+        out_ << label << ":\n";
+        current_block_ = -1;
+        emit_phi_copies(edge.first, edge.second);
+        select_br(block_label(edge.second));
+    }
+    out_ << "\t.size\t" << name << ", .-" << name << "\n";
+}
+
+/**
+ * Decide where every IR local lives, see ValueLoc
+ */
+void X86Backend::classify_values() {
+    const IRFunction &function = *function_;
+    using Kind = ValueLoc::Kind;
+
+    for (const auto &block : function.blocks) {
+        for (const auto &instr : block.instructions) {
+            for (const auto &operand : instr.operands) {
+                if (operand.is_local()) {
+                    ++use_counts_[operand.name];
+                }
+            }
+        }
+    }
+
+    // Trampolines: a lone `br` into a block without phis
+    forward_.assign(function.blocks.size(), -1);
+    auto is_trampoline = [&](size_t b) {
+        const auto &instructions = function.blocks[b].instructions;
+        if (b == 0 || instructions.size() != 1 || instructions[0].opcode != IROpcode::BR) {
+            return false;
+        }
+        int target = function.block_index(instructions[0].labels[0]);
+        const auto &target_instrs = function.blocks[target].instructions;
+        return target_instrs.empty() || target_instrs[0].opcode != IROpcode::PHI;
+    };
+    for (size_t b = 0; b < function.blocks.size(); ++b) {
+        size_t current = b;
+        size_t steps = 0;
+        while (is_trampoline(current) && steps++ < function.blocks.size()) {
+            current = function.block_index(function.blocks[current].instructions[0].labels[0]);
+        }
+        // A cycle of trampolines is an infinite loop, keep its blocks
+        forward_[b] = steps > function.blocks.size() ? static_cast<int>(b)
+                                                      : static_cast<int>(current);
+    }
+
+    // Successors, and conditional edges into blocks with phis
+    for (size_t b = 0; b < function.blocks.size(); ++b) {
+        successors_.emplace_back();
+        const auto &instructions = function.blocks[b].instructions;
+        if (instructions.empty()) {
+            continue;
+        }
+        const IRInstruction &terminator = instructions.back();
+        for (const auto &label : terminator.labels) {
+            int target = function.block_index(label);
+            if (target < 0) {
+                unsupported(terminator, "branch to unknown block %" + label);
+            }
+            successors_[b].push_back(target);
+            const auto &target_instrs = function.blocks[target].instructions;
+            bool has_phi = !target_instrs.empty() && target_instrs[0].opcode == IROpcode::PHI;
+            if (terminator.opcode == IROpcode::COND_BR && has_phi) {
+                edge_labels_[{static_cast<int>(b), target}] =
+                    block_label(static_cast<int>(b)) + "_" + std::to_string(target);
+            }
+        }
+    }
+
+    if (returns_in_memory(function.return_type)) {
+        sret_depth_ = allocate_slot(8, 8);
+    }
+    for (const auto &param : function.params) {
+        if (!param.type->is_scalar()) {
+            throw Unsupported{"aggregate parameter %" + param.name + " of @" + function.name};
+        }
+        int vreg = -1;
+        if (use_counts_[param.name] > 0) {
+            vreg = new_vreg(param.type);
+            values_[param.name] = {Kind::VREG, vreg, 0, ""};
+        }
+        param_vregs_.push_back(vreg);
+    }
+
+    // Aggregates whose slot belongs to them alone (may be updated in place)
+    std::set<std::string> owns_slot;
+
+    auto memory_slot = [&](const IRType *type) {
+        size_t size = align_up(static_cast<int64_t>(std::max<size_t>(type->size, 1)), 8);
+        return allocate_slot(size, std::max<size_t>(type->align, 8));
+    };
+
+    auto truncate = [](int64_t value, unsigned bits, bool sign_extend) {
+        if (bits >= 64) {
+            return value;
+        }
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        uint64_t truncated = static_cast<uint64_t>(value) & mask;
+        if (sign_extend && bits > 1 && (truncated >> (bits - 1)) & 1) {
+            truncated |= ~mask;
+        }
+        return static_cast<int64_t>(truncated);
+    };
+
+    for (const auto &block : function.blocks) {
+        for (size_t i = 0; i < block.instructions.size(); ++i) {
+            const IRInstruction &instr = block.instructions[i];
+            if (instr.result.empty()) {
+                continue;
+            }
+            ValueLoc loc;
+            const IRType *type = instr.type;
+            bool in_memory = type->is_aggregate() || type->is_vector();
+
+            auto operand_loc = [&](const IRValue &value) -> ValueLoc {
+                if (value.kind == IRValue::Kind::GLOBAL) {
+                    return {Kind::SYMBOL, -1, 0, symbol_name(value.name)};
+                }
+                if (value.kind == IRValue::Kind::INT) {
+                    return {Kind::CONST, -1, value.value, ""};
+                }
+                if (value.is_local()) {
+                    auto it = values_.find(value.name);
+                    if (it != values_.end()) {
+                        return it->second;
+                    }
+                }
+                return {};
+            };
+
+            switch (instr.opcode) {
+            case IROpcode::ALLOCA:
+                loc = {Kind::FRAME, -1, allocate_slot(type->size, type->align), ""};
+                break;
+
+            case IROpcode::CAST: {
+                ValueLoc source = operand_loc(instr.operands[0]);
+                unsigned from_bits = instr.operands[0].type->bits;
+                if (source.kind == Kind::CONST) {
+                    if (instr.op == "zext") {
+                        source.offset = truncate(source.offset, from_bits, false);
+                    } else if (instr.op == "sext") {
+                        source.offset = from_bits == 1 ? -(source.offset & 1)
+                                                       : truncate(source.offset, from_bits, true);
+                    } else if (instr.op == "trunc") {
+                        source.offset = truncate(source.offset, type->bits, true);
+                    }
+                    loc = source;
+                } else if ((instr.op == "bitcast" || instr.op == "ptrtoint" ||
+                            instr.op == "inttoptr" || (instr.op == "trunc" && type->bits > 1)) &&
+                           (source.kind == Kind::VREG || source.kind == Kind::FRAME ||
+                            source.kind == Kind::SYMBOL || source.kind == Kind::MEMORY)) {
+                    // Same bits, narrower view
+                    loc = source;
+                }
+                break;
+            }
+
+            case IROpcode::GEP: {
+                ValueLoc base = operand_loc(instr.operands[0]);
+                if (base.kind != Kind::FRAME && base.kind != Kind::SYMBOL) {
+                    break;
+                }
+                int64_t offset = 0;
+                const IRType *current = instr.source_type;
+                bool constant = true;
+                for (size_t k = 1; k < instr.operands.size() && constant; ++k) {
+                    const IRValue &index = instr.operands[k];
+                    if (index.kind != IRValue::Kind::INT) {
+                        constant = false;
+                        break;
+                    }
+                    if (k == 1) {
+                        offset += index.value * static_cast<int64_t>(current->size);
+                    } else {
+                        offset += static_cast<int64_t>(
+                            current->element_offset(static_cast<size_t>(index.value)));
+                        current = current->element_type(static_cast<size_t>(index.value));
+                    }
+                }
+                if (constant) {
+                    loc = base;
+                    // FRAME offsets are depths below the frame base
+                    loc.offset += base.kind == Kind::FRAME ? -offset : offset;
+                }
+                break;
+            }
+
+            case IROpcode::ICMP: {
+                const IRInstruction *next =
+                    i + 1 < block.instructions.size() ? &block.instructions[i + 1] : nullptr;
+                if (!type->is_vector() && use_counts_[instr.result] == 1 && next &&
+                    next->opcode == IROpcode::COND_BR && next->operands[0].is_local() &&
+                    next->operands[0].name == instr.result) {
+                    loc.kind = Kind::FUSED;
+                }
+                break;
+            }
+
+            case IROpcode::INSERT_VALUE:
+            case IROpcode::INSERT_ELEMENT: {
+                const IRValue &source = instr.operands[0];
+                if (source.is_local() && owns_slot.count(source.name) &&
+                    use_counts_[source.name] == 1) {
+                    loc = values_[source.name];
+                    owns_slot.insert(instr.result);
+                }
+                break;
+            }
+
+            case IROpcode::EXTRACT_VALUE: {
+                ValueLoc source = operand_loc(instr.operands[0]);
+                if (in_memory && source.kind == Kind::MEMORY) {
+                    const IRType *current = instr.operands[0].type;
+                    int64_t offset = 0;
+                    for (int64_t index : instr.indices) {
+                        offset += static_cast<int64_t>(
+                            current->element_offset(static_cast<size_t>(index)));
+                        current = current->element_type(static_cast<size_t>(index));
+                    }
+                    loc = source;
+                    loc.offset -= offset;
+                }
+                break;
+            }
+
+            case IROpcode::PHI:
+            case IROpcode::SELECT:
+                if (in_memory) {
+                    unsupported(instr, "aggregate " +
+                                           std::string(instr.opcode == IROpcode::PHI ? "phi"
+                                                                                     : "select"));
+                }
+                break;
+
+            default:
+                break;
+            }
+
+            if (loc.kind == Kind::NONE) {
+                if (in_memory) {
+                    loc = {Kind::MEMORY, -1, memory_slot(type), ""};
+                    owns_slot.insert(instr.result);
+                } else {
+                    loc = {Kind::VREG, new_vreg(type), 0, ""};
+                }
+            }
+            values_[instr.result] = loc;
+        }
+    }
+}
+
+/**
+ * Number instructions, compute liveness intervals and run LinearScan
+ *
+ * Positions: parameters are defined at 0, instruction k of the function at
+ * 2k + 2. Phi copies into the successors of a block happen at the position
+ * just before its terminator.
+ */
+void X86Backend::allocate_registers() {
+    const IRFunction &function = *function_;
+    size_t block_count = function.blocks.size();
+    size_t vreg_count = vregs_.size();
+
+    auto vreg_of = [&](const IRValue &value) {
+        if (!value.is_local()) {
+            return -1;
+        }
+        auto it = values_.find(value.name);
+        return it != values_.end() && it->second.kind == ValueLoc::Kind::VREG ? it->second.vreg
+                                                                              : -1;
+    };
+
+    int position = 2;
+    for (const auto &block : function.blocks) {
+        positions_.emplace_back();
+        for (const auto &instr : block.instructions) {
+            positions_.back().push_back(position);
+            if (lowers_to_call(instr)) {
+                call_positions_.push_back(position);
+            }
+            position += 2;
+        }
+    }
+
+    auto use = [&](int vreg, int pos) {
+        VReg &info = vregs_[vreg];
+        info.interval.end = std::max(info.interval.end, pos);
+        info.interval.start = std::min(info.interval.start, pos);
+    };
+    auto def = [&](int vreg, int pos) {
+        VReg &info = vregs_[vreg];
+        info.interval.start = std::min(info.interval.start, pos);
+        info.interval.end = std::max(info.interval.end, pos);
+    };
+
+    std::vector<VRegSet> gen(block_count, VRegSet(vreg_count));
+    std::vector<VRegSet> kill(block_count, VRegSet(vreg_count));
+    std::vector<VRegSet> live_in(block_count, VRegSet(vreg_count));
+    std::vector<VRegSet> live_out(block_count, VRegSet(vreg_count));
+
+    for (int vreg : param_vregs_) {
+        if (vreg >= 0) {
+            def(vreg, 0);
+        }
+    }
+
+    for (size_t b = 0; b < block_count; ++b) {
+        const IRBlock &block = function.blocks[b];
+        auto record_use = [&](int vreg, int pos) {
+            if (vreg < 0) {
+                return;
+            }
+            if (!kill[b].contains(vreg)) {
+                gen[b].insert(vreg);
+            }
+            use(vreg, pos);
+        };
+        auto record_def = [&](int vreg, int pos) {
+            if (vreg < 0) {
+                return;
+            }
+            kill[b].insert(vreg);
+            def(vreg, pos);
+        };
+
+        const IRInstruction *fused = nullptr;
+        for (size_t i = 0; i < block.instructions.size(); ++i) {
+            const IRInstruction &instr = block.instructions[i];
+            int pos = positions_[b][i];
+            if (instr.opcode == IROpcode::PHI) {
+                continue;
+            }
+
+            if (instr.is_terminator()) {
+                // Phi copies into successors
+                for (int succ : successors_[b]) {
+                    for (const auto &phi : function.blocks[succ].instructions) {
+                        if (phi.opcode != IROpcode::PHI) {
+                            break;
+                        }
+                        for (size_t k = 0; k < phi.labels.size(); ++k) {
+                            if (phi.labels[k] == block.label) {
+                                record_use(vreg_of(phi.operands[k]), pos - 1);
+                            }
+                        }
+                    }
+                    for (const auto &phi : function.blocks[succ].instructions) {
+                        if (phi.opcode != IROpcode::PHI) {
+                            break;
+                        }
+                        record_def(values_[phi.result].vreg, pos - 1);
+                    }
+                }
+                if (fused) {
+                    for (const auto &operand : fused->operands) {
+                        record_use(vreg_of(operand), pos);
+                    }
+                } else {
+                    for (const auto &operand : instr.operands) {
+                        record_use(vreg_of(operand), pos);
+                    }
+                }
+                continue;
+            }
+
+            if (!instr.result.empty() && values_[instr.result].kind == ValueLoc::Kind::FUSED) {
+                fused = &instr;
+                continue;
+            }
+            for (const auto &operand : instr.operands) {
+                record_use(vreg_of(operand), pos);
+            }
+            if (!instr.result.empty()) {
+                const ValueLoc &loc = values_[instr.result];
+                // Aliases (bitcast/trunc) share the vreg of their operand
+                int source = instr.operands.empty() ? -1 : vreg_of(instr.operands[0]);
+                if (loc.kind == ValueLoc::Kind::VREG && loc.vreg != source) {
+                    record_def(loc.vreg, pos);
+                }
+            }
+        }
+    }
+
+    // Backward liveness dataflow
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = block_count; b-- > 0;) {
+            for (int succ : successors_[b]) {
+                live_out[b].unite(live_in[succ]);
+            }
+            changed = live_in[b].assign_transfer(gen[b], live_out[b], kill[b]) || changed;
+        }
+    }
+
+    for (size_t b = 0; b < block_count; ++b) {
+        if (positions_[b].empty()) {
+            continue;
+        }
+        int block_start = positions_[b].front() - 1;
+        int block_end = positions_[b].back();
+        live_in[b].for_each([&](int vreg) { use(vreg, block_start); });
+        live_out[b].for_each([&](int vreg) { use(vreg, block_end); });
+    }
+
+    std::vector<LiveInterval> intervals;
+    for (auto &vreg : vregs_) {
+        LiveInterval &interval = vreg.interval;
+        if (interval.start > interval.end) {
+            interval.start = interval.end = 0;
+        }
+        auto call = std::upper_bound(call_positions_.begin(), call_positions_.end(),
+                                     interval.start);
+        interval.crosses_call = call != call_positions_.end() && *call < interval.end;
+        intervals.push_back(interval);
+    }
+
+    LinearScan allocator({static_cast<int>(X86Reg::RSI), static_cast<int>(X86Reg::RDI),
+                          static_cast<int>(X86Reg::R8), static_cast<int>(X86Reg::R9)},
+                         {static_cast<int>(X86Reg::RBX), static_cast<int>(X86Reg::R12),
+                          static_cast<int>(X86Reg::R13), static_cast<int>(X86Reg::R14),
+                          static_cast<int>(X86Reg::R15)});
+    allocator.allocate(intervals);
+
+    std::set<int> callee_saved;
+    for (const auto &interval : intervals) {
+        VReg &vreg = vregs_[interval.vreg];
+        vreg.interval.reg = interval.reg;
+        if (interval.reg < 0) {
+            vreg.spill_depth = allocate_slot(8, 8);
+        } else if (interval.reg == static_cast<int>(X86Reg::RBX) ||
+                   interval.reg >= static_cast<int>(X86Reg::R12)) {
+            callee_saved.insert(interval.reg);
+        }
+    }
+    for (int reg : callee_saved) {
+        used_callee_saved_.push_back(static_cast<X86Reg>(reg));
+    }
+    callee_save_bytes_ = align_up(8 * static_cast<int64_t>(used_callee_saved_.size()), 16);
+
+    // Outgoing stack arguments
+    for (const auto &block : function.blocks) {
+        for (const auto &instr : block.instructions) {
+            if (instr.opcode == IROpcode::CALL) {
+                int64_t count = static_cast<int64_t>(instr.operands.size()) +
+                                (returns_in_memory(instr.type) ? 1 : 0);
+                outgoing_bytes_ =
+                    std::max(outgoing_bytes_, 8 * std::max<int64_t>(0, count - ARGUMENT_REG_COUNT));
+            }
+        }
+    }
+}
+
+void X86Backend::emit_prologue() {
+    int64_t frame_size = align_up(callee_save_bytes_ + frame_depth_ + outgoing_bytes_, 16);
+    emit("pushq %rbp");
+    emit("movq %rsp, %rbp");
+    if (frame_size > 0) {
+        emit("subq $" + std::to_string(frame_size) + ", %rsp");
+    }
+    for (size_t i = 0; i < used_callee_saved_.size(); ++i) {
+        emit("movq " + reg_name(used_callee_saved_[i], 8) + ", " +
+             std::to_string(-8 * static_cast<int64_t>(i + 1)) + "(%rbp)");
+    }
+
+    // Incoming arguments to their homes
+    std::vector<Move> moves;
+    int abi_index = 0;
+    auto incoming = [&](int index) {
+        Operand operand;
+        if (index < ARGUMENT_REG_COUNT) {
+            operand.kind = Operand::Kind::REG;
+            operand.reg = ARGUMENT_REGS[index];
+        } else {
+            operand.kind = Operand::Kind::MEM;
+            operand.mem = std::to_string(16 + 8 * (index - ARGUMENT_REG_COUNT)) + "(%rbp)";
+        }
+        return operand;
+    };
+    if (sret_depth_ >= 0) {
+        Operand home;
+        home.kind = Operand::Kind::MEM;
+        home.mem = std::to_string(frame_offset(sret_depth_)) + "(%rbp)";
+        moves.push_back({home, incoming(abi_index++)});
+    }
+    for (int vreg : param_vregs_) {
+        int index = abi_index++;
+        if (vreg >= 0) {
+            moves.push_back({vreg_operand(vreg), incoming(index)});
+        }
+    }
+    emit_parallel_moves(moves);
+}
+
+void X86Backend::emit_epilogue() {
+    for (size_t i = 0; i < used_callee_saved_.size(); ++i) {
+        emit("movq " + std::to_string(-8 * static_cast<int64_t>(i + 1)) + "(%rbp), " +
+             reg_name(used_callee_saved_[i], 8));
+    }
+    emit("leave");
+    emit("ret");
+}
+
+void X86Backend::emit_block(int index) {
+    current_block_ = index;
+    const IRBlock &block = function_->blocks[index];
+    out_ << block_label(index) << ":\n";
+
+    const IRInstruction *fused = nullptr;
+    for (const auto &instr : block.instructions) {
+        switch (instr.opcode) {
+        case IROpcode::PHI:
+            break;
+        case IROpcode::BR: {
+            int target = function_->block_index(instr.labels[0]);
+            emit_phi_copies(index, target);
+            select_br(block_label(forward_[target]));
+            break;
+        }
+        case IROpcode::COND_BR:
+            select_cond_br(instr, fused);
+            break;
+        case IROpcode::RET:
+            select_ret(instr);
+            break;
+        case IROpcode::UNREACHABLE:
+            emit("ud2");
+            break;
+        default:
+            if (!instr.result.empty() && values_[instr.result].kind == ValueLoc::Kind::FUSED) {
+                fused = &instr;
+            } else {
+                select(instr);
+            }
+            break;
+        }
+    }
+}
+
+void X86Backend::emit_phi_copies(int pred, int succ) {
+    const std::string &pred_label = function_->blocks[pred].label;
+    std::vector<Move> moves;
+    for (const auto &phi : function_->blocks[succ].instructions) {
+        if (phi.opcode != IROpcode::PHI) {
+            break;
+        }
+        for (size_t k = 0; k < phi.labels.size(); ++k) {
+            if (phi.labels[k] == pred_label) {
+                moves.push_back({vreg_operand(values_[phi.result].vreg),
+                                 value_operand(phi.operands[k])});
+                break;
+            }
+        }
+    }
+    emit_parallel_moves(moves);
+}
+
+/**
+ * Perform moves that conceptually happen at the same time
+ *
+ * A move is emitted once no other pending move still reads its destination.
+ * When only cycles remain, one destination is saved to r11 and its readers
+ * are redirected there. Memory-to-memory moves go through rax.
+ */
+void X86Backend::emit_parallel_moves(std::vector<Move> moves) {
+    auto key = [](const Operand &operand) -> std::string {
+        if (operand.kind == Operand::Kind::REG) {
+            return reg_name(operand.reg, 8);
+        }
+        if (operand.kind == Operand::Kind::MEM) {
+            return operand.mem;
+        }
+        return "";
+    };
+
+    auto emit_move = [&](const Move &move) {
+        if (move.dst.kind == Operand::Kind::REG) {
+            move_to_reg(move.src, move.dst.reg, 8);
+        } else if (move.src.kind == Operand::Kind::REG) {
+            move_from_reg(move.src.reg, move.dst, 8);
+        } else if (move.src.kind == Operand::Kind::IMM && move.src.imm >= INT32_MIN &&
+                   move.src.imm <= INT32_MAX) {
+            emit("movq $" + std::to_string(move.src.imm) + ", " + move.dst.mem);
+        } else {
+            move_to_reg(move.src, X86Reg::RAX, 8);
+            move_from_reg(X86Reg::RAX, move.dst, 8);
+        }
+    };
+
+    moves.erase(std::remove_if(moves.begin(), moves.end(),
+                               [&](const Move &move) {
+                                   return !key(move.src).empty() &&
+                                          key(move.src) == key(move.dst);
+                               }),
+                moves.end());
+
+    while (!moves.empty()) {
+        bool progress = false;
+        for (size_t i = 0; i < moves.size(); ++i) {
+            std::string dst = key(moves[i].dst);
+            bool blocked = false;
+            for (size_t j = 0; j < moves.size() && !blocked; ++j) {
+                blocked = j != i && key(moves[j].src) == dst;
+            }
+            if (!blocked) {
+                emit_move(moves[i]);
+                moves.erase(moves.begin() + static_cast<long>(i));
+                progress = true;
+                break;
+            }
+        }
+        if (progress) {
+            continue;
+        }
+
+        // Only cycles left: save one destination and redirect its readers
+        Operand saved = moves.front().dst;
+        std::string saved_key = key(saved);
+        move_to_reg(saved, X86Reg::R11, 8);
+        for (auto &move : moves) {
+            if (key(move.src) == saved_key) {
+                move.src = Operand();
+                move.src.kind = Operand::Kind::REG;
+                move.src.reg = X86Reg::R11;
+            }
+        }
+    }
+}
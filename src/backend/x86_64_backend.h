@@ -0,0 +1,226 @@
+#pragma once
+
+#include "../error/error.h"
+#include "ir_module.h"
+#include "linear_scan.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * General purpose registers in encoding order
+ */
+enum class X86Reg : int {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+/**
+ * X86Backend - Lowers an IRModule to x86-64 assembly (AT&T syntax, GNU as)
+ *
+ * Core responsibilities:
+ * 1. Instruction selection for the instructions IREmitter produces
+ * 2. Register allocation with LinearScan over liveness intervals
+ * 3. Frames, calls and returns following the System V AMD64 ABI
+ * 4. Globals in .rodata/.data/.bss
+ *
+ * Value classes:
+ * - Addresses of allocas, globals and constant GEPs of them are folded into
+ *   memory operands (-24(%rbp), sym+8(%rip)) and never occupy registers
+ * - bitcast/trunc reuse the register of their operand
+ * - Aggregates and vectors live in frame slots, vector operations are
+ *   scalarized lane by lane
+ * - All other scalars are virtual registers, allocated to
+ *   rbx/r12-r15 (callee-saved) and rsi/rdi/r8/r9 (caller-saved) or spilled
+ * - rax/rcx/rdx/r10/r11 are scratch registers for instruction selection
+ *
+ * Frame layout (rbp-based, rsp 16-byte aligned between calls):
+ *   16(%rbp)...  incoming stack arguments
+ *   8(%rbp)      return address
+ *   0(%rbp)      saved rbp
+ *   below        callee-saved registers, allocas, aggregate slots, spills
+ *   0(%rsp)...   outgoing stack arguments
+ *
+ * Calling convention:
+ * - Integer/pointer arguments in rdi, rsi, rdx, rcx, r8, r9, then the stack
+ * - Scalars return in rax; aggregates up to 16 bytes in rax:rdx, larger ones
+ *   through a hidden pointer passed in rdi and returned in rax
+ * - Vararg calls (printf/scanf) set al to 0
+ *
+ * Phi nodes become parallel copies at the end of predecessors; edges from
+ * a conditional branch into a block with phis get their own copy block.
+ * Blocks holding nothing but `br` (the jmp_true_N/jmp_false_N trampolines)
+ * are not emitted, jumps to them go straight to their target.
+ *
+ * Example:
+ *   ErrorReporter errors;
+ *   X86Backend backend(module, errors);
+ *   std::string assembly;
+ *   if (backend.generate(assembly)) { ... } // assemble with `as`
+ */
+class X86Backend {
+  public:
+    X86Backend(const IRModule &module, ErrorReporter &error_reporter)
+        : module_(module), error_reporter_(error_reporter) {}
+
+    /**
+     * Generate assembly for the whole module
+     * @param assembly Receives the assembly text
+     * @return false if the module uses IR the backend does not support
+     */
+    bool generate(std::string &assembly);
+
+  private:
+    // Memory copies up to this size are inlined, larger ones call memcpy/memset
+    static constexpr size_t INLINE_COPY_LIMIT = 128;
+
+    /**
+     * Where the value of an IR local lives
+     * - VREG: virtual register `vreg`
+     * - FRAME: the value is the address rbp - (callee save area + offset)
+     * - SYMBOL: the value is the address symbol + offset
+     * - MEMORY: aggregate/vector stored at rbp - (callee save area + offset)
+     * - CONST: the value is the constant `offset`
+     * - FUSED: icmp evaluated by the conditional branch that uses it
+     */
+    struct ValueLoc {
+        enum class Kind { NONE, VREG, FRAME, SYMBOL, MEMORY, CONST, FUSED };
+        Kind kind = Kind::NONE;
+        int vreg = -1;
+        int64_t offset = 0;
+        std::string symbol;
+    };
+
+    struct VReg {
+        const IRType *type = nullptr;
+        LiveInterval interval;
+        int64_t spill_depth = 0; // Frame depth of the spill slot, if spilled
+    };
+
+    /**
+     * Assembly operand of a scalar
+     * - IMM: $value
+     * - REG: register holding the value
+     * - MEM: memory holding the value (text is the memory operand)
+     * - ADDR: the value is the address of the memory operand (lea)
+     */
+    struct Operand {
+        enum class Kind { IMM, REG, MEM, ADDR };
+        Kind kind = Kind::IMM;
+        int64_t imm = 0;
+        X86Reg reg = X86Reg::RAX;
+        std::string mem;
+    };
+
+    /**
+     * Memory address: disp(%base) or symbol+disp(%rip)
+     */
+    struct MemRef {
+        std::string base;
+        std::string symbol;
+        int64_t disp = 0;
+
+        std::string text(int64_t extra = 0) const;
+    };
+
+    struct Move {
+        Operand dst;
+        Operand src;
+    };
+
+    struct Unsupported {
+        std::string message;
+    };
+
+    const IRModule &module_;
+    ErrorReporter &error_reporter_;
+    std::ostringstream out_;
+
+    // Current function
+    const IRFunction *function_ = nullptr;
+    int function_index_ = 0;
+    std::unordered_map<std::string, ValueLoc> values_;
+    std::unordered_map<std::string, int> use_counts_;
+    std::vector<VReg> vregs_;
+    std::vector<int> param_vregs_;             // Per parameter, -1 if unused
+    std::vector<std::vector<int>> successors_; // Block indices
+    std::vector<int> forward_;                 // Block a jump to a block really lands in
+    std::vector<std::vector<int>> positions_;  // Per block, per instruction
+    std::vector<int> call_positions_;
+    std::map<std::pair<int, int>, std::string> edge_labels_; // Split edges with phi copies
+    int64_t frame_depth_ = 0;
+    int64_t callee_save_bytes_ = 0;
+    int64_t outgoing_bytes_ = 0;
+    int64_t sret_depth_ = -1; // Home of the hidden return pointer, -1 if none
+    std::vector<X86Reg> used_callee_saved_;
+    int current_block_ = 0;
+
+    // x86_64_backend.cpp: module, frame and register allocation
+    void emit_globals();
+    void lower_function(const IRFunction &function, int index);
+    void classify_values();
+    void allocate_registers();
+    void emit_prologue();
+    void emit_epilogue();
+    void emit_block(int index);
+    void emit_phi_copies(int pred, int succ);
+    void emit_parallel_moves(std::vector<Move> moves);
+    int64_t allocate_slot(size_t size, size_t align);
+    int new_vreg(const IRType *type);
+    std::string block_label(int index) const;
+    std::string fallthrough_label() const;
+    static std::string symbol_name(const std::string &ir_name);
+    bool returns_in_memory(const IRType *type) const;
+    bool lowers_to_call(const IRInstruction &instr) const;
+    [[noreturn]] void unsupported(const IRInstruction &instr, const std::string &what) const;
+
+    // x86_64_isel.cpp: instruction selection
+    void select(const IRInstruction &instr);
+    void select_binary(const IRInstruction &instr);
+    void select_vector_binary(const IRInstruction &instr);
+    void select_icmp(const IRInstruction &instr);
+    void select_cast(const IRInstruction &instr);
+    void select_gep(const IRInstruction &instr);
+    void select_load(const IRInstruction &instr);
+    void select_store(const IRInstruction &instr);
+    void select_call(const IRInstruction &instr);
+    void select_intrinsic(const IRInstruction &instr);
+    void select_select(const IRInstruction &instr);
+    void select_insert_value(const IRInstruction &instr);
+    void select_extract_value(const IRInstruction &instr);
+    void select_insert_element(const IRInstruction &instr);
+    void select_shuffle_vector(const IRInstruction &instr);
+    void select_ret(const IRInstruction &instr);
+    void select_cond_br(const IRInstruction &instr, const IRInstruction *fused);
+    void select_br(const std::string &label);
+
+    void emit(const std::string &text);
+    static std::string reg_name(X86Reg reg, size_t size);
+    static const char *suffix(size_t size);
+    int64_t frame_offset(int64_t depth) const;
+    Operand vreg_operand(int vreg) const;
+    Operand value_operand(const IRValue &value) const;
+    Operand lane_operand(const IRValue &vector, size_t lane) const;
+    Operand dest_operand(const IRInstruction &instr) const;
+    MemRef memory_ref(const IRValue &aggregate) const;
+    MemRef result_ref(const IRInstruction &instr) const;
+    MemRef pointer_ref(const IRValue &pointer, X86Reg scratch);
+    void move_to_reg(const Operand &src, X86Reg reg, size_t size);
+    void move_from_reg(X86Reg reg, const Operand &dst, size_t size);
+    std::string source_text(const Operand &operand, size_t size) const;
+    void extend_reg(X86Reg reg, size_t size, bool is_signed);
+    void load_scalar(const std::string &mem, const Operand &dst, size_t size);
+    void store_scalar(const Operand &value, const std::string &mem, size_t size);
+    void emit_binary(const std::string &op, size_t size, const Operand &lhs, const Operand &rhs,
+                     const Operand &dst);
+    std::string emit_compare(const IRInstruction &icmp);
+    void copy_memory(const MemRef &dst, const MemRef &src, size_t size);
+    void fill_memory(const MemRef &dst, uint8_t value, size_t size);
+    void copy_aggregate(const MemRef &dst, const IRValue &value);
+    void emit_libc_call(const std::string &name, const MemRef &dst, const MemRef *src,
+                        uint8_t value, size_t size);
+};
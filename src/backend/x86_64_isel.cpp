@@ -0,0 +1,1003 @@
+#include "x86_64_backend.h"
+
+#include <climits>
+
+namespace {
+
+const X86Reg ARGUMENT_REGS[] = {X86Reg::RDI, X86Reg::RSI, X86Reg::RDX,
+                                X86Reg::RCX, X86Reg::R8,  X86Reg::R9};
+constexpr int ARGUMENT_REG_COUNT = 6;
+
+bool fits_int32(int64_t value) { return value >= INT32_MIN && value <= INT32_MAX; }
+
+/**
+ * Truncate an immediate to an operand size, sign-extended
+ */
+int64_t truncate_imm(int64_t value, size_t size) {
+    switch (size) {
+    case 1:
+        return static_cast<int8_t>(value);
+    case 2:
+        return static_cast<int16_t>(value);
+    case 4:
+        return static_cast<int32_t>(value);
+    default:
+        return value;
+    }
+}
+
+std::string condition_code(const std::string &predicate) {
+    if (predicate == "eq") return "e";
+    if (predicate == "ne") return "ne";
+    if (predicate == "slt") return "l";
+    if (predicate == "sle") return "le";
+    if (predicate == "sgt") return "g";
+    if (predicate == "sge") return "ge";
+    if (predicate == "ult") return "b";
+    if (predicate == "ule") return "be";
+    if (predicate == "ugt") return "a";
+    return "ae"; // uge
+}
+
+std::string inverse_condition(const std::string &cc) {
+    if (cc == "e") return "ne";
+    if (cc == "ne") return "e";
+    if (cc == "l") return "ge";
+    if (cc == "ge") return "l";
+    if (cc == "le") return "g";
+    if (cc == "g") return "le";
+    if (cc == "b") return "ae";
+    if (cc == "ae") return "b";
+    if (cc == "be") return "a";
+    return "be"; // a
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Operands
+// ---------------------------------------------------------------------------
+
+void X86Backend::emit(const std::string &text) { out_ << "\t" << text << "\n"; }
+
+std::string X86Backend::reg_name(X86Reg reg, size_t size) {
+    static const char *const names[4][16] = {
+        {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil", "r8b", "r9b", "r10b", "r11b", "r12b",
+         "r13b", "r14b", "r15b"},
+        {"ax", "cx", "dx", "bx", "sp", "bp", "si", "di", "r8w", "r9w", "r10w", "r11w", "r12w",
+         "r13w", "r14w", "r15w"},
+        {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi", "r8d", "r9d", "r10d", "r11d",
+         "r12d", "r13d", "r14d", "r15d"},
+        {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi", "r8", "r9", "r10", "r11", "r12",
+         "r13", "r14", "r15"},
+    };
+    int row = size == 1 ? 0 : size == 2 ? 1 : size == 4 ? 2 : 3;
+    return std::string("%") + names[row][static_cast<int>(reg)];
+}
+
+const char *X86Backend::suffix(size_t size) {
+    return size == 1 ? "b" : size == 2 ? "w" : size == 4 ? "l" : "q";
+}
+
+std::string X86Backend::MemRef::text(int64_t extra) const {
+    int64_t offset = disp + extra;
+    if (!symbol.empty()) {
+        std::string result = symbol;
+        if (offset > 0) {
+            result += "+" + std::to_string(offset);
+        } else if (offset < 0) {
+            result += std::to_string(offset);
+        }
+        return result + "(%rip)";
+    }
+    return (offset != 0 ? std::to_string(offset) : "") + "(" + base + ")";
+}
+
+int64_t X86Backend::frame_offset(int64_t depth) const { return -(callee_save_bytes_ + depth); }
+
+X86Backend::Operand X86Backend::vreg_operand(int vreg) const {
+    Operand operand;
+    const VReg &info = vregs_.at(vreg);
+    if (info.interval.reg >= 0) {
+        operand.kind = Operand::Kind::REG;
+        operand.reg = static_cast<X86Reg>(info.interval.reg);
+    } else {
+        operand.kind = Operand::Kind::MEM;
+        operand.mem = std::to_string(frame_offset(info.spill_depth)) + "(%rbp)";
+    }
+    return operand;
+}
+
+X86Backend::Operand X86Backend::value_operand(const IRValue &value) const {
+    Operand operand;
+    switch (value.kind) {
+    case IRValue::Kind::INT:
+        operand.imm = value.value;
+        return operand;
+    case IRValue::Kind::UNDEF:
+    case IRValue::Kind::ZERO:
+        return operand;
+    case IRValue::Kind::GLOBAL:
+        operand.kind = Operand::Kind::ADDR;
+        operand.mem = MemRef{"", symbol_name(value.name), 0}.text();
+        return operand;
+    case IRValue::Kind::LOCAL: {
+        auto it = values_.find(value.name);
+        if (it == values_.end()) {
+            throw Unsupported{"use of undefined value %" + value.name + " in @" + function_->name};
+        }
+        const ValueLoc &loc = it->second;
+        switch (loc.kind) {
+        case ValueLoc::Kind::VREG:
+            return vreg_operand(loc.vreg);
+        case ValueLoc::Kind::FRAME:
+            operand.kind = Operand::Kind::ADDR;
+            operand.mem = std::to_string(frame_offset(loc.offset)) + "(%rbp)";
+            return operand;
+        case ValueLoc::Kind::SYMBOL:
+            operand.kind = Operand::Kind::ADDR;
+            operand.mem = MemRef{"", loc.symbol, loc.offset}.text();
+            return operand;
+        case ValueLoc::Kind::CONST:
+            operand.imm = loc.offset;
+            return operand;
+        default:
+            break;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    throw Unsupported{"value %" + value.name + " is not a scalar in @" + function_->name};
+}
+
+X86Backend::Operand X86Backend::lane_operand(const IRValue &vector, size_t lane) const {
+    Operand operand;
+    size_t element_size = vector.type->element->size;
+    if (vector.kind == IRValue::Kind::VECTOR) {
+        operand.imm = vector.elements.at(lane).value;
+    } else if (vector.is_local()) {
+        operand.kind = Operand::Kind::MEM;
+        operand.mem = memory_ref(vector).text(static_cast<int64_t>(lane * element_size));
+    }
+    return operand;
+}
+
+X86Backend::Operand X86Backend::dest_operand(const IRInstruction &instr) const {
+    return vreg_operand(values_.at(instr.result).vreg);
+}
+
+X86Backend::MemRef X86Backend::memory_ref(const IRValue &aggregate) const {
+    auto it = values_.find(aggregate.name);
+    if (!aggregate.is_local() || it == values_.end() ||
+        it->second.kind != ValueLoc::Kind::MEMORY) {
+        throw Unsupported{"aggregate %" + aggregate.name + " is not in memory in @" +
+                          function_->name};
+    }
+    return {"%rbp", "", frame_offset(it->second.offset)};
+}
+
+X86Backend::MemRef X86Backend::result_ref(const IRInstruction &instr) const {
+    IRValue value;
+    value.kind = IRValue::Kind::LOCAL;
+    value.name = instr.result;
+    return memory_ref(value);
+}
+
+/**
+ * Address a pointer value points to; spilled pointers are loaded into `scratch`
+ */
+X86Backend::MemRef X86Backend::pointer_ref(const IRValue &pointer, X86Reg scratch) {
+    if (pointer.kind == IRValue::Kind::GLOBAL) {
+        return {"", symbol_name(pointer.name), 0};
+    }
+    if (pointer.is_local()) {
+        const ValueLoc &loc = values_.at(pointer.name);
+        if (loc.kind == ValueLoc::Kind::FRAME) {
+            return {"%rbp", "", frame_offset(loc.offset)};
+        }
+        if (loc.kind == ValueLoc::Kind::SYMBOL) {
+            return {"", loc.symbol, loc.offset};
+        }
+    }
+    Operand operand = value_operand(pointer);
+    if (operand.kind == Operand::Kind::REG) {
+        return {reg_name(operand.reg, 8), "", 0};
+    }
+    move_to_reg(operand, scratch, 8);
+    return {reg_name(scratch, 8), "", 0};
+}
+
+/**
+ * Load a scalar into a register; the low `size` bytes are valid afterwards,
+ * sub-word loads from memory zero-extend to 32 bits
+ */
+void X86Backend::move_to_reg(const Operand &src, X86Reg reg, size_t size) {
+    switch (src.kind) {
+    case Operand::Kind::IMM:
+        if (size <= 4) {
+            emit("movl $" + std::to_string(truncate_imm(src.imm, 4)) + ", " + reg_name(reg, 4));
+        } else if (fits_int32(src.imm)) {
+            emit("movq $" + std::to_string(src.imm) + ", " + reg_name(reg, 8));
+        } else {
+            emit("movabsq $" + std::to_string(src.imm) + ", " + reg_name(reg, 8));
+        }
+        break;
+    case Operand::Kind::REG:
+        if (src.reg != reg) {
+            emit("movq " + reg_name(src.reg, 8) + ", " + reg_name(reg, 8));
+        }
+        break;
+    case Operand::Kind::MEM:
+        if (size == 8) {
+            emit("movq " + src.mem + ", " + reg_name(reg, 8));
+        } else if (size == 4) {
+            emit("movl " + src.mem + ", " + reg_name(reg, 4));
+        } else {
+            emit(std::string(size == 2 ? "movzwl " : "movzbl ") + src.mem + ", " +
+                 reg_name(reg, 4));
+        }
+        break;
+    case Operand::Kind::ADDR:
+        emit("leaq " + src.mem + ", " + reg_name(reg, 8));
+        break;
+    }
+}
+
+void X86Backend::move_from_reg(X86Reg reg, const Operand &dst, size_t size) {
+    if (dst.kind == Operand::Kind::REG) {
+        if (dst.reg != reg) {
+            emit("movq " + reg_name(reg, 8) + ", " + reg_name(dst.reg, 8));
+        }
+    } else {
+        emit(std::string("mov") + suffix(size) + " " + reg_name(reg, size) + ", " + dst.mem);
+    }
+}
+
+/**
+ * Text of an operand usable directly as an instruction source, empty if it
+ * has to be loaded into a register first
+ */
+std::string X86Backend::source_text(const Operand &operand, size_t size) const {
+    switch (operand.kind) {
+    case Operand::Kind::IMM: {
+        int64_t value = truncate_imm(operand.imm, size);
+        return fits_int32(value) ? "$" + std::to_string(value) : "";
+    }
+    case Operand::Kind::REG:
+        return reg_name(operand.reg, size);
+    case Operand::Kind::MEM:
+        return operand.mem;
+    default:
+        return "";
+    }
+}
+
+void X86Backend::extend_reg(X86Reg reg, size_t size, bool is_signed) {
+    if (size >= 4) {
+        return;
+    }
+    std::string op = std::string(is_signed ? "movs" : "movz") + (size == 1 ? "bl " : "wl ");
+    emit(op + reg_name(reg, size) + ", " + reg_name(reg, 4));
+}
+
+void X86Backend::load_scalar(const std::string &mem, const Operand &dst, size_t size) {
+    X86Reg reg = dst.kind == Operand::Kind::REG ? dst.reg : X86Reg::RAX;
+    Operand src;
+    src.kind = Operand::Kind::MEM;
+    src.mem = mem;
+    move_to_reg(src, reg, size);
+    move_from_reg(reg, dst, size);
+}
+
+void X86Backend::store_scalar(const Operand &value, const std::string &mem, size_t size) {
+    std::string source = source_text(value, size);
+    if (value.kind == Operand::Kind::MEM || source.empty()) {
+        move_to_reg(value, X86Reg::RAX, size);
+        source = reg_name(X86Reg::RAX, size);
+    }
+    emit(std::string("mov") + suffix(size) + " " + source + ", " + mem);
+}
+
+// ---------------------------------------------------------------------------
+// Memory blocks
+// ---------------------------------------------------------------------------
+
+void X86Backend::emit_libc_call(const std::string &name, const MemRef &dst, const MemRef *src,
+                                uint8_t value, size_t size) {
+    // Addresses may be based on argument registers, compute them first
+    emit("leaq " + dst.text() + ", %rax");
+    if (src) {
+        emit("leaq " + src->text() + ", %rdx");
+    }
+    emit("movq %rax, %rdi");
+    if (src) {
+        emit("movq %rdx, %rsi");
+    } else {
+        emit("movl $" + std::to_string(value) + ", %esi");
+    }
+    emit("movq $" + std::to_string(size) + ", %rdx");
+    emit("call " + name + "@PLT");
+}
+
+void X86Backend::copy_memory(const MemRef &dst, const MemRef &src, size_t size) {
+    if (size > INLINE_COPY_LIMIT) {
+        emit_libc_call("memcpy", dst, &src, 0, size);
+        return;
+    }
+    for (size_t offset = 0; offset < size;) {
+        size_t chunk = size - offset >= 8 ? 8 : size - offset >= 4 ? 4 : size - offset >= 2 ? 2 : 1;
+        int64_t at = static_cast<int64_t>(offset);
+        Operand chunk_src;
+        chunk_src.kind = Operand::Kind::MEM;
+        chunk_src.mem = src.text(at);
+        move_to_reg(chunk_src, X86Reg::RAX, chunk);
+        emit(std::string("mov") + suffix(chunk) + " " + reg_name(X86Reg::RAX, chunk) + ", " +
+             dst.text(at));
+        offset += chunk;
+    }
+}
+
+void X86Backend::fill_memory(const MemRef &dst, uint8_t value, size_t size) {
+    if (size > INLINE_COPY_LIMIT) {
+        emit_libc_call("memset", dst, nullptr, value, size);
+        return;
+    }
+    uint64_t pattern = value * 0x0101010101010101ULL;
+    if (size >= 8 && !fits_int32(static_cast<int64_t>(pattern))) {
+        emit("movabsq $" + std::to_string(static_cast<int64_t>(pattern)) + ", %rax");
+    }
+    for (size_t offset = 0; offset < size;) {
+        size_t chunk = size - offset >= 8 ? 8 : size - offset >= 4 ? 4 : size - offset >= 2 ? 2 : 1;
+        int64_t imm = truncate_imm(static_cast<int64_t>(pattern), chunk);
+        std::string source = fits_int32(imm) ? "$" + std::to_string(imm) : "%rax";
+        emit(std::string("mov") + suffix(chunk) + " " + source + ", " +
+             dst.text(static_cast<int64_t>(offset)));
+        offset += chunk;
+    }
+}
+
+/**
+ * Store an aggregate or vector value to memory
+ */
+void X86Backend::copy_aggregate(const MemRef &dst, const IRValue &value) {
+    switch (value.kind) {
+    case IRValue::Kind::UNDEF:
+        return;
+    case IRValue::Kind::ZERO:
+        fill_memory(dst, 0, value.type->size);
+        return;
+    case IRValue::Kind::VECTOR: {
+        size_t element_size = value.type->element->size;
+        for (size_t lane = 0; lane < value.elements.size(); ++lane) {
+            store_scalar(lane_operand(value, lane), dst.text(static_cast<int64_t>(lane * element_size)),
+                         element_size);
+        }
+        return;
+    }
+    default: {
+        MemRef src = memory_ref(value);
+        if (src.text() != dst.text()) {
+            copy_memory(dst, src, value.type->size);
+        }
+        return;
+    }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Instructions
+// ---------------------------------------------------------------------------
+
+void X86Backend::select(const IRInstruction &instr) {
+    const ValueLoc *loc = instr.result.empty() ? nullptr : &values_[instr.result];
+    bool is_vreg = loc && loc->kind == ValueLoc::Kind::VREG;
+
+    switch (instr.opcode) {
+    case IROpcode::ALLOCA:
+        break;
+    case IROpcode::LOAD:
+        select_load(instr);
+        break;
+    case IROpcode::STORE:
+        select_store(instr);
+        break;
+    case IROpcode::BINARY:
+        if (instr.type->is_vector()) {
+            select_vector_binary(instr);
+        } else {
+            select_binary(instr);
+        }
+        break;
+    case IROpcode::ICMP:
+        if (instr.type->is_vector()) {
+            unsupported(instr, "vector icmp");
+        }
+        select_icmp(instr);
+        break;
+    case IROpcode::CAST: {
+        // Casts sharing the location of their operand need no code
+        const IRValue &source = instr.operands[0];
+        auto it = source.is_local() ? values_.find(source.name) : values_.end();
+        bool aliased = !is_vreg || (it != values_.end() &&
+                                    it->second.kind == ValueLoc::Kind::VREG &&
+                                    it->second.vreg == loc->vreg);
+        if (aliased && loc->kind == ValueLoc::Kind::MEMORY && instr.op != "bitcast") {
+            unsupported(instr, "vector " + instr.op);
+        }
+        if (!aliased) {
+            select_cast(instr);
+        }
+        break;
+    }
+    case IROpcode::GEP:
+        if (is_vreg) {
+            select_gep(instr);
+        }
+        break;
+    case IROpcode::CALL:
+        select_call(instr);
+        break;
+    case IROpcode::SELECT:
+        select_select(instr);
+        break;
+    case IROpcode::INSERT_VALUE:
+        select_insert_value(instr);
+        break;
+    case IROpcode::EXTRACT_VALUE:
+        select_extract_value(instr);
+        break;
+    case IROpcode::INSERT_ELEMENT:
+        select_insert_element(instr);
+        break;
+    case IROpcode::SHUFFLE_VECTOR:
+        select_shuffle_vector(instr);
+        break;
+    default:
+        unsupported(instr, "unexpected instruction");
+    }
+}
+
+/**
+ * Emit `dst = lhs op rhs` on scalars of `size` bytes
+ * Sub-word operations run on 32-bit registers; only the low bytes matter
+ * except for division and right shifts, whose operands are extended first.
+ */
+void X86Backend::emit_binary(const std::string &op, size_t size, const Operand &lhs,
+                             const Operand &rhs, const Operand &dst) {
+    size_t width = size <= 4 ? 4 : 8;
+
+    if (op == "sdiv" || op == "srem" || op == "udiv" || op == "urem") {
+        bool is_signed = op[0] == 's';
+        move_to_reg(rhs, X86Reg::RCX, width);
+        extend_reg(X86Reg::RCX, size, is_signed);
+        move_to_reg(lhs, X86Reg::RAX, width);
+        extend_reg(X86Reg::RAX, size, is_signed);
+        if (is_signed) {
+            emit(width == 4 ? "cltd" : "cqto");
+            emit(std::string("idiv") + suffix(width) + " " + reg_name(X86Reg::RCX, width));
+        } else {
+            emit("xorl %edx, %edx");
+            emit(std::string("div") + suffix(width) + " " + reg_name(X86Reg::RCX, width));
+        }
+        move_from_reg(op == "sdiv" || op == "udiv" ? X86Reg::RAX : X86Reg::RDX, dst, size);
+        return;
+    }
+
+    // Work in the destination register unless the right operand lives there
+    X86Reg work = X86Reg::RAX;
+    if (dst.kind == Operand::Kind::REG &&
+        !(rhs.kind == Operand::Kind::REG && rhs.reg == dst.reg)) {
+        work = dst.reg;
+    }
+
+    if (op == "shl" || op == "ashr" || op == "lshr") {
+        std::string count;
+        if (rhs.kind == Operand::Kind::IMM) {
+            count = "$" + std::to_string(rhs.imm & (width * 8 - 1));
+        } else {
+            move_to_reg(rhs, X86Reg::RCX, width);
+            count = "%cl";
+        }
+        move_to_reg(lhs, work, width);
+        if (op != "shl") {
+            extend_reg(work, size, op == "ashr");
+        }
+        std::string mnemonic = op == "shl" ? "shl" : op == "ashr" ? "sar" : "shr";
+        emit(mnemonic + suffix(width) + " " + count + ", " + reg_name(work, width));
+        move_from_reg(work, dst, size);
+        return;
+    }
+
+    std::string mnemonic = op == "mul" ? "imul" : op;
+    std::string source = source_text(rhs, width);
+    if (source.empty()) {
+        move_to_reg(rhs, X86Reg::RCX, width);
+        source = reg_name(X86Reg::RCX, width);
+    }
+    move_to_reg(lhs, work, width);
+    emit(mnemonic + suffix(width) + " " + source + ", " + reg_name(work, width));
+    move_from_reg(work, dst, size);
+}
+
+void X86Backend::select_binary(const IRInstruction &instr) {
+    emit_binary(instr.op, instr.type->size, value_operand(instr.operands[0]),
+                value_operand(instr.operands[1]), dest_operand(instr));
+}
+
+void X86Backend::select_vector_binary(const IRInstruction &instr) {
+    MemRef dst = result_ref(instr);
+    size_t element_size = instr.type->element->size;
+    for (size_t lane = 0; lane < instr.type->count; ++lane) {
+        Operand lane_dst;
+        lane_dst.kind = Operand::Kind::MEM;
+        lane_dst.mem = dst.text(static_cast<int64_t>(lane * element_size));
+        emit_binary(instr.op, element_size, lane_operand(instr.operands[0], lane),
+                    lane_operand(instr.operands[1], lane), lane_dst);
+    }
+}
+
+/**
+ * Emit the comparison of an icmp, returning its condition code
+ */
+std::string X86Backend::emit_compare(const IRInstruction &icmp) {
+    size_t size = icmp.operands[0].type->size;
+    Operand lhs = value_operand(icmp.operands[0]);
+    Operand rhs = value_operand(icmp.operands[1]);
+
+    std::string source = source_text(rhs, size);
+    if (source.empty()) {
+        move_to_reg(rhs, X86Reg::RCX, size);
+        source = reg_name(X86Reg::RCX, size);
+    }
+    std::string target;
+    if (lhs.kind == Operand::Kind::REG) {
+        target = reg_name(lhs.reg, size);
+    } else if (lhs.kind == Operand::Kind::MEM && rhs.kind != Operand::Kind::MEM) {
+        target = lhs.mem;
+    } else {
+        move_to_reg(lhs, X86Reg::RAX, size);
+        target = reg_name(X86Reg::RAX, size);
+    }
+    emit(std::string("cmp") + suffix(size) + " " + source + ", " + target);
+    return condition_code(icmp.op);
+}
+
+void X86Backend::select_icmp(const IRInstruction &instr) {
+    std::string cc = emit_compare(instr);
+    emit("set" + cc + " %al");
+    emit("movzbl %al, %eax");
+    move_from_reg(X86Reg::RAX, dest_operand(instr), 1);
+}
+
+void X86Backend::select_cast(const IRInstruction &instr) {
+    const IRValue &value = instr.operands[0];
+    Operand src = value_operand(value);
+    Operand dst = dest_operand(instr);
+    size_t from = value.type->size;
+    size_t to = instr.type->size;
+    X86Reg work = dst.kind == Operand::Kind::REG ? dst.reg : X86Reg::RAX;
+
+    if ((instr.op == "zext" || instr.op == "sext") && src.kind != Operand::Kind::IMM) {
+        bool is_signed = instr.op == "sext";
+        std::string text = src.kind == Operand::Kind::REG ? reg_name(src.reg, from) : src.mem;
+        if (src.kind == Operand::Kind::ADDR) {
+            unsupported(instr, "extension of an address");
+        }
+        if (from == 4 && !is_signed) {
+            emit("movl " + text + ", " + reg_name(work, 4));
+        } else if (from == 4) {
+            emit("movslq " + text + ", " + reg_name(work, 8));
+        } else {
+            std::string width = to == 8 && is_signed ? "q " : "l ";
+            std::string op = std::string(is_signed ? "movs" : "movz") + (from == 1 ? "b" : "w") +
+                             width;
+            emit(op + text + ", " + reg_name(work, width == "q " ? 8 : 4));
+        }
+        if (is_signed && value.type->bits == 1) {
+            // sext i1 is 0 or -1
+            emit(std::string("neg") + suffix(to <= 4 ? 4 : 8) + " " +
+                 reg_name(work, to <= 4 ? 4 : 8));
+        }
+        move_from_reg(work, dst, to);
+        return;
+    }
+
+    move_to_reg(src, work, 8);
+    if (instr.op == "trunc" && instr.type->bits == 1) {
+        emit("andl $1, " + reg_name(work, 4));
+    }
+    move_from_reg(work, dst, to);
+}
+
+/**
+ * Address arithmetic: base + sum(index * stride) + constant offset
+ */
+void X86Backend::select_gep(const IRInstruction &instr) {
+    Operand base = value_operand(instr.operands[0]);
+    Operand dst = dest_operand(instr);
+
+    X86Reg acc;
+    if (base.kind == Operand::Kind::REG) {
+        acc = base.reg;
+    } else {
+        move_to_reg(base, X86Reg::RAX, 8);
+        acc = X86Reg::RAX;
+    }
+
+    // Constant indices fold into `offset`, the others are scaled terms
+    struct Term {
+        Operand index;
+        size_t size;
+        int64_t stride;
+    };
+    std::vector<Term> terms;
+    int64_t offset = 0;
+    const IRType *current = instr.source_type;
+    for (size_t k = 1; k < instr.operands.size(); ++k) {
+        const IRValue &index = instr.operands[k];
+        int64_t stride;
+        if (k == 1) {
+            stride = static_cast<int64_t>(current->size);
+        } else if (current->kind == IRType::Kind::STRUCT) {
+            size_t field = static_cast<size_t>(index.value);
+            offset += static_cast<int64_t>(current->element_offset(field));
+            current = current->element_type(field);
+            continue;
+        } else {
+            current = current->element;
+            stride = static_cast<int64_t>(current->size);
+        }
+
+        Operand operand = value_operand(index);
+        if (operand.kind == Operand::Kind::IMM) {
+            offset += operand.imm * stride;
+        } else {
+            terms.push_back({operand, index.type->size, stride});
+        }
+    }
+
+    // Sign-extends a term's index into rcx, unless it already is a 64-bit register
+    auto index_reg = [&](const Term &term) {
+        if (term.size == 8 && term.index.kind == Operand::Kind::REG) {
+            return term.index.reg;
+        }
+        std::string text = term.index.kind == Operand::Kind::REG
+                               ? reg_name(term.index.reg, term.size)
+                               : term.index.mem;
+        if (term.size == 8) {
+            emit("movq " + text + ", %rcx");
+        } else if (term.size == 4) {
+            emit("movslq " + text + ", %rcx");
+        } else {
+            emit(std::string(term.size == 2 ? "movswq " : "movsbq ") + text + ", %rcx");
+        }
+        return X86Reg::RCX;
+    };
+    auto is_scale = [](int64_t stride) {
+        return stride == 1 || stride == 2 || stride == 4 || stride == 8;
+    };
+
+    X86Reg work = dst.kind == Operand::Kind::REG ? dst.reg : X86Reg::RAX;
+
+    // The common a[i]: a single lea
+    if (terms.size() == 1 && is_scale(terms[0].stride) && fits_int32(offset)) {
+        X86Reg index = index_reg(terms[0]);
+        emit("leaq " + (offset != 0 ? std::to_string(offset) : std::string()) + "(" +
+             reg_name(acc, 8) + "," + reg_name(index, 8) + "," +
+             std::to_string(terms[0].stride) + "), " + reg_name(work, 8));
+        move_from_reg(work, dst, 8);
+        return;
+    }
+
+    for (const Term &term : terms) {
+        X86Reg index = index_reg(term);
+        if (is_scale(term.stride)) {
+            emit("leaq (" + reg_name(acc, 8) + "," + reg_name(index, 8) + "," +
+                 std::to_string(term.stride) + "), %rax");
+        } else {
+            emit("imulq $" + std::to_string(term.stride) + ", " + reg_name(index, 8) + ", %rcx");
+            emit("leaq (" + reg_name(acc, 8) + ",%rcx), %rax");
+        }
+        acc = X86Reg::RAX;
+    }
+
+    if (!fits_int32(offset)) {
+        emit("movabsq $" + std::to_string(offset) + ", %rcx");
+        emit("leaq (" + reg_name(acc, 8) + ",%rcx), " + reg_name(work, 8));
+    } else if (offset != 0) {
+        emit("leaq " + std::to_string(offset) + "(" + reg_name(acc, 8) + "), " +
+             reg_name(work, 8));
+    } else if (acc != work) {
+        emit("movq " + reg_name(acc, 8) + ", " + reg_name(work, 8));
+    }
+    move_from_reg(work, dst, 8);
+}
+
+void X86Backend::select_load(const IRInstruction &instr) {
+    MemRef src = pointer_ref(instr.operands[0], X86Reg::R11);
+    if (instr.type->is_aggregate() || instr.type->is_vector()) {
+        copy_memory(result_ref(instr), src, instr.type->size);
+        return;
+    }
+    load_scalar(src.text(), dest_operand(instr), instr.type->size);
+}
+
+void X86Backend::select_store(const IRInstruction &instr) {
+    const IRValue &value = instr.operands[0];
+    MemRef dst = pointer_ref(instr.operands[1], X86Reg::R11);
+    if (value.type->is_aggregate() || value.type->is_vector()) {
+        copy_aggregate(dst, value);
+        return;
+    }
+    store_scalar(value_operand(value), dst.text(), value.type->size);
+}
+
+void X86Backend::select_intrinsic(const IRInstruction &instr) {
+    const std::string &name = instr.op;
+    if (name.rfind("llvm.lifetime.", 0) == 0) {
+        return;
+    }
+
+    bool is_memcpy = name.rfind("llvm.memcpy.", 0) == 0;
+    bool is_memset = name.rfind("llvm.memset.", 0) == 0;
+    if (!is_memcpy && !is_memset) {
+        unsupported(instr, "intrinsic @" + name);
+    }
+
+    const IRValue &length = instr.operands[2];
+    if (length.kind == IRValue::Kind::INT &&
+        (is_memcpy || instr.operands[1].kind == IRValue::Kind::INT)) {
+        MemRef dst = pointer_ref(instr.operands[0], X86Reg::R11);
+        size_t size = static_cast<size_t>(length.value);
+        if (is_memcpy) {
+            copy_memory(dst, pointer_ref(instr.operands[1], X86Reg::R10), size);
+        } else {
+            fill_memory(dst, static_cast<uint8_t>(instr.operands[1].value), size);
+        }
+        return;
+    }
+
+    // Variable length or fill value: call libc
+    std::vector<Move> moves;
+    for (int k = 0; k < 3; ++k) {
+        Operand dst;
+        dst.kind = Operand::Kind::REG;
+        dst.reg = ARGUMENT_REGS[k];
+        moves.push_back({dst, value_operand(instr.operands[k])});
+    }
+    emit_parallel_moves(moves);
+    if (is_memset) {
+        emit("movzbl %sil, %esi");
+    }
+    emit(std::string("call ") + (is_memcpy ? "memcpy" : "memset") + "@PLT");
+}
+
+void X86Backend::select_call(const IRInstruction &instr) {
+    if (instr.op.rfind("llvm.", 0) == 0) {
+        select_intrinsic(instr);
+        return;
+    }
+
+    const IRFunction *callee = module_.find_function(instr.op);
+    bool is_external = !callee || callee->is_declaration;
+    bool has_result = !instr.result.empty() && !instr.type->is_void();
+    bool in_memory = has_result && (instr.type->is_aggregate() || instr.type->is_vector());
+
+    auto argument_slot = [](int index) {
+        Operand operand;
+        if (index < ARGUMENT_REG_COUNT) {
+            operand.kind = Operand::Kind::REG;
+            operand.reg = ARGUMENT_REGS[index];
+        } else {
+            operand.kind = Operand::Kind::MEM;
+            operand.mem = std::to_string(8 * (index - ARGUMENT_REG_COUNT)) + "(%rsp)";
+        }
+        return operand;
+    };
+
+    std::vector<Move> moves;
+    int abi_index = 0;
+    if (returns_in_memory(instr.type)) {
+        Operand address;
+        address.kind = Operand::Kind::ADDR;
+        address.mem = result_ref(instr).text();
+        moves.push_back({argument_slot(abi_index++), address});
+    }
+    for (const auto &argument : instr.operands) {
+        if (!argument.type->is_scalar()) {
+            unsupported(instr, "aggregate argument");
+        }
+        moves.push_back({argument_slot(abi_index++), value_operand(argument)});
+    }
+    emit_parallel_moves(moves);
+
+    if (callee && callee->is_vararg) {
+        emit("movl $0, %eax");
+    }
+    emit("call " + (is_external ? instr.op + "@PLT" : symbol_name(instr.op)));
+
+    if (!has_result) {
+        return;
+    }
+    if (in_memory) {
+        if (!returns_in_memory(instr.type)) {
+            MemRef dst = result_ref(instr);
+            emit("movq %rax, " + dst.text());
+            if (instr.type->size > 8) {
+                emit("movq %rdx, " + dst.text(8));
+            }
+        }
+        return;
+    }
+    move_from_reg(X86Reg::RAX, dest_operand(instr), instr.type->size);
+}
+
+void X86Backend::select_select(const IRInstruction &instr) {
+    Operand condition = value_operand(instr.operands[0]);
+    Operand if_true = value_operand(instr.operands[1]);
+    Operand if_false = value_operand(instr.operands[2]);
+    Operand dst = dest_operand(instr);
+    size_t size = instr.type->size;
+
+    if (condition.kind == Operand::Kind::IMM) {
+        move_to_reg((condition.imm & 1) ? if_true : if_false, X86Reg::RAX, size);
+        move_from_reg(X86Reg::RAX, dst, size);
+        return;
+    }
+    move_to_reg(if_false, X86Reg::RAX, size);
+    move_to_reg(if_true, X86Reg::RCX, size);
+    std::string text = condition.kind == Operand::Kind::REG ? reg_name(condition.reg, 1)
+                                                            : condition.mem;
+    emit("testb $1, " + text);
+    emit("cmovneq %rcx, %rax");
+    move_from_reg(X86Reg::RAX, dst, size);
+}
+
+void X86Backend::select_insert_value(const IRInstruction &instr) {
+    const IRValue &aggregate = instr.operands[0];
+    const IRValue &element = instr.operands[1];
+    MemRef dst = result_ref(instr);
+    copy_aggregate(dst, aggregate);
+
+    const IRType *current = aggregate.type;
+    int64_t offset = 0;
+    for (int64_t index : instr.indices) {
+        offset += static_cast<int64_t>(current->element_offset(static_cast<size_t>(index)));
+        current = current->element_type(static_cast<size_t>(index));
+    }
+    if (current->is_scalar()) {
+        store_scalar(value_operand(element), dst.text(offset), current->size);
+    } else {
+        MemRef field = dst;
+        field.disp += offset;
+        copy_aggregate(field, element);
+    }
+}
+
+void X86Backend::select_extract_value(const IRInstruction &instr) {
+    const IRValue &aggregate = instr.operands[0];
+    const IRType *current = aggregate.type;
+    int64_t offset = 0;
+    for (int64_t index : instr.indices) {
+        offset += static_cast<int64_t>(current->element_offset(static_cast<size_t>(index)));
+        current = current->element_type(static_cast<size_t>(index));
+    }
+
+    bool from_memory = aggregate.is_local();
+    if (current->is_scalar()) {
+        Operand dst = dest_operand(instr);
+        if (from_memory) {
+            load_scalar(memory_ref(aggregate).text(offset), dst, current->size);
+        } else {
+            move_to_reg(Operand(), X86Reg::RAX, current->size);
+            move_from_reg(X86Reg::RAX, dst, current->size);
+        }
+        return;
+    }
+
+    MemRef dst = result_ref(instr);
+    if (from_memory) {
+        MemRef src = memory_ref(aggregate);
+        src.disp += offset;
+        if (src.text() != dst.text()) {
+            copy_memory(dst, src, current->size);
+        }
+    } else if (aggregate.kind == IRValue::Kind::ZERO) {
+        fill_memory(dst, 0, current->size);
+    }
+}
+
+void X86Backend::select_insert_element(const IRInstruction &instr) {
+    MemRef dst = result_ref(instr);
+    copy_aggregate(dst, instr.operands[0]);
+    Operand index = value_operand(instr.operands[2]);
+    if (index.kind != Operand::Kind::IMM) {
+        unsupported(instr, "insertelement with a variable index");
+    }
+    size_t element_size = instr.type->element->size;
+    store_scalar(value_operand(instr.operands[1]), dst.text(index.imm * static_cast<int64_t>(element_size)),
+                 element_size);
+}
+
+void X86Backend::select_shuffle_vector(const IRInstruction &instr) {
+    MemRef dst = result_ref(instr);
+    size_t count = instr.operands[0].type->count;
+    size_t element_size = instr.type->element->size;
+    for (size_t lane = 0; lane < instr.indices.size(); ++lane) {
+        int64_t source = instr.indices[lane];
+        if (source < 0) {
+            continue;
+        }
+        Operand value = static_cast<size_t>(source) < count
+                            ? lane_operand(instr.operands[0], static_cast<size_t>(source))
+                            : lane_operand(instr.operands[1], static_cast<size_t>(source) - count);
+        store_scalar(value, dst.text(static_cast<int64_t>(lane * element_size)), element_size);
+    }
+}
+
+void X86Backend::select_ret(const IRInstruction &instr) {
+    if (!instr.operands.empty()) {
+        const IRValue &value = instr.operands[0];
+        const IRType *type = value.type;
+        if (type->is_scalar()) {
+            move_to_reg(value_operand(value), X86Reg::RAX, type->size);
+        } else if (returns_in_memory(type)) {
+            std::string home = std::to_string(frame_offset(sret_depth_)) + "(%rbp)";
+            emit("movq " + home + ", %r11");
+            copy_aggregate({"%r11", "", 0}, value);
+            emit("movq " + home + ", %rax");
+        } else if (value.is_local()) {
+            MemRef src = memory_ref(value);
+            emit("movq " + src.text() + ", %rax");
+            if (type->size > 8) {
+                emit("movq " + src.text(8) + ", %rdx");
+            }
+        } else {
+            emit("xorl %eax, %eax");
+            emit("xorl %edx, %edx");
+        }
+    }
+    emit_epilogue();
+}
+
+void X86Backend::select_br(const std::string &label) {
+    if (label != fallthrough_label()) {
+        emit("jmp " + label);
+    }
+}
+
+void X86Backend::select_cond_br(const IRInstruction &instr, const IRInstruction *fused) {
+    int true_block = function_->block_index(instr.labels[0]);
+    int false_block = function_->block_index(instr.labels[1]);
+    auto target_label = [&](int target) {
+        auto it = edge_labels_.find({current_block_, target});
+        return it != edge_labels_.end() ? it->second : block_label(forward_[target]);
+    };
+    std::string if_true = target_label(true_block);
+    std::string if_false = target_label(false_block);
+
+    std::string cc;
+    if (fused) {
+        cc = emit_compare(*fused);
+    } else {
+        Operand condition = value_operand(instr.operands[0]);
+        if (condition.kind == Operand::Kind::IMM || condition.kind == Operand::Kind::ADDR) {
+            bool taken = condition.kind == Operand::Kind::ADDR || (condition.imm & 1);
+            select_br(taken ? if_true : if_false);
+            return;
+        }
+        std::string text = condition.kind == Operand::Kind::REG ? reg_name(condition.reg, 1)
+                                                                : condition.mem;
+        emit("testb $1, " + text);
+        cc = "ne";
+    }
+
+    if (if_true == fallthrough_label()) {
+        emit("j" + inverse_condition(cc) + " " + if_false);
+    } else {
+        emit("j" + cc + " " + if_true);
+        select_br(if_false);
+    }
+}
@@ -0,0 +1,240 @@
+#include "compile_cache.h"
+
+#include "../tool/sha256.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// First line of every entry; bump it when the entry or key format changes
+const std::string ENTRY_MAGIC = "code-cache-1";
+
+// Temporary files older than this were left by a compiler that died mid-store
+const auto STALE_TMP_AGE = std::chrono::hours(1);
+
+/**
+ * Random file name suffix, unique across threads and processes
+ */
+std::string unique_suffix() {
+    static const char DIGITS[] = "0123456789abcdef";
+    std::random_device random;
+    std::string suffix;
+    for (int i = 0; i < 4; ++i) {
+        uint32_t bits = random();
+        for (int j = 0; j < 8; ++j, bits >>= 4) {
+            suffix += DIGITS[bits & 0xf];
+        }
+    }
+    return suffix;
+}
+
+} // namespace
+
+CompileCache::CompileCache(std::filesystem::path directory, uint64_t max_bytes)
+    : entries_(directory / "entries"), tmp_(directory / "tmp"), events_(directory / "events"),
+      max_bytes_(max_bytes) {
+    std::error_code error;
+    std::filesystem::create_directories(entries_, error);
+    std::filesystem::create_directories(tmp_, error);
+}
+
+std::string CompileCache::key(std::string_view source, const CompileOptions &options,
+                              std::string_view profile_text, const std::string &build_id) {
+    // Length-prefixed fields, so no two option sets hash the same text.
+    // Thread counts are left out: the output does not depend on them.
+    Sha256 hash;
+    auto field = [&hash](std::string_view name, std::string_view value) {
+        hash.update(name);
+        hash.update("=" + std::to_string(value.size()) + ":");
+        hash.update(value);
+        hash.update("\n");
+    };
+    field("format", ENTRY_MAGIC);
+    field("build", build_id);
+    field("emit", options.emit == CompileOptions::Emit::ASM ? "asm" : "llvm");
+    field("static_storage.main_min_bytes",
+          std::to_string(options.static_storage.main_min_bytes));
+    field("static_storage.min_bytes", std::to_string(options.static_storage.min_bytes));
+    field("block_counters.output_path", options.block_counters.output_path);
+    field("profile", options.profile ? profile_text : std::string_view());
+    field("source", source);
+    return hash.hex_digest();
+}
+
+std::string CompileCache::build_id() {
+    static const std::string id = [] {
+        std::error_code error;
+        std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+        if (!error) {
+            uintmax_t size = std::filesystem::file_size(executable, error);
+            if (!error) {
+                auto time = std::filesystem::last_write_time(executable, error);
+                if (!error) {
+                    return executable.string() + ":" + std::to_string(size) + ":" +
+                           std::to_string(time.time_since_epoch().count());
+                }
+            }
+        }
+        // No /proc: the time this file was compiled
+        return std::string(__DATE__ " " __TIME__);
+    }();
+    return id;
+}
+
+bool CompileCache::lookup(const std::string &key, int &exit_code, std::ostream &diagnostics,
+                          std::ostream &output) {
+    std::filesystem::path path = entries_ / key;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        record('m');
+        return false;
+    }
+
+    // "<magic>\n<exit code> <diagnostics bytes> <output bytes>\n" + diagnostics + output
+    std::string magic;
+    int code = 0;
+    uint64_t diagnostics_size = 0;
+    uint64_t output_size = 0;
+    std::getline(in, magic);
+    in >> code >> diagnostics_size >> output_size;
+    std::error_code error;
+    uint64_t file_size = std::filesystem::file_size(path, error);
+    if (!in || in.get() != '\n' || magic != ENTRY_MAGIC || error ||
+        static_cast<uint64_t>(in.tellg()) + diagnostics_size + output_size != file_size) {
+        std::filesystem::remove(path, error);
+        record('m');
+        return false;
+    }
+
+    char buffer[64 * 1024];
+    auto copy = [&in, &buffer](uint64_t size, std::ostream &out) {
+        while (in && size > 0) {
+            uint64_t chunk = std::min<uint64_t>(sizeof buffer, size);
+            in.read(buffer, static_cast<std::streamsize>(chunk));
+            out.write(buffer, in.gcount());
+            size -= static_cast<uint64_t>(in.gcount());
+        }
+    };
+    copy(diagnostics_size, diagnostics);
+    copy(output_size, output);
+    exit_code = code;
+
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    record('h');
+    return true;
+}
+
+bool CompileCache::store(const std::string &key, int exit_code, std::string_view diagnostics,
+                         std::string_view output) {
+    std::error_code error;
+    std::filesystem::path tmp = tmp_ / (key + "." + unique_suffix());
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        out << ENTRY_MAGIC << "\n"
+            << exit_code << " " << diagnostics.size() << " " << output.size() << "\n";
+        out.write(diagnostics.data(), static_cast<std::streamsize>(diagnostics.size()));
+        out.write(output.data(), static_cast<std::streamsize>(output.size()));
+        out.close();
+        if (!out) {
+            std::filesystem::remove(tmp, error);
+            return false;
+        }
+    }
+    // rename replaces an entry stored meanwhile by another compiler atomically
+    std::filesystem::rename(tmp, entries_ / key, error);
+    if (error) {
+        std::filesystem::remove(tmp, error);
+        return false;
+    }
+    record('s');
+    evict();
+    return true;
+}
+
+CompileCache::Stats CompileCache::stats() const {
+    Stats stats;
+    std::ifstream in(events_, std::ios::binary);
+    for (char event; in.get(event);) {
+        switch (event) {
+        case 'h':
+            ++stats.hits;
+            break;
+        case 'm':
+            ++stats.misses;
+            break;
+        case 's':
+            ++stats.stores;
+            break;
+        case 'e':
+            ++stats.evictions;
+            break;
+        }
+    }
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(entries_, error), end; !error && it != end;
+         it.increment(error)) {
+        std::error_code size_error;
+        uint64_t size = it->file_size(size_error);
+        if (!size_error) {
+            ++stats.entries;
+            stats.bytes += size;
+        }
+    }
+    return stats;
+}
+
+void CompileCache::record(char event) const {
+    // One byte in append mode is one atomic write, even with other processes appending
+    std::ofstream out(events_, std::ios::app | std::ios::binary);
+    out.put(event);
+}
+
+void CompileCache::evict() {
+    struct File {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<File> files;
+    uint64_t total = 0;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(entries_, error), end; !error && it != end;
+         it.increment(error)) {
+        std::error_code file_error;
+        File file{it->path(), it->last_write_time(file_error), 0};
+        file.size = file_error ? 0 : it->file_size(file_error);
+        if (!file_error) {
+            total += file.size;
+            files.push_back(std::move(file));
+        }
+    }
+
+    if (total > max_bytes_) {
+        std::sort(files.begin(), files.end(),
+                  [](const File &a, const File &b) { return a.time < b.time; });
+        for (const File &file : files) {
+            if (total <= max_bytes_) {
+                break;
+            }
+            std::error_code remove_error;
+            if (std::filesystem::remove(file.path, remove_error)) {
+                record('e');
+            }
+            total -= file.size;
+        }
+    }
+
+    auto stale = std::filesystem::file_time_type::clock::now() - STALE_TMP_AGE;
+    for (std::filesystem::directory_iterator it(tmp_, error), end; !error && it != end;
+         it.increment(error)) {
+        std::error_code file_error;
+        if (it->last_write_time(file_error) < stale && !file_error) {
+            std::filesystem::remove(it->path(), file_error);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "compiler.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * CompileCache - On-disk cache of compilation results, addressed by content
+ *
+ * Core responsibilities:
+ * 1. Key a compilation by the SHA-256 of the source text, the compiler build
+ *    and every option that changes the output (key)
+ * 2. Store what the compilation printed: exit code, diagnostics and output
+ *    (IR or assembly), failed compilations included (store)
+ * 3. Stream a stored output back without running any phase (lookup)
+ * 4. Keep the cache under a size bound, evicting least recently used
+ *    entries first, and count hits, misses, stores and evictions (stats)
+ *
+ * Layout of the cache directory:
+ *   entries/<key>  one file per compilation
+ *   tmp/           entries being written; each is renamed into entries/
+ *                  once complete, so readers never see a partial entry
+ *   events         one byte appended per event (h, m, s, e); appends are
+ *                  atomic, so concurrent compilers can share a cache
+ *
+ * An entry's modification time is its last use: a hit touches it, and
+ * eviction removes the oldest entries until the total size is at most
+ * max_bytes. Unreadable or truncated entries count as misses.
+ *
+ * Example:
+ *   CompileCache cache("/var/cache/code", 512 << 20);
+ *   std::string key = CompileCache::key(source, options);
+ *   if (!cache.lookup(key, exit_code, std::cerr, std::cout)) {
+ *       ... compile, print ...
+ *       cache.store(key, exit_code, diagnostics, output);
+ *   }
+ */
+class CompileCache {
+  public:
+    /**
+     * Counters of the events recorded in a cache, and its current contents
+     */
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    /**
+     * @param directory Cache directory, created if missing
+     * @param max_bytes Bound on the total size of the entries
+     */
+    CompileCache(std::filesystem::path directory, uint64_t max_bytes);
+
+    /**
+     * Key of a compilation
+     * @param profile_text Text of the block profile used, if any (options.profile
+     *                     is only a pointer, so its content is passed here)
+     * @param build_id Identity of the compiler, see build_id()
+     * @return 64 hex digits
+     */
+    static std::string key(std::string_view source, const CompileOptions &options,
+                           std::string_view profile_text = {},
+                           const std::string &build_id = CompileCache::build_id());
+
+    /**
+     * Identity of the running compiler build: size and modification time of
+     * the executable, so any rebuild invalidates the cache
+     */
+    static std::string build_id();
+
+    /**
+     * Look up a compilation; on a hit, write its stored diagnostics and then
+     * its output, in chunks
+     * @return false on a miss (nothing written)
+     */
+    bool lookup(const std::string &key, int &exit_code, std::ostream &diagnostics,
+                std::ostream &output);
+
+    /**
+     * Store a compilation, then evict entries if the cache is over its bound
+     * @return false if the entry could not be written (the cache is optional,
+     *         so callers may ignore this)
+     */
+    bool store(const std::string &key, int exit_code, std::string_view diagnostics,
+               std::string_view output);
+
+    Stats stats() const;
+
+  private:
+    std::filesystem::path entries_;
+    std::filesystem::path tmp_;
+    std::filesystem::path events_;
+    uint64_t max_bytes_;
+
+    void record(char event) const;
+    void evict();
+};
@@ -0,0 +1,161 @@
+#include "compiler.h"
+
+#include "../backend/ir_parser.h"
+#include "../backend/x86_64_backend.h"
+#include "../ir/ir_generator.h"
+#include "../lexer/lexer.h"
+#include "../pre_processor/pre_processor.h"
+#include "../semantic/semantic.h"
+#include "../tool/thread_pool.h"
+#include "incremental.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+Compiler::Compiler(const CompileOptions &options)
+    : options_(options), parser_(no_tokens_, no_errors_) {}
+
+CompileResult Compiler::compile(std::string_view source) {
+    return compile(source, nullptr);
+}
+
+CompileResult Compiler::compile(std::string_view source, const OutputSink &sink) {
+    CompileResult result;
+    ErrorReporter error_reporter(result.diagnostics, options_.on_diagnostic);
+    auto fail = [&result](CompileStage stage) {
+        result.failed_stage = stage;
+        return result;
+    };
+
+    // The preprocessed text and the tokens are released once parsed, so
+    // they are not alive next to the symbol tables and the IR
+    std::shared_ptr<Program> ast;
+    std::unique_ptr<IncrementalState> incremental;
+    {
+        std::istringstream in{std::string(source)};
+        Prog program = read_program(in);
+        if (options_.incremental_dir.empty()) {
+            // The parser pulls each token from the lexer as it needs it, so
+            // the token sequence never exists as a whole. At its first error
+            // the parser lexes the rest of the program, so the lexer errors
+            // are known by then: a program with lexer errors fails at the
+            // lexer stage and reports only those, as if lexed first
+            ErrorReporter lexer_errors([&error_reporter](const Diagnostic &diagnostic) {
+                error_reporter.report_error(diagnostic.message, diagnostic.line,
+                                            diagnostic.column);
+            });
+            ErrorReporter parser_errors([&](const Diagnostic &diagnostic) {
+                if (!lexer_errors.has_errors()) {
+                    error_reporter.report_error(diagnostic.message, diagnostic.line,
+                                                diagnostic.column);
+                }
+            });
+            Lexer lexer(program, lexer_errors);
+            parser_.reset(lexer, parser_errors);
+            ast = parser_.parse();
+            parser_.reset(no_tokens_, no_errors_);
+            if (lexer_errors.has_errors()) {
+                return fail(CompileStage::LEXER);
+            }
+        } else {
+            // Source digests are computed from the tokens, so they are kept
+            vector<Token> tokens = lexer_program(program, error_reporter);
+            program = Prog();
+            if (error_reporter.has_errors()) {
+                return fail(CompileStage::LEXER);
+            }
+            parser_.reset(tokens, error_reporter);
+            ast = parser_.parse();
+            parser_.reset(no_tokens_, no_errors_);
+            if (ast && !error_reporter.has_errors()) {
+                incremental = std::make_unique<IncrementalState>(options_.incremental_dir);
+                incremental->index(*ast, tokens);
+            }
+        }
+        if (!ast || error_reporter.has_errors()) {
+            return fail(CompileStage::PARSER);
+        }
+    }
+
+    // Everything below is owned by this compilation: symbol tables live in
+    // Semantic, types in builtin_types and the AST, the emitter in ir_gen
+    BuiltinTypes builtin_types;
+    Semantic(ast, error_reporter, builtin_types, options_.check_threads);
+    if (error_reporter.has_errors()) {
+        return fail(CompileStage::SEMANTIC);
+    }
+
+    IRGenerator ir_gen(builtin_types, options_.static_storage, options_.block_counters,
+                       options_.profile);
+    ir_gen.set_error_reporter(&error_reporter);
+    ir_gen.set_threads(options_.ir_threads);
+    if (incremental) {
+        ir_gen.set_unit_store(incremental.get());
+    }
+    auto finish_incremental = [&] {
+        if (incremental) {
+            incremental->finish();
+            result.reused_units = incremental->reused();
+            result.generated_units = incremental->generated();
+        }
+    };
+
+    // LLVM output for a sink is written function by function, never whole
+    if (sink && options_.emit == CompileOptions::Emit::LLVM) {
+        ir_gen.generate(ast.get(), sink);
+        finish_incremental();
+        result.ok = true;
+        return result;
+    }
+
+    std::string output = ir_gen.generate(ast.get());
+    finish_incremental();
+
+    if (options_.emit == CompileOptions::Emit::ASM) {
+        IRModule module;
+        std::string assembly;
+        if (!IRParser(error_reporter).parse(output, module) ||
+            !X86Backend(module, error_reporter).generate(assembly)) {
+            return fail(CompileStage::BACKEND);
+        }
+        output = std::move(assembly);
+    }
+
+    result.ok = true;
+    if (sink) {
+        sink(output);
+    } else {
+        result.output = std::move(output);
+    }
+    return result;
+}
+
+CompileResult compile(std::string_view source, const CompileOptions &options) {
+    return Compiler(options).compile(source);
+}
+
+CompileResult compile(std::string_view source, const CompileOptions &options,
+                      const OutputSink &sink) {
+    return Compiler(options).compile(source, sink);
+}
+
+std::vector<CompileResult> compile_parallel(const std::vector<std::string_view> &sources,
+                                            const CompileOptions &options, size_t threads) {
+    std::vector<CompileResult> results(sources.size());
+    if (threads == 0) {
+        threads = ThreadPool::hardware_threads();
+    }
+    threads = std::max<size_t>(1, std::min(threads, sources.size()));
+
+    ThreadPool pool(threads);
+    std::vector<std::unique_ptr<Compiler>> compilers;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        compilers.push_back(std::make_unique<Compiler>(options));
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        pool.submit([&, i](size_t worker) { results[i] = compilers[worker]->compile(sources[i]); });
+    }
+    pool.wait();
+    return results;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../error/error.h"
+#include "../ir/block_counters.h"
+#include "../ir/block_profile.h"
+#include "../ir/static_storage.h"
+#include "../parser/parser.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Options of a compilation
+ * profile: block counts for branch weights and block layout, may be null;
+ *          must outlive the compilations that use it
+ * check_threads: threads type checking function bodies, 0 for one per
+ *                hardware thread; the diagnostics are the same for any number
+ * ir_threads: threads generating the IR of functions, 0 for one per
+ *             hardware thread; the output is the same for any number
+ * incremental_dir: keep the IR of each function there and reuse it while
+ *                  the function and what it depends on are unchanged (see
+ *                  IncrementalState); empty for none
+ * on_diagnostic: called with each diagnostic as soon as it is reported, in
+ *                addition to CompileResult::diagnostics (e.g., to print it
+ *                even if a later phase crashes); with compile_parallel it
+ *                is called from several threads
+ */
+struct CompileOptions {
+    enum class Emit { LLVM, ASM };
+
+    Emit emit = Emit::LLVM;
+    StaticStorageOptions static_storage;
+    BlockCounterOptions block_counters; // Off by default
+    const BlockProfile *profile = nullptr;
+    size_t check_threads = 1;
+    size_t ir_threads = 1;
+    std::string incremental_dir;
+    DiagnosticSink on_diagnostic;
+};
+
+/**
+ * Phase that stopped a compilation
+ */
+enum class CompileStage { NONE, LEXER, PARSER, SEMANTIC, BACKEND };
+
+/**
+ * Outcome of a compilation
+ * output: LLVM IR or assembly; empty if the compilation failed or the
+ *         output went to a sink
+ * diagnostics: errors and warnings of all phases, in report order
+ * reused_units, generated_units: with incremental_dir, functions whose IR
+ *                                was reused or generated
+ */
+struct CompileResult {
+    bool ok = false;
+    CompileStage failed_stage = CompileStage::NONE;
+    std::string output;
+    std::vector<Diagnostic> diagnostics;
+    size_t reused_units = 0;
+    size_t generated_units = 0;
+};
+
+/**
+ * Receives the output of a successful compilation, possibly in several
+ * pieces to be concatenated
+ */
+using OutputSink = std::function<void(std::string_view)>;
+
+/**
+ * Compiler - In-memory compilation of source text
+ *
+ * Core responsibilities:
+ * 1. Run preprocessing, lexing, parsing, semantic analysis and IR
+ *    generation on a source string, and the x86-64 backend for Emit::ASM
+ * 2. Collect diagnostics as data instead of printing them
+ * 3. Hand the output back in the result or to a caller-provided sink
+ *
+ * A Compiler can be reused: the parser's rule tables are built once, every
+ * compilation gets fresh builtin types, symbol tables and IR generator.
+ * Compilations share no mutable state, so separate Compilers may run on
+ * separate threads; one Compiler must not be used by two threads at once
+ * (see compile_parallel).
+ *
+ * Example:
+ *   Compiler compiler;
+ *   CompileResult result = compiler.compile("fn main() { exit(0); }");
+ *   if (!result.ok) {
+ *       for (const auto &diagnostic : result.diagnostics) {
+ *           std::cerr << diagnostic.to_string() << "\n";
+ *       }
+ *   }
+ */
+class Compiler {
+  public:
+    explicit Compiler(const CompileOptions &options = CompileOptions());
+
+    CompileResult compile(std::string_view source);
+
+    /**
+     * Compile, passing the output to sink instead of CompileResult::output
+     * LLVM IR is passed in pieces as each top-level item is generated, so
+     * the whole module is never held in memory; assembly is passed at once.
+     * The sink is not called if the compilation fails.
+     */
+    CompileResult compile(std::string_view source, const OutputSink &sink);
+
+    const CompileOptions &options() const { return options_; }
+
+  private:
+    CompileOptions options_;
+    std::vector<Token> no_tokens_;
+    ErrorReporter no_errors_;
+    Parser parser_; // Reset to each program's tokens
+};
+
+/**
+ * Compile one program with a temporary Compiler
+ */
+CompileResult compile(std::string_view source, const CompileOptions &options = CompileOptions());
+CompileResult compile(std::string_view source, const CompileOptions &options,
+                      const OutputSink &sink);
+
+/**
+ * Compile independent programs on a work-stealing thread pool
+ *
+ * Each worker reuses one Compiler. The sources must stay valid until the
+ * call returns.
+ *
+ * @param threads Number of workers, 0 for one per hardware thread
+ * @return One result per source, in the order of sources
+ */
+std::vector<CompileResult> compile_parallel(const std::vector<std::string_view> &sources,
+                                            const CompileOptions &options = CompileOptions(),
+                                            size_t threads = 0);
@@ -0,0 +1,240 @@
+#include "incremental.h"
+
+#include "../tool/sha256.h"
+#include "compile_cache.h"
+
+#include <fstream>
+#include <map>
+
+namespace {
+
+// First line of every unit file; bump it when the format changes
+const std::string UNIT_MAGIC = "code-unit-1";
+
+/**
+ * Canonical text of tokens [begin, end): type, lexeme size and lexeme of
+ * each, so whitespace and comments do not matter but every token does
+ */
+std::string token_text(const std::vector<Token> &tokens, size_t begin, size_t end) {
+    std::string text;
+    for (size_t i = begin; i < end && i < tokens.size(); ++i) {
+        const std::string &lexeme = tokens[i].lexeme;
+        text += static_cast<char>(tokens[i].type);
+        // Size in base 128, low digits first, the high bit marking more digits
+        size_t size = lexeme.size();
+        do {
+            char digit = static_cast<char>(size & 0x7f);
+            size >>= 7;
+            text += static_cast<char>(digit | (size ? 0x80 : 0));
+        } while (size);
+        text += lexeme;
+    }
+    return text;
+}
+
+/**
+ * Tokens of an impl block up to and including its '{'
+ */
+std::string impl_header(const std::vector<Token> &tokens, const ImplBlock &impl) {
+    size_t end = impl.token_begin;
+    while (end < impl.token_end && end < tokens.size() &&
+           tokens[end].type != TokenType::LEFT_BRACE) {
+        ++end;
+    }
+    return token_text(tokens, impl.token_begin, end + 1);
+}
+
+/**
+ * Read "<size>\n" followed by size bytes
+ */
+bool read_string(std::istream &in, std::string &value) {
+    size_t size = 0;
+    if (!(in >> size) || in.get() != '\n') {
+        return false;
+    }
+    value.resize(size);
+    in.read(value.data(), static_cast<std::streamsize>(size));
+    return static_cast<size_t>(in.gcount()) == size;
+}
+
+void write_string(std::ostream &out, const std::string &value) {
+    out << value.size() << "\n";
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+} // namespace
+
+IncrementalState::IncrementalState(std::filesystem::path directory)
+    : units_(directory / "units") {
+    std::error_code error;
+    std::filesystem::create_directories(units_, error);
+}
+
+/**
+ * Digest every unit of a program.
+ *
+ * A unit's digest covers:
+ * - its own tokens, signature and body (and the header of its impl block)
+ * - the signatures of all functions and methods named like an identifier
+ *   of its body, which fix the types of its calls
+ * - the tokens of every struct, enum, const and impl header, which fix
+ *   layouts, const values and method lookup
+ * - the compiler build, so a rebuilt compiler generates every unit again
+ *
+ * Identifiers that are local names only make the digest more specific, so
+ * an edit can invalidate more units than it needs to, never fewer.
+ */
+void IncrementalState::index(const Program &program, const std::vector<Token> &tokens) {
+    digests_.clear();
+
+    struct Function {
+        FnDecl *decl;
+        std::string header; // Impl header for methods
+    };
+    std::vector<Function> functions;
+    std::map<std::string, std::string> signatures;
+    Sha256 types_hash;
+    types_hash.update(CompileCache::build_id());
+
+    for (const auto &item : program.items) {
+        if (!item) {
+            continue;
+        }
+        if (auto fn_decl = dynamic_cast<FnDecl *>(item.get())) {
+            functions.push_back({fn_decl, ""});
+        } else if (auto impl = dynamic_cast<ImplBlock *>(item.get())) {
+            std::string header = impl_header(tokens, *impl);
+            types_hash.update(header);
+            for (const auto &impl_item : impl->implemented_items) {
+                if (auto fn_decl = dynamic_cast<FnDecl *>(impl_item.get())) {
+                    functions.push_back({fn_decl, header});
+                }
+            }
+        } else {
+            types_hash.update(token_text(tokens, item->token_begin, item->token_end));
+        }
+    }
+    std::string types_digest = types_hash.hex_digest();
+
+    for (const Function &function : functions) {
+        signatures[function.decl->name.lexeme] +=
+            function.header +
+            token_text(tokens, function.decl->token_begin, function.decl->body_token_begin);
+    }
+
+    for (const Function &function : functions) {
+        FnDecl *decl = function.decl;
+        std::set<std::string> names;
+        for (size_t i = decl->body_token_begin; i < decl->token_end && i < tokens.size(); ++i) {
+            if (tokens[i].type == TokenType::IDENTIFIER) {
+                names.insert(tokens[i].lexeme);
+            }
+        }
+
+        Sha256 hash;
+        hash.update(types_digest);
+        hash.update(function.header);
+        hash.update(token_text(tokens, decl->token_begin, decl->token_end));
+        for (const std::string &name : names) {
+            auto it = signatures.find(name);
+            if (it != signatures.end()) {
+                hash.update(it->second);
+            }
+        }
+        digests_[decl] = hash.hex_digest();
+    }
+}
+
+std::string IncrementalState::source_digest(FnDecl *decl) const {
+    auto it = digests_.find(decl);
+    return it != digests_.end() ? it->second : std::string();
+}
+
+bool IncrementalState::load(const std::string &key, GeneratedUnit &unit) {
+    std::ifstream in(units_ / key, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    // "<magic>\n<metadata count> <constants> <diagnostics>\n", then each
+    // constant key, each diagnostic, and the IR as length-prefixed strings
+    std::string magic;
+    size_t constants = 0;
+    size_t diagnostics = 0;
+    GeneratedUnit loaded;
+    std::getline(in, magic);
+    if (magic != UNIT_MAGIC ||
+        !(in >> loaded.metadata_count >> constants >> diagnostics) || in.get() != '\n') {
+        return false;
+    }
+    loaded.const_globals.resize(constants);
+    for (std::string &constant : loaded.const_globals) {
+        if (!read_string(in, constant)) {
+            return false;
+        }
+    }
+    loaded.diagnostics.resize(diagnostics);
+    for (Diagnostic &diagnostic : loaded.diagnostics) {
+        int severity = 0;
+        if (!(in >> severity >> diagnostic.line >> diagnostic.column) || in.get() != ' ' ||
+            !read_string(in, diagnostic.message)) {
+            return false;
+        }
+        diagnostic.severity = static_cast<Diagnostic::Severity>(severity);
+    }
+    if (!read_string(in, loaded.ir) || in.peek() != std::char_traits<char>::eof()) {
+        return false;
+    }
+
+    unit = std::move(loaded);
+    used_.insert(key);
+    ++reused_;
+    return true;
+}
+
+void IncrementalState::store(const std::string &key, const GeneratedUnit &unit) {
+    used_.insert(key);
+    ++generated_;
+
+    std::error_code error;
+    std::filesystem::path tmp = units_ / (key + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        out << UNIT_MAGIC << "\n"
+            << unit.metadata_count << " " << unit.const_globals.size() << " "
+            << unit.diagnostics.size() << "\n";
+        for (const std::string &constant : unit.const_globals) {
+            write_string(out, constant);
+        }
+        for (const Diagnostic &diagnostic : unit.diagnostics) {
+            out << static_cast<int>(diagnostic.severity) << " " << diagnostic.line << " "
+                << diagnostic.column << " ";
+            write_string(out, diagnostic.message);
+        }
+        write_string(out, unit.ir);
+        out.close();
+        if (!out) {
+            std::filesystem::remove(tmp, error);
+            return;
+        }
+    }
+    // A unit is reused only once complete
+    std::filesystem::rename(tmp, units_ / key, error);
+    if (error) {
+        std::filesystem::remove(tmp, error);
+    }
+}
+
+void IncrementalState::finish() {
+    std::vector<std::filesystem::path> unused;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(units_, error), end; !error && it != end;
+         it.increment(error)) {
+        if (!used_.count(it->path().filename().string())) {
+            unused.push_back(it->path());
+        }
+    }
+    for (const auto &path : unused) {
+        std::filesystem::remove(path, error);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../ir/ir_generator.h"
+#include "../lexer/lexer.h"
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * IncrementalState - Function units of earlier compilations of one program
+ *
+ * Core responsibilities:
+ * 1. Digest each top-level function and impl method from its tokens, the
+ *    signatures of the functions and methods it names, the tokens of every
+ *    struct, enum, const and impl header, and the compiler build (index,
+ *    source_digest)
+ * 2. Keep the generated IR of each unit on disk under the key IRGenerator
+ *    derives from that digest (load, store)
+ * 3. Drop the units the last compilation did not use (finish)
+ *
+ * Lexing, parsing and semantic analysis still run on the whole program: the
+ * module analyses read the types of every body. IR generation, the most
+ * expensive phase, only runs for the units whose key changed.
+ *
+ * Layout of the directory:
+ *   units/<key>  one file per unit: constant globals, metadata count,
+ *                warnings and IR; written to <key>.tmp, then renamed
+ *
+ * A directory belongs to one program and one compiler at a time.
+ *
+ * Example:
+ *   IncrementalState state("build/prog.inc");
+ *   state.index(*ast, tokens);
+ *   ir_gen.set_unit_store(&state);
+ *   std::string ir = ir_gen.generate(ast.get());
+ *   state.finish();
+ */
+class IncrementalState : public FunctionUnitStore {
+  public:
+    /**
+     * @param directory State directory, created if missing
+     */
+    explicit IncrementalState(std::filesystem::path directory);
+
+    /**
+     * Compute the source digests of a program
+     * @param tokens Tokens the program was parsed from (the AST token spans
+     *               index them)
+     */
+    void index(const Program &program, const std::vector<Token> &tokens);
+
+    std::string source_digest(FnDecl *decl) const override;
+    bool load(const std::string &key, GeneratedUnit &unit) override;
+    void store(const std::string &key, const GeneratedUnit &unit) override;
+
+    /**
+     * Remove the units not loaded or stored since construction
+     */
+    void finish();
+
+    size_t reused() const { return reused_; }
+    size_t generated() const { return generated_; }
+
+  private:
+    std::filesystem::path units_;
+    std::unordered_map<FnDecl *, std::string> digests_;
+    std::set<std::string> used_;
+    size_t reused_ = 0;
+    size_t generated_ = 0;
+};
@@ -1,20 +1,31 @@
 // error.cpp
 #include "error.h"
-void ErrorReporter::report_error(const std::string &message, int line, int column) {
-    has_errors_ = true;
-    std::cerr << "Error";
+
+std::string Diagnostic::to_string() const {
+    std::string text = severity == Severity::ERROR ? "Error" : "Warning";
     if (line >= 0)
-        std::cerr << " at line " << line;
+        text += " at line " + std::to_string(line);
     if (column >= 0)
-        std::cerr << ", column " << column;
-    std::cerr << ": " << message << std::endl;
+        text += ", column " + std::to_string(column);
+    return text + ": " + message;
+}
+
+void ErrorReporter::report_error(const std::string &message, int line, int column) {
+    has_errors_ = true;
+    report({Diagnostic::Severity::ERROR, message, line, column});
 }
 
 void ErrorReporter::report_warning(const std::string &message, int line, int column) {
-    std::cerr << "Warning";
-    if (line >= 0)
-        std::cerr << " at line " << line;
-    if (column >= 0)
-        std::cerr << ", column " << column;
-    std::cerr << ": " << message << std::endl;
-}
\ No newline at end of file
+    report({Diagnostic::Severity::WARNING, message, line, column});
+}
+
+void ErrorReporter::report(Diagnostic diagnostic) {
+    if (sink_) {
+        sink_(diagnostic);
+    }
+    if (diagnostics_) {
+        diagnostics_->push_back(std::move(diagnostic));
+    } else if (!sink_) {
+        std::cerr << diagnostic.to_string() << std::endl;
+    }
+}
@@ -1,13 +1,50 @@
 #pragma once
+#include <functional>
 #include <iostream>
 #include <string>
+#include <vector>
+
+/**
+ * One reported error or warning
+ * line/column: -1 if unknown
+ */
+struct Diagnostic {
+    enum class Severity { ERROR, WARNING };
+
+    Severity severity = Severity::ERROR;
+    std::string message;
+    int line = -1;
+    int column = -1;
+
+    // Error at line 3, column 5: message
+    std::string to_string() const;
+};
+
+/**
+ * Receives each diagnostic as it is reported
+ */
+using DiagnosticSink = std::function<void(const Diagnostic &)>;
 
 class ErrorReporter {
   public:
+    // Print diagnostics to std::cerr
+    ErrorReporter() = default;
+    // Collect diagnostics into a list instead of printing them
+    explicit ErrorReporter(std::vector<Diagnostic> &diagnostics) : diagnostics_(&diagnostics) {}
+    // Pass diagnostics to sink instead of printing them
+    explicit ErrorReporter(DiagnosticSink sink) : sink_(std::move(sink)) {}
+    // Collect diagnostics into a list, and pass each to sink as it is reported
+    ErrorReporter(std::vector<Diagnostic> &diagnostics, DiagnosticSink sink)
+        : diagnostics_(&diagnostics), sink_(std::move(sink)) {}
+
     void report_error(const std::string &message, int line = -1, int column = -1);
     void report_warning(const std::string &message, int line = -1, int column = -1);
     bool has_errors() const { return has_errors_; }
 
   private:
     bool has_errors_ = false;
-};
\ No newline at end of file
+    std::vector<Diagnostic> *diagnostics_ = nullptr;
+    DiagnosticSink sink_;
+
+    void report(Diagnostic diagnostic);
+};
@@ -0,0 +1,95 @@
+#include "abi.h"
+
+bool AbiLowering::is_flattened(const Type *type) { return !scalars(type).empty(); }
+
+const std::vector<AbiScalar> &AbiLowering::scalars(const Type *type) {
+    static const std::vector<AbiScalar> none;
+    if (!type || (type->kind != TypeKind::ARRAY && type->kind != TypeKind::STRUCT)) {
+        return none;
+    }
+
+    std::string ir_type = type_mapper_.map(type);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = cache_.find(ir_type);
+        if (it != cache_.end()) {
+            return it->second;
+        }
+    }
+
+    std::vector<AbiScalar> leaves;
+    size_t size = data_layout_.size_of(type);
+    if (size > 0 && size <= MAX_FLATTENED_BYTES) {
+        std::vector<std::string> indices = {"i64 0"};
+        if (!flatten(type, indices, leaves) || leaves.size() > MAX_FLATTENED_SCALARS) {
+            leaves.clear();
+        }
+    }
+    // Map nodes never move, so the reference stays valid
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return cache_.emplace(ir_type, std::move(leaves)).first->second;
+}
+
+std::string AbiLowering::return_type(const Type *type) {
+    const auto &leaves = scalars(type);
+    if (leaves.size() == 1) {
+        return leaves.front().type;
+    }
+
+    std::string result = "{ ";
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        result += (i > 0 ? ", " : "") + leaves[i].type;
+    }
+    return result + " }";
+}
+
+bool AbiLowering::flatten(const Type *type, std::vector<std::string> &indices,
+                          std::vector<AbiScalar> &leaves) {
+    if (leaves.size() > MAX_FLATTENED_SCALARS) {
+        return false;
+    }
+
+    switch (type->kind) {
+    case TypeKind::I32:
+    case TypeKind::U32:
+    case TypeKind::ISIZE:
+    case TypeKind::USIZE:
+    case TypeKind::BOOL:
+    case TypeKind::CHAR:
+    case TypeKind::ANY_INTEGER:
+    case TypeKind::REFERENCE:
+    case TypeKind::RAW_POINTER:
+        leaves.push_back({type_mapper_.map(type), indices});
+        return true;
+
+    case TypeKind::ARRAY: {
+        auto array_type = static_cast<const ArrayType *>(type);
+        for (size_t i = 0; i < array_type->size; ++i) {
+            indices.push_back("i64 " + std::to_string(i));
+            bool ok = flatten(array_type->element_type.get(), indices, leaves);
+            indices.pop_back();
+            if (!ok) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    case TypeKind::STRUCT: {
+        const StructLayout &layout =
+            data_layout_.struct_layout(static_cast<const StructType *>(type));
+        for (size_t i = 0; i < layout.field_types.size(); ++i) {
+            indices.push_back("i32 " + std::to_string(i));
+            bool ok = flatten(layout.field_types[i], indices, leaves);
+            indices.pop_back();
+            if (!ok) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../semantic/semantic.h"
+#include "data_layout.h"
+#include "type_mapper.h"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * AbiScalar - One scalar of a flattened aggregate
+ * type: IR scalar type (e.g., "i32")
+ * indices: GEP indices from the aggregate pointer (e.g., {"i64 0", "i32 1"})
+ */
+struct AbiScalar {
+    std::string type;
+    std::vector<std::string> indices;
+};
+
+/**
+ * AbiLowering - How by-value aggregates cross function boundaries
+ *
+ * Core responsibilities:
+ * 1. Classify array and struct types by size
+ * 2. Flatten small aggregates into their scalar leaves (memory order)
+ * 3. Provide the IR type a flattened aggregate is returned as
+ *
+ * Classes:
+ * - Small (size <= MAX_FLATTENED_BYTES, at most MAX_FLATTENED_SCALARS
+ *   leaves): passed as one parameter per leaf, returned as the single leaf
+ *   or a literal struct of the leaves
+ * - Everything else: passed as a pointer (copied by the callee), structs
+ *   returned through sret, arrays returned as a first-class value
+ *
+ * Example:
+ *   struct Point { x: i32, y: i32 }
+ *   fn add(a: Point, b: Point) -> Point
+ *   ->
+ *   define { i32, i32 } @add(i32 %a.0, i32 %a.1, i32 %b.0, i32 %b.1)
+ *
+ * Caller and callee classify by the declared type alone, so both sides
+ * always agree.
+ */
+class AbiLowering {
+  public:
+    static constexpr size_t MAX_FLATTENED_BYTES = 16;
+    static constexpr size_t MAX_FLATTENED_SCALARS = 4;
+
+    AbiLowering(DataLayout &data_layout, TypeMapper &type_mapper)
+        : data_layout_(data_layout), type_mapper_(type_mapper) {}
+
+    /**
+     * Check if a by-value type is passed and returned as scalars
+     * @return false for scalars and large aggregates
+     */
+    bool is_flattened(const Type *type);
+
+    /**
+     * Get the scalar leaves of a flattened aggregate
+     * @return Leaves in memory order, empty if the type is not flattened
+     */
+    const std::vector<AbiScalar> &scalars(const Type *type);
+
+    /**
+     * Get the IR return type of a flattened aggregate
+     * Example: "i32" (one leaf), "{ i32, i1 }" (several leaves)
+     */
+    std::string return_type(const Type *type);
+
+  private:
+    DataLayout &data_layout_;
+    TypeMapper &type_mapper_;
+
+    // Leaves by IR type, empty for types that are not flattened; guarded by
+    // mutex_ so one AbiLowering can serve several IR generating threads
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::vector<AbiScalar>> cache_;
+
+    /**
+     * Append the leaves of type at GEP path indices
+     * @return false if some leaf cannot be passed as a scalar
+     */
+    bool flatten(const Type *type, std::vector<std::string> &indices,
+                 std::vector<AbiScalar> &leaves);
+};
@@ -0,0 +1,115 @@
+#include "block_counters.h"
+
+#include <cstdio>
+
+namespace {
+
+/**
+ * LLVM c"..." literal of text with a terminating NUL
+ * @return The literal and its size in bytes
+ */
+std::pair<std::string, size_t> c_string(const std::string &text) {
+    std::string literal = "c\"";
+    for (unsigned char c : text) {
+        if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\') {
+            literal += static_cast<char>(c);
+        } else {
+            char escaped[4];
+            std::snprintf(escaped, sizeof(escaped), "\\%02X", c);
+            literal += escaped;
+        }
+    }
+    literal += "\\00\"";
+    return {literal, text.size() + 1};
+}
+
+} // namespace
+
+std::string BlockCounters::counter_name(const Block &block) {
+    return "__block_count." + block.function + "." + std::to_string(block.index);
+}
+
+std::vector<std::string> BlockCounters::add_block(const std::string &function,
+                                                  const std::string &label, int line) {
+    // The blocks of a function are added one after another
+    size_t index = 0;
+    if (!blocks_.empty() && blocks_.back().function == function) {
+        index = blocks_.back().index + 1;
+    }
+    blocks_.push_back({function, label, line, index});
+    line_pending_ = true;
+
+    std::string counter = "@" + counter_name(blocks_.back());
+    std::string value = "%block_count." + std::to_string(index);
+    return {value + " = load i64, i64* " + counter + ", align 8",
+            value + ".next = add i64 " + value + ", 1",
+            "store i64 " + value + ".next, i64* " + counter + ", align 8"};
+}
+
+void BlockCounters::note_line(int line) {
+    if (line_pending_ && line > 0) {
+        blocks_.back().line = line;
+        line_pending_ = false;
+    }
+}
+
+void BlockCounters::append(const BlockCounters &other) {
+    blocks_.insert(blocks_.end(), other.blocks_.begin(), other.blocks_.end());
+    line_pending_ = false;
+}
+
+void BlockCounters::emit_support(IREmitter &emitter) const {
+    if (!enabled()) {
+        return;
+    }
+
+    emitter.emit_function_declaration("i8*", "fopen", {"i8*", "i8*"});
+    emitter.emit_function_declaration("i32", "fprintf", {"i8*", "i8*"}, true);
+    emitter.emit_function_declaration("i32", "fclose", {"i8*"});
+    emitter.emit_blank_line();
+
+    // Returns the array type of the string
+    auto emit_string = [&emitter](const std::string &name, const std::string &text) {
+        auto [literal, size] = c_string(text);
+        std::string type = "[" + std::to_string(size) + " x i8]";
+        emitter.emit_global_variable(name, type, literal, true, "private unnamed_addr");
+        return type;
+    };
+
+    std::string path_type = emit_string(".block_counts.path", options_.output_path);
+    std::string mode_type = emit_string(".block_counts.mode", "w");
+    std::vector<std::string> key_types;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        const Block &block = blocks_[i];
+        emitter.emit_global_variable(counter_name(block), "i64", "0", false, "internal");
+        key_types.push_back(emit_string(".block_counts.key." + std::to_string(i),
+                                        block.function + " " + block.label + " " +
+                                            std::to_string(block.line) + " %llu\n"));
+    }
+
+    emitter.begin_function("void", DUMP_FUNCTION, {});
+    emitter.begin_basic_block("bb.entry");
+    std::string path =
+        emitter.emit_getelementptr(path_type, "@.block_counts.path", {"i32 0", "i32 0"});
+    std::string mode =
+        emitter.emit_getelementptr(mode_type, "@.block_counts.mode", {"i32 0", "i32 0"});
+    std::string file = emitter.emit_call("i8*", "fopen", {{"i8*", path}, {"i8*", mode}});
+    std::string failed = emitter.emit_icmp("eq", "i8*", file, "null");
+    emitter.emit_cond_br(failed, "bb.done", "bb.write");
+
+    emitter.begin_basic_block("bb.write");
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        std::string key = emitter.emit_getelementptr(
+            key_types[i], "@.block_counts.key." + std::to_string(i), {"i32 0", "i32 0"});
+        std::string count = emitter.emit_load("i64", "@" + counter_name(blocks_[i]));
+        emitter.emit_vararg_call("i32", "fprintf", "(i8*, i8*, ...)",
+                                 {{"i8*", file}, {"i8*", key}, {"i64", count}});
+    }
+    emitter.emit_call("i32", "fclose", {{"i8*", file}});
+    emitter.emit_br("bb.done");
+
+    emitter.begin_basic_block("bb.done");
+    emitter.emit_ret_void();
+    emitter.end_function();
+    emitter.emit_blank_line();
+}
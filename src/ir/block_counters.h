@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ir_emitter.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Options of block execution counting
+ * output_path: file the instrumented program writes its counts to when main
+ *              returns, empty disables the instrumentation
+ */
+struct BlockCounterOptions {
+    std::string output_path;
+};
+
+/**
+ * BlockCounters - Execution counters on basic blocks
+ *
+ * Core responsibilities:
+ * 1. Give every block started through IRGenerator::begin_block an internal
+ *    i64 counter (@__block_count.<function>.N, the N-th counted block of the
+ *    function) and the IR that increments it
+ * 2. Remember the function, label and source line of each counter
+ * 3. Emit the counters and @__block_counts_dump, which main calls right
+ *    before it returns. The dump writes one line per block:
+ *
+ *      <function> <label> <line> <count>
+ *      main bb.entry 1 1
+ *      main while.cond.0 4 11
+ *
+ * Placement:
+ * - The increment is the block prologue (IREmitter::set_block_prologue),
+ *   so it follows the phis of its block
+ * - Trampoline blocks of IREmitter::emit_cond_br are not counted: their
+ *   count is the count of the block they jump to
+ *
+ * Source lines: the line of the first token generated in the block, or of
+ * the last token before it when the block has none of its own (e.g., the
+ * join block of an if whose value is unused).
+ *
+ * Example:
+ *   ./code --instrument-blocks=counts.txt < prog.rs > prog.ll
+ *   lli prog.ll            # writes counts.txt
+ */
+class BlockCounters {
+  public:
+    explicit BlockCounters(const BlockCounterOptions &options = BlockCounterOptions())
+        : options_(options) {}
+
+    bool enabled() const { return !options_.output_path.empty(); }
+
+    /**
+     * Add a counter for a block
+     * @param line Source line to use if no token follows in the block
+     * @return IR lines incrementing the counter
+     */
+    std::vector<std::string> add_block(const std::string &function, const std::string &label,
+                                       int line);
+
+    /**
+     * Record a source token: the first one after add_block sets the line of
+     * that block
+     */
+    void note_line(int line);
+
+    /**
+     * Add the blocks of other, counted separately (e.g., by the generator of
+     * a function unit), after those of this
+     * Counter names only depend on the function, so they stay unique as long
+     * as each function is counted in one place.
+     */
+    void append(const BlockCounters &other);
+
+    const BlockCounterOptions &options() const { return options_; }
+
+    /**
+     * Emit the counters, key strings, the dump function and the C library
+     * declarations it uses. Call once, after all functions
+     */
+    void emit_support(IREmitter &emitter) const;
+
+    /**
+     * Name of the function main calls before returning
+     */
+    static constexpr const char *DUMP_FUNCTION = "__block_counts_dump";
+
+  private:
+    struct Block {
+        std::string function;
+        std::string label;
+        int line = 0;
+        size_t index = 0; // Among the counted blocks of the function
+    };
+
+    BlockCounterOptions options_;
+    std::vector<Block> blocks_;
+    bool line_pending_ = false;
+
+    static std::string counter_name(const Block &block);
+};
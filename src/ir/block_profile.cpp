@@ -0,0 +1,95 @@
+#include "block_profile.h"
+
+#include <sstream>
+#include <stdexcept>
+
+bool BlockProfile::load(std::istream &in, std::string &error) {
+    std::string text;
+    for (int line_number = 1; std::getline(in, text); ++line_number) {
+        std::istringstream line(text);
+        std::vector<std::string> fields;
+        for (std::string field; line >> field;) {
+            fields.push_back(field);
+        }
+        if (fields.empty() || fields[0][0] == '#') {
+            continue;
+        }
+
+        const std::string &last = fields.back();
+        bool numeric = !last.empty() && last.find_first_not_of("0123456789") == std::string::npos;
+        if ((fields.size() != 3 && fields.size() != 4) || !numeric) {
+            error = "line " + std::to_string(line_number) +
+                    ": expected '<function> <label> [<line>] <count>'";
+            return false;
+        }
+
+        uint64_t count = 0;
+        try {
+            count = std::stoull(last);
+        } catch (const std::out_of_range &) {
+            error = "line " + std::to_string(line_number) + ": count out of range";
+            return false;
+        }
+        counts_[{fields[0], fields[1]}] += count;
+        functions_.insert(fields[0]);
+    }
+    return true;
+}
+
+bool BlockProfile::count(const std::string &function, const std::string &label,
+                         uint64_t &count) const {
+    auto it = counts_.find({function, label});
+    if (it == counts_.end()) {
+        return false;
+    }
+    count = it->second;
+    return true;
+}
+
+std::vector<size_t> BlockProfile::hot_cold_order(const std::vector<LayoutBlock> &blocks) {
+    std::vector<size_t> order;
+    if (blocks.empty()) {
+        return order;
+    }
+    std::vector<bool> placed(blocks.size(), false);
+
+    auto place_chain = [&](size_t block) {
+        while (true) {
+            placed[block] = true;
+            order.push_back(block);
+            size_t next = blocks.size();
+            for (size_t succ : blocks[block].successors) {
+                if (succ < blocks.size() && !placed[succ] && blocks[succ].count > 0 &&
+                    (next == blocks.size() || blocks[succ].count > blocks[next].count)) {
+                    next = succ;
+                }
+            }
+            if (next == blocks.size()) {
+                return;
+            }
+            block = next;
+        }
+    };
+
+    place_chain(0);
+    while (true) {
+        size_t seed = blocks.size();
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!placed[i] && blocks[i].count > 0 &&
+                (seed == blocks.size() || blocks[i].count > blocks[seed].count)) {
+                seed = i;
+            }
+        }
+        if (seed == blocks.size()) {
+            break;
+        }
+        place_chain(seed);
+    }
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (!placed[i]) {
+            order.push_back(i);
+        }
+    }
+    return order;
+}
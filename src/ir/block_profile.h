@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * BlockProfile - Block execution counts read back for optimization
+ *
+ * Core responsibilities:
+ * 1. Read the file written by --instrument-blocks (see BlockCounters): one
+ *    block per line, "<function> <label> [<line>] <count>". Counts of the
+ *    same block are added, so profiles of several runs can be concatenated
+ * 2. Answer the count of a block of a function
+ * 3. Order the blocks of a function so the hot path falls through and
+ *    never executed blocks come last (hot_cold_order)
+ *
+ * Labels are those of IRGenerator::begin_block, which do not depend on
+ * instrumentation, so a profile of an instrumented build applies to the
+ * plain build of the same source.
+ *
+ * Example:
+ *   ./code --instrument-blocks=counts.txt < prog.rs > prog.ll && lli prog.ll
+ *   ./code --profile=counts.txt < prog.rs > prog.ll
+ */
+class BlockProfile {
+  public:
+    /**
+     * A block to lay out
+     * count: executions of the block, 0 if never executed or unknown
+     * successors: indices of the blocks its terminator jumps to, in order
+     */
+    struct LayoutBlock {
+        uint64_t count = 0;
+        std::vector<size_t> successors;
+    };
+
+    /**
+     * Read a profile, adding to the counts read so far
+     * @param error Receives "line N: ..." for a malformed line
+     * @return false on a malformed line
+     */
+    bool load(std::istream &in, std::string &error);
+
+    bool has_function(const std::string &function) const {
+        return functions_.count(function) > 0;
+    }
+
+    /**
+     * Count of a block
+     * @param count Receives the count if the block is in the profile
+     * @return false if the block is not in the profile
+     */
+    bool count(const std::string &function, const std::string &label, uint64_t &count) const;
+
+    /**
+     * Hot/cold layout of a function's blocks
+     *
+     * Starting at the entry block (index 0), each chain keeps following its
+     * most executed successor not yet placed, so that edge becomes the
+     * fallthrough. When a chain ends, the next one starts at the most
+     * executed block left. Blocks with a count of 0 follow, in their
+     * original order.
+     *
+     * @return Permutation of the block indices, entry first
+     */
+    static std::vector<size_t> hot_cold_order(const std::vector<LayoutBlock> &blocks);
+
+  private:
+    std::map<std::pair<std::string, std::string>, uint64_t> counts_;
+    std::set<std::string> functions_;
+};
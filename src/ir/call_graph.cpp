@@ -0,0 +1,266 @@
+#include "call_graph.h"
+#include "../ast/ast_walker.h"
+#include "../semantic/semantic.h"
+
+namespace {
+
+/**
+ * Collects the calls made directly by one function body and the nested
+ * functions it defines. Nested function bodies are separate graph nodes.
+ */
+class CallCollector : public AstWalker {
+  public:
+    std::set<std::string> callees;
+    std::set<std::string> builtins;
+    std::vector<FnDecl *> nested_functions;
+
+    void visit(CallExpr *node) override {
+        std::string name = CallGraph::callee_name(node);
+        if (CallGraph::is_builtin(name)) {
+            builtins.insert(name);
+        } else if (!name.empty()) {
+            callees.insert(name);
+        }
+        AstWalker::visit(node);
+    }
+
+    void visit(ItemStmt *node) override {
+        if (auto fn_decl = dynamic_cast<FnDecl *>(node->item.get())) {
+            nested_functions.push_back(fn_decl);
+        }
+    }
+};
+
+std::string struct_name_of(Type *type) {
+    if (!type) {
+        return "";
+    }
+    if (auto ref_type = dynamic_cast<ReferenceType *>(type)) {
+        type = ref_type->referenced_type.get();
+    } else if (auto ptr_type = dynamic_cast<RawPointerType *>(type)) {
+        type = ptr_type->pointee_type.get();
+    }
+    auto struct_type = dynamic_cast<StructType *>(type);
+    return struct_type ? struct_type->name : "";
+}
+
+} // namespace
+
+void CallGraph::build(Program *program) {
+    functions_.clear();
+    reachable_.clear();
+    used_builtins_.clear();
+    recursive_.clear();
+
+    for (const auto &item : program->items) {
+        if (auto fn_decl = dynamic_cast<FnDecl *>(item.get())) {
+            add_function(fn_decl->name.lexeme, fn_decl);
+        } else if (auto impl = dynamic_cast<ImplBlock *>(item.get())) {
+            add_impl_block(impl);
+        }
+    }
+
+    if (functions_.count("main")) {
+        mark_reachable("main");
+    } else {
+        for (const auto &[name, node] : functions_) {
+            mark_reachable(name);
+        }
+    }
+
+    find_recursive_functions();
+}
+
+bool CallGraph::is_reachable(const std::string &name) const { return reachable_.count(name) > 0; }
+
+std::vector<std::string> CallGraph::reachable_functions() const {
+    return std::vector<std::string>(reachable_.begin(), reachable_.end());
+}
+
+const std::vector<FnDecl *> &CallGraph::declarations(const std::string &name) const {
+    static const std::vector<FnDecl *> empty;
+    auto it = functions_.find(name);
+    return it != functions_.end() ? it->second.decls : empty;
+}
+
+const std::set<std::string> &CallGraph::callees(const std::string &name) const {
+    static const std::set<std::string> empty;
+    auto it = functions_.find(name);
+    return it != functions_.end() ? it->second.callees : empty;
+}
+
+const std::set<std::string> &CallGraph::builtins(const std::string &name) const {
+    static const std::set<std::string> empty;
+    auto it = functions_.find(name);
+    return it != functions_.end() ? it->second.builtins : empty;
+}
+
+const std::set<std::string> &CallGraph::nested_functions(const std::string &name) const {
+    static const std::set<std::string> empty;
+    auto it = functions_.find(name);
+    return it != functions_.end() ? it->second.nested : empty;
+}
+
+bool CallGraph::is_recursive(const std::string &name) const { return recursive_.count(name) > 0; }
+
+bool CallGraph::uses_builtin(const std::string &name) const {
+    return used_builtins_.count(name) > 0;
+}
+
+std::string CallGraph::callee_name(CallExpr *call) {
+    if (auto var_expr = dynamic_cast<VariableExpr *>(call->callee.get())) {
+        return var_expr->name.lexeme;
+    }
+
+    if (auto path_expr = dynamic_cast<PathExpr *>(call->callee.get())) {
+        auto left_var = dynamic_cast<VariableExpr *>(path_expr->left.get());
+        auto right_var = dynamic_cast<VariableExpr *>(path_expr->right.get());
+        if (left_var && right_var) {
+            return left_var->name.lexeme + "_" + right_var->name.lexeme;
+        }
+        return "";
+    }
+
+    if (auto field_expr = dynamic_cast<FieldAccessExpr *>(call->callee.get())) {
+        std::string type_name = struct_name_of(field_expr->object->type.get());
+        if (type_name.empty() || field_expr->field.lexeme.empty()) {
+            return "";
+        }
+        return type_name + "_" + field_expr->field.lexeme;
+    }
+
+    return "";
+}
+
+bool CallGraph::is_builtin(const std::string &name) {
+    return name == "printInt" || name == "printlnInt" || name == "getInt" || name == "exit";
+}
+
+void CallGraph::add_function(const std::string &name, FnDecl *decl) {
+    FunctionNode &node = functions_[name];
+    node.decls.push_back(decl);
+
+    if (!decl->body.has_value() || !decl->body.value()) {
+        return;
+    }
+
+    CallCollector collector;
+    collector.walk(decl->body.value().get());
+
+    node.callees.insert(collector.callees.begin(), collector.callees.end());
+    node.builtins.insert(collector.builtins.begin(), collector.builtins.end());
+
+    for (FnDecl *nested : collector.nested_functions) {
+        node.nested.insert(nested->name.lexeme);
+        add_function(nested->name.lexeme, nested);
+    }
+}
+
+void CallGraph::add_impl_block(ImplBlock *impl) {
+    if (!impl->target_type || !impl->target_type->resolved_type) {
+        return;
+    }
+
+    auto struct_type = std::dynamic_pointer_cast<StructType>(impl->target_type->resolved_type);
+    if (!struct_type) {
+        return;
+    }
+
+    for (const auto &item : impl->implemented_items) {
+        if (auto fn_decl = dynamic_cast<FnDecl *>(item.get())) {
+            add_function(struct_type->name + "_" + fn_decl->name.lexeme, fn_decl);
+        }
+    }
+}
+
+void CallGraph::mark_reachable(const std::string &root) {
+    std::vector<std::string> worklist = {root};
+
+    while (!worklist.empty()) {
+        std::string name = worklist.back();
+        worklist.pop_back();
+
+        auto it = functions_.find(name);
+        if (it == functions_.end() || !reachable_.insert(name).second) {
+            continue;
+        }
+
+        used_builtins_.insert(it->second.builtins.begin(), it->second.builtins.end());
+        for (const auto &callee : it->second.callees) {
+            worklist.push_back(callee);
+        }
+    }
+}
+
+/**
+ * Tarjan's strongly connected components over the reachable functions.
+ * Iterative, so deep call chains cannot overflow the native stack.
+ */
+void CallGraph::find_recursive_functions() {
+    std::map<std::string, int> index;
+    std::map<std::string, int> lowlink;
+    std::set<std::string> on_stack;
+    std::vector<std::string> scc_stack;
+    int next_index = 0;
+
+    struct Frame {
+        std::string name;
+        std::set<std::string>::const_iterator next_callee;
+    };
+
+    for (const auto &root : reachable_) {
+        if (index.count(root)) {
+            continue;
+        }
+
+        std::vector<Frame> frames;
+        auto visit = [&](const std::string &name) {
+            index[name] = lowlink[name] = next_index++;
+            scc_stack.push_back(name);
+            on_stack.insert(name);
+            frames.push_back({name, functions_.at(name).callees.begin()});
+        };
+        visit(root);
+
+        while (!frames.empty()) {
+            Frame &frame = frames.back();
+            const auto &callees = functions_.at(frame.name).callees;
+
+            if (frame.next_callee != callees.end()) {
+                const std::string &callee = *frame.next_callee++;
+                if (!functions_.count(callee)) {
+                    continue;
+                }
+                if (!index.count(callee)) {
+                    visit(callee);
+                } else if (on_stack.count(callee)) {
+                    lowlink[frame.name] = std::min(lowlink[frame.name], index[callee]);
+                }
+                continue;
+            }
+
+            std::string name = frame.name;
+            frames.pop_back();
+            if (!frames.empty()) {
+                lowlink[frames.back().name] = std::min(lowlink[frames.back().name], lowlink[name]);
+            }
+
+            if (lowlink[name] != index[name]) {
+                continue;
+            }
+
+            std::vector<std::string> component;
+            std::string member;
+            do {
+                member = scc_stack.back();
+                scc_stack.pop_back();
+                on_stack.erase(member);
+                component.push_back(member);
+            } while (member != name);
+
+            if (component.size() > 1 || functions_.at(name).callees.count(name)) {
+                recursive_.insert(component.begin(), component.end());
+            }
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../ast/ast.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * CallGraph - Whole-program call graph
+ *
+ * Core responsibilities:
+ * 1. Collect every function the generator can emit (top-level fns,
+ *    impl methods, nested fns) under its IR name
+ * 2. Record direct calls between them and calls to built-in functions
+ * 3. Compute the set of functions reachable from main
+ *
+ * Design principles:
+ * - Functions are keyed by IR name (e.g., "main", "Point_new"), exactly as
+ *   IRGenerator names them, so lookups need no symbol information
+ * - Built-in calls (printInt, getInt, ...) are recorded separately, they take
+ *   precedence over user functions just like in IRGenerator::visit(CallExpr)
+ */
+class CallGraph {
+  public:
+    /**
+     * Build call graph for the complete program and mark reachable functions
+     * If the program has no main, every function is considered reachable
+     * @param program AST root node
+     */
+    void build(Program *program);
+
+    /**
+     * Check if function is reachable from main
+     * @param name Function IR name
+     */
+    bool is_reachable(const std::string &name) const;
+
+    /**
+     * Check if a reachable function calls the built-in function
+     * @param name Built-in function name (e.g., "printInt")
+     */
+    bool uses_builtin(const std::string &name) const;
+
+    /**
+     * Get all functions reachable from main, in name order
+     */
+    std::vector<std::string> reachable_functions() const;
+
+    /**
+     * Get declarations of a function
+     * Nested functions in different bodies may share one IR name
+     * @return All declarations with this IR name, empty if unknown
+     */
+    const std::vector<FnDecl *> &declarations(const std::string &name) const;
+
+    /**
+     * Get user functions called directly by a function
+     */
+    const std::set<std::string> &callees(const std::string &name) const;
+
+    /**
+     * Get built-in functions called directly by a function
+     */
+    const std::set<std::string> &builtins(const std::string &name) const;
+
+    /**
+     * Get functions declared directly in a function's body
+     */
+    const std::set<std::string> &nested_functions(const std::string &name) const;
+
+    /**
+     * Check if function can call itself, directly or through other functions
+     */
+    bool is_recursive(const std::string &name) const;
+
+    /**
+     * Compute IR name of the function called by a call expression
+     * Methods are mangled as Type_method
+     * @return Function name, or empty string if the callee is not a known function form
+     */
+    static std::string callee_name(CallExpr *call);
+
+    /**
+     * Check if name refers to a built-in function
+     */
+    static bool is_builtin(const std::string &name);
+
+  private:
+    struct FunctionNode {
+        std::vector<FnDecl *> decls;
+        std::set<std::string> callees;
+        std::set<std::string> builtins;
+        std::set<std::string> nested;
+    };
+
+    std::map<std::string, FunctionNode> functions_;
+    std::set<std::string> reachable_;
+    std::set<std::string> used_builtins_;
+    std::set<std::string> recursive_;
+
+    void add_function(const std::string &name, FnDecl *decl);
+    void add_impl_block(ImplBlock *impl);
+    void mark_reachable(const std::string &root);
+
+    /**
+     * Find recursive functions: members of a strongly connected component
+     * with more than one function, or functions that call themselves
+     */
+    void find_recursive_functions();
+};
@@ -0,0 +1,161 @@
+#include "data_layout.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+size_t align_to(size_t offset, size_t alignment) {
+    if (alignment == 0 || offset % alignment == 0) {
+        return offset;
+    }
+    return offset + (alignment - offset % alignment);
+}
+
+} // namespace
+
+int StructLayout::field_index(const std::string &name) const {
+    auto it = field_indices.find(name);
+    return it != field_indices.end() ? it->second : -1;
+}
+
+size_t DataLayout::size_of(const Type *type) {
+    if (!type) {
+        return 0;
+    }
+
+    switch (type->kind) {
+    case TypeKind::BOOL:
+        return 1;
+    case TypeKind::I32:
+    case TypeKind::U32:
+    case TypeKind::ISIZE:
+    case TypeKind::USIZE:
+    case TypeKind::CHAR:
+    case TypeKind::ANY_INTEGER:
+    case TypeKind::ENUM:
+        return 4;
+    case TypeKind::REFERENCE:
+    case TypeKind::RAW_POINTER:
+    case TypeKind::FUNCTION:
+    case TypeKind::STR:
+    case TypeKind::STRING:
+    case TypeKind::RSTRING:
+    case TypeKind::CSTRING:
+    case TypeKind::RCSTRING:
+        return POINTER_SIZE;
+    case TypeKind::ARRAY: {
+        auto arr_type = static_cast<const ArrayType *>(type);
+        const Type *elem_type = arr_type->element_type.get();
+        size_t stride = align_to(size_of(elem_type), alignment_of(elem_type));
+        return stride * arr_type->size;
+    }
+    case TypeKind::STRUCT:
+        return struct_layout(static_cast<const StructType *>(type)).size;
+    default:
+        return 0;
+    }
+}
+
+size_t DataLayout::alignment_of(const Type *type) {
+    if (!type) {
+        return 1;
+    }
+
+    switch (type->kind) {
+    case TypeKind::ARRAY:
+        return alignment_of(static_cast<const ArrayType *>(type)->element_type.get());
+    case TypeKind::STRUCT:
+        return struct_layout(static_cast<const StructType *>(type)).alignment;
+    default:
+        return std::max<size_t>(size_of(type), 1);
+    }
+}
+
+const StructLayout &DataLayout::struct_layout(const StructType *type) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = struct_layouts_.find(type);
+        if (it != struct_layouts_.end()) {
+            return it->second;
+        }
+    }
+
+    std::vector<Type *> decl_types;
+    std::vector<size_t> decl_aligns;
+    for (const auto &field_name : type->field_order) {
+        auto field_it = type->fields.find(field_name);
+        Type *field_type = field_it != type->fields.end() ? field_it->second.get() : nullptr;
+        decl_types.push_back(field_type);
+        decl_aligns.push_back(alignment_of(field_type));
+    }
+
+    std::vector<size_t> order(type->field_order.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return decl_aligns[a] > decl_aligns[b]; });
+
+    StructLayout layout;
+    size_t offset = 0;
+    for (size_t decl_index : order) {
+        Type *field_type = decl_types[decl_index];
+        size_t field_align = decl_aligns[decl_index];
+
+        offset = align_to(offset, field_align);
+        layout.field_indices[type->field_order[decl_index]] =
+            static_cast<int>(layout.field_names.size());
+        layout.field_names.push_back(type->field_order[decl_index]);
+        layout.field_types.push_back(field_type);
+        layout.field_offsets.push_back(offset);
+
+        offset += size_of(field_type);
+        layout.alignment = std::max(layout.alignment, field_align);
+    }
+    layout.size = align_to(offset, layout.alignment);
+
+    // Computed without the lock (fields recurse into struct_layout); a layout
+    // another thread stored meanwhile is identical. Map nodes never move, so
+    // the reference stays valid
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    struct_alignments_["%" + type->name] = layout.alignment;
+    return struct_layouts_.emplace(type, std::move(layout)).first->second;
+}
+
+size_t DataLayout::ir_alignment(const std::string &ir_type) const {
+    if (ir_type.empty()) {
+        return 0;
+    }
+
+    if (ir_type.back() == '*') {
+        return POINTER_SIZE;
+    }
+
+    if (ir_type.front() == '[') {
+        // [N x T]
+        size_t sep = ir_type.find(" x ");
+        if (sep == std::string::npos || ir_type.back() != ']') {
+            return 0;
+        }
+        return ir_alignment(ir_type.substr(sep + 3, ir_type.size() - sep - 4));
+    }
+
+    if (ir_type.front() == '%') {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = struct_alignments_.find(ir_type);
+        return it != struct_alignments_.end() ? it->second : 0;
+    }
+
+    if (ir_type == "i1" || ir_type == "i8") {
+        return 1;
+    }
+    if (ir_type == "i16") {
+        return 2;
+    }
+    if (ir_type == "i32") {
+        return 4;
+    }
+    if (ir_type == "i64") {
+        return 8;
+    }
+    return 0;
+}
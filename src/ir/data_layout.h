@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../semantic/semantic.h"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * StructLayout - Memory layout of one struct type
+ *
+ * Fields are stored in IR order, which may differ from declaration order.
+ */
+struct StructLayout {
+    std::vector<std::string> field_names; // IR order
+    std::vector<Type *> field_types;      // IR order
+    std::vector<size_t> field_offsets;    // Byte offset of each field, IR order
+    std::unordered_map<std::string, int> field_indices;
+    size_t size = 0;
+    size_t alignment = 1;
+
+    /**
+     * Get IR index of a field (the GEP index)
+     * @return Field index, -1 if the struct has no such field
+     */
+    int field_index(const std::string &name) const;
+};
+
+/**
+ * DataLayout - Sizes, alignments and struct layouts of the target
+ *
+ * Core responsibilities:
+ * 1. Compute size and ABI alignment of every Rust type
+ * 2. Compute struct layouts once, with fields reordered to minimize padding
+ * 3. Provide alignments of IR type strings for alloca/load/store/memcpy
+ *
+ * Thread safety: the layout cache is guarded, so one DataLayout can serve
+ * several threads generating IR at once.
+ *
+ * Target model (x86-64 SysV, matching LLVM_DATALAYOUT):
+ * - i32/u32/isize/usize/char: 4 bytes
+ * - bool: 1 byte
+ * - references, raw pointers, strings: 8 bytes
+ * - arrays: element stride × length, stride is the element size rounded
+ *   up to its alignment
+ *
+ * Field ordering:
+ * - Fields are sorted by decreasing alignment, ties keep declaration order
+ * - With power-of-two alignments this never needs padding between fields,
+ *   only tail padding up to the struct alignment
+ * - Example: struct S { a: bool, b: i32, c: bool }
+ *     declaration order: { i1, i32, i1 }  -> 12 bytes
+ *     layout order:      { i32, i1, i1 }  -> 8 bytes
+ */
+class DataLayout {
+  public:
+    /**
+     * Datalayout string emitted as `target datalayout`
+     */
+    static constexpr const char *LLVM_DATALAYOUT =
+        "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128";
+
+    static constexpr size_t POINTER_SIZE = 8;
+
+    /**
+     * Get type size in bytes (allocation size, including tail padding)
+     */
+    size_t size_of(const Type *type);
+
+    /**
+     * Get type ABI alignment in bytes
+     */
+    size_t alignment_of(const Type *type);
+
+    /**
+     * Get layout of a struct type, computed on first use
+     */
+    const StructLayout &struct_layout(const StructType *type);
+
+    /**
+     * Get ABI alignment of an IR type string
+     * Supports integers, pointers, arrays and structs whose layout was computed
+     * @param ir_type IR type (e.g., "i32", "[10 x %Point]", "i8*")
+     * @return Alignment in bytes, 0 if unknown
+     */
+    size_t ir_alignment(const std::string &ir_type) const;
+
+  private:
+    mutable std::shared_mutex mutex_; // Guards the two caches below
+    std::unordered_map<const StructType *, StructLayout> struct_layouts_;
+
+    /**
+     * Struct alignments by IR name (e.g., "%Point"), for ir_alignment
+     */
+    std::unordered_map<std::string, size_t> struct_alignments_;
+};
@@ -0,0 +1,632 @@
+#include "effect_analysis.h"
+#include "../ast/ast_walker.h"
+#include "../semantic/semantic.h"
+
+#include <set>
+
+namespace {
+
+Expr *strip_grouping(Expr *expr) {
+    while (auto group = dynamic_cast<GroupingExpr *>(expr)) {
+        expr = group->expression.get();
+    }
+    return expr;
+}
+
+bool is_pointer_type(Type *type) {
+    return type && (type->kind == TypeKind::REFERENCE || type->kind == TypeKind::RAW_POINTER);
+}
+
+/**
+ * Scans one function body for memory accesses through its pointer
+ * parameters, memory accesses through other pointers, pointer arguments
+ * passed to callees, I/O and loops.
+ */
+class EffectScanner : public AstWalker {
+  public:
+    struct PointerArg {
+        std::string callee;
+        size_t callee_param;
+        int caller_param; // -1: pointer of unknown origin
+    };
+
+    explicit EffectScanner(const std::map<std::string, size_t> &pointer_params, size_t param_count)
+        : read(param_count), written(param_count), captured(param_count),
+          pointer_params_(pointer_params) {}
+
+    std::vector<bool> read;
+    std::vector<bool> written;
+    std::vector<bool> captured;
+    bool reads_memory = false;
+    bool writes_memory = false;
+    bool has_io = false;
+    bool may_not_return = false;
+    std::vector<PointerArg> pointer_args;
+
+    void visit(VariableExpr *node) override {
+        size_t param;
+        if (pointer_param(node, param)) {
+            captured[param] = true;
+        }
+    }
+
+    void visit(UnaryExpr *node) override {
+        if (node->op.type != TokenType::STAR) {
+            AstWalker::visit(node);
+            return;
+        }
+        record_access(node, false);
+        walk_object(node->right.get());
+    }
+
+    void visit(IndexExpr *node) override {
+        record_access(node, false);
+        walk_object(node->object.get());
+        walk(node->index.get());
+    }
+
+    void visit(FieldAccessExpr *node) override {
+        record_access(node, false);
+        walk_object(node->object.get());
+    }
+
+    void visit(AssignmentExpr *node) override {
+        record_access(node->target.get(), true);
+        AstWalker::visit(node);
+    }
+
+    void visit(CompoundAssignmentExpr *node) override {
+        record_access(node->target.get(), true);
+        AstWalker::visit(node);
+    }
+
+    void visit(ReferenceExpr *node) override {
+        size_t param;
+        if (classify(node->expression.get(), param) == Place::PARAM) {
+            captured[param] = true;
+        }
+        AstWalker::visit(node);
+    }
+
+    void visit(LoopExpr *node) override {
+        may_not_return = true;
+        AstWalker::visit(node);
+    }
+
+    void visit(WhileExpr *node) override {
+        may_not_return = true;
+        AstWalker::visit(node);
+    }
+
+    /**
+     * Calls are walked by hand: pointer arguments are recorded instead of
+     * being treated as captures, and the callee name is not a variable use.
+     */
+    void visit(CallExpr *node) override {
+        std::string name = CallGraph::callee_name(node);
+
+        if (CallGraph::is_builtin(name)) {
+            has_io = true;
+            if (name == "exit") {
+                may_not_return = true;
+            }
+        }
+
+        size_t offset = 0;
+        auto field_expr = dynamic_cast<FieldAccessExpr *>(node->callee.get());
+        if (field_expr && !name.empty()) {
+            // Method call: the object is passed by address as the first argument
+            visit_pointer_arg(name, 0, field_expr->object.get());
+            offset = 1;
+        }
+
+        for (size_t i = 0; i < node->arguments.size(); ++i) {
+            Expr *arg = node->arguments[i].get();
+            if (!name.empty() && !CallGraph::is_builtin(name) && arg->type &&
+                arg->type->kind == TypeKind::REFERENCE) {
+                visit_pointer_arg(name, i + offset, arg);
+            } else {
+                walk(arg);
+            }
+        }
+    }
+
+  private:
+    enum class Place { LOCAL, PARAM, UNKNOWN };
+
+    const std::map<std::string, size_t> &pointer_params_;
+
+    bool pointer_param(Expr *expr, size_t &param) const {
+        auto var = dynamic_cast<VariableExpr *>(strip_grouping(expr));
+        if (!var) {
+            return false;
+        }
+        auto it = pointer_params_.find(var->name.lexeme);
+        if (it == pointer_params_.end()) {
+            return false;
+        }
+        param = it->second;
+        return true;
+    }
+
+    /**
+     * Find the memory a place expression lives in
+     *   p.x, p[i], *p (p a pointer parameter)  -> PARAM
+     *   r.x, *f() (any other pointer)          -> UNKNOWN
+     *   local, local.x[i], temporaries         -> LOCAL
+     */
+    Place classify(Expr *expr, size_t &param) const {
+        expr = strip_grouping(expr);
+
+        if (auto index = dynamic_cast<IndexExpr *>(expr)) {
+            return classify_object(index->object.get(), param);
+        }
+        if (auto field = dynamic_cast<FieldAccessExpr *>(expr)) {
+            return classify_object(field->object.get(), param);
+        }
+        if (auto unary = dynamic_cast<UnaryExpr *>(expr)) {
+            if (unary->op.type == TokenType::STAR) {
+                return pointer_param(unary->right.get(), param) ? Place::PARAM : Place::UNKNOWN;
+            }
+        }
+        return Place::LOCAL;
+    }
+
+    /**
+     * Objects of index and field expressions are dereferenced automatically
+     * when they are pointers. An object without type is assumed to be one.
+     */
+    Place classify_object(Expr *object, size_t &param) const {
+        if (!object->type || is_pointer_type(object->type.get())) {
+            return pointer_param(object, param) ? Place::PARAM : Place::UNKNOWN;
+        }
+        return classify(object, param);
+    }
+
+    void record_access(Expr *place, bool is_write) {
+        size_t param;
+        switch (classify(place, param)) {
+        case Place::PARAM:
+            (is_write ? written : read)[param] = true;
+            break;
+        case Place::UNKNOWN:
+            (is_write ? writes_memory : reads_memory) = true;
+            break;
+        case Place::LOCAL:
+            break;
+        }
+    }
+
+    /**
+     * Walk the object of an access, a pointer parameter used as the object
+     * is only dereferenced, not captured
+     */
+    void walk_object(Expr *object) {
+        size_t param;
+        if (!pointer_param(object, param)) {
+            walk(object);
+        }
+    }
+
+    /**
+     * Record a pointer passed to a user function
+     *   p          -> callee parameter receives caller parameter p
+     *   &p.x, &*p  -> same, the address is derived from p
+     *   &local     -> nothing to record, callee effects stay local
+     *   anything else (other references, method objects) -> unknown origin
+     */
+    void visit_pointer_arg(const std::string &callee, size_t index, Expr *arg) {
+        size_t param;
+        if (pointer_param(arg, param)) {
+            pointer_args.push_back({callee, index, static_cast<int>(param)});
+            return;
+        }
+
+        Expr *place = nullptr;
+        if (auto ref = dynamic_cast<ReferenceExpr *>(strip_grouping(arg))) {
+            place = ref->expression.get();
+        } else if (arg->type && !is_pointer_type(arg->type.get())) {
+            // Method object held by value, its address is passed
+            place = arg;
+        }
+
+        if (!place) {
+            pointer_args.push_back({callee, index, -1});
+            walk(arg);
+            return;
+        }
+
+        switch (classify(place, param)) {
+        case Place::PARAM:
+            pointer_args.push_back({callee, index, static_cast<int>(param)});
+            break;
+        case Place::UNKNOWN:
+            pointer_args.push_back({callee, index, -1});
+            break;
+        case Place::LOCAL:
+            break;
+        }
+        walk(place);
+    }
+};
+
+/**
+ * Get the by-value parameter a place expression is rooted at: a, a[i], a.x, (a)
+ */
+bool root_param(Expr *expr, const std::map<std::string, size_t> &params, size_t &param) {
+    expr = strip_grouping(expr);
+    if (auto index = dynamic_cast<IndexExpr *>(expr)) {
+        return root_param(index->object.get(), params, param);
+    }
+    if (auto field = dynamic_cast<FieldAccessExpr *>(expr)) {
+        return root_param(field->object.get(), params, param);
+    }
+    if (auto var = dynamic_cast<VariableExpr *>(expr)) {
+        auto it = params.find(var->name.lexeme);
+        if (it != params.end()) {
+            param = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Check if a value of type outer can hold a value of type inner
+ */
+bool contains_type(const Type *outer, const Type *inner) {
+    if (outer->to_string() == inner->to_string()) {
+        return true;
+    }
+    if (outer->kind == TypeKind::ARRAY) {
+        return contains_type(static_cast<const ArrayType *>(outer)->element_type.get(), inner);
+    }
+    if (outer->kind == TypeKind::STRUCT) {
+        for (const auto &[_, field_type] : static_cast<const StructType *>(outer)->fields) {
+            if (field_type && contains_type(field_type.get(), inner)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Finds by-value aggregate parameters that cannot share the caller's
+ * storage, because they are modified or their address escapes:
+ *   a = v, a[i] = v, a.x += v        -> modified
+ *   &mut a, &mut a.x                 -> modified
+ *   a.m() where m takes &mut self    -> modified
+ *   &a outside a direct call argument -> escapes
+ * Reading, copying (let b = a) and passing a or &a to a call are fine.
+ */
+class AggregateParamScanner : public AstWalker {
+  public:
+    AggregateParamScanner(const std::map<std::string, size_t> &params, const CallGraph &call_graph)
+        : params_(params), call_graph_(call_graph) {}
+
+    std::set<size_t> needs_copy;
+
+    void visit(AssignmentExpr *node) override {
+        mark(node->target.get());
+        AstWalker::visit(node);
+    }
+
+    void visit(CompoundAssignmentExpr *node) override {
+        mark(node->target.get());
+        AstWalker::visit(node);
+    }
+
+    void visit(ReferenceExpr *node) override {
+        mark(node->expression.get());
+        AstWalker::visit(node);
+    }
+
+    void visit(CallExpr *node) override {
+        auto field_expr = dynamic_cast<FieldAccessExpr *>(node->callee.get());
+        if (field_expr && takes_mut_self(CallGraph::callee_name(node))) {
+            mark(field_expr->object.get());
+        }
+        walk(node->callee.get());
+
+        for (const auto &arg : node->arguments) {
+            auto ref = dynamic_cast<ReferenceExpr *>(strip_grouping(arg.get()));
+            if (ref && !ref->is_mutable) {
+                walk(ref->expression.get());
+            } else {
+                walk(arg.get());
+            }
+        }
+    }
+
+  private:
+    const std::map<std::string, size_t> &params_;
+    const CallGraph &call_graph_;
+
+    void mark(Expr *place) {
+        size_t param;
+        if (root_param(place, params_, param)) {
+            needs_copy.insert(param);
+        }
+    }
+
+    /**
+     * Unknown methods are assumed to take &mut self
+     */
+    bool takes_mut_self(const std::string &name) const {
+        if (name.empty() || CallGraph::is_builtin(name)) {
+            return false;
+        }
+        const auto &decls = call_graph_.declarations(name);
+        if (decls.empty()) {
+            return true;
+        }
+        for (FnDecl *decl : decls) {
+            if (decl->params.empty() || !decl->params.front()->type ||
+                !decl->params.front()->type->resolved_type) {
+                return true;
+            }
+            auto self_type = decl->params.front()->type->resolved_type.get();
+            if (self_type->kind == TypeKind::REFERENCE &&
+                static_cast<ReferenceType *>(self_type)->is_mutable) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+void EffectAnalysis::run(const CallGraph &call_graph,
+                         const StaticStorageAnalysis &static_storage, AbiLowering &abi) {
+    effects_.clear();
+
+    std::vector<std::string> functions = call_graph.reachable_functions();
+
+    for (const auto &name : functions) {
+        const auto &decls = call_graph.declarations(name);
+        FunctionEffects effects;
+
+        if (decls.size() == 1) {
+            effects = scan_function(decls.front(), call_graph, abi);
+        } else {
+            // Several bodies share this IR name, assume the worst
+            effects.has_io = true;
+            effects.may_not_return = true;
+        }
+
+        if (static_storage.uses_static_storage(name) || writes_globals_) {
+            effects.reads_memory = true;
+            effects.writes_memory = true;
+        }
+
+        effects.is_recursive = call_graph.is_recursive(name);
+        if (effects.is_recursive) {
+            effects.may_not_return = true;
+        }
+        effects_[name] = std::move(effects);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto &name : functions) {
+            changed |= propagate(effects_[name], call_graph, name);
+        }
+    }
+}
+
+EffectAnalysis::FunctionEffects EffectAnalysis::scan_function(FnDecl *decl,
+                                                              const CallGraph &call_graph,
+                                                              AbiLowering &abi) {
+    FunctionEffects effects;
+    std::map<std::string, size_t> pointer_params;
+    std::map<std::string, size_t> aggregate_params;
+    std::vector<Type *> mut_pointees;
+
+    effects.params.resize(decl->params.size());
+    for (size_t i = 0; i < decl->params.size(); ++i) {
+        const auto &param = decl->params[i];
+        auto id_pattern = dynamic_cast<IdentifierPattern *>(param->pattern.get());
+        if (!id_pattern || !param->type || !param->type->resolved_type) {
+            continue;
+        }
+
+        Type *type = param->type->resolved_type.get();
+        if (is_pointer_type(type)) {
+            effects.params[i].is_pointer = true;
+            pointer_params[id_pattern->name.lexeme] = i;
+
+            if (type->kind == TypeKind::REFERENCE) {
+                auto ref_type = static_cast<ReferenceType *>(type);
+                if (ref_type->is_mutable && ref_type->referenced_type) {
+                    mut_pointees.push_back(ref_type->referenced_type.get());
+                }
+            } else {
+                auto ptr_type = static_cast<RawPointerType *>(type);
+                if (ptr_type->is_mutable && ptr_type->pointee_type) {
+                    mut_pointees.push_back(ptr_type->pointee_type.get());
+                }
+            }
+        } else if (type->kind == TypeKind::ARRAY || type->kind == TypeKind::STRUCT) {
+            effects.params[i].is_pointer = !abi.is_flattened(type);
+            effects.params[i].is_local_copy = true;
+            effects.params[i].read = true;
+            if (effects.params[i].is_pointer) {
+                aggregate_params[id_pattern->name.lexeme] = i;
+            }
+        }
+    }
+
+    if (decl->return_type.has_value() && decl->return_type.value() &&
+        decl->return_type.value()->resolved_type &&
+        decl->return_type.value()->resolved_type->kind == TypeKind::STRUCT &&
+        !abi.is_flattened(decl->return_type.value()->resolved_type.get())) {
+        effects.uses_sret = true;
+    }
+
+    if (!decl->body.has_value() || !decl->body.value()) {
+        effects.has_io = true;
+        effects.may_not_return = true;
+        return effects;
+    }
+
+    EffectScanner scanner(pointer_params, decl->params.size());
+    scanner.walk(decl->body.value().get());
+
+    // A by-value aggregate may use the caller's storage if the body never
+    // modifies it and no mutable pointer parameter can reach that storage
+    AggregateParamScanner aggregate_scanner(aggregate_params, call_graph);
+    aggregate_scanner.walk(decl->body.value().get());
+
+    for (const auto &[_, i] : aggregate_params) {
+        Type *type = decl->params[i]->type->resolved_type.get();
+        bool may_alias = false;
+        for (Type *pointee : mut_pointees) {
+            may_alias |= contains_type(pointee, type) || contains_type(type, pointee);
+        }
+        if (!may_alias && !aggregate_scanner.needs_copy.count(i)) {
+            effects.params[i].is_local_copy = false;
+        }
+    }
+
+    for (const auto &[_, i] : pointer_params) {
+        ParamEffects &param = effects.params[i];
+        param.read = scanner.read[i];
+        param.written = scanner.written[i];
+        param.captured = scanner.captured[i];
+    }
+
+    effects.reads_memory = scanner.reads_memory;
+    effects.writes_memory = scanner.writes_memory;
+    effects.has_io = scanner.has_io;
+    effects.may_not_return = scanner.may_not_return;
+
+    for (const auto &arg : scanner.pointer_args) {
+        effects.pointer_args.push_back({arg.callee, arg.callee_param, arg.caller_param});
+    }
+
+    return effects;
+}
+
+bool EffectAnalysis::propagate(FunctionEffects &effects, const CallGraph &call_graph,
+                               const std::string &name) {
+    FunctionEffects before = effects;
+
+    for (const auto &callee : call_graph.callees(name)) {
+        auto it = effects_.find(callee);
+        if (it == effects_.end()) {
+            effects.has_io = true;
+            effects.may_not_return = true;
+            effects.reads_memory = true;
+            effects.writes_memory = true;
+            continue;
+        }
+        const FunctionEffects &callee_effects = it->second;
+        effects.has_io |= callee_effects.has_io;
+        effects.may_not_return |= callee_effects.may_not_return;
+        effects.reads_memory |= callee_effects.reads_memory;
+        effects.writes_memory |= callee_effects.writes_memory;
+    }
+
+    for (const auto &arg : effects.pointer_args) {
+        // Unknown callees and parameters may do anything with the pointer
+        ParamEffects callee_param;
+        callee_param.read = callee_param.written = callee_param.captured = true;
+
+        auto it = effects_.find(arg.callee);
+        if (it != effects_.end() && arg.callee_param < it->second.params.size() &&
+            (it->second.params[arg.callee_param].is_pointer ||
+             it->second.params[arg.callee_param].is_local_copy)) {
+            callee_param = it->second.params[arg.callee_param];
+        }
+
+        if (arg.caller_param >= 0) {
+            ParamEffects &param = effects.params[arg.caller_param];
+            param.read |= callee_param.read;
+            param.written |= callee_param.written;
+            param.captured |= callee_param.captured;
+        } else {
+            effects.reads_memory |= callee_param.read || callee_param.captured;
+            effects.writes_memory |= callee_param.written || callee_param.captured;
+        }
+    }
+
+    bool changed = effects.has_io != before.has_io ||
+                   effects.may_not_return != before.may_not_return ||
+                   effects.reads_memory != before.reads_memory ||
+                   effects.writes_memory != before.writes_memory;
+    for (size_t i = 0; i < effects.params.size(); ++i) {
+        changed |= effects.params[i].read != before.params[i].read ||
+                   effects.params[i].written != before.params[i].written ||
+                   effects.params[i].captured != before.params[i].captured;
+    }
+    return changed;
+}
+
+bool EffectAnalysis::reads(const FunctionEffects &effects) {
+    if (effects.reads_memory) {
+        return true;
+    }
+    for (const auto &param : effects.params) {
+        if (param.is_pointer && (param.read || param.captured)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EffectAnalysis::writes(const FunctionEffects &effects) {
+    if (effects.writes_memory || effects.uses_sret) {
+        return true;
+    }
+    for (const auto &param : effects.params) {
+        if (param.is_pointer && (param.written || param.captured)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string EffectAnalysis::function_attributes(const std::string &name) const {
+    auto it = effects_.find(name);
+    if (it == effects_.end()) {
+        return "";
+    }
+    const FunctionEffects &effects = it->second;
+
+    std::string attrs;
+    if (!effects.is_recursive) {
+        attrs += "norecurse ";
+    }
+    attrs += "nounwind";
+    if (!effects.has_io && !writes(effects)) {
+        attrs += reads(effects) ? " readonly" : " readnone";
+    }
+    if (!effects.may_not_return) {
+        attrs += " willreturn";
+    }
+    return attrs;
+}
+
+bool EffectAnalysis::param_needs_copy(const std::string &name, size_t index) const {
+    auto it = effects_.find(name);
+    if (it == effects_.end() || index >= it->second.params.size()) {
+        return true;
+    }
+    return it->second.params[index].is_local_copy;
+}
+
+std::string EffectAnalysis::param_attributes(const std::string &name, size_t index) const {
+    auto it = effects_.find(name);
+    if (it == effects_.end() || index >= it->second.params.size()) {
+        return "";
+    }
+
+    const ParamEffects &param = it->second.params[index];
+    if (!param.is_pointer || param.captured) {
+        return "";
+    }
+    return param.written ? "nocapture" : "nocapture readonly";
+}
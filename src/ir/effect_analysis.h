@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../ast/ast.h"
+#include "abi.h"
+#include "call_graph.h"
+#include "static_storage.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * EffectAnalysis - Interprocedural memory and control effects
+ *
+ * Core responsibilities:
+ * 1. Scan each reachable function for memory accesses through pointer
+ *    parameters, I/O built-ins and loops
+ * 2. Propagate effects bottom-up over the call graph to a fixpoint
+ * 3. Translate the result into LLVM function and parameter attributes
+ *
+ * Function attributes:
+ * - nounwind:   always, the language has no unwinding
+ * - readnone:   no access to memory visible to the caller, no I/O
+ * - readonly:   only reads memory visible to the caller, no I/O
+ * - willreturn: no loops, no recursion, no exit and no such callee
+ * - norecurse:  not part of a call graph cycle
+ *
+ * Parameter attributes (pointer parameters only):
+ * - nocapture:  the pointer is only dereferenced or passed to a callee
+ *               that does not capture it
+ * - readonly:   additionally never written through, here or in callees
+ *
+ * Design principles:
+ * - Conservative: any use that is not understood (a reference parameter
+ *   stored in a local, returned, borrowed, ...) counts as a capture, which
+ *   also implies reads and writes
+ * - Locals never count: by-value aggregate parameters are copied into a
+ *   local on entry, so their pointer is only read by that memcpy
+ * - Except locals in static storage: they live in module globals, so their
+ *   function reads and writes memory
+ * - Functions are keyed by IR name, exactly like CallGraph
+ */
+class EffectAnalysis {
+  public:
+    /**
+     * Analyze all functions reachable in the call graph
+     * @param call_graph Call graph built for the program
+     * @param static_storage Local arrays placed in module globals
+     * @param abi Passing of by-value aggregates (pointer or scalars)
+     */
+    void run(const CallGraph &call_graph, const StaticStorageAnalysis &static_storage,
+             AbiLowering &abi);
+
+    /**
+     * Get function attributes
+     * @param name Function IR name
+     * @return Space-separated attribute list (e.g., "nounwind readnone"),
+     *         empty if the function is unknown
+     */
+    std::string function_attributes(const std::string &name) const;
+
+    /**
+     * Get attributes for a parameter of a function
+     * @param name Function IR name
+     * @param index Parameter index in the source signature (self included,
+     *              sret pointer excluded)
+     * @return Space-separated attribute list (e.g., "nocapture readonly"),
+     *         empty if nothing can be inferred
+     */
+    std::string param_attributes(const std::string &name, size_t index) const;
+
+    /**
+     * Check if a by-value aggregate parameter needs its own copy on entry
+     * Parameters that are never modified and whose address does not escape
+     * use the caller's storage directly
+     * @param name Function IR name
+     * @param index Parameter index in the source signature
+     * @return true if unknown
+     */
+    bool param_needs_copy(const std::string &name, size_t index) const;
+
+    /**
+     * Treat every function as reading and writing module globals (e.g., the
+     * block execution counters of BlockCounters), so none is readnone or
+     * readonly. Call before run()
+     */
+    void set_writes_globals(bool writes_globals) { writes_globals_ = writes_globals; }
+
+  private:
+    bool writes_globals_ = false;
+
+    /**
+     * How a parameter is used. Only pointer parameters are tracked.
+     * A by-value aggregate is a pointer parameter unless AbiLowering flattens
+     * it, in which case the caller does the read. It is a local copy if it is
+     * flattened or may be modified; otherwise it is only read in place.
+     */
+    struct ParamEffects {
+        bool is_pointer = false;
+        bool is_local_copy = false; // By-value aggregate, copied on entry
+        bool read = false;
+        bool written = false;
+        bool captured = false;
+    };
+
+    /**
+     * Pointer argument of a call: callee parameter `callee_param` receives
+     * caller parameter `caller_param`, or memory of unknown origin if
+     * caller_param is -1
+     */
+    struct PointerArg {
+        std::string callee;
+        size_t callee_param;
+        int caller_param;
+    };
+
+    struct FunctionEffects {
+        std::vector<ParamEffects> params;
+        bool reads_memory = false;  // Through pointers of unknown origin
+        bool writes_memory = false; // Through pointers of unknown origin
+        bool uses_sret = false;     // Writes its result through the sret pointer
+        bool has_io = false;
+        bool may_not_return = false;
+        bool is_recursive = false;
+        std::vector<PointerArg> pointer_args;
+    };
+
+    std::map<std::string, FunctionEffects> effects_;
+
+    FunctionEffects scan_function(FnDecl *decl, const CallGraph &call_graph, AbiLowering &abi);
+
+    /**
+     * Propagate callee effects into one function
+     * @return true if anything changed
+     */
+    bool propagate(FunctionEffects &effects, const CallGraph &call_graph,
+                   const std::string &name);
+
+    static bool reads(const FunctionEffects &effects);
+    static bool writes(const FunctionEffects &effects);
+};
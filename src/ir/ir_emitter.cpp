@@ -1,20 +1,95 @@
 #include "ir_emitter.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <map>
+
+namespace {
+
+bool is_name_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '_' || c == '$' ||
+           c == '-';
+}
+
+/**
+ * Renumber the unnamed temporaries (%0, %1, ...) of a function body in order
+ * of definition, as LLVM requires after its blocks were reordered
+ */
+std::string renumber_temps(const std::string &body) {
+    // Definitions: "%N = " at the start of an indented line
+    std::map<std::string, std::string> numbers;
+    for (size_t pos = 0; pos < body.size();) {
+        size_t end = body.find('\n', pos);
+        end = end == std::string::npos ? body.size() : end;
+        size_t at = body.find_first_not_of(' ', pos);
+        if (at < end && body[at] == '%') {
+            size_t name_end = at + 1;
+            while (name_end < end && std::isdigit(static_cast<unsigned char>(body[name_end]))) {
+                ++name_end;
+            }
+            if (name_end > at + 1 && body.compare(name_end, 3, " = ") == 0) {
+                std::string next = std::to_string(numbers.size());
+                numbers.emplace(body.substr(at + 1, name_end - at - 1), next);
+            }
+        }
+        pos = end + 1;
+    }
+
+    std::string result;
+    result.reserve(body.size());
+    for (size_t i = 0; i < body.size();) {
+        if (body[i] != '%') {
+            result += body[i++];
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < body.size() && is_name_char(body[end])) {
+            ++end;
+        }
+        std::string name = body.substr(i + 1, end - i - 1);
+        auto it = numbers.find(name);
+        result += '%';
+        result += it != numbers.end() ? it->second : name;
+        i = end;
+    }
+    return result;
+}
+
+} // namespace
 
-IREmitter::IREmitter(const std::string &module_name)
-    : module_name_(module_name), temp_counter_(0), label_counter_(0), stack_counter_(0),
-      trampoline_counter_(0), indent_level_(0), in_entry_block_(false), is_inside_function_(false) {
+IREmitter::IREmitter(const std::string &module_name, const DataLayout *data_layout,
+                     bool module_header)
+    : module_name_(module_name), data_layout_(data_layout), temp_counter_(0), label_counter_(0),
+      stack_counter_(0), trampoline_counter_(0), indent_level_(0), in_entry_block_(false),
+      is_inside_function_(false) {
+    if (!module_header) {
+        return;
+    }
     ir_stream_ << "; ModuleID = '" << module_name_ << "'\n";
-    ir_stream_ << "source_filename = \"" << module_name_ << "\"\n\n";
+    ir_stream_ << "source_filename = \"" << module_name_ << "\"\n";
+    if (data_layout_) {
+        ir_stream_ << "target datalayout = \"" << DataLayout::LLVM_DATALAYOUT << "\"\n";
+    }
+    ir_stream_ << "\n";
 }
 
 void IREmitter::emit_global_variable(const std::string &name, const std::string &type,
-                                     const std::string &initializer, bool is_constant) {
+                                     const std::string &initializer, bool is_constant,
+                                     const std::string &linkage) {
     ir_stream_ << "@" << name << " = ";
+    if (!linkage.empty()) {
+        ir_stream_ << linkage << " ";
+    }
     ir_stream_ << (is_constant ? "constant " : "global ");
-    ir_stream_ << type << " " << initializer << "\n";
+    ir_stream_ << type << " " << initializer;
+    size_t align = alignment_of(type);
+    if (align > 0) {
+        ir_stream_ << ", align " << align;
+    }
+    ir_stream_ << "\n";
 }
 
 void IREmitter::emit_struct_type(const std::string &name,
@@ -49,22 +124,31 @@ void IREmitter::emit_function_declaration(const std::string &return_type, const
 }
 
 void IREmitter::begin_function(const std::string &return_type, const std::string &name,
-                               const std::vector<std::pair<std::string, std::string>> &params) {
+                               const std::vector<std::pair<std::string, std::string>> &params,
+                               const std::string &attributes) {
     is_inside_function_ = true;
-    function_body_buffer_.str("");
-    function_body_buffer_.clear();
+    function_body_.clear();
     function_allocas_.clear();
+    block_prologue_.clear();
+    function_name_ = name;
+    current_label_.clear();
 
-    ir_stream_ << "\ndefine " << return_type << " @" << name << "(";
+    std::stringstream header;
+    header << "\ndefine " << return_type << " @" << name << "(";
 
     for (size_t i = 0; i < params.size(); ++i) {
-        ir_stream_ << params[i].first << " %" << params[i].second;
+        header << params[i].first << " %" << params[i].second;
         if (i + 1 < params.size()) {
-            ir_stream_ << ", ";
+            header << ", ";
         }
     }
 
-    ir_stream_ << ") {\n";
+    header << ")";
+    if (!attributes.empty()) {
+        header << " " << attributes;
+    }
+    header << " {\n";
+    function_header_ = header.str();
     indent_level_++;
 
     reset_temp_counter();
@@ -80,18 +164,21 @@ void IREmitter::finish_entry_block() {}
 void IREmitter::end_function() {
     indent_level_--;
 
-    std::string body = function_body_buffer_.str();
+    std::string body = layout_blocks(function_body_.take());
     size_t pos = body.find(":\n");
 
+    ir_stream_ << function_header_;
+
     if (pos != std::string::npos) {
+        std::string_view text = body;
         size_t insert_pos = pos + 2;
-        ir_stream_ << body.substr(0, insert_pos);
+        ir_stream_ << text.substr(0, insert_pos);
 
         for (const auto &alloca_instr : function_allocas_) {
             ir_stream_ << "  " << alloca_instr;
         }
 
-        ir_stream_ << body.substr(insert_pos);
+        ir_stream_ << text.substr(insert_pos);
     } else {
         for (const auto &alloca_instr : function_allocas_) {
             ir_stream_ << "  " << alloca_instr;
@@ -100,10 +187,17 @@ void IREmitter::end_function() {
     }
 
     ir_stream_ << "}\n";
+    for (const auto &metadata : function_metadata_) {
+        ir_stream_ << metadata << "\n";
+    }
+    function_metadata_.clear();
     is_inside_function_ = false;
+    flush();
 }
 
 void IREmitter::begin_basic_block(const std::string &label) {
+    block_prologue_.clear();
+    current_label_ = label;
     if (indent_level_ > 0) {
         indent_level_--;
     }
@@ -117,10 +211,17 @@ void IREmitter::begin_basic_block(const std::string &label) {
     indent_level_++;
 }
 
+void IREmitter::set_block_prologue(std::vector<std::string> lines) {
+    block_prologue_ = std::move(lines);
+}
+
 std::string IREmitter::emit_alloca(const std::string &type, const std::string &var_name) {
     std::string result = "%stack." + std::to_string(stack_counter_++);
 
     std::string line = result + " = alloca " + type;
+    if (size_t align = alignment_of(type)) {
+        line += ", align " + std::to_string(align);
+    }
     if (!var_name.empty()) {
         line += " ; " + var_name;
     }
@@ -136,13 +237,27 @@ std::string IREmitter::emit_alloca(const std::string &type, const std::string &v
 }
 
 void IREmitter::emit_store(const std::string &value_type, const std::string &value,
-                           const std::string &ptr) {
-    emit_line("store " + value_type + " " + value + ", " + value_type + "* " + ptr);
+                           const std::string &ptr, size_t align) {
+    std::string line = "store " + value_type + " " + value + ", " + value_type + "* " + ptr;
+    if (align == 0) {
+        align = alignment_of(value_type);
+    }
+    if (align > 0) {
+        line += ", align " + std::to_string(align);
+    }
+    emit_line(line);
 }
 
-std::string IREmitter::emit_load(const std::string &type, const std::string &ptr) {
+std::string IREmitter::emit_load(const std::string &type, const std::string &ptr, size_t align) {
     std::string result = new_temp();
-    emit_line(result + " = load " + type + ", " + type + "* " + ptr);
+    std::string line = result + " = load " + type + ", " + type + "* " + ptr;
+    if (align == 0) {
+        align = alignment_of(type);
+    }
+    if (align > 0) {
+        line += ", align " + std::to_string(align);
+    }
+    emit_line(line);
     return result;
 }
 
@@ -152,8 +267,8 @@ void IREmitter::emit_memcpy(const std::string &dest_ptr, const std::string &src_
     std::string src_i8 = emit_bitcast(ptr_type, src_ptr, "i8*");
 
     std::stringstream ss;
-    ss << "call void @llvm.memcpy.p0.p0.i64(i8* " << dest_i8 << ", i8* " << src_i8 << ", i64 "
-       << bytes << ", i1 false)";
+    ss << "call void @llvm.memcpy.p0.p0.i64(" << aligned_i8_ptr(ptr_type, dest_i8) << ", "
+       << aligned_i8_ptr(ptr_type, src_i8) << ", i64 " << bytes << ", i1 false)";
     emit_line(ss.str());
 }
 
@@ -162,11 +277,25 @@ void IREmitter::emit_memset(const std::string &dest_ptr, int value, size_t bytes
     std::string dest_i8 = emit_bitcast(ptr_type, dest_ptr, "i8*");
 
     std::stringstream ss;
-    ss << "call void @llvm.memset.p0.i64(i8* " << dest_i8 << ", i8 " << value << ", i64 " << bytes
-       << ", i1 false)";
+    ss << "call void @llvm.memset.p0.i64(" << aligned_i8_ptr(ptr_type, dest_i8) << ", i8 " << value
+       << ", i64 " << bytes << ", i1 false)";
     emit_line(ss.str());
 }
 
+void IREmitter::emit_lifetime_start(const std::string &ptr, size_t bytes,
+                                    const std::string &ptr_type) {
+    std::string ptr_i8 = emit_bitcast(ptr_type, ptr, "i8*");
+    emit_line("call void @llvm.lifetime.start.p0(i64 " + std::to_string(bytes) + ", i8* " + ptr_i8 +
+              ")");
+}
+
+void IREmitter::emit_lifetime_end(const std::string &ptr, size_t bytes,
+                                  const std::string &ptr_type) {
+    std::string ptr_i8 = emit_bitcast(ptr_type, ptr, "i8*");
+    emit_line("call void @llvm.lifetime.end.p0(i64 " + std::to_string(bytes) + ", i8* " + ptr_i8 +
+              ")");
+}
+
 std::string IREmitter::emit_binary_op(const std::string &op, const std::string &type,
                                       const std::string &lhs, const std::string &rhs) {
     std::string result = new_temp();
@@ -217,6 +346,40 @@ std::string IREmitter::emit_bitcast(const std::string &from_type, const std::str
     return result;
 }
 
+std::string IREmitter::emit_insertelement(const std::string &vec_type, const std::string &vec,
+                                          const std::string &elem_type, const std::string &elem,
+                                          int index) {
+    std::string result = new_temp();
+    emit_line(result + " = insertelement " + vec_type + " " + vec + ", " + elem_type + " " + elem +
+              ", i32 " + std::to_string(index));
+    return result;
+}
+
+std::string IREmitter::emit_shufflevector(const std::string &vec_type, const std::string &lhs,
+                                          const std::string &rhs, const std::string &mask_type,
+                                          const std::string &mask) {
+    std::string result = new_temp();
+    emit_line(result + " = shufflevector " + vec_type + " " + lhs + ", " + vec_type + " " + rhs +
+              ", " + mask_type + " " + mask);
+    return result;
+}
+
+std::string IREmitter::emit_insertvalue(const std::string &agg_type, const std::string &agg,
+                                        const std::string &elem_type, const std::string &elem,
+                                        size_t index) {
+    std::string result = new_temp();
+    emit_line(result + " = insertvalue " + agg_type + " " + agg + ", " + elem_type + " " + elem +
+              ", " + std::to_string(index));
+    return result;
+}
+
+std::string IREmitter::emit_extractvalue(const std::string &agg_type, const std::string &agg,
+                                         size_t index) {
+    std::string result = new_temp();
+    emit_line(result + " = extractvalue " + agg_type + " " + agg + ", " + std::to_string(index));
+    return result;
+}
+
 void IREmitter::emit_ret(const std::string &type, const std::string &value) {
     emit_line("ret " + type + " " + value);
 }
@@ -240,7 +403,8 @@ std::pair<std::string, std::string> IREmitter::emit_cond_br(const std::string &c
     std::string jmp_false = "jmp_false_" + std::to_string(tramp_id);
     
     // Conditional branch to nearby trampoline blocks
-    emit_line("br i1 " + condition + ", label %" + jmp_true + ", label %" + jmp_false);
+    emit_line("br i1 " + condition + ", label %" + jmp_true + ", label %" + jmp_false +
+              branch_weights(true_label, false_label));
     
     // Trampoline block for true branch
     if (indent_level_ > 0) indent_level_--;
@@ -261,6 +425,7 @@ std::pair<std::string, std::string> IREmitter::emit_cond_br(const std::string &c
     }
     indent_level_++;
     emit_line("br label %" + false_label);
+    current_label_ = jmp_false;
     
     // Return the trampoline labels for PHI node predecessors
     return {jmp_true, jmp_false};
@@ -285,7 +450,8 @@ std::string IREmitter::emit_phi(const std::string &type,
 void IREmitter::emit_unreachable() { emit_line("unreachable"); }
 
 std::string IREmitter::emit_call(const std::string &return_type, const std::string &func_name,
-                                 const std::vector<std::pair<std::string, std::string>> &args) {
+                                 const std::vector<std::pair<std::string, std::string>> &args,
+                                 const std::string &attributes) {
     std::string result = new_temp();
     std::string call_str = result + " = call " + return_type + " @" + func_name + "(";
 
@@ -297,12 +463,16 @@ std::string IREmitter::emit_call(const std::string &return_type, const std::stri
     }
 
     call_str += ")";
+    if (!attributes.empty()) {
+        call_str += " " + attributes;
+    }
     emit_line(call_str);
     return result;
 }
 
 void IREmitter::emit_call_void(const std::string &func_name,
-                               const std::vector<std::pair<std::string, std::string>> &args) {
+                               const std::vector<std::pair<std::string, std::string>> &args,
+                               const std::string &attributes) {
     std::string call_str = "call void @" + func_name + "(";
 
     for (size_t i = 0; i < args.size(); ++i) {
@@ -313,6 +483,9 @@ void IREmitter::emit_call_void(const std::string &func_name,
     }
 
     call_str += ")";
+    if (!attributes.empty()) {
+        call_str += " " + attributes;
+    }
     emit_line(call_str);
 }
 
@@ -381,15 +554,51 @@ void IREmitter::write_to_file(const std::string &filename) {
         std::cerr << "Error: Cannot open file " << filename << " for writing" << std::endl;
         return;
     }
-    out << ir_stream_.str();
+    out << ir_buffer_.str();
     out.close();
 }
 
-void IREmitter::write_to_stdout() { std::cout << ir_stream_.str(); }
+void IREmitter::write_to_stdout() { std::cout << ir_buffer_.str(); }
+
+std::string IREmitter::get_ir_string() const { return ir_buffer_.str(); }
+
+std::string IREmitter::take_ir() { return ir_buffer_.take(); }
+
+void IREmitter::append_ir(const std::string &text) {
+    if (sink_) {
+        flush();
+        if (!text.empty()) {
+            sink_(text);
+        }
+    } else {
+        ir_stream_ << text;
+    }
+}
+
+void IREmitter::set_sink(IRSink sink) { sink_ = std::move(sink); }
 
-std::string IREmitter::get_ir_string() const { return ir_stream_.str(); }
+void IREmitter::flush() {
+    if (sink_ && !ir_buffer_.str().empty()) {
+        sink_(ir_buffer_.str());
+        // Keeps the capacity for the next function
+        ir_buffer_.clear();
+    }
+}
+
+size_t IREmitter::reserve_metadata(size_t count) {
+    size_t first = metadata_counter_;
+    metadata_counter_ += count;
+    return first;
+}
 
 void IREmitter::emit_line(const std::string &line) {
+    if (!block_prologue_.empty() && line.find(" = phi ") == std::string::npos) {
+        std::vector<std::string> prologue = std::move(block_prologue_);
+        block_prologue_.clear();
+        for (const auto &prologue_line : prologue) {
+            emit_line(prologue_line);
+        }
+    }
     if (is_inside_function_) {
         function_body_buffer_ << indent() << line << "\n";
     } else {
@@ -405,4 +614,119 @@ void IREmitter::emit_raw(const std::string &text) {
     }
 }
 
+size_t IREmitter::alignment_of(const std::string &ir_type) const {
+    return data_layout_ ? data_layout_->ir_alignment(ir_type) : 0;
+}
+
+std::string IREmitter::aligned_i8_ptr(const std::string &ptr_type,
+                                      const std::string &i8_ptr) const {
+    size_t align = 0;
+    if (!ptr_type.empty() && ptr_type.back() == '*') {
+        align = alignment_of(ptr_type.substr(0, ptr_type.size() - 1));
+    }
+    if (align == 0) {
+        return "i8* " + i8_ptr;
+    }
+    return "i8* align " + std::to_string(align) + " " + i8_ptr;
+}
+
+std::string IREmitter::branch_weights(const std::string &true_label,
+                                      const std::string &false_label) {
+    uint64_t taken = 0;
+    uint64_t not_taken = 0;
+    if (!profile_ || !profile_->count(function_name_, true_label, taken) ||
+        !profile_->count(function_name_, false_label, not_taken)) {
+        return "";
+    }
+    // A target may have other predecessors, but no edge runs more often than its
+    // source. If the targets together ran more often, take the busier one for a
+    // join point that the other target also reaches (if.end after if.then)
+    uint64_t source = 0;
+    if (profile_->count(function_name_, current_label_, source)) {
+        taken = std::min(taken, source);
+        not_taken = std::min(not_taken, source);
+        if (taken + not_taken > source) {
+            (taken > not_taken ? taken : not_taken) = source - std::min(taken, not_taken);
+        }
+    }
+    if (taken == 0 && not_taken == 0) {
+        return "";
+    }
+
+    // Weights are i32
+    uint64_t scale = std::max(taken, not_taken) / UINT32_MAX + 1;
+    std::string id = "!" + std::to_string(metadata_counter_++);
+    function_metadata_.push_back(id + " = !{!\"branch_weights\", i32 " +
+                                 std::to_string(taken / scale) + ", i32 " +
+                                 std::to_string(not_taken / scale) + "}");
+    return ", !prof " + id;
+}
+
+std::string IREmitter::layout_blocks(std::string body) const {
+    if (!profile_ || !profile_->has_function(function_name_)) {
+        return body;
+    }
+
+    // Split at label lines (the only unindented lines)
+    struct Block {
+        std::string label;
+        std::string text;
+        std::string terminator;
+    };
+    std::vector<Block> blocks;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        size_t end = body.find('\n', pos);
+        end = end == std::string::npos ? body.size() : end + 1;
+        std::string line = body.substr(pos, end - pos);
+        bool is_label = line.size() > 2 && line[0] != ' ' && line[line.size() - 2] == ':';
+        if (is_label) {
+            blocks.push_back({line.substr(0, line.size() - 2), "", ""});
+        } else if (blocks.empty()) {
+            return body;
+        } else if (line.find_first_not_of(" \n") != std::string::npos) {
+            blocks.back().terminator = line;
+        }
+        blocks.back().text += line;
+        pos = end;
+    }
+
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        index[blocks[i].label] = i;
+    }
+    std::vector<BlockProfile::LayoutBlock> layout(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const std::string &terminator = blocks[i].terminator;
+        for (size_t at = terminator.find("label %"); at != std::string::npos;
+             at = terminator.find("label %", at)) {
+            at += 7;
+            size_t end = terminator.find_first_of(", \n", at);
+            auto target = index.find(terminator.substr(at, end - at));
+            if (target != index.end()) {
+                layout[i].successors.push_back(target->second);
+            }
+        }
+    }
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        // Trampolines run as often as their target
+        const std::string &label = blocks[i].label;
+        bool trampoline = label.rfind("jmp_true_", 0) == 0 || label.rfind("jmp_false_", 0) == 0;
+        const std::string &counted = trampoline && !layout[i].successors.empty()
+                                         ? blocks[layout[i].successors[0]].label
+                                         : label;
+        profile_->count(function_name_, counted, layout[i].count);
+    }
+
+    std::vector<size_t> order = BlockProfile::hot_cold_order(layout);
+    if (std::is_sorted(order.begin(), order.end())) {
+        return body;
+    }
+    std::string result;
+    for (size_t i : order) {
+        result += blocks[i].text;
+    }
+    return renumber_temps(result);
+}
+
 std::string IREmitter::indent() const { return std::string(indent_level_ * 2, ' '); }
@@ -1,6 +1,12 @@
 #pragma once
+#include "block_profile.h"
+#include "data_layout.h"
+#include "../tool/string_buffer.h"
+
+#include <functional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -13,21 +19,39 @@
  * 3. Manage basic block label naming (label0, label1...)
  * 4. Provide text generation methods for various IR instructions
  * 5. Maintain indentation for readable output
+ * 6. Annotate memory instructions with ABI alignment from DataLayout
+ * 7. With a block profile, weight conditional branches and lay out the
+ *    blocks of profiled functions hot path first
+ */
+/**
+ * Receives the IR of a module piece by piece, in order
  */
+using IRSink = std::function<void(std::string_view)>;
+
 class IREmitter {
   public:
     /**
      * Constructor
      * @param module_name Module name
+     * @param data_layout Target data layout, emits `target datalayout` and
+     *        default alignments of alloca/load/store/memcpy/memset when set
+     * @param module_header Start with the module header; false for a fragment
+     *        that is later appended to a module (see append_ir)
      */
-    explicit IREmitter(const std::string &module_name);
+    explicit IREmitter(const std::string &module_name, const DataLayout *data_layout = nullptr,
+                       bool module_header = true);
 
     /**
      * Emit global variable declaration
-     * Example: @global_var = global i32 0
+     * @param linkage Linkage and attributes placed before global/constant
+     *        (e.g., "private unnamed_addr"), empty for external
+     * Alignment comes from the data layout, if set
+     * Example: @global_var = global i32 0, align 4
+     * Example: @.const.0 = private unnamed_addr constant [3 x i32] [i32 2, i32 3, i32 5], align 4
      */
     void emit_global_variable(const std::string &name, const std::string &type,
-                              const std::string &initializer, bool is_constant = false);
+                              const std::string &initializer, bool is_constant = false,
+                              const std::string &linkage = "");
 
     /**
      * Emit struct type definition
@@ -45,10 +69,13 @@ class IREmitter {
 
     /**
      * Begin function definition
+     * @param attributes Function attributes placed after the parameter list
      * Example: define i32 @main(i32 %argc, i8** %argv) {
+     * Example: define i32 @sq(i32 %x) nounwind readnone {
      */
     void begin_function(const std::string &return_type, const std::string &name,
-                        const std::vector<std::pair<std::string, std::string>> &params);
+                        const std::vector<std::pair<std::string, std::string>> &params,
+                        const std::string &attributes = "");
 
     /**
      * Finish entry block, output buffered alloca instructions
@@ -68,41 +95,70 @@ class IREmitter {
      */
     void begin_basic_block(const std::string &label);
 
+    /**
+     * Set instructions that start the current block after its phis
+     * They are emitted right before the first instruction that is not a phi;
+     * the next begin_basic_block discards them if none came
+     * Example: block execution counters (see BlockCounters)
+     */
+    void set_block_prologue(std::vector<std::string> lines);
+
+    /**
+     * Use a block execution profile (nullptr: none)
+     * - emit_cond_br attaches !prof branch_weights from the counts of its
+     *   targets, capped by the count of the branching block
+     * - end_function reorders the blocks of a function in the profile with
+     *   BlockProfile::hot_cold_order (the entry block stays first)
+     * Labels are looked up in the function being emitted.
+     */
+    void set_profile(const BlockProfile *profile) { profile_ = profile; }
+
     /**
      * alloca instruction: Allocate memory on stack
      * @return Allocated pointer variable name (e.g., %0)
-     * Example: %0 = alloca i32
+     * Alignment comes from the data layout, if set
+     * Example: %0 = alloca i32, align 4
      */
     std::string emit_alloca(const std::string &type, const std::string &var_name = "");
 
     /**
      * store instruction: Store value to memory
+     * @param align Explicit alignment in bytes (0 = ABI alignment of the type)
      * Example: store i32 42, i32* %0
      */
     void emit_store(const std::string &value_type, const std::string &value,
-                    const std::string &ptr);
+                    const std::string &ptr, size_t align = 0);
 
     /**
      * load instruction: Load value from memory
      * @return Loaded value variable name (e.g., %1)
+     * @param align Explicit alignment in bytes (0 = ABI alignment of the type)
      * Example: %1 = load i32, i32* %0
      */
-    std::string emit_load(const std::string &type, const std::string &ptr);
+    std::string emit_load(const std::string &type, const std::string &ptr, size_t align = 0);
 
     /**
      * memcpy instruction: Memory copy
-     * Uses llvm.memcpy.p0.p0.i64
+     * Uses llvm.memcpy.p0.p0.i64, pointers carry the alignment of ptr_type's pointee
      */
     void emit_memcpy(const std::string &dest_ptr, const std::string &src_ptr, size_t bytes,
                      const std::string &ptr_type);
 
     /**
      * memset instruction: Memory set
-     * Uses llvm.memset.p0.i64
+     * Uses llvm.memset.p0.i64, the pointer carries the alignment of ptr_type's pointee
      */
     void emit_memset(const std::string &dest_ptr, int value, size_t bytes,
                      const std::string &ptr_type);
 
+    /**
+     * Lifetime markers: the stack object at ptr becomes alive/dead
+     * Uses llvm.lifetime.start.p0 / llvm.lifetime.end.p0 on the i8* view of ptr
+     * Example: call void @llvm.lifetime.start.p0(i64 400, i8* %12)
+     */
+    void emit_lifetime_start(const std::string &ptr, size_t bytes, const std::string &ptr_type);
+    void emit_lifetime_end(const std::string &ptr, size_t bytes, const std::string &ptr_type);
+
     /**
      * Binary operation instruction
      * @param op Operator (add, sub, mul, sdiv, srem, udiv, urem, and, or, xor, etc.)
@@ -163,6 +219,37 @@ class IREmitter {
     std::string emit_bitcast(const std::string &from_type, const std::string &value,
                              const std::string &to_type);
 
+    /**
+     * insertelement instruction: Insert scalar into vector lane
+     * Example: %10 = insertelement <4 x i32> undef, i32 %0, i32 0
+     */
+    std::string emit_insertelement(const std::string &vec_type, const std::string &vec,
+                                   const std::string &elem_type, const std::string &elem,
+                                   int index);
+
+    /**
+     * shufflevector instruction: Permute lanes of two vectors
+     * Example: %11 = shufflevector <4 x i32> %10, <4 x i32> undef, <4 x i32> zeroinitializer
+     */
+    std::string emit_shufflevector(const std::string &vec_type, const std::string &lhs,
+                                   const std::string &rhs, const std::string &mask_type,
+                                   const std::string &mask);
+
+    /**
+     * insertvalue instruction: Insert a field into a first-class aggregate
+     * Example: %12 = insertvalue { i32, i32 } undef, i32 %0, 0
+     */
+    std::string emit_insertvalue(const std::string &agg_type, const std::string &agg,
+                                 const std::string &elem_type, const std::string &elem,
+                                 size_t index);
+
+    /**
+     * extractvalue instruction: Read a field of a first-class aggregate
+     * Example: %13 = extractvalue { i32, i32 } %12, 1
+     */
+    std::string emit_extractvalue(const std::string &agg_type, const std::string &agg,
+                                  size_t index);
+
     /**
      * Return instruction (with return value)
      * Example: ret i32 0
@@ -186,6 +273,7 @@ class IREmitter {
      * Uses trampoline blocks to avoid RISC-V beq/bne ±4KB range limitation
      * @return pair of (true_trampoline_label, false_trampoline_label) for PHI predecessors
      * Example: br i1 %cond, label %jmp_true_N, label %jmp_false_N
+     * Example: br i1 %cond, label %jmp_true_N, label %jmp_false_N, !prof !0   (with a profile)
      */
     std::pair<std::string, std::string> emit_cond_br(const std::string &condition, 
                                                       const std::string &true_label,
@@ -210,17 +298,21 @@ class IREmitter {
      * call instruction (with return value)
      * @param args Format: [(type1, value1), (type2, value2), ...]
      * @return Call result variable name
+     * @param attributes Call site function attributes
      * Example: %10 = call i32 @add(i32 %0, i32 %1)
+     * Example: %10 = call i32 @add(i32 %0, i32 %1) nounwind readnone
      */
     std::string emit_call(const std::string &return_type, const std::string &func_name,
-                          const std::vector<std::pair<std::string, std::string>> &args);
+                          const std::vector<std::pair<std::string, std::string>> &args,
+                          const std::string &attributes = "");
 
     /**
      * call instruction (no return value/void)
      * Example: call void @print(i32 %0)
      */
     void emit_call_void(const std::string &func_name,
-                        const std::vector<std::pair<std::string, std::string>> &args);
+                        const std::vector<std::pair<std::string, std::string>> &args,
+                        const std::string &attributes = "");
 
     /**
      * Generate vararg function call (for printf, scanf, etc.)
@@ -284,13 +376,55 @@ class IREmitter {
     void write_to_stdout();
 
     /**
-     * Get the generated IR string
+     * Get the generated IR string (with a sink, the IR not passed on yet)
      */
     std::string get_ir_string() const;
 
+    /**
+     * Get the IR emitted since the last call and drop it from the emitter
+     * (numbering state is kept)
+     */
+    std::string take_ir();
+
+    /**
+     * Append IR text verbatim, e.g. a fragment generated by another emitter
+     * Metadata ids of the fragment must come from reserve_metadata
+     * With a sink, the fragment is passed on directly, not copied
+     */
+    void append_ir(const std::string &text);
+
+    /**
+     * Stream the IR to sink instead of accumulating it
+     *
+     * The emitter passes its text on at the end of each function and before
+     * each appended fragment; module-level text in between (globals,
+     * declarations) waits for the next of those or for flush().
+     * @param sink Receives the IR in order; empty to accumulate again
+     */
+    void set_sink(IRSink sink);
+
+    /**
+     * Pass the IR emitted so far to the sink, if there is one
+     */
+    void flush();
+
+    /**
+     * Number of metadata nodes emitted so far (!0 .. !N-1)
+     */
+    size_t metadata_count() const { return metadata_counter_; }
+
+    /**
+     * Reserve ids for count metadata nodes defined elsewhere
+     * @return First reserved id
+     */
+    size_t reserve_metadata(size_t count);
+
   private:
     std::string module_name_;
-    std::stringstream ir_stream_;
+    StringBuffer ir_buffer_;
+    std::ostream ir_stream_{&ir_buffer_};
+    IRSink sink_;
+    const DataLayout *data_layout_;
 
     size_t temp_counter_;
     size_t label_counter_;
@@ -302,10 +436,51 @@ class IREmitter {
     std::vector<std::string> alloca_buffer_;
     std::stringstream instruction_buffer_;
 
+    /**
+     * The current function is buffered until end_function, so globals emitted
+     * while generating it (e.g., constant literals) land before its definition
+     */
     bool is_inside_function_;
-    std::stringstream function_body_buffer_;
+    std::string function_header_;
+    StringBuffer function_body_;
+    std::ostream function_body_buffer_{&function_body_};
     std::vector<std::string> function_allocas_;
 
+    /**
+     * Pending prologue of the current block, see set_block_prologue
+     */
+    std::vector<std::string> block_prologue_;
+
+    // Block profile (see set_profile)
+    const BlockProfile *profile_ = nullptr;
+    std::string function_name_;
+    std::string current_label_;
+    size_t metadata_counter_ = 0;
+    std::vector<std::string> function_metadata_; // Emitted after the function
+
+    /**
+     * Get ABI alignment of an IR type, 0 if unknown or no data layout is set
+     */
+    size_t alignment_of(const std::string &ir_type) const;
+
+    /**
+     * Format an i8* intrinsic argument with the pointee alignment of ptr_type
+     * Example: "i8* align 4 %5"
+     */
+    std::string aligned_i8_ptr(const std::string &ptr_type, const std::string &i8_ptr) const;
+
+    /**
+     * !prof suffix of a conditional branch from the block profile
+     * @return ", !prof !N", empty without counts for both targets
+     */
+    std::string branch_weights(const std::string &true_label, const std::string &false_label);
+
+    /**
+     * Reorder the blocks of a buffered function body, see set_profile
+     * @return The body unchanged if the function is not in the profile
+     */
+    std::string layout_blocks(std::string body) const;
+
     /**
      * Output a line (with indentation)
      */
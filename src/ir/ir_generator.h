@@ -1,19 +1,72 @@
 #pragma once
 
 #include "../ast/ast.h"
+#include "../ast/ast_walker.h"
 #include "../ast/visit.h"
 #include "../semantic/semantic.h"
+#include "abi.h"
+#include "block_counters.h"
+#include "call_graph.h"
+#include "data_layout.h"
+#include "effect_analysis.h"
 #include "ir_emitter.h"
+#include "static_storage.h"
 #include "type_mapper.h"
 #include "value_manager.h"
 
 #include <map>
 #include <memory>
 #include <set>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+class ThreadPool;
+
+/**
+ * What generating a function unit produced, all a module needs to merge the
+ * unit without generating it again
+ * ir: globals defined while generating it, then its definitions; constant
+ *     globals (@.const.N) and metadata (!N) are numbered from 0 in the unit
+ * const_globals: key of each constant global, by unit number
+ * diagnostics: warnings, reported when the unit is merged
+ */
+struct GeneratedUnit {
+    std::string ir;
+    std::vector<std::string> const_globals;
+    size_t metadata_count = 0;
+    std::vector<Diagnostic> diagnostics;
+};
+
+/**
+ * FunctionUnitStore - Generated function units kept across compilations
+ *
+ * IRGenerator looks every unit up under a key covering all its IR depends
+ * on: the store's digest of the function source, the struct types, the
+ * const values, the options, and the analysis results of the functions the
+ * unit defines or calls. Only units not found are generated, then stored.
+ * The generator calls the store from its own thread, one call at a time.
+ */
+class FunctionUnitStore {
+  public:
+    virtual ~FunctionUnitStore() = default;
+
+    /**
+     * Digest of a top-level function or impl method: its tokens and the
+     * declarations they can refer to
+     * @return Empty if the unit must not be reused
+     */
+    virtual std::string source_digest(FnDecl *decl) const = 0;
+
+    /**
+     * @return false if no unit is stored under key
+     */
+    virtual bool load(const std::string &key, GeneratedUnit &unit) = 0;
+
+    virtual void store(const std::string &key, const GeneratedUnit &unit) = 0;
+};
+
 /**
  * IRGenerator - LLVM IR Generator
  *
@@ -21,20 +74,35 @@
  * 1. Traverse AST to generate LLVM IR text
  * 2. Coordinate IREmitter, TypeMapper, ValueManager
  * 3. Handle expressions, statements, function definitions
+ * 4. Generate top-level functions as independent units, optionally on
+ *    several threads, and merge them in source order (set_threads)
+ * 5. Reuse units generated by an earlier compilation (set_unit_store)
  *
  * Design principles:
  * - Use visitor pattern to traverse AST
  * - Expression results are stored in expr_results_, not passed by return value
  * - Directly use the type field in AST nodes to get type information
  * - Do not use LLVM C++ API, generate plain text IR
+ * - Every top-level function and impl method (with the functions nested in
+ *   it) is generated by its own IRGenerator, sharing only the module
+ *   analyses; labels are numbered per unit, so the output does not depend
+ *   on the number of threads
  */
 class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
   public:
     /**
      * Constructor
      * @param builtin_types Reference to built-in types (from semantic analyzer)
+     * @param static_storage Size thresholds for moving local arrays to globals
+     * @param block_counters Block execution counting, off by default
+     * @param profile Block counts for branch weights and block layout, may be null;
+     *        must outlive the generator
      */
-    explicit IRGenerator(BuiltinTypes &builtin_types);
+    explicit IRGenerator(BuiltinTypes &builtin_types,
+                         const StaticStorageOptions &static_storage =
+                             StaticStorageOptions(),
+                         const BlockCounterOptions &block_counters = BlockCounterOptions(),
+                         const BlockProfile *profile = nullptr);
 
     /**
      * Generate IR for complete program
@@ -43,6 +111,36 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
      */
     std::string generate(Program *program);
 
+    /**
+     * Generate IR for complete program, passing it to sink as it is merged
+     *
+     * Units are generated a window at a time (one unit, or a few per thread)
+     * and released once written, so the IR held at any time is that of a
+     * window instead of the whole module. The concatenated pieces equal
+     * generate(program).
+     *
+     * @param program AST root node
+     * @param sink Receives the IR in order, in pieces of any size
+     */
+    void generate(Program *program, const IRSink &sink);
+
+    /**
+     * Report warnings to error_reporter instead of std::cerr (may be null)
+     */
+    void set_error_reporter(ErrorReporter *error_reporter) { error_reporter_ = error_reporter; }
+
+    /**
+     * Number of threads generating function units
+     * @param threads 1 (default): on the calling thread, 0: one per hardware thread
+     */
+    void set_threads(size_t threads) { threads_ = threads; }
+
+    /**
+     * Reuse generated units from store (may be null, must outlive generate)
+     * Units are never reused with block counting or a profile.
+     */
+    void set_unit_store(FunctionUnitStore *store) { unit_store_ = store; }
+
     void visit(LiteralExpr *node) override;
     void visit(ArrayLiteralExpr *node) override;
     void visit(ArrayInitializerExpr *node) override;
@@ -93,10 +191,96 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
     }
 
   private:
+    /**
+     * Analyses and type caches of the module, shared by the generator of the
+     * module and those of its function units
+     * The analyses run before any unit and are only read afterwards; the
+     * caches of DataLayout, TypeMapper and AbiLowering are thread-safe.
+     */
+    struct ModuleState {
+        ModuleState(BuiltinTypes &builtin_types, const StaticStorageOptions &static_storage_options)
+            : type_mapper(builtin_types), abi(data_layout, type_mapper),
+              static_storage(static_storage_options) {}
+
+        DataLayout data_layout;
+        TypeMapper type_mapper;
+        AbiLowering abi;
+        CallGraph call_graph;
+        EffectAnalysis effect_analysis;
+        StaticStorageAnalysis static_storage;
+    };
+
+    /**
+     * A top-level function or impl method and the functions nested in it,
+     * generated by its own IRGenerator
+     * key: key in the unit store, empty if the unit is not reused
+     */
+    struct FunctionUnit : GeneratedUnit {
+        Item *item = nullptr; // FnDecl or ImplBlock in Program::items
+        FnDecl *decl = nullptr;
+        std::string name; // IR name (Type_method for methods)
+        std::string key;
+        BlockCounters block_counters;
+    };
+
+    /**
+     * Generator of one function unit, sharing module with its parent
+     */
+    IRGenerator(std::shared_ptr<ModuleState> module, const BlockCounterOptions &block_counters,
+                const BlockProfile *profile, bool module_header);
+
+    std::shared_ptr<ModuleState> module_;
+
+    /**
+     * Type sizes, alignments and struct layouts (declared before emitter_,
+     * which refers to it)
+     */
+    DataLayout &data_layout_;
     IREmitter emitter_;
-    TypeMapper type_mapper_;
+    TypeMapper &type_mapper_;
     ValueManager value_manager_;
 
+    /**
+     * Parameter and return value passing of by-value aggregates
+     */
+    AbiLowering &abi_;
+
+    /**
+     * Call graph rooted at main
+     * Only reachable functions and used built-ins are emitted
+     */
+    CallGraph &call_graph_;
+
+    /**
+     * Effects of reachable functions, emitted as function, parameter and
+     * call site attributes
+     */
+    EffectAnalysis &effect_analysis_;
+
+    /**
+     * Large local arrays of non-reentrant functions, placed in globals
+     * emitted_static_slots_: globals already defined in the module
+     */
+    StaticStorageAnalysis &static_storage_;
+    std::set<std::string> emitted_static_slots_;
+
+    const BlockProfile *profile_ = nullptr;
+    size_t threads_ = 1;
+
+    /**
+     * Units of earlier compilations
+     * module_key_: digest of the module state every unit depends on,
+     *              empty when units are not reused
+     */
+    FunctionUnitStore *unit_store_ = nullptr;
+    std::string module_key_;
+
+    /**
+     * Execution counters on the blocks started by begin_block, dumped when
+     * main returns
+     */
+    BlockCounters block_counters_;
+
     /**
      * Target address (for in-place initialization optimization of aggregate types)
      */
@@ -119,6 +303,9 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
     int if_counter_ = 0;
     int while_counter_ = 0;
     int loop_counter_ = 0;
+    int logical_counter_ = 0;
+
+    ErrorReporter *error_reporter_ = nullptr;
 
     /**
      * Loop context: for break/continue jumps
@@ -130,6 +317,53 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
 
     std::vector<LoopContext> loop_stack_;
 
+    /**
+     * Loop unrolling limits, shared by while loops and array initializers
+     * UNROLL_THRESHOLD: maximum trip count that is fully unrolled
+     * UNROLL_BUDGET: maximum number of AST nodes in all copies of an unrolled body
+     */
+    static constexpr size_t UNROLL_THRESHOLD = 16;
+    static constexpr size_t UNROLL_BUDGET = 256;
+
+    /**
+     * Counted while loop: while (i < bound) { ...; i += step; }
+     * start is only known when the initial value of i is a constant
+     */
+    struct CountedLoop {
+        VariableExpr *induction = nullptr;
+        Expr *increment = nullptr;
+        std::string pred;
+        long long bound = 0;
+        long long step = 0;
+        bool is_unsigned = false;
+        bool has_start = false;
+        long long start = 0;
+        size_t body_cost = 0;
+    };
+
+    /**
+     * State of a vectorized loop body
+     * width: number of lanes, vec_type: e.g. "<4 x i32>"
+     * index: scalar induction value, index_i64: index widened for GEP
+     * array_bases: array variable name -> (array pointer, array IR type)
+     * splats: loop-invariant scalar variable name -> splatted vector
+     */
+    struct VectorLoopContext {
+        size_t width = 0;
+        std::string vec_type;
+        std::string index;
+        std::string index_i64;
+        std::map<std::string, std::pair<std::string, std::string>> array_bases;
+        std::map<std::string, std::string> splats;
+    };
+
+    /**
+     * Block and statement index currently being generated
+     * Used to look up the initial value of a loop induction variable
+     */
+    BlockStmt *current_block_stmt_ = nullptr;
+    size_t current_stmt_index_ = 0;
+
     /**
      * Marks whether current basic block is terminated (has br/ret/unreachable)
      * Used to avoid adding extra terminator instructions in terminated blocks
@@ -142,6 +376,16 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
      */
     std::string current_block_label_;
 
+    /**
+     * IR name of the function being generated
+     */
+    std::string current_function_name_;
+
+    /**
+     * Line of the last source token generated (for BlockCounters)
+     */
+    int current_source_line_ = 0;
+
     /**
      * Marks whether current function uses sret optimization
      */
@@ -153,6 +397,12 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
      */
     std::string current_function_return_type_str_;
 
+    /**
+     * Return type of the current function if it is a flattened aggregate
+     * (see AbiLowering), nullptr otherwise
+     */
+    Type *current_function_flat_return_ = nullptr;
+
     /**
      * Marks whether currently generating lvalue (for assignment target)
      * When true, IndexExpr and FieldAccessExpr return pointer instead of loading value
@@ -160,14 +410,150 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
     bool generating_lvalue_ = false;
 
     /**
-     * Process top-level Item (functions, structs, etc.)
+     * Recognize a counted while loop that is safe to unroll
+     * Rejects bodies with break/continue, nested loops, items, or other writes to i
+     * @param node While expression node
+     * @param loop Output: loop description
+     * @return true if the loop is a counted loop
+     */
+    bool analyze_counted_loop(WhileExpr *node, CountedLoop &loop);
+
+    /**
+     * Find the constant value of var on entry to a while loop
+     * Scans backwards over the statements preceding the loop in the current block
+     */
+    bool find_loop_entry_value(WhileExpr *node, const std::string &var, long long &value);
+
+    /**
+     * Number of iterations of a counted loop with a known start value
+     */
+    long long counted_loop_trip_count(const CountedLoop &loop);
+
+    /**
+     * Check whether a loop (or array initializer) should be fully unrolled
+     * @param trip_count Number of iterations
+     * @param body_cost Size of one copy of the body
+     */
+    bool should_fully_unroll(size_t trip_count, size_t body_cost);
+
+    /**
+     * Choose the partial unroll factor (8 or 4) for a counted loop
+     * @return Unroll factor, or 0 if the loop should not be unrolled
      */
-    void visit_item(Item *item);
+    size_t choose_unroll_factor(const CountedLoop &loop);
+
+    /**
+     * Emit all iterations of a counted loop as straight-line code
+     */
+    void emit_fully_unrolled_loop(WhileExpr *node, const CountedLoop &loop);
+
+    /**
+     * Emit the main loop of a partially unrolled counted loop
+     * The regular while lowering that follows serves as the remainder loop
+     */
+    void emit_partially_unrolled_loop(WhileExpr *node, const CountedLoop &loop, size_t factor);
+
+    /**
+     * Choose the vector width for an elementwise array loop
+     * Body must consist of X[i] = expr / X[i] op= expr over i32 arrays indexed by i
+     * @return 8 or 4, or 0 if the loop cannot be vectorized
+     */
+    size_t choose_vector_width(WhileExpr *node, const CountedLoop &loop);
+
+    /**
+     * Check whether expression can be evaluated lane-wise in a vectorized loop
+     */
+    bool is_vectorizable_expr(Expr *expr, const CountedLoop &loop);
+
+    /**
+     * Check whether index expression is X[i] with X an i32 array covering the loop range
+     */
+    bool is_vectorizable_access(Expr *expr, const CountedLoop &loop);
+
+    /**
+     * Emit the vector loop of a vectorized counted loop
+     * The regular while lowering that follows serves as the scalar epilogue
+     */
+    void emit_vectorized_loop(WhileExpr *node, const CountedLoop &loop, size_t width);
+
+    /**
+     * Emit loop-invariant parts of a vectorized expression (array bases, splats)
+     */
+    void emit_vector_invariants(Expr *expr, const CountedLoop &loop, VectorLoopContext &ctx);
+
+    /**
+     * Emit lane-wise evaluation of a vectorizable expression
+     * @return Vector value
+     */
+    std::string emit_vector_expr(Expr *expr, const CountedLoop &loop, VectorLoopContext &ctx);
+
+    /**
+     * Emit pointer to the vector of elements X[i .. i + width - 1]
+     */
+    std::string emit_vector_element_ptr(IndexExpr *access, VectorLoopContext &ctx);
+
+    /**
+     * Allocate stack storage for a value of the given type
+     * Aggregates get a slot owned by the current ValueManager scope, bracketed
+     * by lifetime markers; a dead slot of the same IR type is reused if free.
+     * Scalars get a plain alloca (mem2reg promotes them anyway)
+     * @return Pointer to the storage
+     */
+    std::string allocate_stack_slot(Type *type);
+
+    /**
+     * End the lifetime of released stack slots at the current position
+     * Nothing is emitted after a terminator
+     */
+    void end_stack_slot_lifetimes(const std::vector<StackSlot> &slots);
+
+    /**
+     * Check whether an aggregate expression builds its value directly at the
+     * target address (array literals, repeat arrays, struct initializers)
+     */
+    bool builds_at_target_address(Expr *expr);
+
+    /**
+     * Evaluate an aggregate expression into dest
+     * Builds in place when possible, otherwise copies the result with memcpy
+     */
+    void emit_aggregate_into(Expr *value, const std::string &dest, Type *type);
+
+    /**
+     * Get the private constant global holding a fully-constant aggregate literal
+     * Emits the global on first use, identical literals share one global
+     * @param expr Array literal, zero repeat array or struct initializer
+     * @return Global pointer (e.g., "@.const.0"), empty if the literal is not
+     *         constant or smaller than CONST_GLOBAL_MIN_BYTES
+     */
+    std::string get_const_aggregate_global(Expr *expr);
+
+    /**
+     * Initialize dest from a fully-constant aggregate literal
+     * All-zero literals use memset, others memcpy from their constant global
+     * @return false if the literal is not constant (nothing emitted)
+     */
+    bool emit_const_aggregate_init(Expr *expr, const std::string &dest, Type *type);
+
+    /**
+     * Store value into elements [0, count) of an array with a counted loop
+     */
+    void emit_fill_loop(const std::string &array_ir_type, const std::string &array_ptr,
+                        const std::string &elem_ir_type, const std::string &value, size_t count);
+
+    /**
+     * Replicate element 0 of an array into elements [1, count) by doubling:
+     * memcpy [0, n) -> [n, 2n) until the array is full, log2(count) copies
+     */
+    void emit_doubling_fill(const std::string &array_ir_type, const std::string &array_ptr,
+                            Type *elem_type, size_t count);
 
     /**
      * Process function definition
+     * @param name IR name of the function
      */
-    void visit_function_decl(FnDecl *node);
+    void visit_function_decl(FnDecl *node, const std::string &name);
+    void visit_function_decl(FnDecl *node) { visit_function_decl(node, node->name.lexeme); }
 
     /**
      * Process struct definition
@@ -180,9 +566,49 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
     void visit_const_decl(ConstDecl *node);
 
     /**
-     * Process impl block
+     * Function units of the reachable top-level functions and impl methods,
+     * in source order
+     */
+    std::vector<FunctionUnit> collect_function_units(Program *program);
+
+    /**
+     * Generate the module, passing it to sink piece by piece if there is one
+     */
+    void generate_module(Program *program, const IRSink *sink);
+
+    /**
+     * Load the units found in the unit store, generate the others and store
+     * them
+     * @param pool Workers, null to generate on the calling thread
+     */
+    void generate_function_units(std::span<FunctionUnit> units, ThreadPool *pool);
+
+    /**
+     * Digest of the module state all units depend on
+     * @param struct_types IR of the struct type definitions
+     */
+    std::string module_fingerprint(const std::string &struct_types) const;
+
+    /**
+     * Key of a unit in the unit store, empty if the store cannot digest it
      */
-    void visit_impl_block(ImplBlock *node);
+    std::string unit_key(const FunctionUnit &unit) const;
+
+    /**
+     * Generate one unit with a generator of its own
+     */
+    void generate_function_unit(FunctionUnit &unit) const;
+
+    /**
+     * Append a generated unit to the module: give its constant globals and
+     * metadata module numbers, add its block counters and report its warnings
+     */
+    void merge_function_unit(FunctionUnit &unit);
+
+    /**
+     * Report a warning to error_reporter_, or to std::cerr without one
+     */
+    void warn(const std::string &message);
 
     /**
      * Collect all struct definitions in program (including local structs)
@@ -214,6 +640,17 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
      */
     void begin_block(const std::string &label);
 
+    /**
+     * Record the source line of a token being generated
+     */
+    void note_source_line(int line);
+
+    /**
+     * Emit what has to run before main returns (the block count dump)
+     * Nothing is emitted in other functions
+     */
+    void emit_exit_hooks();
+
     /**
      * Declare C library functions needed by built-in functions
      */
@@ -265,6 +702,9 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
 
     /**
      * Compile-time evaluate constant expression
+     * Scalars evaluate to a number (e.g., "25"), arrays and structs to an LLVM
+     * constant in IR field order (e.g., "[i32 1, i32 2]", "{ i32 1, i1 0 }",
+     * "zeroinitializer")
      * @param expr Expression node
      * @param result Output: evaluation result (as string)
      * @return Whether evaluation succeeded
@@ -272,15 +712,18 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
     bool evaluate_const_expr(Expr *expr, std::string &result);
 
     /**
-     * Get type size (in bytes)
-     * Considers alignment and padding
+     * Parse an integer literal lexeme (decimal, 0x, 0b, 0o, optional type suffix)
+     * @return Whether the lexeme is a valid integer
      */
-    size_t get_type_size(Type *type);
+    static bool parse_integer_literal(const std::string &lexeme, long long &value);
 
     /**
-     * Get type alignment requirement (in bytes)
+     * Compile-time evaluate integer constant expression
+     * @param expr Expression node
+     * @param result Output: evaluation result
+     * @return Whether evaluation succeeded
      */
-    size_t get_type_alignment(Type *type);
+    bool evaluate_const_int(Expr *expr, long long &result);
 
     /**
      * Check if expression is a zero initializer
@@ -292,15 +735,56 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
 
     /**
      * Check if function should use sret optimization
-     * Condition: function name ends with _new AND returns large struct (>64 bytes)
+     * Condition: returns a struct that AbiLowering does not flatten
      */
     bool should_use_sret_optimization(const std::string &func_name, Type *return_type);
 
+    /**
+     * Check if a method takes self by value (`self`, not `&self`)
+     * Such a self is passed like any other by-value argument
+     * @param func_name Method IR name (e.g., "Point_len")
+     */
+    bool takes_self_by_value(const std::string &func_name);
+
+    /**
+     * Load the scalars of a flattened aggregate (see AbiLowering)
+     * @param ptr Pointer to the aggregate
+     * @return (IR type, value) pairs in AbiLowering::scalars order
+     */
+    std::vector<std::pair<std::string, std::string>> emit_flattened_loads(Type *type,
+                                                                          const std::string &ptr);
+
+    /**
+     * Store scalars of a flattened aggregate into memory at ptr
+     */
+    void emit_flattened_stores(Type *type, const std::vector<std::string> &values,
+                               const std::string &ptr);
+
+    /**
+     * Return the flattened aggregate at ptr: ret of the single scalar, or of
+     * a literal struct built with insertvalue
+     */
+    void emit_flattened_return(Type *type, const std::string &ptr);
+
+    /**
+     * Store the result of a call returning a flattened aggregate into a new
+     * stack slot
+     * @return Pointer to the slot
+     */
+    std::string unpack_flattened_result(Type *type, const std::string &result);
+
     std::unordered_map<std::string, std::string> const_values_;
 
-    std::unordered_map<Type *, size_t> type_size_cache_;
+    /**
+     * Private constant globals of aggregate literals
+     * Key: "<IR type> <constant>", value: global name (e.g., "@.const.0")
+     */
+    std::unordered_map<std::string, std::string> const_globals_;
 
-    std::unordered_map<std::string, int> field_index_cache_;
+    /**
+     * Aggregates smaller than this are initialized with individual stores
+     */
+    static constexpr size_t CONST_GLOBAL_MIN_BYTES = 16;
 
     /**
      * Nested function queue: stores functions defined inside function body
@@ -316,7 +800,9 @@ class IRGenerator : public ExprVisitor<void>, public StmtVisitor {
     /**
      * Local struct queue: stores structs defined inside function body
      * Type definitions for these structs need to be generated at module top
-     * Uses set to avoid duplicate collection
+     * Emitted in collection (source) order, so the output does not depend on
+     * heap addresses; uses set to avoid duplicate collection
      */
+    std::vector<StructDecl *> local_structs_;
     std::set<StructDecl *> local_structs_set_;
 };
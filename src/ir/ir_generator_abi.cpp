@@ -0,0 +1,93 @@
+#include "ir_generator.h"
+
+bool IRGenerator::takes_self_by_value(const std::string &func_name) {
+    const auto &decls = call_graph_.declarations(func_name);
+    if (decls.empty() || decls.front()->params.empty()) {
+        return false;
+    }
+
+    const auto &self_param = decls.front()->params.front();
+    auto id_pattern = dynamic_cast<IdentifierPattern *>(self_param->pattern.get());
+    if (!id_pattern || id_pattern->name.lexeme != "self" || !self_param->type ||
+        !self_param->type->resolved_type) {
+        return false;
+    }
+    return self_param->type->resolved_type->kind != TypeKind::REFERENCE;
+}
+
+/**
+ * Load every scalar leaf of a flattened aggregate.
+ *
+ * Example for struct Point { x: i32, y: i32 }:
+ *   %1 = getelementptr inbounds %Point, %Point* %p, i64 0, i32 0
+ *   %2 = load i32, i32* %1
+ *   %3 = getelementptr inbounds %Point, %Point* %p, i64 0, i32 1
+ *   %4 = load i32, i32* %3
+ *   -> {("i32", "%2"), ("i32", "%4")}
+ */
+std::vector<std::pair<std::string, std::string>>
+IRGenerator::emit_flattened_loads(Type *type, const std::string &ptr) {
+    std::string ir_type = type_mapper_.map(type);
+
+    std::vector<std::pair<std::string, std::string>> values;
+    for (const auto &scalar : abi_.scalars(type)) {
+        std::string elem_ptr = emitter_.emit_getelementptr_inbounds(ir_type, ptr, scalar.indices);
+        values.push_back({scalar.type, emitter_.emit_load(scalar.type, elem_ptr)});
+    }
+    return values;
+}
+
+void IRGenerator::emit_flattened_stores(Type *type, const std::vector<std::string> &values,
+                                        const std::string &ptr) {
+    std::string ir_type = type_mapper_.map(type);
+
+    const auto &scalars = abi_.scalars(type);
+    for (size_t i = 0; i < scalars.size() && i < values.size(); ++i) {
+        std::string elem_ptr =
+            emitter_.emit_getelementptr_inbounds(ir_type, ptr, scalars[i].indices);
+        emitter_.emit_store(scalars[i].type, values[i], elem_ptr);
+    }
+}
+
+/**
+ * Return a flattened aggregate.
+ *
+ * One leaf:      ret i32 %v
+ * Several leaves:
+ *   %r0 = insertvalue { i32, i32 } undef, i32 %x, 0
+ *   %r1 = insertvalue { i32, i32 } %r0, i32 %y, 1
+ *   ret { i32, i32 } %r1
+ */
+void IRGenerator::emit_flattened_return(Type *type, const std::string &ptr) {
+    auto values = emit_flattened_loads(type, ptr);
+    std::string ret_type = abi_.return_type(type);
+
+    if (values.size() == 1) {
+        emitter_.emit_ret(ret_type, values.front().second);
+        return;
+    }
+
+    std::string result = "undef";
+    for (size_t i = 0; i < values.size(); ++i) {
+        result = emitter_.emit_insertvalue(ret_type, result, values[i].first, values[i].second, i);
+    }
+    emitter_.emit_ret(ret_type, result);
+}
+
+std::string IRGenerator::unpack_flattened_result(Type *type, const std::string &result) {
+    std::string slot = allocate_stack_slot(type);
+
+    size_t count = abi_.scalars(type).size();
+    std::vector<std::string> values;
+    if (count == 1) {
+        values.push_back(result);
+    } else {
+        std::string ret_type = abi_.return_type(type);
+        for (size_t i = 0; i < count; ++i) {
+            values.push_back(emitter_.emit_extractvalue(ret_type, result, i));
+        }
+    }
+
+    emit_flattened_stores(type, values, slot);
+    return slot;
+}
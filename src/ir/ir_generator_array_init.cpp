@@ -0,0 +1,184 @@
+#include "ir_generator.h"
+
+bool IRGenerator::builds_at_target_address(Expr *expr) {
+    return dynamic_cast<ArrayLiteralExpr *>(expr) || dynamic_cast<ArrayInitializerExpr *>(expr) ||
+           dynamic_cast<StructInitializerExpr *>(expr);
+}
+
+/**
+ * Evaluate an aggregate expression into dest.
+ *
+ * Literals and initializers take dest as their target address and build the
+ * value there. Any other expression (variables, calls, field/index accesses)
+ * yields a pointer to its value, which is copied with one memcpy.
+ *
+ * The value is never loaded as a first-class aggregate.
+ */
+void IRGenerator::emit_aggregate_into(Expr *value, const std::string &dest, Type *type) {
+    bool in_place = builds_at_target_address(value);
+    if (in_place) {
+        set_target_address(dest);
+    }
+
+    value->accept(this);
+    take_target_address();
+
+    std::string value_ptr = get_expr_result(value);
+    if (value_ptr.empty() || value_ptr == dest) {
+        return;
+    }
+
+    size_t size = data_layout_.size_of(type);
+    if (size > 0) {
+        emitter_.emit_memcpy(dest, value_ptr, size, type_mapper_.map(type) + "*");
+    }
+}
+
+/**
+ * Emit a counted loop storing value into every element of an array.
+ *
+ * IR structure:
+ *   store i64 0, i64* %idx
+ *   br label %fill.body.N
+ *
+ * fill.body.N:
+ *   %i = load i64, i64* %idx
+ *   %p = getelementptr inbounds [count x T], [count x T]* %arr, i64 0, i64 %i
+ *   store T value, T* %p
+ *   %next = add i64 %i, 1
+ *   store i64 %next, i64* %idx
+ *   %done = icmp eq i64 %next, count
+ *   br i1 %done, label %fill.end.N, label %fill.body.N
+ *
+ * fill.end.N:
+ *
+ * count is a positive constant, so the check is done once per element at the
+ * bottom of the single body block.
+ */
+void IRGenerator::emit_fill_loop(const std::string &array_ir_type, const std::string &array_ptr,
+                                 const std::string &elem_ir_type, const std::string &value,
+                                 size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    int current = while_counter_++;
+    std::string body_label = "fill.body." + std::to_string(current);
+    std::string end_label = "fill.end." + std::to_string(current);
+
+    std::string idx_ptr = emitter_.emit_alloca("i64");
+    emitter_.emit_store("i64", "0", idx_ptr);
+    emitter_.emit_br(body_label);
+
+    begin_block(body_label);
+    std::string i_val = emitter_.emit_load("i64", idx_ptr);
+    std::string elem_ptr =
+        emitter_.emit_getelementptr_inbounds(array_ir_type, array_ptr, {"i64 0", "i64 " + i_val});
+    emitter_.emit_store(elem_ir_type, value, elem_ptr);
+
+    std::string next_i = emitter_.emit_binary_op("add", "i64", i_val, "1");
+    emitter_.emit_store("i64", next_i, idx_ptr);
+    std::string done = emitter_.emit_icmp("eq", "i64", next_i, std::to_string(count));
+    emitter_.emit_cond_br(done, end_label, body_label);
+
+    begin_block(end_label);
+}
+
+/**
+ * Replicate element 0 into the rest of the array by doubling.
+ *
+ * Example for 5 elements, element size S:
+ *   memcpy(&arr[1], &arr[0], 1 * S)   ; [0, 1) -> [1, 2)
+ *   memcpy(&arr[2], &arr[0], 2 * S)   ; [0, 2) -> [2, 4)
+ *   memcpy(&arr[4], &arr[0], 1 * S)   ; [0, 1) -> [4, 5)
+ *
+ * Source and destination never overlap. The number of copies is
+ * ceil(log2(count)), and each copy is a large block move.
+ */
+void IRGenerator::emit_doubling_fill(const std::string &array_ir_type,
+                                     const std::string &array_ptr, Type *elem_type,
+                                     size_t count) {
+    size_t elem_size = data_layout_.size_of(elem_type);
+    if (elem_size == 0 || count < 2) {
+        return;
+    }
+
+    std::string elem_ptr_type = type_mapper_.map(elem_type) + "*";
+    std::string first_ptr =
+        emitter_.emit_getelementptr_inbounds(array_ir_type, array_ptr, {"i64 0", "i64 0"});
+
+    size_t filled = 1;
+    while (filled < count) {
+        size_t chunk = std::min(filled, count - filled);
+        std::string dest_ptr = emitter_.emit_getelementptr_inbounds(
+            array_ir_type, array_ptr, {"i64 0", "i64 " + std::to_string(filled)});
+        emitter_.emit_memcpy(dest_ptr, first_ptr, chunk * elem_size, elem_ptr_type);
+        filled += chunk;
+    }
+}
+
+/**
+ * Emit a fully-constant aggregate literal once as a private constant global.
+ *
+ * Example:
+ *   let primes = [2, 3, 5, 7, 11];
+ *   ->
+ *   @.const.0 = private unnamed_addr constant [5 x i32] [i32 2, i32 3, ...], align 4
+ *
+ * Literals below CONST_GLOBAL_MIN_BYTES stay as individual stores. Repeat
+ * arrays qualify only when zero: a non-zero [v; n] would spell out n copies
+ * in the module, while its fill loop is a few instructions.
+ */
+std::string IRGenerator::get_const_aggregate_global(Expr *expr) {
+    if (!expr || !expr->type) {
+        return "";
+    }
+
+    bool is_literal = dynamic_cast<ArrayLiteralExpr *>(expr) ||
+                      dynamic_cast<StructInitializerExpr *>(expr) ||
+                      (dynamic_cast<ArrayInitializerExpr *>(expr) && is_zero_initializer(expr));
+    if (!is_literal || data_layout_.size_of(expr->type.get()) < CONST_GLOBAL_MIN_BYTES) {
+        return "";
+    }
+
+    std::string init_value;
+    if (!evaluate_const_expr(expr, init_value)) {
+        return "";
+    }
+
+    std::string ir_type = type_mapper_.map(expr->type.get());
+    std::string key = ir_type + " " + init_value;
+    auto it = const_globals_.find(key);
+    if (it != const_globals_.end()) {
+        return it->second;
+    }
+
+    std::string name = ".const." + std::to_string(const_globals_.size());
+    emitter_.emit_global_variable(name, ir_type, init_value, true, "private unnamed_addr");
+    return const_globals_[key] = "@" + name;
+}
+
+/**
+ * Initialize dest from a constant aggregate literal.
+ *
+ * - All zero: one memset, no global needed
+ * - Otherwise: one memcpy from the literal's private constant global,
+ *   replacing one GEP + store per element
+ */
+bool IRGenerator::emit_const_aggregate_init(Expr *expr, const std::string &dest, Type *type) {
+    std::string ptr_type = type_mapper_.map(type) + "*";
+    size_t size = data_layout_.size_of(type);
+
+    if (size >= CONST_GLOBAL_MIN_BYTES && is_zero_initializer(expr)) {
+        emitter_.emit_memset(dest, 0, size, ptr_type);
+        return true;
+    }
+
+    std::string const_ptr = get_const_aggregate_global(expr);
+    if (const_ptr.empty()) {
+        return false;
+    }
+
+    emitter_.emit_memcpy(dest, const_ptr, size, ptr_type);
+    return true;
+}
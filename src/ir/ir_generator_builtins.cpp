@@ -20,22 +20,43 @@
  * - @.str.print = private constant [4 x i8] c"%d\0A\00"
  * - @.str.scan = private constant [3 x i8] c"%d\00"
  *
- * @note Called once at the start of IR generation
+ * Only the C functions and format strings needed by built-ins reachable
+ * from main are declared. Memory intrinsics are always declared.
+ *
+ * @note Called once at the start of IR generation, after the call graph is built
  */
 void IRGenerator::emit_builtin_declarations() {
-    emitter_.emit_function_declaration("i32", "printf", {"i8*"}, true);
-    emitter_.emit_function_declaration("i32", "scanf", {"i8*"}, true);
-    emitter_.emit_function_declaration("void", "exit", {"i32"}, false);
+    bool uses_print = call_graph_.uses_builtin("printInt");
+    bool uses_println = call_graph_.uses_builtin("printlnInt");
+    bool uses_scan = call_graph_.uses_builtin("getInt");
+
+    if (uses_print || uses_println) {
+        emitter_.emit_function_declaration("i32", "printf", {"i8*"}, true);
+    }
+    if (uses_scan) {
+        emitter_.emit_function_declaration("i32", "scanf", {"i8*"}, true);
+    }
+    if (call_graph_.uses_builtin("exit")) {
+        emitter_.emit_function_declaration("void", "exit", {"i32"}, false);
+    }
     emitter_.emit_function_declaration("void", "llvm.memset.p0.i64", {"i8*", "i8", "i64", "i1"},
                                        false);
     emitter_.emit_function_declaration("void", "llvm.memcpy.p0.p0.i64", {"i8*", "i8*", "i64", "i1"},
                                        false);
+    emitter_.emit_function_declaration("void", "llvm.lifetime.start.p0", {"i64", "i8*"}, false);
+    emitter_.emit_function_declaration("void", "llvm.lifetime.end.p0", {"i64", "i8*"}, false);
 
     emitter_.emit_blank_line();
 
-    emitter_.emit_global_variable(".str.int", "[3 x i8]", "c\"%d\\00\"", true);
-    emitter_.emit_global_variable(".str.int_newline", "[4 x i8]", "c\"%d\\0A\\00\"", true);
-    emitter_.emit_global_variable(".str.int_scanf", "[3 x i8]", "c\"%d\\00\"", true);
+    if (uses_print) {
+        emitter_.emit_global_variable(".str.int", "[3 x i8]", "c\"%d\\00\"", true);
+    }
+    if (uses_println) {
+        emitter_.emit_global_variable(".str.int_newline", "[4 x i8]", "c\"%d\\0A\\00\"", true);
+    }
+    if (uses_scan) {
+        emitter_.emit_global_variable(".str.int_scanf", "[3 x i8]", "c\"%d\\00\"", true);
+    }
 
     emitter_.emit_blank_line();
 }
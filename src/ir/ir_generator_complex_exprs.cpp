@@ -15,6 +15,9 @@
  * Optimization:
  * - Target address mechanism: allows in-place initialization
  * - Avoids extra copy when used in let statement or return
+ * - Aggregate elements are built in place or copied with memcpy
+ * - Fully-constant literals are copied from a private constant global
+ *   (one memcpy instead of one store per element), all-zero ones use memset
  *
  * @param node The array literal expression AST node
  * @return Pointer to the initialized array
@@ -38,28 +41,35 @@ void IRGenerator::visit(ArrayLiteralExpr *node) {
 
     std::string array_ptr = take_target_address();
     if (array_ptr.empty()) {
-        array_ptr = emitter_.emit_alloca(array_ir_type);
+        array_ptr = allocate_stack_slot(array_type.get());
     }
 
+    if (emit_const_aggregate_init(node, array_ptr, array_type.get())) {
+        store_expr_result(node, array_ptr);
+        return;
+    }
+
+    Type *elem_type = array_type->element_type.get();
+    bool elem_is_aggregate =
+        (elem_type->kind == TypeKind::ARRAY || elem_type->kind == TypeKind::STRUCT);
+
     for (size_t i = 0; i < node->elements.size(); ++i) {
-        node->elements[i]->accept(this);
-        std::string elem_value = get_expr_result(node->elements[i].get());
+        std::vector<std::string> indices = {"i64 0", "i64 " + std::to_string(i)};
 
-        if (elem_value.empty()) {
+        if (elem_is_aggregate) {
+            std::string elem_ptr =
+                emitter_.emit_getelementptr_inbounds(array_ir_type, array_ptr, indices);
+            emit_aggregate_into(node->elements[i].get(), elem_ptr, elem_type);
             continue;
         }
 
-        bool elem_is_aggregate = false;
-        if (auto elem_type = node->elements[i]->type) {
-            elem_is_aggregate =
-                (elem_type->kind == TypeKind::ARRAY || elem_type->kind == TypeKind::STRUCT);
-        }
+        node->elements[i]->accept(this);
+        std::string elem_value = get_expr_result(node->elements[i].get());
 
-        if (elem_is_aggregate) {
-            elem_value = emitter_.emit_load(elem_ir_type, elem_value);
+        if (elem_value.empty()) {
+            continue;
         }
 
-        std::vector<std::string> indices = {"i64 0", "i64 " + std::to_string(i)};
         std::string elem_ptr =
             emitter_.emit_getelementptr_inbounds(array_ir_type, array_ptr, indices);
 
@@ -75,20 +85,21 @@ void IRGenerator::visit(ArrayLiteralExpr *node) {
  * Syntax: [value; size]  // Creates array with 'size' copies of 'value'
  * Example: [0; 100]  // Array of 100 zeros
  *
- * Optimization strategies:
- * 1. Small arrays (≤16 elements):
+ * Lowering strategies:
+ * 1. Zero initialization (any nesting, e.g. [[0; 1000]; 1000]):
+ *    - One llvm.memset over the whole array
+ *
+ * 2. Scalar value, small array (≤16 elements):
  *    - Unroll as individual GEP + store instructions
- *    - Best for small constant-size arrays
  *
- * 2. Zero initialization (>64 elements):
- *    - Use llvm.memset.p0i8 intrinsic
- *    - Single call to set all bytes to zero
- *    - Most efficient for zero-init
+ * 3. Scalar value, large array:
+ *    - Counted fill loop storing the value (emit_fill_loop)
+ *
+ * 4. Aggregate value (arrays, structs):
+ *    - Build the value in place in element 0
+ *    - Copy it to the rest with doubling memcpys (emit_doubling_fill)
  *
- * 3. Large arrays with non-zero value (>16 elements):
- *    - Generate initialization loop:
- *      for (i = 0; i < size; i++) arr[i] = value;
- *    - Avoids code bloat from unrolling
+ * Aggregates are never loaded as first-class values.
  *
  * @param node The array initializer expression AST node
  * @return Pointer to the initialized array
@@ -109,25 +120,42 @@ void IRGenerator::visit(ArrayInitializerExpr *node) {
     std::string target_ptr = take_target_address();
 
     size_t array_size = array_type->size;
+    Type *elem_type = array_type->element_type.get();
 
-    std::string elem_ir_type = type_mapper_.map(array_type->element_type.get());
+    std::string elem_ir_type = type_mapper_.map(elem_type);
     std::string array_ir_type = "[" + std::to_string(array_size) + " x " + elem_ir_type + "]";
 
-    bool value_is_aggregate = false;
-    if (node->value->type) {
-        value_is_aggregate = (node->value->type->kind == TypeKind::ARRAY ||
-                              node->value->type->kind == TypeKind::STRUCT);
+    std::string array_ptr = target_ptr;
+    if (array_ptr.empty()) {
+        array_ptr = allocate_stack_slot(array_type.get());
     }
 
-    if (value_is_aggregate) {
-        std::string temp_ptr = emitter_.emit_alloca(elem_ir_type);
-        set_target_address(temp_ptr);
+    if (is_zero_initializer(node)) {
+        size_t total_bytes = data_layout_.size_of(array_type.get());
+        if (total_bytes > 0) {
+            emitter_.emit_memset(array_ptr, 0, total_bytes, array_ir_type + "*");
+        }
+        store_expr_result(node, array_ptr);
+        return;
     }
 
-    node->value->accept(this);
+    bool value_is_aggregate = (elem_type->kind == TypeKind::ARRAY ||
+                               elem_type->kind == TypeKind::STRUCT);
 
-    take_target_address();
+    if (value_is_aggregate) {
+        if (array_size > 0) {
+            std::string first_ptr = emitter_.emit_getelementptr_inbounds(
+                array_ir_type, array_ptr, {"i64 0", "i64 0"});
+            emit_aggregate_into(node->value.get(), first_ptr, elem_type);
+            emit_doubling_fill(array_ir_type, array_ptr, elem_type, array_size);
+        } else {
+            node->value->accept(this);
+        }
+        store_expr_result(node, array_ptr);
+        return;
+    }
 
+    node->value->accept(this);
     std::string init_value = get_expr_result(node->value.get());
 
     if (init_value.empty()) {
@@ -135,38 +163,7 @@ void IRGenerator::visit(ArrayInitializerExpr *node) {
         return;
     }
 
-    if (value_is_aggregate) {
-        init_value = emitter_.emit_load(elem_ir_type, init_value);
-    }
-
-    std::string array_ptr = target_ptr;
-    if (array_ptr.empty()) {
-        array_ptr = emitter_.emit_alloca(array_ir_type);
-    }
-
-    const size_t UNROLL_THRESHOLD = 16;
-    const size_t MEMSET_THRESHOLD = 64;
-
-    bool is_zero_init = is_zero_initializer(node->value.get());
-
-    size_t elem_size = 0;
-    if (elem_ir_type == "i1")
-        elem_size = 1;
-    else if (elem_ir_type == "i8")
-        elem_size = 1;
-    else if (elem_ir_type == "i32")
-        elem_size = 4;
-    else if (elem_ir_type == "i64")
-        elem_size = 8;
-    else if (elem_ir_type.find('%') == 0) {
-        elem_size = get_type_size(array_type->element_type.get());
-    }
-
-    if (is_zero_init && array_size > MEMSET_THRESHOLD && elem_size > 0) {
-        size_t total_bytes = array_size * elem_size;
-
-        emitter_.emit_memset(array_ptr, 0, total_bytes, array_ir_type + "*");
-    } else if (array_size <= UNROLL_THRESHOLD) {
+    if (should_fully_unroll(array_size, 1)) {
         for (size_t i = 0; i < array_size; ++i) {
             std::vector<std::string> indices = {"i64 0", "i64 " + std::to_string(i)};
             std::string elem_ptr =
@@ -175,31 +172,7 @@ void IRGenerator::visit(ArrayInitializerExpr *node) {
             emitter_.emit_store(elem_ir_type, init_value, elem_ptr);
         }
     } else {
-
-        std::string loop_cond_label = emitter_.new_label();
-        std::string loop_body_label = emitter_.new_label();
-        std::string loop_end_label = emitter_.new_label();
-
-        std::string i_ptr = emitter_.emit_alloca("i64");
-        emitter_.emit_store("i64", "0", i_ptr);
-        emitter_.emit_br(loop_cond_label);
-
-        begin_block(loop_cond_label);
-        std::string i_val = emitter_.emit_load("i64", i_ptr);
-        std::string cmp = emitter_.emit_icmp("slt", "i64", i_val, std::to_string(array_size));
-        emitter_.emit_cond_br(cmp, loop_body_label, loop_end_label);
-
-        begin_block(loop_body_label);
-        std::vector<std::string> indices = {"i64 0", "i64 " + i_val};
-        std::string elem_ptr =
-            emitter_.emit_getelementptr_inbounds(array_ir_type, array_ptr, indices);
-        emitter_.emit_store(elem_ir_type, init_value, elem_ptr);
-
-        std::string next_i = emitter_.emit_binary_op("add", "i64", i_val, "1");
-        emitter_.emit_store("i64", next_i, i_ptr);
-        emitter_.emit_br(loop_cond_label);
-
-        begin_block(loop_end_label);
+        emit_fill_loop(array_ir_type, array_ptr, elem_ir_type, init_value, array_size);
     }
 
     store_expr_result(node, array_ptr);
@@ -325,26 +298,18 @@ void IRGenerator::visit(StructInitializerExpr *node) {
     } else if (sret_self) {
         struct_ptr = sret_self->alloca_name;
     } else {
-        struct_ptr = emitter_.emit_alloca(struct_ir_type);
+        struct_ptr = allocate_stack_slot(struct_type.get());
     }
 
-    for (const auto &field_init : node->fields) {
-        std::string cache_key = struct_type->name + "." + field_init->name.lexeme;
-        int field_index = -1;
+    if (emit_const_aggregate_init(node, struct_ptr, struct_type.get())) {
+        store_expr_result(node, struct_ptr);
+        return;
+    }
 
-        auto cache_it = field_index_cache_.find(cache_key);
-        if (cache_it != field_index_cache_.end()) {
-            field_index = cache_it->second;
-        } else {
-            for (size_t i = 0; i < struct_type->field_order.size(); ++i) {
-                if (struct_type->field_order[i] == field_init->name.lexeme) {
-                    field_index = static_cast<int>(i);
-                    field_index_cache_[cache_key] = field_index;
-                    break;
-                }
-            }
-        }
+    const StructLayout &layout = data_layout_.struct_layout(struct_type.get());
 
+    for (const auto &field_init : node->fields) {
+        int field_index = layout.field_index(field_init->name.lexeme);
         if (field_index == -1) {
             continue;
         }
@@ -363,33 +328,19 @@ void IRGenerator::visit(StructInitializerExpr *node) {
             (it->second->kind == TypeKind::ARRAY || it->second->kind == TypeKind::STRUCT);
 
         if (field_is_aggregate) {
-            set_target_address(field_ptr);
+            emit_aggregate_into(field_init->value.get(), field_ptr, it->second.get());
+            continue;
         }
 
         field_init->value->accept(this);
 
-        take_target_address();
-
         std::string field_value = get_expr_result(field_init->value.get());
 
         if (field_value.empty()) {
             continue;
         }
 
-        if (field_is_aggregate && field_value == field_ptr) {
-            continue;
-        }
-
-        std::string value_to_store = field_value;
-
-        if (field_is_aggregate) {
-            if (loaded_aggregate_results_.find(field_init->value.get()) ==
-                loaded_aggregate_results_.end()) {
-                value_to_store = emitter_.emit_load(field_ir_type, field_value);
-            }
-        }
-
-        emitter_.emit_store(field_ir_type, value_to_store, field_ptr);
+        emitter_.emit_store(field_ir_type, field_value, field_ptr);
     }
 
     store_expr_result(node, struct_ptr);
@@ -429,22 +380,7 @@ void IRGenerator::visit(FieldAccessExpr *node) {
         return;
     }
 
-    std::string cache_key = struct_type->name + "." + node->field.lexeme;
-    int field_index = -1;
-
-    auto cache_it = field_index_cache_.find(cache_key);
-    if (cache_it != field_index_cache_.end()) {
-        field_index = cache_it->second;
-    } else {
-        for (size_t i = 0; i < struct_type->field_order.size(); ++i) {
-            if (struct_type->field_order[i] == node->field.lexeme) {
-                field_index = static_cast<int>(i);
-                field_index_cache_[cache_key] = field_index;
-                break;
-            }
-        }
-    }
-
+    int field_index = data_layout_.struct_layout(struct_type.get()).field_index(node->field.lexeme);
     if (field_index == -1) {
         store_expr_result(node, "");
         return;
@@ -156,6 +156,12 @@ void IRGenerator::visit(IfExpr *node) {
  * - While loops always return () (unit type)
  * - Not expressions in terms of producing values
  *
+ * Counted loops (see analyze_counted_loop) are optimized first:
+ * - Elementwise array loops get a <4 x i32>/<8 x i32> vector loop
+ * - Small trip counts are fully unrolled
+ * - Larger trip counts get an unrolled main loop
+ * The loop below then runs the remaining iterations.
+ *
  * Example:
  *   while i < 10 {
  *       print(i);
@@ -166,6 +172,21 @@ void IRGenerator::visit(IfExpr *node) {
  */
 void IRGenerator::visit(WhileExpr *node) {
 
+    CountedLoop counted_loop;
+    if (analyze_counted_loop(node, counted_loop)) {
+        size_t width = choose_vector_width(node, counted_loop);
+        if (width > 0) {
+            emit_vectorized_loop(node, counted_loop, width);
+        } else if (counted_loop.has_start &&
+            should_fully_unroll(counted_loop_trip_count(counted_loop), counted_loop.body_cost)) {
+            emit_fully_unrolled_loop(node, counted_loop);
+            store_expr_result(node, "");
+            return;
+        } else if (size_t factor = choose_unroll_factor(counted_loop)) {
+            emit_partially_unrolled_loop(node, counted_loop, factor);
+        }
+    }
+
     int current_while = while_counter_++;
 
     std::string cond_label = "while.cond." + std::to_string(current_while);
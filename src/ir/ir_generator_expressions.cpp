@@ -20,6 +20,7 @@
  * @note Results are stored as constant values in expr_results_
  */
 void IRGenerator::visit(LiteralExpr *node) {
+    note_source_line(node->literal.line);
     if (!node->type) {
         return;
     }
@@ -29,35 +30,9 @@ void IRGenerator::visit(LiteralExpr *node) {
 
     switch (node->literal.type) {
     case TokenType::NUMBER: {
-        std::string lexeme = node->literal.lexeme;
-
-        size_t suffix_pos = lexeme.find_first_of("iu");
-        if (suffix_pos != std::string::npos) {
-            lexeme = lexeme.substr(0, suffix_pos);
-        }
-
-        int base = 10;
-        size_t start_pos = 0;
-
-        if (lexeme.length() > 2 && lexeme[0] == '0') {
-            if (lexeme[1] == 'x' || lexeme[1] == 'X') {
-                base = 16;
-                start_pos = 2;
-            } else if (lexeme[1] == 'b' || lexeme[1] == 'B') {
-                base = 2;
-                start_pos = 2;
-            } else if (lexeme[1] == 'o' || lexeme[1] == 'O') {
-                base = 8;
-                start_pos = 2;
-            }
-        }
-
-        try {
-            long long num_value = std::stoll(lexeme.substr(start_pos), nullptr, base);
-            value = std::to_string(num_value);
-        } catch (...) {
-            value = "0";
-        }
+        long long num_value = 0;
+        value = parse_integer_literal(node->literal.lexeme, num_value) ? std::to_string(num_value)
+                                                                        : "0";
         break;
     }
     case TokenType::TRUE:
@@ -111,6 +86,7 @@ void IRGenerator::visit(LiteralExpr *node) {
  * @param node The variable expression AST node
  */
 void IRGenerator::visit(VariableExpr *node) {
+    note_source_line(node->name.line);
     std::string var_name = node->name.lexeme;
 
     VariableInfo *var_info = value_manager_.lookup_variable(var_name);
@@ -139,6 +115,12 @@ void IRGenerator::visit(VariableExpr *node) {
         std::string const_name = node->name.lexeme;
         std::string type_str = type_mapper_.map(node->type.get());
 
+        if (node->type &&
+            (node->type->kind == TypeKind::ARRAY || node->type->kind == TypeKind::STRUCT)) {
+            store_expr_result(node, "@" + const_name);
+            return;
+        }
+
         std::string loaded_value = emitter_.emit_load(type_str, "@" + const_name);
         store_expr_result(node, loaded_value);
         return;
@@ -165,6 +147,7 @@ void IRGenerator::visit(VariableExpr *node) {
  * @note Short-circuit logical operators delegated to visit_logical_binary_expr
  */
 void IRGenerator::visit(BinaryExpr *node) {
+    note_source_line(node->op.line);
     if (!node->type) {
         return;
     }
@@ -320,6 +303,7 @@ void IRGenerator::visit(BinaryExpr *node) {
  * @param node The unary expression AST node
  */
 void IRGenerator::visit(UnaryExpr *node) {
+    note_source_line(node->op.line);
     if (!node->type) {
         return;
     }
@@ -371,8 +355,7 @@ void IRGenerator::visit(UnaryExpr *node) {
 void IRGenerator::visit_logical_binary_expr(BinaryExpr *node) {
     bool is_or = (node->op.type == TokenType::PIPE_PIPE);
 
-    static int logical_counter = 0;
-    int current = logical_counter++;
+    int current = logical_counter_++;
 
     std::string rhs_label = (is_or ? "or.rhs." : "and.rhs.") + std::to_string(current);
     std::string end_label = (is_or ? "or.end." : "and.end.") + std::to_string(current);
@@ -441,12 +424,14 @@ void IRGenerator::visit_logical_binary_expr(BinaryExpr *node) {
  *
  * Argument passing strategy:
  * - Scalar types: pass by value (loaded if from variable)
- * - Aggregate types (arrays/structs): pass pointer directly
+ * - Small aggregates (see AbiLowering): pass their scalar leaves
+ * - Other aggregate types (arrays/structs): pass pointer directly
  * - References: pass pointer value
  *
  * Return value handling:
  * - Void functions: no return value
  * - Scalar returns: use call result directly
+ * - Small aggregate returns: scalars stored into a stack slot
  * - Aggregate returns: SRET or direct pointer
  *
  * @param node The call expression AST node
@@ -481,6 +466,9 @@ void IRGenerator::visit(CallExpr *node) {
                 } else {
                     args.push_back({arg_type_str + "*", arg_value});
                 }
+            } else if (abi_.is_flattened(arg->type.get())) {
+                auto values = emit_flattened_loads(arg->type.get(), arg_value);
+                args.insert(args.end(), values.begin(), values.end());
             } else {
                 args.push_back({arg_type_str + "*", arg_value});
             }
@@ -489,31 +477,15 @@ void IRGenerator::visit(CallExpr *node) {
         }
     }
 
-    std::string func_name;
+    std::string func_name = CallGraph::callee_name(node);
     std::vector<std::pair<std::string, std::string>> self_args;
 
-    if (auto var_expr = dynamic_cast<VariableExpr *>(node->callee.get())) {
-        func_name = var_expr->name.lexeme;
-    } else if (auto path_expr = dynamic_cast<PathExpr *>(node->callee.get())) {
-
-        std::string type_name;
-        std::string method_name;
-
-        if (auto left_var = dynamic_cast<VariableExpr *>(path_expr->left.get())) {
-            type_name = left_var->name.lexeme;
-        }
+    if (func_name.empty()) {
+        store_expr_result(node, "");
+        return;
+    }
 
-        if (auto right_var = dynamic_cast<VariableExpr *>(path_expr->right.get())) {
-            method_name = right_var->name.lexeme;
-        }
-
-        if (!type_name.empty() && !method_name.empty()) {
-            func_name = type_name + "_" + method_name;
-        } else {
-            store_expr_result(node, "");
-            return;
-        }
-    } else if (auto field_expr = dynamic_cast<FieldAccessExpr *>(node->callee.get())) {
+    if (auto field_expr = dynamic_cast<FieldAccessExpr *>(node->callee.get())) {
 
         field_expr->object->accept(this);
         std::string obj_ptr = get_expr_result(field_expr->object.get());
@@ -523,52 +495,18 @@ void IRGenerator::visit(CallExpr *node) {
             return;
         }
 
-        std::string type_name;
-        if (field_expr->object->type) {
-            if (auto struct_type =
-                    std::dynamic_pointer_cast<StructType>(field_expr->object->type)) {
-                type_name = struct_type->name;
-            } else if (field_expr->object->type->kind == TypeKind::REFERENCE) {
-                auto ref_type = std::dynamic_pointer_cast<ReferenceType>(field_expr->object->type);
-                if (ref_type && ref_type->referenced_type) {
-                    if (auto struct_type =
-                            std::dynamic_pointer_cast<StructType>(ref_type->referenced_type)) {
-                        type_name = struct_type->name;
-                    }
-                }
-            } else if (field_expr->object->type->kind == TypeKind::RAW_POINTER) {
-                auto ptr_type = std::dynamic_pointer_cast<RawPointerType>(field_expr->object->type);
-                if (ptr_type && ptr_type->pointee_type) {
-                    if (auto struct_type =
-                            std::dynamic_pointer_cast<StructType>(ptr_type->pointee_type)) {
-                        type_name = struct_type->name;
-                    }
-                }
-            }
-        }
-
-        std::string method_name = field_expr->field.lexeme;
-
-        if (type_name.empty() || method_name.empty()) {
-            store_expr_result(node, "");
-            return;
+        Type *obj_type = field_expr->object->type.get();
+        if (obj_type->kind == TypeKind::REFERENCE) {
+            auto ref_type = std::dynamic_pointer_cast<ReferenceType>(field_expr->object->type);
+            obj_type = ref_type ? ref_type->referenced_type.get() : nullptr;
         }
+        std::string obj_type_str = obj_type ? type_mapper_.map(obj_type) + "*" : "";
 
-        func_name = type_name + "_" + method_name;
-
-        std::string obj_type_str;
-        if (field_expr->object->type->kind == TypeKind::REFERENCE) {
-            auto ref_type = std::dynamic_pointer_cast<ReferenceType>(field_expr->object->type);
-            if (ref_type && ref_type->referenced_type) {
-                obj_type_str = type_mapper_.map(ref_type->referenced_type.get()) + "*";
-            }
+        if (obj_type && takes_self_by_value(func_name) && abi_.is_flattened(obj_type)) {
+            self_args = emit_flattened_loads(obj_type, obj_ptr);
         } else {
-            obj_type_str = type_mapper_.map(field_expr->object->type.get()) + "*";
+            self_args.push_back({obj_type_str, obj_ptr});
         }
-        self_args.push_back({obj_type_str, obj_ptr});
-    } else {
-        store_expr_result(node, "");
-        return;
     }
 
     if (handle_builtin_function(node, func_name, args)) {
@@ -577,6 +515,7 @@ void IRGenerator::visit(CallExpr *node) {
 
     std::string ret_type_str = "void";
     bool ret_is_aggregate = false;
+    bool ret_is_flattened = false;
     bool use_sret = false;
 
     if (node->type) {
@@ -584,6 +523,11 @@ void IRGenerator::visit(CallExpr *node) {
         ret_is_aggregate =
             (node->type->kind == TypeKind::ARRAY || node->type->kind == TypeKind::STRUCT);
 
+        if (ret_is_aggregate && abi_.is_flattened(node->type.get())) {
+            ret_is_flattened = true;
+            ret_type_str = abi_.return_type(node->type.get());
+        }
+
         if (should_use_sret_optimization(func_name, node->type.get())) {
             use_sret = true;
         }
@@ -593,24 +537,28 @@ void IRGenerator::visit(CallExpr *node) {
 
     std::string sret_alloca;
     if (use_sret) {
-        sret_alloca = emitter_.emit_alloca(ret_type_str);
+        sret_alloca = allocate_stack_slot(node->type.get());
         all_args.push_back({ret_type_str + "*", sret_alloca});
     }
 
     all_args.insert(all_args.end(), self_args.begin(), self_args.end());
     all_args.insert(all_args.end(), args.begin(), args.end());
 
+    std::string call_attrs = effect_analysis_.function_attributes(func_name);
+
     if (use_sret) {
-        emitter_.emit_call_void(func_name, all_args);
+        emitter_.emit_call_void(func_name, all_args, call_attrs);
         store_expr_result(node, sret_alloca);
     } else if (ret_type_str == "void") {
-        emitter_.emit_call_void(func_name, all_args);
+        emitter_.emit_call_void(func_name, all_args, call_attrs);
         store_expr_result(node, "");
     } else {
-        std::string result = emitter_.emit_call(ret_type_str, func_name, all_args);
+        std::string result = emitter_.emit_call(ret_type_str, func_name, all_args, call_attrs);
 
-        if (ret_is_aggregate) {
-            std::string alloca_ptr = emitter_.emit_alloca(ret_type_str);
+        if (ret_is_flattened) {
+            store_expr_result(node, unpack_flattened_result(node->type.get(), result));
+        } else if (ret_is_aggregate) {
+            std::string alloca_ptr = allocate_stack_slot(node->type.get());
             emitter_.emit_store(ret_type_str, result, alloca_ptr);
             store_expr_result(node, alloca_ptr);
         } else {
@@ -680,7 +628,7 @@ void IRGenerator::visit(AssignmentExpr *node) {
             std::string value_to_store = value_var;
 
             if (value_is_aggregate) {
-                size_t size = get_type_size(node->value->type.get());
+                size_t size = data_layout_.size_of(node->value->type.get());
                 std::string ptr_type = target_type_str + "*";
                 emitter_.emit_memcpy(var_info->alloca_name, value_var, size, ptr_type);
             } else {
@@ -712,7 +660,7 @@ void IRGenerator::visit(AssignmentExpr *node) {
             std::string value_to_store = value_var;
 
             if (value_is_aggregate) {
-                size_t size = get_type_size(node->value->type.get());
+                size_t size = data_layout_.size_of(node->value->type.get());
                 std::string ptr_type = type_str + "*";
                 emitter_.emit_memcpy(elem_ptr, value_var, size, ptr_type);
             } else {
@@ -737,7 +685,7 @@ void IRGenerator::visit(AssignmentExpr *node) {
             std::string value_to_store = value_var;
 
             if (value_is_aggregate) {
-                size_t size = get_type_size(node->value->type.get());
+                size_t size = data_layout_.size_of(node->value->type.get());
                 std::string ptr_type = type_str + "*";
                 emitter_.emit_memcpy(field_ptr, value_var, size, ptr_type);
             } else {
@@ -759,7 +707,7 @@ void IRGenerator::visit(AssignmentExpr *node) {
                                            node->value->type->kind == TypeKind::STRUCT);
 
                 if (value_is_aggregate) {
-                    size_t size = get_type_size(node->value->type.get());
+                    size_t size = data_layout_.size_of(node->value->type.get());
                     std::string ptr_type = value_type_str + "*";
                     emitter_.emit_memcpy(ptr_value, value_var, size, ptr_type);
                 } else {
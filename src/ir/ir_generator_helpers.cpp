@@ -87,6 +87,38 @@ void IRGenerator::begin_block(const std::string &label) {
     emitter_.begin_basic_block(label);
     current_block_label_ = label;
     current_block_terminated_ = false;
+    if (block_counters_.enabled()) {
+        emitter_.set_block_prologue(
+            block_counters_.add_block(current_function_name_, label, current_source_line_));
+    }
+}
+
+/**
+ * Record the line of a source token being generated.
+ *
+ * The first token after begin_block gives the block its source line in
+ * the block count profile.
+ *
+ * @param line Token line, 0 if unknown
+ */
+void IRGenerator::note_source_line(int line) {
+    if (line <= 0) {
+        return;
+    }
+    current_source_line_ = line;
+    block_counters_.note_line(line);
+}
+
+/**
+ * Emit the code that runs right before main returns.
+ *
+ * With block counting enabled this is the call that writes the counts
+ * to the profile file. Must be called before every ret of main.
+ */
+void IRGenerator::emit_exit_hooks() {
+    if (block_counters_.enabled() && current_function_name_ == "main") {
+        emitter_.emit_call_void(BlockCounters::DUMP_FUNCTION, {});
+    }
 }
 
 /**
@@ -248,9 +280,17 @@ int IRGenerator::get_integer_bits(TypeKind kind) {
  * - No variable references (except other consts)
  * - Integer arithmetic only (no floating point)
  *
+ * Aggregates:
+ * - Array literals, repeat arrays and struct initializers whose leaves are all
+ *   constant evaluate to an LLVM constant of their IR type
+ * - Struct fields are emitted in DataLayout (IR) order, not source order
+ * - All-zero aggregates evaluate to "zeroinitializer"
+ *
  * Example:
  *   const SIZE: i32 = 10 * 2 + 5;  // Evaluates to "25"
  *   const FLAG: bool = true;       // Evaluates to "1"
+ *   [2, 3, 5]                      // Evaluates to "[i32 2, i32 3, i32 5]"
+ *   Point { x: 1, y: 2 }           // Evaluates to "{ i32 1, i32 2 }"
  *
  * @param expr The expression to evaluate
  * @param result [out] The string representation of the constant value
@@ -264,7 +304,11 @@ bool IRGenerator::evaluate_const_expr(Expr *expr, std::string &result) {
 
     if (auto literal = dynamic_cast<LiteralExpr *>(expr)) {
         if (literal->literal.type == TokenType::NUMBER) {
-            result = literal->literal.lexeme;
+            long long value = 0;
+            if (!parse_integer_literal(literal->literal.lexeme, value)) {
+                return false;
+            }
+            result = std::to_string(value);
             return true;
         } else if (literal->literal.type == TokenType::TRUE) {
             result = "1";
@@ -361,11 +405,21 @@ bool IRGenerator::evaluate_const_expr(Expr *expr, std::string &result) {
 
     if (auto var_expr = dynamic_cast<VariableExpr *>(expr)) {
         std::string var_name = var_expr->name.lexeme;
+        auto symbol = var_expr->resolved_symbol;
+        if (symbol && symbol->kind != Symbol::CONSTANT) {
+            return false;
+        }
+
         auto it = const_values_.find(var_name);
         if (it != const_values_.end()) {
             result = it->second;
             return true;
         }
+
+        // Constants declared later in the source have not been visited yet
+        if (symbol && symbol->const_decl_node) {
+            return evaluate_const_expr(symbol->const_decl_node->value.get(), result);
+        }
         return false;
     }
 
@@ -377,147 +431,121 @@ bool IRGenerator::evaluate_const_expr(Expr *expr, std::string &result) {
         return evaluate_const_expr(grouping->expression.get(), result);
     }
 
-    return false;
-}
-
-// Get the alignment requirement of a type.
-size_t IRGenerator::get_type_alignment(Type *type) {
-    if (!type)
-        return 1;
-
-    switch (type->kind) {
-    case TypeKind::BOOL:
-        return 1;
-    case TypeKind::I32:
-    case TypeKind::U32:
-    case TypeKind::USIZE:
-    case TypeKind::ISIZE:
-        return 4;
-    case TypeKind::REFERENCE:
-        return 4;
-    case TypeKind::ARRAY:
-        if (auto arr_type = dynamic_cast<ArrayType *>(type)) {
-            return get_type_alignment(arr_type->element_type.get());
+    if (auto array_lit = dynamic_cast<ArrayLiteralExpr *>(expr)) {
+        auto array_type = dynamic_cast<ArrayType *>(array_lit->type.get());
+        if (!array_type) {
+            return false;
         }
-        return 1;
-    case TypeKind::STRUCT:
-        if (auto struct_type = dynamic_cast<StructType *>(type)) {
-            size_t max_align = 1;
-            for (const auto &field_name : struct_type->field_order) {
-                auto it = struct_type->fields.find(field_name);
-                if (it != struct_type->fields.end()) {
-                    size_t field_align = get_type_alignment(it->second.get());
-                    if (field_align > max_align) {
-                        max_align = field_align;
-                    }
-                }
+
+        std::string elem_ir_type = type_mapper_.map(array_type->element_type.get());
+        std::string elements;
+        for (size_t i = 0; i < array_lit->elements.size(); ++i) {
+            std::string elem_value;
+            if (!evaluate_const_expr(array_lit->elements[i].get(), elem_value)) {
+                return false;
             }
-            return max_align;
+            elements += (i > 0 ? ", " : "") + elem_ir_type + " " + elem_value;
         }
-        return 1;
-    default:
-        return 1;
+
+        result = is_zero_initializer(array_lit) ? "zeroinitializer" : "[" + elements + "]";
+        return true;
     }
-}
 
-/**
- * Calculate the size in bytes of a type.
- *
- * Size table (32-bit platform):
- * - i32, u32, isize, usize, char: 4 bytes
- * - bool: 1 byte
- * - unit type (): 0 bytes
- * - pointers/references: 4 bytes
- * - arrays: element_size × array_length
- * - structs: sum of field sizes
- *
- * Features:
- * - Result caching to avoid redundant calculations
- * - Recursive size computation for nested types
- *
- * Limitations:
- * - Does not account for struct field padding/alignment
- * - Assumes tight packing of struct fields
- * - Platform-specific (32-bit assumed)
- *
- * @param type The type to measure
- * @return Size in bytes
- * @note Used for memcpy/memset size calculations
- */
-size_t IRGenerator::get_type_size(Type *type) {
-    if (!type)
-        return 0;
+    if (auto array_init = dynamic_cast<ArrayInitializerExpr *>(expr)) {
+        auto array_type = dynamic_cast<ArrayType *>(array_init->type.get());
+        std::string elem_value;
+        if (!array_type || !evaluate_const_expr(array_init->value.get(), elem_value)) {
+            return false;
+        }
 
-    auto cache_it = type_size_cache_.find(type);
-    if (cache_it != type_size_cache_.end()) {
-        return cache_it->second;
-    }
+        if (is_zero_initializer(array_init)) {
+            result = "zeroinitializer";
+            return true;
+        }
 
-    size_t size = 0;
+        std::string elem_ir_type = type_mapper_.map(array_type->element_type.get());
+        std::string elements;
+        for (size_t i = 0; i < array_type->size; ++i) {
+            elements += (i > 0 ? ", " : "") + elem_ir_type + " " + elem_value;
+        }
+        result = "[" + elements + "]";
+        return true;
+    }
 
-    switch (type->kind) {
-    case TypeKind::BOOL:
-        size = 1;
-        break;
-    case TypeKind::I32:
-    case TypeKind::U32:
-    case TypeKind::USIZE:
-    case TypeKind::ISIZE:
-        size = 4;
-        break;
-    case TypeKind::REFERENCE:
-        size = 4;
-        break;
-    case TypeKind::ARRAY:
-        if (auto arr_type = dynamic_cast<ArrayType *>(type)) {
-            size_t elem_size = get_type_size(arr_type->element_type.get());
-            size_t elem_align = get_type_alignment(arr_type->element_type.get());
-
-            if (elem_size % elem_align != 0) {
-                elem_size += (elem_align - (elem_size % elem_align));
-            }
+    if (auto struct_init = dynamic_cast<StructInitializerExpr *>(expr)) {
+        auto struct_type = dynamic_cast<StructType *>(struct_init->type.get());
+        if (!struct_type) {
+            return false;
+        }
 
-            size = elem_size * arr_type->size;
+        std::unordered_map<std::string, Expr *> field_values;
+        for (const auto &field_init : struct_init->fields) {
+            field_values[field_init->name.lexeme] = field_init->value.get();
         }
-        break;
-    case TypeKind::STRUCT:
-        if (auto struct_type = dynamic_cast<StructType *>(type)) {
-            size_t offset = 0;
-            size_t max_align = 1;
-
-            for (const auto &field_name : struct_type->field_order) {
-                auto it = struct_type->fields.find(field_name);
-                if (it != struct_type->fields.end()) {
-                    Type *field_type = it->second.get();
-                    size_t field_size = get_type_size(field_type);
-                    size_t field_align = get_type_alignment(field_type);
-
-                    if (field_align > max_align) {
-                        max_align = field_align;
-                    }
-
-                    if (offset % field_align != 0) {
-                        offset += (field_align - (offset % field_align));
-                    }
-
-                    offset += field_size;
-                }
-            }
 
-            if (offset % max_align != 0) {
-                offset += (max_align - (offset % max_align));
+        const StructLayout &layout = data_layout_.struct_layout(struct_type);
+        std::string fields;
+        for (size_t i = 0; i < layout.field_names.size(); ++i) {
+            auto it = field_values.find(layout.field_names[i]);
+            std::string field_value;
+            if (it == field_values.end() || !evaluate_const_expr(it->second, field_value)) {
+                return false;
             }
+            fields += (i > 0 ? ", " : "") + type_mapper_.map(layout.field_types[i]) + " " +
+                      field_value;
+        }
 
-            size = offset;
+        result = is_zero_initializer(struct_init) ? "zeroinitializer" : "{ " + fields + " }";
+        return true;
+    }
+
+    return false;
+}
+
+bool IRGenerator::parse_integer_literal(const std::string &lexeme, long long &value) {
+    std::string digits = lexeme;
+
+    size_t suffix_pos = digits.find_first_of("iu");
+    if (suffix_pos != std::string::npos) {
+        digits = digits.substr(0, suffix_pos);
+    }
+
+    int base = 10;
+    size_t start_pos = 0;
+
+    if (digits.length() > 2 && digits[0] == '0') {
+        if (digits[1] == 'x' || digits[1] == 'X') {
+            base = 16;
+            start_pos = 2;
+        } else if (digits[1] == 'b' || digits[1] == 'B') {
+            base = 2;
+            start_pos = 2;
+        } else if (digits[1] == 'o' || digits[1] == 'O') {
+            base = 8;
+            start_pos = 2;
         }
-        break;
-    default:
-        size = 0;
-        break;
     }
 
-    type_size_cache_[type] = size;
-    return size;
+    try {
+        value = std::stoll(digits.substr(start_pos), nullptr, base);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IRGenerator::evaluate_const_int(Expr *expr, long long &result) {
+    std::string value_str;
+    if (!evaluate_const_expr(expr, value_str)) {
+        return false;
+    }
+
+    try {
+        result = std::stoll(value_str);
+        return true;
+    } catch (...) {
+        return false;
+    }
 }
 
 /**
@@ -527,6 +555,7 @@ size_t IRGenerator::get_type_size(Type *type) {
  * - Integer literals with value 0
  * - Boolean literal false
  * - Array literals with all zero elements
+ * - Repeat arrays of a zero value, at any nesting depth: [[0; N]; M]
  * - Struct initializers with all zero fields
  *
  * Purpose:
@@ -574,6 +603,14 @@ bool IRGenerator::is_zero_initializer(Expr *expr) {
         return true;
     }
 
+    if (auto array_init = dynamic_cast<ArrayInitializerExpr *>(expr)) {
+        return is_zero_initializer(array_init->value.get());
+    }
+
+    if (auto group = dynamic_cast<GroupingExpr *>(expr)) {
+        return is_zero_initializer(group->expression.get());
+    }
+
     return false;
 }
 
@@ -601,8 +638,8 @@ bool IRGenerator::is_zero_initializer(Expr *expr) {
  *   }
  *
  * Criteria:
- * - Return type is struct or array
- * - Size is large (threshold-based decision)
+ * - Return type is struct
+ * - Not small enough to be returned as scalars (AbiLowering)
  * - Not for main() function (special case)
  *
  * @param func_name Function name being generated
@@ -614,6 +651,53 @@ bool IRGenerator::should_use_sret_optimization(const std::string &func_name, Typ
     if (!return_type || return_type->kind != TypeKind::STRUCT)
         return false;
 
-    size_t size = get_type_size(return_type);
+    if (abi_.is_flattened(return_type))
+        return false;
+
+    size_t size = data_layout_.size_of(return_type);
     return size > 0;
 }
+
+/**
+ * Allocate stack storage with scope-based slot coloring.
+ *
+ * Every aggregate slot belongs to the ValueManager scope that is current at
+ * allocation. When that scope is released, its slots get lifetime.end and go
+ * back to a free list keyed by IR type. A later allocation of the same type
+ * takes the dead slot instead of a new alloca:
+ *
+ *   { let a: [i32; 100] = ...; }     %stack.0, lifetime.start/end
+ *   { let b: [i32; 100] = ...; }     %stack.0 again, lifetime.start/end
+ *
+ * Allocas stay in the entry block, the markers tell LLVM which ranges of
+ * the function each slot is live in.
+ */
+std::string IRGenerator::allocate_stack_slot(Type *type) {
+    std::string ir_type = type_mapper_.map(type);
+    if (type->kind != TypeKind::ARRAY && type->kind != TypeKind::STRUCT) {
+        return emitter_.emit_alloca(ir_type);
+    }
+
+    std::string ptr = value_manager_.reuse_stack_slot(ir_type);
+    if (ptr.empty()) {
+        ptr = emitter_.emit_alloca(ir_type);
+    }
+
+    size_t size = data_layout_.size_of(type);
+    if (size > 0) {
+        emitter_.emit_lifetime_start(ptr, size, ir_type + "*");
+    }
+    value_manager_.add_stack_slot({ptr, ir_type, size});
+    return ptr;
+}
+
+void IRGenerator::end_stack_slot_lifetimes(const std::vector<StackSlot> &slots) {
+    if (current_block_terminated_) {
+        return;
+    }
+    for (const auto &slot : slots) {
+        if (slot.size > 0) {
+            emitter_.emit_lifetime_end(slot.ptr, slot.size, slot.type + "*");
+        }
+    }
+}
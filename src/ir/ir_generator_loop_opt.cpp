@@ -0,0 +1,380 @@
+#include "ir_generator.h"
+
+#include <cstdint>
+
+namespace {
+
+/**
+ * Scans a loop body (or the statements before a loop) for uses of the
+ * induction variable that prevent unrolling.
+ *
+ * - writes: assignments to var other than the allowed increment
+ * - escapes: &var / &mut var
+ * - shadowed: let var inside the scanned code
+ * - has_control: break/continue, nested loops or nested items
+ * - cost: number of AST nodes visited
+ */
+class InductionScanner : public AstWalker {
+  public:
+    InductionScanner(const std::string &var, Expr *increment) : var_(var), increment_(increment) {}
+
+    int writes = 0;
+    bool escapes = false;
+    bool shadowed = false;
+    bool has_control = false;
+    size_t cost = 0;
+
+    bool modifies_var() const { return writes > 0 || escapes || shadowed; }
+
+    void walk(Expr *expr) override {
+        ++cost;
+        AstWalker::walk(expr);
+    }
+
+    void walk(Stmt *stmt) override {
+        ++cost;
+        AstWalker::walk(stmt);
+    }
+
+    void visit(AssignmentExpr *node) override {
+        record_write(node, node->target.get());
+        AstWalker::visit(node);
+    }
+
+    void visit(CompoundAssignmentExpr *node) override {
+        record_write(node, node->target.get());
+        AstWalker::visit(node);
+    }
+
+    void visit(ReferenceExpr *node) override {
+        if (is_var(node->expression.get())) {
+            escapes = true;
+        }
+        AstWalker::visit(node);
+    }
+
+    void visit(LetStmt *node) override {
+        if (auto id = dynamic_cast<IdentifierPattern *>(node->pattern.get())) {
+            if (id->name.lexeme == var_) {
+                shadowed = true;
+            }
+        }
+        AstWalker::visit(node);
+    }
+
+    // Nested loops are walked too: their writes to var count
+    void visit(LoopExpr *node) override {
+        has_control = true;
+        AstWalker::visit(node);
+    }
+
+    void visit(WhileExpr *node) override {
+        has_control = true;
+        AstWalker::visit(node);
+    }
+
+    void visit(BreakStmt *node) override { has_control = true; }
+    void visit(ContinueStmt *node) override { has_control = true; }
+    void visit(ItemStmt *node) override { has_control = true; }
+
+  private:
+    std::string var_;
+    Expr *increment_;
+
+    bool is_var(Expr *expr) const {
+        while (auto group = dynamic_cast<GroupingExpr *>(expr)) {
+            expr = group->expression.get();
+        }
+        auto var = dynamic_cast<VariableExpr *>(expr);
+        return var && var->name.lexeme == var_;
+    }
+
+    void record_write(Expr *node, Expr *target) {
+        if (node != increment_ && is_var(target)) {
+            ++writes;
+        }
+    }
+};
+
+Expr *strip_grouping(Expr *expr) {
+    while (auto group = dynamic_cast<GroupingExpr *>(expr)) {
+        expr = group->expression.get();
+    }
+    return expr;
+}
+
+bool is_same_var(Expr *expr, const std::string &var) {
+    auto var_expr = dynamic_cast<VariableExpr *>(strip_grouping(expr));
+    return var_expr && var_expr->name.lexeme == var;
+}
+
+} // namespace
+
+/**
+ * Recognize a counted while loop.
+ *
+ * Accepted form:
+ *   while (i < bound) { ...; i += step; }      (also <=, and i = i + step)
+ *
+ * Requirements:
+ * - i is a local integer variable, bound and step are constants, step > 0
+ * - The increment is the last statement of the body and the only write to i
+ * - i is never borrowed or shadowed in the body
+ * - The body has no break/continue, nested loops or nested items
+ * - i + step cannot overflow past the bound
+ *
+ * @param node The while expression AST node
+ * @param loop Output: loop description
+ * @return true if the loop can be unrolled
+ */
+bool IRGenerator::analyze_counted_loop(WhileExpr *node, CountedLoop &loop) {
+    auto cond = dynamic_cast<BinaryExpr *>(strip_grouping(node->condition.get()));
+    auto body = dynamic_cast<BlockStmt *>(node->body.get());
+    if (!cond || !body) {
+        return false;
+    }
+
+    if (cond->op.type == TokenType::LESS) {
+        loop.pred = "lt";
+    } else if (cond->op.type == TokenType::LESS_EQUAL) {
+        loop.pred = "le";
+    } else {
+        return false;
+    }
+
+    auto induction = dynamic_cast<VariableExpr *>(strip_grouping(cond->left.get()));
+    if (!induction || !induction->type) {
+        return false;
+    }
+
+    TypeKind kind = induction->type->kind;
+    if (kind != TypeKind::I32 && kind != TypeKind::ISIZE && kind != TypeKind::U32 &&
+        kind != TypeKind::USIZE) {
+        return false;
+    }
+    loop.induction = induction;
+    loop.is_unsigned = (kind == TypeKind::U32 || kind == TypeKind::USIZE);
+    loop.pred = (loop.is_unsigned ? "u" : "s") + loop.pred;
+
+    const std::string &var = induction->name.lexeme;
+    VariableInfo *var_info = value_manager_.lookup_variable(var);
+    if (!var_info || var_info->is_global) {
+        return false;
+    }
+
+    if (!evaluate_const_int(cond->right.get(), loop.bound)) {
+        return false;
+    }
+
+    // The increment is the last statement (or the final expression) of the body
+    Expr *increment = nullptr;
+    if (body->final_expr.has_value()) {
+        increment = body->final_expr.value().get();
+    } else if (!body->statements.empty()) {
+        if (auto expr_stmt = dynamic_cast<ExprStmt *>(body->statements.back().get())) {
+            increment = expr_stmt->expression.get();
+        }
+    }
+    if (!increment) {
+        return false;
+    }
+
+    if (auto compound = dynamic_cast<CompoundAssignmentExpr *>(increment)) {
+        if (compound->op.type != TokenType::PLUS_EQUAL || !is_same_var(compound->target.get(), var) ||
+            !evaluate_const_int(compound->value.get(), loop.step)) {
+            return false;
+        }
+    } else if (auto assign = dynamic_cast<AssignmentExpr *>(increment)) {
+        auto sum = dynamic_cast<BinaryExpr *>(strip_grouping(assign->value.get()));
+        if (!is_same_var(assign->target.get(), var) || !sum || sum->op.type != TokenType::PLUS ||
+            !is_same_var(sum->left.get(), var) || !evaluate_const_int(sum->right.get(), loop.step)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    if (loop.step <= 0) {
+        return false;
+    }
+    loop.increment = increment;
+
+    // i must not wrap around while stepping past the bound
+    long long type_max = loop.is_unsigned ? UINT32_MAX : INT32_MAX;
+    long long type_min = loop.is_unsigned ? 0 : INT32_MIN;
+    if (loop.bound < type_min || loop.bound + loop.step > type_max) {
+        return false;
+    }
+
+    InductionScanner scanner(var, increment);
+    scanner.walk(body);
+    if (scanner.modifies_var() || scanner.has_control) {
+        return false;
+    }
+    loop.body_cost = scanner.cost;
+
+    loop.has_start = find_loop_entry_value(node, var, loop.start);
+    return true;
+}
+
+/**
+ * Find the constant value of var on entry to a while loop.
+ *
+ * Walks backwards from the loop over the statements of the enclosing block
+ * until it finds `let [mut] var: T = <const>;` or `var = <const>;`. Any other
+ * statement that may change var ends the search.
+ *
+ * @return true if the entry value is known
+ */
+bool IRGenerator::find_loop_entry_value(WhileExpr *node, const std::string &var,
+                                        long long &value) {
+    BlockStmt *block = current_block_stmt_;
+    if (!block) {
+        return false;
+    }
+
+    size_t index = current_stmt_index_;
+    if (index < block->statements.size()) {
+        auto expr_stmt = dynamic_cast<ExprStmt *>(block->statements[index].get());
+        if (!expr_stmt || expr_stmt->expression.get() != node) {
+            return false;
+        }
+    } else if (!block->final_expr.has_value() || block->final_expr.value().get() != node) {
+        return false;
+    }
+
+    while (index > 0) {
+        Stmt *stmt = block->statements[--index].get();
+
+        if (auto let_stmt = dynamic_cast<LetStmt *>(stmt)) {
+            auto id = dynamic_cast<IdentifierPattern *>(let_stmt->pattern.get());
+            if (id && id->name.lexeme == var) {
+                return let_stmt->initializer.has_value() &&
+                       evaluate_const_int(let_stmt->initializer.value().get(), value);
+            }
+        }
+
+        if (auto expr_stmt = dynamic_cast<ExprStmt *>(stmt)) {
+            auto assign = dynamic_cast<AssignmentExpr *>(expr_stmt->expression.get());
+            if (assign && is_same_var(assign->target.get(), var)) {
+                return evaluate_const_int(assign->value.get(), value);
+            }
+        }
+
+        InductionScanner scanner(var, nullptr);
+        scanner.walk(stmt);
+        if (scanner.modifies_var()) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+long long IRGenerator::counted_loop_trip_count(const CountedLoop &loop) {
+    long long last = (loop.pred == "slt" || loop.pred == "ult") ? loop.bound - 1 : loop.bound;
+    if (loop.start > last) {
+        return 0;
+    }
+    return (last - loop.start) / loop.step + 1;
+}
+
+bool IRGenerator::should_fully_unroll(size_t trip_count, size_t body_cost) {
+    return trip_count <= UNROLL_THRESHOLD && trip_count * body_cost <= UNROLL_BUDGET;
+}
+
+size_t IRGenerator::choose_unroll_factor(const CountedLoop &loop) {
+    if (!loop.has_start) {
+        return 0;
+    }
+
+    long long trip_count = counted_loop_trip_count(loop);
+    for (size_t factor : {8, 4}) {
+        long long main_bound = loop.bound - static_cast<long long>(factor - 1) * loop.step;
+        long long type_min = loop.is_unsigned ? 0 : INT32_MIN;
+        if (factor * loop.body_cost <= UNROLL_BUDGET &&
+            trip_count >= 2 * static_cast<long long>(factor) && main_bound >= type_min) {
+            return factor;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Emit every iteration of a counted loop as a copy of its body.
+ *
+ * Each copy keeps its own increment of i, so i has its final value after the
+ * loop just like in the rolled form. The condition has no side effects and is
+ * not emitted at all.
+ */
+void IRGenerator::emit_fully_unrolled_loop(WhileExpr *node, const CountedLoop &loop) {
+    long long trip_count = counted_loop_trip_count(loop);
+
+    for (long long i = 0; i < trip_count; ++i) {
+        if (current_block_terminated_) {
+            break;
+        }
+        node->body->accept(this);
+    }
+}
+
+/**
+ * Emit the unrolled main loop of a partially unrolled counted loop.
+ *
+ * IR structure:
+ *   br label %unroll.cond.N
+ *
+ * unroll.cond.N:
+ *   %i = load i
+ *   %cond = icmp <pred> %i, <bound - (factor - 1) * step>
+ *   br i1 %cond, label %unroll.body.N, label %unroll.end.N
+ *
+ * unroll.body.N:
+ *   <body> x factor
+ *   br label %unroll.cond.N
+ *
+ * unroll.end.N:
+ *   ; Remainder: regular while loop
+ *
+ * The adjusted bound guarantees all factor copies run within the original
+ * bound, the remaining iterations are executed by the regular loop.
+ */
+void IRGenerator::emit_partially_unrolled_loop(WhileExpr *node, const CountedLoop &loop,
+                                               size_t factor) {
+    int current_while = while_counter_++;
+
+    std::string cond_label = "unroll.cond." + std::to_string(current_while);
+    std::string body_label = "unroll.body." + std::to_string(current_while);
+    std::string end_label = "unroll.end." + std::to_string(current_while);
+
+    std::string var_type = type_mapper_.map(loop.induction->type.get());
+    VariableInfo *var_info = value_manager_.lookup_variable(loop.induction->name.lexeme);
+
+    long long main_bound = loop.bound - static_cast<long long>(factor - 1) * loop.step;
+    std::string bound_str =
+        std::to_string(static_cast<int32_t>(static_cast<uint32_t>(main_bound)));
+
+    emitter_.emit_br(cond_label);
+
+    begin_block(cond_label);
+    std::string i_val = emitter_.emit_load(var_type, var_info->alloca_name);
+    std::string cmp = emitter_.emit_icmp(loop.pred, var_type, i_val, bound_str);
+    emitter_.emit_cond_br(cmp, body_label, end_label);
+
+    begin_block(body_label);
+    current_block_terminated_ = false;
+
+    for (size_t i = 0; i < factor; ++i) {
+        if (current_block_terminated_) {
+            break;
+        }
+        node->body->accept(this);
+    }
+
+    if (!current_block_terminated_) {
+        emitter_.emit_br(cond_label);
+    }
+
+    begin_block(end_label);
+    current_block_terminated_ = false;
+}
@@ -1,18 +1,50 @@
+#include "../tool/thread_pool.h"
 #include "ir_generator.h"
 
+#include <algorithm>
 #include <cassert>
 
-IRGenerator::IRGenerator(BuiltinTypes &builtin_types)
-    : emitter_("main_module"), type_mapper_(builtin_types) {}
+namespace {
+
+// Units generated ahead of the merge per thread when streaming: enough to
+// keep the workers busy, few enough that the IR held stays small
+const size_t STREAM_UNITS_PER_THREAD = 4;
+
+} // namespace
+
+IRGenerator::IRGenerator(BuiltinTypes &builtin_types,
+                         const StaticStorageOptions &static_storage,
+                         const BlockCounterOptions &block_counters,
+                         const BlockProfile *profile)
+    : IRGenerator(std::make_shared<ModuleState>(builtin_types, static_storage), block_counters,
+                  profile, true) {
+    effect_analysis_.set_writes_globals(block_counters_.enabled());
+}
+
+IRGenerator::IRGenerator(std::shared_ptr<ModuleState> module,
+                         const BlockCounterOptions &block_counters, const BlockProfile *profile,
+                         bool module_header)
+    : module_(std::move(module)), data_layout_(module_->data_layout),
+      emitter_("main_module", &data_layout_, module_header), type_mapper_(module_->type_mapper),
+      abi_(module_->abi), call_graph_(module_->call_graph),
+      effect_analysis_(module_->effect_analysis), static_storage_(module_->static_storage),
+      profile_(profile), block_counters_(block_counters) {
+    emitter_.set_profile(profile);
+}
 
 /**
  * Generate complete LLVM IR for the entire program.
  *
  * Process:
  * 1. Collect and emit all struct type definitions (including nested structs)
- * 2. Emit built-in function declarations (printf, scanf, exit)
- * 3. Process all top-level items (functions, consts, impl blocks)
- * 4. Return complete IR module as text
+ * 2. Build the call graph from main, analyze function effects and pick
+ *    local arrays for static storage
+ * 3. Emit declarations of the built-in functions that are used
+ * 4. Generate the reachable functions as units (see set_threads), or
+ *    reuse them from the unit store (see set_unit_store)
+ * 5. Emit consts and merge the units in source order
+ * 6. With block counting, emit the counters and their dump function
+ * 7. Return complete IR module as text
  *
  * @param program The program AST root node
  * @return Complete LLVM IR module as string
@@ -21,55 +53,100 @@ std::string IRGenerator::generate(Program *program) {
     if (!program) {
         return "";
     }
+    generate_module(program, nullptr);
+    return emitter_.get_ir_string();
+}
 
+/**
+ * Generate the module, streaming it to sink.
+ *
+ * The struct types, builtin declarations and module analyses come first as
+ * in generate(); then each top-level item is merged and written out before
+ * the next. Only the units of the current window are generated and alive.
+ *
+ * @param program The program AST root node
+ * @param sink Receives the IR in order
+ */
+void IRGenerator::generate(Program *program, const IRSink &sink) {
+    if (program) {
+        generate_module(program, &sink);
+    }
+}
+
+/**
+ * Generate the module into the emitter, or through it into sink.
+ *
+ * Without a sink, every unit is generated before the first one is merged
+ * (most parallelism); with one, a window of units at a time, each window
+ * released once merged and written.
+ */
+void IRGenerator::generate_module(Program *program, const IRSink *sink) {
     collect_all_structs(program);
 
-    for (StructDecl *struct_decl : local_structs_set_) {
+    for (StructDecl *struct_decl : local_structs_) {
         visit_struct_decl(struct_decl);
     }
+    std::string struct_types = unit_store_ ? emitter_.get_ir_string() : std::string();
+
+    call_graph_.build(program);
+    static_storage_.run(call_graph_, data_layout_);
+    effect_analysis_.run(call_graph_, static_storage_, abi_);
 
     emit_builtin_declarations();
 
+    // Units look consts up by name, whether declared before or after them
     for (const auto &item : program->items) {
-        visit_item(item.get());
+        if (auto const_decl = dynamic_cast<ConstDecl *>(item.get())) {
+            std::string value;
+            if (evaluate_const_expr(const_decl->value.get(), value)) {
+                const_values_[const_decl->name.lexeme] = value;
+            }
+        }
     }
 
-    return emitter_.get_ir_string();
-}
+    // Block counters and profiles depend on source lines and labels of the
+    // whole program; such builds always generate every unit
+    if (unit_store_ && !block_counters_.enabled() && !profile_) {
+        module_key_ = module_fingerprint(struct_types);
+    }
 
-/**
- * Dispatch to appropriate visitor based on item type.
- *
- * Top-level items:
- * - fn: Function declarations -> visit_function_decl()
- * - struct: Type definitions -> (handled in first pass)
- * - const: Global constants -> visit_const_decl()
- * - impl: Method implementations -> visit_impl_block()
- *
- * Processing order:
- * 1. First pass: collect_all_structs() gathers struct definitions
- * 2. Second pass: This function processes functions, consts, impls
- *
- * Why struct_decl is empty:
- * - Struct types already emitted before functions
- * - No additional IR generation needed here
- *
- * Example program:
- *   struct Point { x: i32, y: i32 }  // Skipped (already emitted)
- *   const MAX: i32 = 100;             // visit_const_decl()
- *   fn main() { ... }                 // visit_function_decl()
- *   impl Point { ... }                // visit_impl_block()
- *
- * @param item The top-level item to process
- */
-void IRGenerator::visit_item(Item *item) {
-    if (auto fn_decl = dynamic_cast<FnDecl *>(item)) {
-        visit_function_decl(fn_decl);
-    } else if (auto struct_decl = dynamic_cast<StructDecl *>(item)) {
-    } else if (auto const_decl = dynamic_cast<ConstDecl *>(item)) {
-        visit_const_decl(const_decl);
-    } else if (auto impl_block = dynamic_cast<ImplBlock *>(item)) {
-        visit_impl_block(impl_block);
+    std::vector<FunctionUnit> units = collect_function_units(program);
+    size_t threads = threads_ == 0 ? ThreadPool::hardware_threads() : threads_;
+    threads = std::min(threads, units.size());
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+    size_t window = sink ? std::max<size_t>(threads, 1) * STREAM_UNITS_PER_THREAD : units.size();
+
+    // Each merged unit goes to the sink as is, without being copied into
+    // the module's text
+    if (sink) {
+        emitter_.set_sink(*sink);
+    }
+
+    size_t next_unit = 0;
+    size_t generated_units = 0;
+    for (const auto &item : program->items) {
+        if (auto const_decl = dynamic_cast<ConstDecl *>(item.get())) {
+            visit_const_decl(const_decl);
+        }
+        while (next_unit < units.size() && units[next_unit].item == item.get()) {
+            if (next_unit == generated_units) {
+                size_t count = std::min(window, units.size() - generated_units);
+                generate_function_units(std::span(units).subspan(generated_units, count),
+                                        pool.get());
+                generated_units += count;
+            }
+            merge_function_unit(units[next_unit]);
+            units[next_unit++] = FunctionUnit();
+        }
+    }
+
+    block_counters_.emit_support(emitter_);
+    if (sink) {
+        emitter_.flush();
+        emitter_.set_sink(nullptr);
     }
 }
 
@@ -81,7 +158,9 @@ void IRGenerator::visit_item(Item *item) {
  * - SRET optimization for large struct returns
  * - Parameter passing strategies:
  *   * Scalar types: pass by value, alloca + store in function
- *   * Aggregate types (arrays/structs): pass by pointer, memcpy to local
+ *   * Small aggregates: one parameter per scalar leaf, stored to a local
+ *   * Other aggregate types (arrays/structs): pass by pointer, memcpy to local
+ *     unless EffectAnalysis finds the parameter is only read in place
  *   * References: pass pointer directly, no alloca needed
  * - Function body generation with proper scoping
  * - Return value handling (direct return or SRET copy)
@@ -89,11 +168,20 @@ void IRGenerator::visit_item(Item *item) {
  * Optimizations:
  * - All allocas hoisted to entry block by IREmitter
  * - Mutable reference parameters marked with noalias attribute
+ * - Pointer parameters and the function itself carry the attributes
+ *   inferred by EffectAnalysis (nocapture, readonly, readnone, ...)
+ * - Small aggregates (see AbiLowering) are passed and returned as scalars
  * - Large struct returns use SRET (return via pointer parameter)
  *
+ * Functions that cannot be reached from main are skipped entirely.
+ *
  * @param node The function declaration AST node
  */
-void IRGenerator::visit_function_decl(FnDecl *node) {
+void IRGenerator::visit_function_decl(FnDecl *node, const std::string &name) {
+    if (!call_graph_.is_reachable(name)) {
+        return;
+    }
+
     std::vector<FnDecl *> outer_nested_functions = std::move(nested_functions_);
     nested_functions_.clear();
 
@@ -116,17 +204,23 @@ void IRGenerator::visit_function_decl(FnDecl *node) {
     std::vector<std::string> param_names;
     std::vector<bool> param_is_aggregate;
 
-    std::string func_name = node->name.lexeme;
+    std::string func_name = name;
     if (func_name == "main") {
         ret_type_str = "i32";
     }
+    Type *flat_return = nullptr;
+    if (return_type_ptr && func_name != "main" && abi_.is_flattened(return_type_ptr)) {
+        flat_return = return_type_ptr;
+        ret_type_str = abi_.return_type(return_type_ptr);
+    }
     if (return_type_ptr && should_use_sret_optimization(func_name, return_type_ptr)) {
         use_sret = true;
         params.push_back({ret_type_str + "*", "sret_ptr"});
         param_names.push_back("sret_ptr");
     }
 
-    for (const auto &param : node->params) {
+    for (size_t param_index = 0; param_index < node->params.size(); ++param_index) {
+        const auto &param = node->params[param_index];
         if (param->type && param->type->resolved_type) {
             auto resolved_type = param->type->resolved_type.get();
             std::string param_type_str = type_mapper_.map(resolved_type);
@@ -146,15 +240,25 @@ void IRGenerator::visit_function_decl(FnDecl *node) {
                     }
                 }
 
-                if (is_aggregate) {
-                    params.push_back({param_type_str + "*", param_name});
-                } else {
-                    std::string type_with_attr = param_type_str;
-                    if (is_mut_ref) {
-                        type_with_attr += " noalias";
+                if (is_aggregate && abi_.is_flattened(resolved_type)) {
+                    const auto &scalars = abi_.scalars(resolved_type);
+                    for (size_t k = 0; k < scalars.size(); ++k) {
+                        params.push_back({scalars[k].type, param_name + "." + std::to_string(k)});
                     }
-                    params.push_back({type_with_attr, param_name});
+                    param_names.push_back(param_name);
+                    param_is_aggregate.push_back(is_aggregate);
+                    continue;
+                }
+
+                std::string type_with_attr = is_aggregate ? param_type_str + "*" : param_type_str;
+                if (is_mut_ref) {
+                    type_with_attr += " noalias";
+                }
+                std::string effect_attrs = effect_analysis_.param_attributes(func_name, param_index);
+                if (!effect_attrs.empty()) {
+                    type_with_attr += " " + effect_attrs;
                 }
+                params.push_back({type_with_attr, param_name});
 
                 param_names.push_back(param_name);
                 param_is_aggregate.push_back(is_aggregate);
@@ -164,14 +268,20 @@ void IRGenerator::visit_function_decl(FnDecl *node) {
 
     std::string actual_ret_type = use_sret ? "void" : ret_type_str;
 
+    std::string outer_function_name = current_function_name_;
+    current_function_name_ = func_name;
+    note_source_line(node->name.line);
     current_function_uses_sret_ = use_sret;
     current_function_return_type_str_ = use_sret ? "void" : ret_type_str;
+    current_function_flat_return_ = flat_return;
 
-    emitter_.begin_function(actual_ret_type, func_name, params);
+    emitter_.begin_function(actual_ret_type, func_name, params,
+                            effect_analysis_.function_attributes(func_name));
     begin_block("bb.entry");
 
     emitter_.reset_temp_counter();
 
+    value_manager_.reset_stack_slots();
     value_manager_.enter_scope();
 
     size_t param_start_index = 0;
@@ -197,11 +307,26 @@ void IRGenerator::visit_function_decl(FnDecl *node) {
                 if (is_reference) {
                     value_manager_.define_variable(param_name, param_ir_name, param_type_str,
                                                    is_mutable);
+                } else if (is_aggregate && abi_.is_flattened(param->type->resolved_type.get())) {
+                    auto resolved = param->type->resolved_type.get();
+                    std::string local_alloca = emitter_.emit_alloca(param_type_str);
+
+                    std::vector<std::string> values;
+                    for (size_t k = 0; k < abi_.scalars(resolved).size(); ++k) {
+                        values.push_back(param_ir_name + "." + std::to_string(k));
+                    }
+                    emit_flattened_stores(resolved, values, local_alloca);
+
+                    value_manager_.define_variable(param_name, local_alloca, param_type_str + "*",
+                                                   is_mutable);
+                } else if (is_aggregate && !effect_analysis_.param_needs_copy(func_name, i)) {
+                    value_manager_.define_variable(param_name, param_ir_name, param_type_str + "*",
+                                                   is_mutable);
                 } else if (is_aggregate) {
                     std::string local_alloca = emitter_.emit_alloca(param_type_str);
 
                     auto resolved = param->type->resolved_type.get();
-                    size_t size_bytes = get_type_size(resolved);
+                    size_t size_bytes = data_layout_.size_of(resolved);
 
                     std::string ptr_type = param_type_str + "*";
                     emitter_.emit_memcpy(local_alloca, param_ir_name, size_bytes, ptr_type);
@@ -235,15 +360,22 @@ void IRGenerator::visit_function_decl(FnDecl *node) {
             }
 
             if (!current_block_terminated_) {
+                emit_exit_hooks();
                 if (use_sret) {
                     if (!body_result.empty() && return_type_ptr) {
-                        size_t size_bytes = get_type_size(return_type_ptr);
+                        size_t size_bytes = data_layout_.size_of(return_type_ptr);
                         std::string ptr_type = ret_type_str + "*";
                         emitter_.emit_memcpy("%sret_ptr", body_result, size_bytes, ptr_type);
                     }
                     emitter_.emit_ret_void();
                 } else if (ret_type_str == "void") {
                     emitter_.emit_ret_void();
+                } else if (flat_return) {
+                    if (!body_result.empty()) {
+                        emit_flattened_return(flat_return, body_result);
+                    } else {
+                        emitter_.emit_ret(ret_type_str, "zeroinitializer");
+                    }
                 } else if (!body_result.empty()) {
                     bool ret_is_aggregate = false;
                     if (node->return_type.has_value()) {
@@ -273,8 +405,10 @@ void IRGenerator::visit_function_decl(FnDecl *node) {
     }
 
     current_block_terminated_ = false;
+    current_function_name_ = outer_function_name;
     current_function_uses_sret_ = false;
     current_function_return_type_str_ = "";
+    current_function_flat_return_ = nullptr;
 
     value_manager_.exit_scope();
 
@@ -304,14 +438,16 @@ void IRGenerator::visit_function_decl(FnDecl *node) {
  *
  * Process:
  * 1. Extract struct type information from semantic analysis
- * 2. Map each field to LLVM type string
- * 3. Preserve field order (important for GEP indices)
+ * 2. Get field order from DataLayout::struct_layout
+ * 3. Map each field to LLVM type string
  * 4. Emit type definition to IR
  *
  * Field ordering:
- * - Follows declaration order in source code
- * - GEP uses numeric indices: 0, 1, 2...
- * - Example: point.y -> getelementptr %Point, ..., i32 1
+ * - Fields are sorted by decreasing alignment to minimize padding,
+ *   ties keep declaration order
+ * - GEP uses the layout index: StructLayout::field_index
+ * - Example: struct S { a: bool, b: i32 } -> %S = type { i32, i1 },
+ *   s.a -> getelementptr %S, ..., i32 1
  *
  * Type handling:
  * - Recursive structs use pointers: struct Node { next: &Node }
@@ -331,12 +467,8 @@ void IRGenerator::visit_struct_decl(StructDecl *node) {
     }
 
     std::vector<std::string> field_types;
-    for (const auto &field_name : struct_type->field_order) {
-        auto it = struct_type->fields.find(field_name);
-        if (it != struct_type->fields.end()) {
-            std::string field_type_str = type_mapper_.map(it->second.get());
-            field_types.push_back(field_type_str);
-        }
+    for (Type *field_type : data_layout_.struct_layout(struct_type.get()).field_types) {
+        field_types.push_back(type_mapper_.map(field_type));
     }
 
     emitter_.emit_struct_type(struct_type->name, field_types);
@@ -389,64 +521,7 @@ void IRGenerator::visit_const_decl(ConstDecl *node) {
 
         const_values_[const_name] = value_str;
     } else {
-        std::cerr << "Warning: Failed to evaluate constant expression for: " << const_name
-                  << std::endl;
-    }
-}
-
-/**
- * Generate IR for impl blocks (method implementations).
- *
- * Example Rust:
- *   impl Point {
- *       fn new(x: i32, y: i32) -> Point { ... }
- *       fn distance(&self) -> i32 { ... }
- *   }
- *
- * Process:
- * - Each method is generated as a regular function
- * - First parameter of instance methods is 'self' (implicit pointer)
- * - Static methods (no self) are just regular functions
- *
- * Method name mangling:
- * - new -> Point_new
- * - distance -> Point_distance
- * - Prevents name collision between types
- *
- * Self parameter:
- * - &self -> %self: T*
- * - &mut self -> %self: T* (mutability is semantic only)
- * - self -> %self: T (moves ownership, rare)
- *
- * @param node The impl block AST node
- */
-void IRGenerator::visit_impl_block(ImplBlock *node) {
-
-    if (!node->target_type || !node->target_type->resolved_type) {
-        return;
-    }
-
-    std::string type_name;
-    if (auto struct_type =
-            std::dynamic_pointer_cast<StructType>(node->target_type->resolved_type)) {
-        type_name = struct_type->name;
-    } else {
-        return;
-    }
-
-    for (const auto &item : node->implemented_items) {
-        if (auto fn_decl = dynamic_cast<FnDecl *>(item.get())) {
-            std::string original_name = fn_decl->name.lexeme;
-
-            std::string mangled_name = type_name + "_" + original_name;
-
-            Token original_token = fn_decl->name;
-            fn_decl->name.lexeme = mangled_name;
-
-            visit_function_decl(fn_decl);
-
-            fn_decl->name = original_token;
-        }
+        warn("Failed to evaluate constant expression for: " + const_name);
     }
 }
 
@@ -458,7 +533,7 @@ void IRGenerator::visit_impl_block(ImplBlock *node) {
  * Process:
  * 1. Traverse top-level items for struct declarations
  * 2. Recursively search function bodies for local structs
- * 3. Store unique structs in local_structs_set_
+ * 3. Store unique structs in local_structs_, in source order
  * 4. Emit all collected struct definitions
  *
  * Why needed:
@@ -480,7 +555,9 @@ void IRGenerator::visit_impl_block(ImplBlock *node) {
 void IRGenerator::collect_all_structs(Program *program) {
     for (const auto &item : program->items) {
         if (auto struct_decl = dynamic_cast<StructDecl *>(item.get())) {
-            local_structs_set_.insert(struct_decl);
+            if (local_structs_set_.insert(struct_decl).second) {
+                local_structs_.push_back(struct_decl);
+            }
         } else if (auto fn_decl = dynamic_cast<FnDecl *>(item.get())) {
             if (fn_decl->body.has_value() && fn_decl->body.value()) {
                 collect_structs_from_stmt(fn_decl->body.value().get());
@@ -494,7 +571,7 @@ void IRGenerator::collect_all_structs(Program *program) {
  *
  * Purpose:
  * - Find structs defined inside function bodies
- * - Add them to local_structs_set_ for later processing
+ * - Add them to local_structs_ for later processing
  * - Enables struct hoisting to module level
  *
  * Example:
@@ -530,7 +607,9 @@ void IRGenerator::collect_structs_from_stmt(Stmt *stmt) {
     } else if (auto item_stmt = dynamic_cast<ItemStmt *>(stmt)) {
         if (item_stmt->item) {
             if (auto struct_decl = dynamic_cast<StructDecl *>(item_stmt->item.get())) {
-                local_structs_set_.insert(struct_decl);
+                if (local_structs_set_.insert(struct_decl).second) {
+                    local_structs_.push_back(struct_decl);
+                }
             } else if (auto fn_decl = dynamic_cast<FnDecl *>(item_stmt->item.get())) {
                 if (fn_decl->body.has_value() && fn_decl->body.value()) {
                     collect_structs_from_stmt(fn_decl->body.value().get());
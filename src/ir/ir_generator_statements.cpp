@@ -16,29 +16,67 @@
  * - Variables defined in block are destroyed on exit
  * - Supports variable shadowing
  * - Nested blocks create nested scopes
+ * - Every statement other than let/item runs in its own scope, so the
+ *   temporaries it allocates die right after it
+ *
+ * Stack slot lifetimes:
+ * - Released statement scopes end their slots (lifetime.end), later
+ *   allocations of the same type reuse them
+ * - Slots of let/item statements live until the block exits. They are
+ *   released there unless the block's value is an aggregate or reference,
+ *   which may still point into them: then they go to the enclosing scope
  *
  * @param node The block statement AST node
  */
 void IRGenerator::visit(BlockStmt *node) {
     value_manager_.enter_scope();
 
+    BlockStmt *saved_block_stmt = current_block_stmt_;
+    size_t saved_stmt_index = current_stmt_index_;
+    current_block_stmt_ = node;
+
     for (size_t i = 0; i < node->statements.size(); ++i) {
         if (current_block_terminated_) {
             break;
         }
 
+        current_stmt_index_ = i;
         auto &stmt = node->statements[i];
+        if (dynamic_cast<LetStmt *>(stmt.get()) || dynamic_cast<ItemStmt *>(stmt.get())) {
+            stmt->accept(this);
+            continue;
+        }
+
+        value_manager_.enter_scope();
         stmt->accept(this);
+        end_stack_slot_lifetimes(value_manager_.exit_scope_and_release());
     }
 
     if (node->final_expr.has_value()) {
         auto final_expr = node->final_expr.value();
         if (final_expr) {
+            current_stmt_index_ = node->statements.size();
             final_expr->accept(this);
         }
     }
 
-    value_manager_.exit_scope();
+    current_block_stmt_ = saved_block_stmt;
+    current_stmt_index_ = saved_stmt_index;
+
+    bool value_may_point_into_block = true;
+    if (!node->final_expr.has_value() || !node->final_expr.value()) {
+        value_may_point_into_block = false;
+    } else if (auto value_type = node->final_expr.value()->type) {
+        value_may_point_into_block =
+            (value_type->kind == TypeKind::ARRAY || value_type->kind == TypeKind::STRUCT ||
+             value_type->kind == TypeKind::REFERENCE);
+    }
+
+    if (value_may_point_into_block) {
+        value_manager_.exit_scope();
+    } else {
+        end_stack_slot_lifetimes(value_manager_.exit_scope_and_release());
+    }
 }
 
 /**
@@ -86,12 +124,18 @@ void IRGenerator::visit(ExprStmt *node) {
  * 2. Aggregate types returning pointer (array/struct literals, function calls):
  *    - Initializer already returns pointer
  *    - Use that pointer directly, no copy needed
+ *    - Immutable bindings of constant literals use the literal's private
+ *      constant global directly, no stack space or initialization at all
  *
  * 3. Regular types:
  *    - Allocate stack space (alloca)
  *    - Evaluate initializer
  *    - Store value to allocated space
  *
+ * 4. Arrays chosen by StaticStorageAnalysis:
+ *    - Bound to an internal zero-initialized global instead of an alloca
+ *    - Zero initializers that run at most once are skipped
+ *
  * @param node The let statement AST node
  */
 void IRGenerator::visit(LetStmt *node) {
@@ -119,6 +163,25 @@ void IRGenerator::visit(LetStmt *node) {
     }
 
     std::string type_str = type_mapper_.map(var_type.get());
+
+    if (const auto *slot = static_storage_.slot(node)) {
+        std::string global_ptr = "@" + slot->name;
+        if (emitted_static_slots_.insert(slot->name).second) {
+            emitter_.emit_global_variable(slot->name, type_str, "zeroinitializer", false,
+                                          "internal");
+        }
+
+        if (node->initializer.has_value() && node->initializer.value()) {
+            Expr *init_expr = node->initializer.value().get();
+            if (!slot->runs_once || !is_zero_initializer(init_expr)) {
+                emit_aggregate_into(init_expr, global_ptr, var_type.get());
+            }
+        }
+
+        value_manager_.define_variable(var_name, global_ptr, type_str + "*", is_mutable);
+        return;
+    }
+
     bool is_reference = (var_type->kind == TypeKind::REFERENCE);
     bool is_aggregate_returns_pointer = false;
     std::string alloca_name;
@@ -153,10 +216,15 @@ void IRGenerator::visit(LetStmt *node) {
 
     if (is_aggregate_returns_pointer) {
         auto init_expr = node->initializer.value();
-        init_expr->accept(this);
-        alloca_name = get_expr_result(init_expr.get());
+        if (!is_mutable) {
+            alloca_name = get_const_aggregate_global(init_expr.get());
+        }
+        if (alloca_name.empty()) {
+            init_expr->accept(this);
+            alloca_name = get_expr_result(init_expr.get());
+        }
     } else {
-        alloca_name = emitter_.emit_alloca(type_str);
+        alloca_name = allocate_stack_slot(var_type.get());
 
         if (node->initializer.has_value()) {
             auto init_expr = node->initializer.value();
@@ -175,7 +243,7 @@ void IRGenerator::visit(LetStmt *node) {
                 if (!init_value.empty()) {
                     if (is_aggregate && init_value == alloca_name) {
                     } else if (is_aggregate) {
-                        size_t size = get_type_size(var_type.get());
+                        size_t size = data_layout_.size_of(var_type.get());
                         std::string ptr_type = type_str + "*";
                         emitter_.emit_memcpy(alloca_name, init_value, size, ptr_type);
                     } else {
@@ -203,6 +271,9 @@ void IRGenerator::visit(LetStmt *node) {
  * 3. return struct; (SRET optimization)
  *    -> memcpy to sret pointer, then ret void
  *
+ * 4. return small aggregate; (see AbiLowering)
+ *    -> load scalars, ret i32 %x or ret { i32, i32 } %pair
+ *
  * SRET handling:
  * - Large structs use hidden pointer parameter
  * - Function signature: void @foo(%Struct* sret %retval)
@@ -230,9 +301,12 @@ void IRGenerator::visit(ReturnStmt *node) {
             std::string return_value = get_expr_result(return_expr.get());
 
             if (return_expr->type) {
+                emit_exit_hooks();
                 std::string expr_type_str = type_mapper_.map(return_expr->type.get());
 
-                if (current_function_uses_sret_) {
+                if (current_function_flat_return_) {
+                    emit_flattened_return(current_function_flat_return_, return_value);
+                } else if (current_function_uses_sret_) {
                     emitter_.emit_ret_void();
                 } else {
                     bool is_aggregate = (return_expr->type->kind == TypeKind::ARRAY ||
@@ -266,6 +340,7 @@ void IRGenerator::visit(ReturnStmt *node) {
             }
         }
     } else {
+        emit_exit_hooks();
         emitter_.emit_ret_void();
         current_block_terminated_ = true;
     }
@@ -367,10 +442,25 @@ void IRGenerator::visit(ItemStmt *node) {
             return;
         }
 
-        std::string llvm_type = type_mapper_.map(const_decl->type->resolved_type.get());
+        Type *const_type = const_decl->type->resolved_type.get();
+        std::string llvm_type = type_mapper_.map(const_type);
         std::string const_name = const_decl->name.lexeme;
 
-        std::string alloca_ptr = emitter_.emit_alloca(llvm_type);
+        if (const_type->kind == TypeKind::ARRAY || const_type->kind == TypeKind::STRUCT) {
+            std::string const_ptr = get_const_aggregate_global(const_decl->value.get());
+            if (!const_ptr.empty()) {
+                value_manager_.define_variable(const_name, const_ptr, llvm_type + "*", false);
+                return;
+            }
+        }
+
+        std::string alloca_ptr = allocate_stack_slot(const_type);
+
+        if (const_type->kind == TypeKind::ARRAY || const_type->kind == TypeKind::STRUCT) {
+            emit_aggregate_into(const_decl->value.get(), alloca_ptr, const_type);
+            value_manager_.define_variable(const_name, alloca_ptr, llvm_type + "*", false);
+            return;
+        }
 
         const_decl->value->accept(this);
         std::string init_value = get_expr_result(const_decl->value.get());
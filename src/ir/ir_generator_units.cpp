@@ -0,0 +1,390 @@
+#include "../tool/sha256.h"
+#include "../tool/thread_pool.h"
+#include "ir_generator.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+const std::string CONST_PREFIX = "@.const.";
+const std::string PROF_PREFIX = ", !prof !";
+
+/**
+ * Parse the decimal number at text[pos]
+ * @return Position after the digits (pos if there are none)
+ */
+size_t parse_number(const std::string &text, size_t pos, size_t &value) {
+    size_t end = pos;
+    value = 0;
+    while (end < text.size() && std::isdigit(static_cast<unsigned char>(text[end]))) {
+        value = value * 10 + static_cast<size_t>(text[end] - '0');
+        ++end;
+    }
+    return end;
+}
+
+/**
+ * Replace every @.const.N of an instruction by its module name
+ */
+void rename_const_refs(const std::string &line, const std::vector<std::string> &names,
+                       std::string &out) {
+    size_t pos = 0;
+    while (true) {
+        size_t found = line.find(CONST_PREFIX, pos);
+        if (found == std::string::npos) {
+            out.append(line, pos, std::string::npos);
+            return;
+        }
+        size_t number = 0;
+        size_t end = parse_number(line, found + CONST_PREFIX.size(), number);
+        out.append(line, pos, found - pos);
+        if (end == found + CONST_PREFIX.size() || number >= names.size()) {
+            out.append(line, found, end - found);
+        } else {
+            out += names[number];
+        }
+        pos = end;
+    }
+}
+
+/**
+ * Rewrite the IR of a unit with module numbers
+ *
+ * The unit's emitter wrote these forms, which are the only ones rewritten:
+ * - "@.const.N = ..." definitions (dropped when the module already has one
+ *   with the same constant)
+ * - "!N = ..." metadata definitions
+ * - @.const.N operands and a trailing ", !prof !N" in instructions (indented
+ *   lines, which never contain string literals)
+ *
+ * @param const_names Module name of each unit constant global
+ * @param const_defined Whether the module already defined it
+ * @param metadata_base Module id of the unit's !0
+ */
+std::string relink_unit_ir(const std::string &ir, const std::vector<std::string> &const_names,
+                           const std::vector<bool> &const_defined, size_t metadata_base) {
+    std::string out;
+    out.reserve(ir.size());
+    std::string renamed;
+    size_t start = 0;
+    while (start < ir.size()) {
+        size_t end = ir.find('\n', start);
+        end = end == std::string::npos ? ir.size() : end + 1;
+        std::string line = ir.substr(start, end - start);
+        start = end;
+
+        if (line.compare(0, CONST_PREFIX.size(), CONST_PREFIX) == 0) {
+            size_t number = 0;
+            size_t digits_end = parse_number(line, CONST_PREFIX.size(), number);
+            if (number < const_names.size()) {
+                if (!const_defined[number]) {
+                    out += const_names[number];
+                    out.append(line, digits_end, std::string::npos);
+                }
+                continue;
+            }
+        } else if (line.size() > 1 && line[0] == '!' &&
+                   std::isdigit(static_cast<unsigned char>(line[1]))) {
+            size_t number = 0;
+            size_t digits_end = parse_number(line, 1, number);
+            out += "!" + std::to_string(metadata_base + number);
+            out.append(line, digits_end, std::string::npos);
+            continue;
+        } else if (line[0] == ' ') {
+            renamed.clear();
+            rename_const_refs(line, const_names, renamed);
+            size_t prof = renamed.rfind(PROF_PREFIX);
+            if (prof != std::string::npos) {
+                size_t number = 0;
+                size_t digits_end = parse_number(renamed, prof + PROF_PREFIX.size(), number);
+                renamed = renamed.substr(0, prof + PROF_PREFIX.size()) +
+                          std::to_string(metadata_base + number) + renamed.substr(digits_end);
+            }
+            out += renamed;
+            continue;
+        }
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * Length-prefixed field, so no two field lists hash the same text
+ */
+void hash_field(Sha256 &hash, std::string_view name, std::string_view value) {
+    hash.update(name);
+    hash.update("=" + std::to_string(value.size()) + ":");
+    hash.update(value);
+    hash.update("\n");
+}
+
+std::string type_name(const std::shared_ptr<TypeNode> &type) {
+    return type && type->resolved_type ? type->resolved_type->to_string() : "?";
+}
+
+} // namespace
+
+/**
+ * Collect the function units of a program.
+ *
+ * Every top-level function and every method of an impl block is one unit;
+ * functions nested in a body belong to the unit of that body (they are
+ * generated right after it). Units of functions that cannot be reached from
+ * main are not created.
+ *
+ * Method name mangling:
+ * - impl Point { fn new(..) } -> Point_new
+ * - Prevents name collision between types
+ * - The AST keeps the source name; the unit carries the IR name
+ *
+ * @param program The program AST root node
+ * @return Units in source order
+ */
+std::vector<IRGenerator::FunctionUnit> IRGenerator::collect_function_units(Program *program) {
+    std::vector<FunctionUnit> units;
+    auto add_unit = [&](Item *item, FnDecl *decl, const std::string &name) {
+        if (call_graph_.is_reachable(name)) {
+            FunctionUnit unit;
+            unit.item = item;
+            unit.decl = decl;
+            unit.name = name;
+            units.push_back(std::move(unit));
+        }
+    };
+
+    for (const auto &item : program->items) {
+        if (auto fn_decl = dynamic_cast<FnDecl *>(item.get())) {
+            add_unit(item.get(), fn_decl, fn_decl->name.lexeme);
+        } else if (auto impl_block = dynamic_cast<ImplBlock *>(item.get())) {
+            if (!impl_block->target_type || !impl_block->target_type->resolved_type) {
+                continue;
+            }
+            auto struct_type =
+                std::dynamic_pointer_cast<StructType>(impl_block->target_type->resolved_type);
+            if (!struct_type) {
+                continue;
+            }
+            for (const auto &impl_item : impl_block->implemented_items) {
+                if (auto fn_decl = dynamic_cast<FnDecl *>(impl_item.get())) {
+                    add_unit(item.get(), fn_decl, struct_type->name + "_" + fn_decl->name.lexeme);
+                }
+            }
+        }
+    }
+    return units;
+}
+
+/**
+ * Generate all units.
+ *
+ * Without a pool they are generated in order on the calling thread;
+ * otherwise the work-stealing pool takes them, largest functions spreading
+ * naturally since idle workers steal. Either way each unit has its own
+ * generator, so the result is the same.
+ *
+ * With a unit store, units found in it are loaded instead, and the
+ * generated ones are stored afterwards on the calling thread.
+ *
+ * @param units Units to fill in
+ * @param pool Workers, may be null
+ */
+void IRGenerator::generate_function_units(std::span<FunctionUnit> units, ThreadPool *pool) {
+    std::vector<FunctionUnit *> pending;
+    for (FunctionUnit &unit : units) {
+        if (!module_key_.empty()) {
+            unit.key = unit_key(unit);
+            if (!unit.key.empty() && unit_store_->load(unit.key, unit)) {
+                continue;
+            }
+        }
+        pending.push_back(&unit);
+    }
+
+    if (!pool || pending.size() <= 1) {
+        for (FunctionUnit *unit : pending) {
+            generate_function_unit(*unit);
+        }
+    } else {
+        for (FunctionUnit *unit : pending) {
+            pool->submit([this, unit](size_t) { generate_function_unit(*unit); });
+        }
+        pool->wait();
+    }
+
+    for (FunctionUnit *unit : pending) {
+        if (!unit->key.empty()) {
+            unit_store_->store(unit->key, *unit);
+        }
+    }
+}
+
+/**
+ * Digest the module state every unit depends on.
+ *
+ * Struct types fix type names, layouts and the ABI of aggregates; const
+ * values are substituted into bodies; the static storage thresholds decide
+ * which local arrays become globals.
+ *
+ * @param struct_types IR of the struct type definitions
+ * @return 64 hex digits
+ */
+std::string IRGenerator::module_fingerprint(const std::string &struct_types) const {
+    Sha256 hash;
+    hash_field(hash, "format", "code-unit-module-1");
+    hash_field(hash, "struct_types", struct_types);
+    std::map<std::string, std::string> consts(const_values_.begin(), const_values_.end());
+    for (const auto &[name, value] : consts) {
+        hash_field(hash, "const", name + "=" + value);
+    }
+    const StaticStorageOptions &options = static_storage_.options();
+    hash_field(hash, "static_storage.main_min_bytes", std::to_string(options.main_min_bytes));
+    hash_field(hash, "static_storage.min_bytes", std::to_string(options.min_bytes));
+    return hash.hex_digest();
+}
+
+/**
+ * Compute the store key of a unit.
+ *
+ * Besides the module fingerprint and the source digest, the key holds what
+ * the analyses concluded about each function the unit defines (its own and
+ * nested functions) or calls: the declarations sharing its name and their
+ * signatures, reachability, recursion, static storage, built-ins used, and
+ * the function and parameter attributes. An edit elsewhere that changes any
+ * of these, e.g. a callee that stops being readonly, changes the key.
+ *
+ * @param unit Unit with decl and name set
+ * @return 64 hex digits, empty if the store has no digest for the source
+ */
+std::string IRGenerator::unit_key(const FunctionUnit &unit) const {
+    std::string source_digest = unit_store_->source_digest(unit.decl);
+    if (source_digest.empty()) {
+        return "";
+    }
+
+    std::set<std::string> defined = {unit.name};
+    std::vector<std::string> worklist = {unit.name};
+    while (!worklist.empty()) {
+        std::string name = std::move(worklist.back());
+        worklist.pop_back();
+        for (const std::string &nested : call_graph_.nested_functions(name)) {
+            if (defined.insert(nested).second) {
+                worklist.push_back(nested);
+            }
+        }
+    }
+    std::set<std::string> functions = defined;
+    for (const std::string &name : defined) {
+        const auto &callees = call_graph_.callees(name);
+        functions.insert(callees.begin(), callees.end());
+    }
+
+    Sha256 hash;
+    hash_field(hash, "module", module_key_);
+    hash_field(hash, "name", unit.name);
+    hash_field(hash, "source", source_digest);
+    for (const std::string &name : functions) {
+        std::string facts = name;
+        size_t param_count = 0;
+        for (FnDecl *decl : call_graph_.declarations(name)) {
+            facts += " fn(";
+            for (const auto &param : decl->params) {
+                facts += type_name(param->type) + ",";
+            }
+            facts += ")";
+            if (decl->return_type.has_value()) {
+                facts += "->" + type_name(decl->return_type.value());
+            }
+            param_count = std::max(param_count, decl->params.size());
+        }
+        facts += " reachable=" + std::to_string(call_graph_.is_reachable(name));
+        facts += " recursive=" + std::to_string(call_graph_.is_recursive(name));
+        facts += " static=" + std::to_string(static_storage_.uses_static_storage(name));
+        for (const std::string &builtin : call_graph_.builtins(name)) {
+            facts += " " + builtin;
+        }
+        facts += " attributes=" + effect_analysis_.function_attributes(name);
+        for (size_t i = 0; i < param_count; ++i) {
+            facts += " param" + std::to_string(i) + "=" +
+                     effect_analysis_.param_attributes(name, i) + "/" +
+                     std::to_string(effect_analysis_.param_needs_copy(name, i));
+        }
+        hash_field(hash, "function", facts);
+    }
+    return hash.hex_digest();
+}
+
+/**
+ * Generate one unit.
+ *
+ * The unit generator starts from the module's struct types, analyses and
+ * top-level const values; everything it numbers (temporaries, labels,
+ * trampolines, constant globals, metadata) starts at 0.
+ *
+ * @param unit Unit to fill in: IR, constant global keys, metadata count,
+ *             block counters and warnings
+ */
+void IRGenerator::generate_function_unit(FunctionUnit &unit) const {
+    IRGenerator generator(module_, block_counters_.options(), profile_, false);
+    generator.const_values_ = const_values_;
+    ErrorReporter error_reporter(unit.diagnostics);
+    generator.set_error_reporter(&error_reporter);
+
+    generator.visit_function_decl(unit.decl, unit.name);
+
+    unit.ir = generator.emitter_.take_ir();
+    unit.const_globals.resize(generator.const_globals_.size());
+    for (const auto &[key, name] : generator.const_globals_) {
+        size_t number = 0;
+        parse_number(name, CONST_PREFIX.size(), number);
+        unit.const_globals[number] = key;
+    }
+    unit.metadata_count = generator.emitter_.metadata_count();
+    unit.block_counters = std::move(generator.block_counters_);
+}
+
+/**
+ * Merge a generated unit into the module.
+ *
+ * Constant globals are numbered by first use in the module, as if the units
+ * had been generated one after another by one generator; one already
+ * defined by an earlier unit is shared, not defined again.
+ *
+ * @param unit Generated unit, its IR is released
+ */
+void IRGenerator::merge_function_unit(FunctionUnit &unit) {
+    std::vector<std::string> const_names;
+    std::vector<bool> const_defined;
+    for (const std::string &key : unit.const_globals) {
+        auto [it, inserted] = const_globals_.emplace(key, "");
+        if (inserted) {
+            it->second = CONST_PREFIX + std::to_string(const_globals_.size() - 1);
+        }
+        const_names.push_back(it->second);
+        const_defined.push_back(!inserted);
+    }
+    size_t metadata_base = emitter_.reserve_metadata(unit.metadata_count);
+
+    if (const_names.empty() && unit.metadata_count == 0) {
+        emitter_.append_ir(unit.ir);
+    } else {
+        emitter_.append_ir(relink_unit_ir(unit.ir, const_names, const_defined, metadata_base));
+    }
+    unit.ir.clear();
+    unit.ir.shrink_to_fit();
+
+    block_counters_.append(unit.block_counters);
+
+    // IR generation only reports warnings
+    for (const Diagnostic &diagnostic : unit.diagnostics) {
+        warn(diagnostic.message);
+    }
+}
+
+void IRGenerator::warn(const std::string &message) {
+    if (error_reporter_) {
+        error_reporter_->report_warning(message);
+    } else {
+        std::cerr << "Warning: " << message << std::endl;
+    }
+}
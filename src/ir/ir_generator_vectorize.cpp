@@ -0,0 +1,422 @@
+#include "ir_generator.h"
+
+#include <cstdint>
+
+namespace {
+
+Expr *strip_grouping(Expr *expr) {
+    while (auto group = dynamic_cast<GroupingExpr *>(expr)) {
+        expr = group->expression.get();
+    }
+    return expr;
+}
+
+// Integer types that map to i32
+bool is_i32_type(Type *type) {
+    return type && (type->kind == TypeKind::I32 || type->kind == TypeKind::U32 ||
+                    type->kind == TypeKind::ISIZE || type->kind == TypeKind::USIZE);
+}
+
+// i, (i) or i as usize; all integer casts are no-ops on i32
+bool is_induction(Expr *expr, const std::string &var) {
+    expr = strip_grouping(expr);
+    while (auto as_expr = dynamic_cast<AsExpr *>(expr)) {
+        if (!is_i32_type(as_expr->type.get())) {
+            return false;
+        }
+        expr = strip_grouping(as_expr->expression.get());
+    }
+    auto var_expr = dynamic_cast<VariableExpr *>(expr);
+    return var_expr && var_expr->name.lexeme == var;
+}
+
+// Array type of a local array or a reference to an array
+ArrayType *array_type_of(Expr *expr) {
+    if (!expr || !expr->type) {
+        return nullptr;
+    }
+    Type *type = expr->type.get();
+    if (auto ref_type = dynamic_cast<ReferenceType *>(type)) {
+        type = ref_type->referenced_type.get();
+    }
+    return dynamic_cast<ArrayType *>(type);
+}
+
+// Lane-wise IR operator for binary and compound assignment operators
+std::string vector_ir_op(TokenType op) {
+    switch (op) {
+    case TokenType::PLUS:
+    case TokenType::PLUS_EQUAL:
+        return "add";
+    case TokenType::MINUS:
+    case TokenType::MINUS_EQUAL:
+        return "sub";
+    case TokenType::STAR:
+    case TokenType::STAR_EQUAL:
+        return "mul";
+    case TokenType::AMPERSAND:
+    case TokenType::AMPERSAND_EQUAL:
+        return "and";
+    case TokenType::PIPE:
+    case TokenType::PIPE_EQUAL:
+        return "or";
+    case TokenType::CARET:
+    case TokenType::CARET_EQUAL:
+        return "xor";
+    default:
+        return "";
+    }
+}
+
+std::string vector_constant(size_t width, const std::string &lane) {
+    std::string result = "<";
+    for (size_t i = 0; i < width; ++i) {
+        result += (i > 0 ? ", i32 " : "i32 ") + lane;
+    }
+    return result + ">";
+}
+
+std::string lane_indices(size_t width) {
+    std::string result = "<";
+    for (size_t i = 0; i < width; ++i) {
+        result += (i > 0 ? ", i32 " : "i32 ") + std::to_string(i);
+    }
+    return result + ">";
+}
+
+} // namespace
+
+/**
+ * Choose the vector width for an elementwise array loop.
+ *
+ * Accepted body (besides the increment i += 1):
+ *   X[i] = expr;   or   X[i] op= expr;
+ *
+ * where every array access is indexed by exactly i. Because all accesses use
+ * the same index, lane k of every statement only touches element i + k and
+ * there is no dependence between lanes, even if the arrays alias.
+ *
+ * @return 8 if the loop runs at least 16 iterations, 4 if it runs at least
+ *         4 (or the start value is unknown), 0 if it cannot be vectorized
+ */
+size_t IRGenerator::choose_vector_width(WhileExpr *node, const CountedLoop &loop) {
+    if (loop.step != 1) {
+        return 0;
+    }
+
+    auto body = dynamic_cast<BlockStmt *>(node->body.get());
+    if (!body) {
+        return 0;
+    }
+
+    size_t stmt_count = 0;
+    for (auto &stmt : body->statements) {
+        auto expr_stmt = dynamic_cast<ExprStmt *>(stmt.get());
+        if (!expr_stmt) {
+            return 0;
+        }
+
+        Expr *expr = expr_stmt->expression.get();
+        if (expr == loop.increment) {
+            continue;
+        }
+
+        if (auto assign = dynamic_cast<AssignmentExpr *>(expr)) {
+            if (!is_vectorizable_access(assign->target.get(), loop) ||
+                !is_vectorizable_expr(assign->value.get(), loop)) {
+                return 0;
+            }
+        } else if (auto compound = dynamic_cast<CompoundAssignmentExpr *>(expr)) {
+            if (vector_ir_op(compound->op.type).empty() ||
+                !is_vectorizable_access(compound->target.get(), loop) ||
+                !is_vectorizable_expr(compound->value.get(), loop)) {
+                return 0;
+            }
+        } else {
+            return 0;
+        }
+        ++stmt_count;
+    }
+
+    if (stmt_count == 0) {
+        return 0;
+    }
+
+    size_t width = 4;
+    if (loop.has_start) {
+        long long trip_count = counted_loop_trip_count(loop);
+        if (trip_count < 4) {
+            return 0;
+        }
+        width = trip_count >= 16 ? 8 : 4;
+    }
+
+    // The adjusted bound of the vector loop must not wrap around
+    long long type_min = loop.is_unsigned ? 0 : INT32_MIN;
+    if (loop.bound - static_cast<long long>(width - 1) < type_min) {
+        return 0;
+    }
+    return width;
+}
+
+bool IRGenerator::is_vectorizable_access(Expr *expr, const CountedLoop &loop) {
+    auto access = dynamic_cast<IndexExpr *>(strip_grouping(expr));
+    if (!access || !is_induction(access->index.get(), loop.induction->name.lexeme)) {
+        return false;
+    }
+
+    auto array_var = dynamic_cast<VariableExpr *>(strip_grouping(access->object.get()));
+    ArrayType *array_type = array_type_of(array_var);
+    if (!array_type || !is_i32_type(array_type->element_type.get())) {
+        return false;
+    }
+
+    VariableInfo *var_info = value_manager_.lookup_variable(array_var->name.lexeme);
+    if (!var_info) {
+        return false;
+    }
+
+    // Every index the loop can reach must be inside the array
+    long long last = (loop.pred == "slt" || loop.pred == "ult") ? loop.bound - 1 : loop.bound;
+    return last < static_cast<long long>(array_type->size);
+}
+
+bool IRGenerator::is_vectorizable_expr(Expr *expr, const CountedLoop &loop) {
+    expr = strip_grouping(expr);
+
+    long long value;
+    if (evaluate_const_int(expr, value)) {
+        return value >= INT32_MIN && value <= UINT32_MAX;
+    }
+
+    if (!expr || !is_i32_type(expr->type.get())) {
+        return false;
+    }
+
+    if (auto var_expr = dynamic_cast<VariableExpr *>(expr)) {
+        // The body only writes array elements, so any scalar is loop-invariant
+        return value_manager_.lookup_variable(var_expr->name.lexeme) != nullptr;
+    }
+
+    if (auto as_expr = dynamic_cast<AsExpr *>(expr)) {
+        return is_vectorizable_expr(as_expr->expression.get(), loop);
+    }
+
+    if (auto unary = dynamic_cast<UnaryExpr *>(expr)) {
+        return unary->op.type == TokenType::MINUS && is_vectorizable_expr(unary->right.get(), loop);
+    }
+
+    if (auto binary = dynamic_cast<BinaryExpr *>(expr)) {
+        return !vector_ir_op(binary->op.type).empty() &&
+               is_vectorizable_expr(binary->left.get(), loop) &&
+               is_vectorizable_expr(binary->right.get(), loop);
+    }
+
+    if (dynamic_cast<IndexExpr *>(expr)) {
+        return is_vectorizable_access(expr, loop);
+    }
+
+    return false;
+}
+
+/**
+ * Emit the vector loop of a vectorized counted loop.
+ *
+ * IR structure:
+ *   <array base pointers and splatted scalars>
+ *   br label %vec.cond.N
+ *
+ * vec.cond.N:
+ *   %i = load i
+ *   %cond = icmp <pred> %i, <bound - (width - 1)>
+ *   br i1 %cond, label %vec.body.N, label %vec.end.N
+ *
+ * vec.body.N:
+ *   %p = bitcast i32* <&X[i]> to <W x i32>*
+ *   %v = load <W x i32>, <W x i32>* %p, align 4
+ *   ...
+ *   store <W x i32> %r, <W x i32>* %q, align 4
+ *   i += width
+ *   br label %vec.cond.N
+ *
+ * vec.end.N:
+ *   ; Scalar epilogue: regular while loop
+ *
+ * Vector memory accesses use the element alignment, arrays are only
+ * guaranteed to be aligned to their element type.
+ */
+void IRGenerator::emit_vectorized_loop(WhileExpr *node, const CountedLoop &loop, size_t width) {
+    int current_while = while_counter_++;
+
+    std::string cond_label = "vec.cond." + std::to_string(current_while);
+    std::string body_label = "vec.body." + std::to_string(current_while);
+    std::string end_label = "vec.end." + std::to_string(current_while);
+
+    VectorLoopContext ctx;
+    ctx.width = width;
+    ctx.vec_type = "<" + std::to_string(width) + " x i32>";
+
+    auto body = dynamic_cast<BlockStmt *>(node->body.get());
+    std::vector<Expr *> stores;
+    for (auto &stmt : body->statements) {
+        Expr *expr = static_cast<ExprStmt *>(stmt.get())->expression.get();
+        if (expr != loop.increment) {
+            stores.push_back(expr);
+        }
+    }
+
+    for (Expr *expr : stores) {
+        if (auto assign = dynamic_cast<AssignmentExpr *>(expr)) {
+            emit_vector_invariants(assign->target.get(), loop, ctx);
+            emit_vector_invariants(assign->value.get(), loop, ctx);
+        } else if (auto compound = dynamic_cast<CompoundAssignmentExpr *>(expr)) {
+            emit_vector_invariants(compound->target.get(), loop, ctx);
+            emit_vector_invariants(compound->value.get(), loop, ctx);
+        }
+    }
+
+    std::string var_type = type_mapper_.map(loop.induction->type.get());
+    VariableInfo *var_info = value_manager_.lookup_variable(loop.induction->name.lexeme);
+
+    long long vector_bound = loop.bound - static_cast<long long>(width - 1);
+    std::string bound_str =
+        std::to_string(static_cast<int32_t>(static_cast<uint32_t>(vector_bound)));
+
+    emitter_.emit_br(cond_label);
+
+    begin_block(cond_label);
+    ctx.index = emitter_.emit_load(var_type, var_info->alloca_name);
+    std::string cmp = emitter_.emit_icmp(loop.pred, var_type, ctx.index, bound_str);
+    emitter_.emit_cond_br(cmp, body_label, end_label);
+
+    begin_block(body_label);
+    current_block_terminated_ = false;
+
+    if (loop.is_unsigned) {
+        ctx.index_i64 = emitter_.emit_zext("i32", ctx.index, "i64");
+    } else {
+        ctx.index_i64 = emitter_.emit_sext("i32", ctx.index, "i64");
+    }
+
+    for (Expr *expr : stores) {
+        if (auto assign = dynamic_cast<AssignmentExpr *>(expr)) {
+            std::string value = emit_vector_expr(assign->value.get(), loop, ctx);
+            auto target = static_cast<IndexExpr *>(strip_grouping(assign->target.get()));
+            std::string ptr = emit_vector_element_ptr(target, ctx);
+            emitter_.emit_store(ctx.vec_type, value, ptr, 4);
+        } else if (auto compound = dynamic_cast<CompoundAssignmentExpr *>(expr)) {
+            auto target = static_cast<IndexExpr *>(strip_grouping(compound->target.get()));
+            std::string ptr = emit_vector_element_ptr(target, ctx);
+            std::string current = emitter_.emit_load(ctx.vec_type, ptr, 4);
+            std::string value = emit_vector_expr(compound->value.get(), loop, ctx);
+            std::string result = emitter_.emit_binary_op(vector_ir_op(compound->op.type),
+                                                         ctx.vec_type, current, value);
+            emitter_.emit_store(ctx.vec_type, result, ptr, 4);
+        }
+    }
+
+    std::string next_index =
+        emitter_.emit_binary_op("add", var_type, ctx.index, std::to_string(width));
+    emitter_.emit_store(var_type, next_index, var_info->alloca_name);
+    emitter_.emit_br(cond_label);
+
+    begin_block(end_label);
+    current_block_terminated_ = false;
+}
+
+void IRGenerator::emit_vector_invariants(Expr *expr, const CountedLoop &loop,
+                                         VectorLoopContext &ctx) {
+    expr = strip_grouping(expr);
+
+    long long value;
+    if (evaluate_const_int(expr, value)) {
+        return;
+    }
+
+    if (auto var_expr = dynamic_cast<VariableExpr *>(expr)) {
+        const std::string &name = var_expr->name.lexeme;
+        if (name == loop.induction->name.lexeme || ctx.splats.count(name)) {
+            return;
+        }
+        var_expr->accept(this);
+        std::string scalar = get_expr_result(var_expr);
+        std::string lane0 = emitter_.emit_insertelement(ctx.vec_type, "undef", "i32", scalar, 0);
+        ctx.splats[name] = emitter_.emit_shufflevector(ctx.vec_type, lane0, "undef", ctx.vec_type,
+                                                       "zeroinitializer");
+        return;
+    }
+
+    if (auto as_expr = dynamic_cast<AsExpr *>(expr)) {
+        emit_vector_invariants(as_expr->expression.get(), loop, ctx);
+    } else if (auto unary = dynamic_cast<UnaryExpr *>(expr)) {
+        emit_vector_invariants(unary->right.get(), loop, ctx);
+    } else if (auto binary = dynamic_cast<BinaryExpr *>(expr)) {
+        emit_vector_invariants(binary->left.get(), loop, ctx);
+        emit_vector_invariants(binary->right.get(), loop, ctx);
+    } else if (auto access = dynamic_cast<IndexExpr *>(expr)) {
+        auto array_var = static_cast<VariableExpr *>(strip_grouping(access->object.get()));
+        const std::string &name = array_var->name.lexeme;
+        if (ctx.array_bases.count(name)) {
+            return;
+        }
+
+        bool was_generating_lvalue = generating_lvalue_;
+        generating_lvalue_ = true;
+        array_var->accept(this);
+        generating_lvalue_ = was_generating_lvalue;
+
+        ArrayType *array_type = array_type_of(array_var);
+        std::string array_ir_type = "[" + std::to_string(array_type->size) + " x i32]";
+        ctx.array_bases[name] = {get_expr_result(array_var), array_ir_type};
+    }
+}
+
+std::string IRGenerator::emit_vector_expr(Expr *expr, const CountedLoop &loop,
+                                          VectorLoopContext &ctx) {
+    expr = strip_grouping(expr);
+
+    long long value;
+    if (evaluate_const_int(expr, value)) {
+        return vector_constant(ctx.width,
+                               std::to_string(static_cast<int32_t>(static_cast<uint32_t>(value))));
+    }
+
+    if (auto var_expr = dynamic_cast<VariableExpr *>(expr)) {
+        if (var_expr->name.lexeme != loop.induction->name.lexeme) {
+            return ctx.splats[var_expr->name.lexeme];
+        }
+        // Lane k holds i + k
+        std::string lane0 = emitter_.emit_insertelement(ctx.vec_type, "undef", "i32", ctx.index, 0);
+        std::string splat = emitter_.emit_shufflevector(ctx.vec_type, lane0, "undef",
+                                                        ctx.vec_type, "zeroinitializer");
+        return emitter_.emit_binary_op("add", ctx.vec_type, splat, lane_indices(ctx.width));
+    }
+
+    if (auto as_expr = dynamic_cast<AsExpr *>(expr)) {
+        return emit_vector_expr(as_expr->expression.get(), loop, ctx);
+    }
+
+    if (auto unary = dynamic_cast<UnaryExpr *>(expr)) {
+        std::string operand = emit_vector_expr(unary->right.get(), loop, ctx);
+        return emitter_.emit_binary_op("sub", ctx.vec_type, "zeroinitializer", operand);
+    }
+
+    if (auto binary = dynamic_cast<BinaryExpr *>(expr)) {
+        std::string lhs = emit_vector_expr(binary->left.get(), loop, ctx);
+        std::string rhs = emit_vector_expr(binary->right.get(), loop, ctx);
+        return emitter_.emit_binary_op(vector_ir_op(binary->op.type), ctx.vec_type, lhs, rhs);
+    }
+
+    auto access = static_cast<IndexExpr *>(expr);
+    std::string ptr = emit_vector_element_ptr(access, ctx);
+    return emitter_.emit_load(ctx.vec_type, ptr, 4);
+}
+
+std::string IRGenerator::emit_vector_element_ptr(IndexExpr *access, VectorLoopContext &ctx) {
+    auto array_var = static_cast<VariableExpr *>(strip_grouping(access->object.get()));
+    auto &base = ctx.array_bases[array_var->name.lexeme];
+
+    std::vector<std::string> indices = {"i64 0", "i64 " + ctx.index_i64};
+    std::string elem_ptr = emitter_.emit_getelementptr_inbounds(base.second, base.first, indices);
+    return emitter_.emit_bitcast("i32*", elem_ptr, ctx.vec_type + "*");
+}
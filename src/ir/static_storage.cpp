@@ -0,0 +1,152 @@
+#include "static_storage.h"
+#include "../ast/ast_walker.h"
+#include "../semantic/semantic.h"
+
+#include <vector>
+
+namespace {
+
+Expr *strip_grouping(Expr *expr) {
+    while (auto group = dynamic_cast<GroupingExpr *>(expr)) {
+        expr = group->expression.get();
+    }
+    return expr;
+}
+
+/**
+ * Get the variable a place expression is rooted at: x, x[i], x.f, (x)
+ */
+VariableExpr *root_variable(Expr *expr) {
+    expr = strip_grouping(expr);
+    if (auto index = dynamic_cast<IndexExpr *>(expr)) {
+        return root_variable(index->object.get());
+    }
+    if (auto field = dynamic_cast<FieldAccessExpr *>(expr)) {
+        return root_variable(field->object.get());
+    }
+    return dynamic_cast<VariableExpr *>(expr);
+}
+
+/**
+ * Collects array let statements with their loop nesting, and variables
+ * whose address escapes.
+ */
+class StorageScanner : public AstWalker {
+  public:
+    struct ArrayLet {
+        LetStmt *stmt;
+        std::string name;
+        Type *type;
+        bool in_loop;
+    };
+
+    std::vector<ArrayLet> array_lets;
+    std::set<std::string> escaped;
+
+    void visit(LetStmt *node) override {
+        auto id_pattern = dynamic_cast<IdentifierPattern *>(node->pattern.get());
+
+        Type *type = nullptr;
+        if (node->type_annotation.has_value() && node->type_annotation.value()->resolved_type) {
+            type = node->type_annotation.value()->resolved_type.get();
+        } else if (node->initializer.has_value() && node->initializer.value() &&
+                   node->initializer.value()->type) {
+            type = node->initializer.value()->type.get();
+        }
+
+        if (id_pattern && type && type->kind == TypeKind::ARRAY) {
+            array_lets.push_back({node, id_pattern->name.lexeme, type, loop_depth_ > 0});
+        }
+        AstWalker::visit(node);
+    }
+
+    void visit(LoopExpr *node) override {
+        ++loop_depth_;
+        AstWalker::visit(node);
+        --loop_depth_;
+    }
+
+    void visit(WhileExpr *node) override {
+        ++loop_depth_;
+        AstWalker::visit(node);
+        --loop_depth_;
+    }
+
+    /**
+     * A borrow escapes unless it is passed straight to a call: without
+     * lifetimes in the language, the callee cannot keep it
+     */
+    void visit(ReferenceExpr *node) override {
+        if (auto var = root_variable(node->expression.get())) {
+            escaped.insert(var->name.lexeme);
+        }
+        AstWalker::visit(node);
+    }
+
+    void visit(CallExpr *node) override {
+        walk(node->callee.get());
+        for (const auto &arg : node->arguments) {
+            auto ref = dynamic_cast<ReferenceExpr *>(strip_grouping(arg.get()));
+            walk(ref ? ref->expression.get() : arg.get());
+        }
+    }
+
+  private:
+    int loop_depth_ = 0;
+};
+
+} // namespace
+
+void StaticStorageAnalysis::run(const CallGraph &call_graph, DataLayout &data_layout) {
+    slots_.clear();
+    functions_.clear();
+
+    for (const auto &name : call_graph.reachable_functions()) {
+        const auto &decls = call_graph.declarations(name);
+        if (decls.size() != 1 || call_graph.is_recursive(name)) {
+            continue;
+        }
+        scan_function(name, decls.front(), data_layout);
+    }
+}
+
+const StaticStorageAnalysis::Slot *StaticStorageAnalysis::slot(LetStmt *stmt) const {
+    auto it = slots_.find(stmt);
+    return it != slots_.end() ? &it->second : nullptr;
+}
+
+bool StaticStorageAnalysis::uses_static_storage(const std::string &name) const {
+    return functions_.count(name) > 0;
+}
+
+void StaticStorageAnalysis::scan_function(const std::string &name, FnDecl *decl,
+                                          DataLayout &data_layout) {
+    if (!decl->body.has_value() || !decl->body.value()) {
+        return;
+    }
+
+    StorageScanner scanner;
+    scanner.walk(decl->body.value().get());
+
+    bool is_main = (name == "main");
+    size_t min_bytes = is_main ? options_.main_min_bytes : options_.min_bytes;
+
+    std::map<std::string, int> name_counts;
+    for (const auto &array_let : scanner.array_lets) {
+        if (data_layout.size_of(array_let.type) < min_bytes) {
+            continue;
+        }
+        if (!is_main && scanner.escaped.count(array_let.name)) {
+            continue;
+        }
+
+        std::string global_name = name + "." + array_let.name;
+        int count = name_counts[global_name]++;
+        if (count > 0) {
+            global_name += "." + std::to_string(count);
+        }
+
+        slots_[array_let.stmt] = {global_name, is_main && !array_let.in_loop};
+        functions_.insert(name);
+    }
+}
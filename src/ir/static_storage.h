@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../ast/ast.h"
+#include "call_graph.h"
+#include "data_layout.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+/**
+ * Size thresholds of StaticStorageAnalysis in bytes
+ * An array is moved when its size is at least the threshold of its function,
+ * SIZE_MAX disables the transformation.
+ */
+struct StaticStorageOptions {
+    size_t main_min_bytes = 4 * 1024; // Arrays in main
+    size_t min_bytes = 64 * 1024;     // Arrays in other non-recursive functions
+};
+
+/**
+ * StaticStorageAnalysis - Moves oversized local arrays to module globals
+ *
+ * Core responsibilities:
+ * 1. Find functions that are never re-entered: reachable, not recursive
+ *    (per CallGraph) and with a single body under their IR name
+ * 2. Find large local arrays in them whose address does not escape
+ * 3. Assign each such array a zero-initialized internal global (.bss)
+ *
+ * Why it is safe:
+ * - A non-recursive function has at most one activation at a time, so one
+ *   static copy per local array is enough
+ * - The array is re-initialized by its let statement on every execution, as
+ *   on the stack. Only main's let statements outside loops run at most once;
+ *   their zero initializers are skipped, .bss is already zero
+ * - In functions other than main an escaping address (a borrow that is not
+ *   a direct call argument) could observe the next call, such arrays stay on
+ *   the stack. main's storage lives until exit either way
+ *
+ * Example:
+ *   fn main() { let mut dp: [i32; 1000000] = [0; 1000000]; ... }
+ *   ->
+ *   @main.dp = internal global [1000000 x i32] zeroinitializer, align 4
+ *   (no alloca, no memset)
+ */
+class StaticStorageAnalysis {
+  public:
+    /**
+     * Static storage of one let statement
+     * name: global name without '@' (e.g., "main.dp")
+     * runs_once: the statement executes at most once per program run
+     */
+    struct Slot {
+        std::string name;
+        bool runs_once = false;
+    };
+
+    explicit StaticStorageAnalysis(const StaticStorageOptions &options = StaticStorageOptions())
+        : options_(options) {}
+
+    /**
+     * Analyze all functions reachable in the call graph
+     * @param call_graph Call graph built for the program
+     * @param data_layout Layout used to compute array sizes
+     */
+    void run(const CallGraph &call_graph, DataLayout &data_layout);
+
+    /**
+     * Get the static storage assigned to a let statement
+     * @return Slot, nullptr if the variable stays on the stack
+     */
+    const Slot *slot(LetStmt *stmt) const;
+
+    /**
+     * Check if a function keeps any local array in static storage
+     * Such a function reads and writes module memory
+     * @param name Function IR name
+     */
+    bool uses_static_storage(const std::string &name) const;
+
+    const StaticStorageOptions &options() const { return options_; }
+
+  private:
+    StaticStorageOptions options_;
+    std::map<LetStmt *, Slot> slots_;
+    std::set<std::string> functions_;
+
+    void scan_function(const std::string &name, FnDecl *decl, DataLayout &data_layout);
+};
@@ -9,9 +9,12 @@ std::string TypeMapper::map(const Type *rust_type) {
         return "void";
     }
 
-    auto it = type_cache_.find(rust_type);
-    if (it != type_cache_.end()) {
-        return it->second;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = type_cache_.find(rust_type);
+        if (it != type_cache_.end()) {
+            return it->second;
+        }
     }
 
     std::string ir_type;
@@ -72,6 +75,7 @@ std::string TypeMapper::map(const Type *rust_type) {
         break;
     }
 
+    std::unique_lock<std::shared_mutex> lock(mutex_);
     type_cache_[rust_type] = ir_type;
 
     return ir_type;
@@ -180,12 +184,14 @@ std::string TypeMapper::get_zero_value(const Type *type) {
 }
 
 std::string TypeMapper::declare_struct_type(const StructType *type) {
-    if (declared_structs_[type->name]) {
-        return "";
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (declared_structs_[type->name]) {
+            return "";
+        }
+        declared_structs_[type->name] = true;
     }
 
-    declared_structs_[type->name] = true;
-
 
     std::stringstream ss;
     ss << "%" << type->name << " = type { ";
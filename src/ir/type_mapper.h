@@ -1,6 +1,8 @@
 #pragma once
 #include "../semantic/semantic.h"
 
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 
@@ -12,6 +14,9 @@
  * 2. Cache converted types to improve performance
  * 3. Generate struct type definitions
  * 4. Provide zero value representation for types
+ *
+ * Thread safety: the caches are guarded, so one TypeMapper can serve
+ * several threads generating IR at once.
  */
 class TypeMapper {
   public:
@@ -86,6 +91,7 @@ class TypeMapper {
   private:
     BuiltinTypes &builtin_types_;
 
+    std::shared_mutex mutex_; // Guards the caches below
     std::unordered_map<const Type *, std::string> type_cache_;
 
     std::unordered_map<std::string, bool> declared_structs_;
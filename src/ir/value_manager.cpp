@@ -6,7 +6,50 @@ void ValueManager::enter_scope() { scope_stack_.emplace_back(); }
 
 void ValueManager::exit_scope() {
     if (scope_stack_.size() > 1) {
+        std::vector<StackSlot> slots = std::move(scope_stack_.back().stack_slots);
         scope_stack_.pop_back();
+
+        auto &parent_slots = scope_stack_.back().stack_slots;
+        parent_slots.insert(parent_slots.end(), slots.begin(), slots.end());
+    }
+}
+
+std::vector<StackSlot> ValueManager::exit_scope_and_release() {
+    if (scope_stack_.size() <= 1) {
+        return {};
+    }
+
+    std::vector<StackSlot> slots = std::move(scope_stack_.back().stack_slots);
+    scope_stack_.pop_back();
+
+    for (const auto &slot : slots) {
+        free_stack_slots_[slot.type].push_back(slot.ptr);
+    }
+    return slots;
+}
+
+void ValueManager::add_stack_slot(const StackSlot &slot) {
+    if (scope_stack_.empty()) {
+        return;
+    }
+    scope_stack_.back().stack_slots.push_back(slot);
+}
+
+std::string ValueManager::reuse_stack_slot(const std::string &type) {
+    auto it = free_stack_slots_.find(type);
+    if (it == free_stack_slots_.end() || it->second.empty()) {
+        return "";
+    }
+
+    std::string ptr = it->second.back();
+    it->second.pop_back();
+    return ptr;
+}
+
+void ValueManager::reset_stack_slots() {
+    free_stack_slots_.clear();
+    for (auto &scope : scope_stack_) {
+        scope.stack_slots.clear();
     }
 }
 
@@ -103,5 +146,6 @@ std::vector<std::string> ValueManager::get_current_scope_variables() const {
 
 void ValueManager::clear() {
     scope_stack_.clear();
+    free_stack_slots_.clear();
     enter_scope();
 }
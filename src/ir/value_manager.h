@@ -23,6 +23,16 @@ struct VariableInfo {
           is_global(global) {}
 };
 
+/**
+ * StackSlot - Stack allocation owned by a scope
+ * ptr: alloca result (e.g., "%stack.3"), type: allocated IR type, size: bytes
+ */
+struct StackSlot {
+    std::string ptr;
+    std::string type;
+    size_t size;
+};
+
 /**
  * ValueManager - Variable and value manager
  *
@@ -32,6 +42,7 @@ struct VariableInfo {
  * 3. Support variable shadowing
  * 4. Detect duplicate definitions
  * 5. Handle local variables, function parameters, and global variables
+ * 6. Track the lifetime of stack slots per scope, recycle dead slots
  *
  * Design principles:
  * - Do not use LLVM C++ API
@@ -50,10 +61,35 @@ class ValueManager {
 
     /**
      * Exit current scope
+     * Stack slots of the scope are handed to the enclosing scope, the value
+     * of a block may still live in them
      * Note: Cannot exit global scope
      */
     void exit_scope();
 
+    /**
+     * Exit current scope and end the lifetime of its stack slots
+     * The slots become free for later allocations of the same IR type
+     * @return Released slots, in allocation order
+     */
+    std::vector<StackSlot> exit_scope_and_release();
+
+    /**
+     * Record a stack slot as owned by the current scope
+     */
+    void add_stack_slot(const StackSlot &slot);
+
+    /**
+     * Take a free stack slot of an IR type
+     * @return Alloca name, empty if no slot of this type is free
+     */
+    std::string reuse_stack_slot(const std::string &type);
+
+    /**
+     * Forget all owned and free stack slots (called at the start of each function)
+     */
+    void reset_stack_slots();
+
     /**
      * Get current scope depth
      * @return 0 for global scope, 1 for first nested level, and so on
@@ -139,11 +175,16 @@ class ValueManager {
   private:
     /**
      * Scope - Single scope
-     * Stores all variables defined in this scope
+     * Stores all variables defined in this scope and the stack slots whose
+     * lifetime ends with it
      */
     struct Scope {
         std::unordered_map<std::string, VariableInfo> variables;
+        std::vector<StackSlot> stack_slots;
     };
 
     std::vector<Scope> scope_stack_;
+
+    // Dead stack slots by IR type
+    std::unordered_map<std::string, std::vector<std::string>> free_stack_slots_;
 };
@@ -236,7 +236,7 @@ string tokenTypeToString(TokenType type) {
     }
 }
 
-static std::unordered_map<std::string, TokenType> keywords = {
+static const std::unordered_map<std::string, TokenType> keywords = {
 
     {"as", TokenType::AS},
     {"break", TokenType::BREAK},
@@ -293,7 +293,7 @@ static std::unordered_map<std::string, TokenType> keywords = {
 
 };
 
-static std::unordered_map<std::string, TokenType> symbols = {
+static const std::unordered_map<std::string, TokenType> symbols = {
 
     {">>=", TokenType::GREATER_GREATER_EQUAL},
     {"<<=", TokenType::LESS_LESS_EQUAL},
@@ -361,17 +361,30 @@ bool check_inRstring(string &token) {
     }
     return 1;
 }
-vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter) {
-    bool in_string = 0;
-    bool in_string2 = 0;
-    size_t in_rstring = 0;
-    bool trans = 0;
-    size_t i = 0;
-    string token = "";
-    Token new_token;
-    vector<Token> result;
+Lexer::Lexer(const Prog &program, ErrorReporter &error_reporter)
+    : program_(program), error_reporter_(error_reporter) {}
+
+/**
+ * Scan up to the end of the next token.
+ *
+ * The scanning state (position, pending token text, string flags) lives in
+ * the lexer between calls; the names below alias it.
+ *
+ * @param new_token Receives the token
+ * @return false at the end of the program
+ */
+bool Lexer::next(Token &new_token) {
+    const Prog &program = program_;
+    ErrorReporter &error_reporter = error_reporter_;
+    bool &in_string = in_string_;
+    bool &in_string2 = in_string2_;
+    size_t &in_rstring = in_rstring_;
+    bool &trans = trans_;
+    size_t &i = pos_;
+    string &token = text_;
 
     while (i < program.content.size()) {
+        bool produced = false;
         char ch = program.content[i];
         char next_ch = (i + 1 < program.content.size()) ? program.content[i + 1] : '\0';
 
@@ -400,7 +413,7 @@ vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter)
                     new_token.type = TokenType::RCSTRING;
                 else
                     new_token.type = TokenType::RSTRING;
-                result.push_back(new_token);
+                produced = true;
                 token = "";
             }
             i++;
@@ -421,7 +434,7 @@ vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter)
                 new_token.lexeme = token;
                 new_token.line = program.positions[i].first;
                 new_token.column = program.positions[i].second;
-                result.push_back(new_token);
+                produced = true;
                 token = "";
             }
             i++;
@@ -438,7 +451,7 @@ vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter)
                 new_token.lexeme = token;
                 new_token.line = program.positions[i].first;
                 new_token.column = program.positions[i].second;
-                result.push_back(new_token);
+                produced = true;
 
                 token = "";
             }
@@ -685,7 +698,7 @@ vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter)
             new_token.line = program.positions[i].first;
             new_token.column = program.positions[i].second;
             i++;
-            result.push_back(new_token);
+            produced = true;
 
         } else if (!(ch >= '0' && ch <= '9') && !(ch >= 'A' && ch <= 'Z') &&
                    !(ch >= 'a' && ch <= 'z') && ch != '_' && ch != '#' && token.length() > 0) {
@@ -701,7 +714,7 @@ vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter)
             new_token.lexeme = token;
             new_token.line = program.positions[i - 1].first;
             new_token.column = program.positions[i - 1].second;
-            result.push_back(new_token);
+            produced = true;
 
             token = "";
         } else if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') ||
@@ -716,6 +729,9 @@ vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter)
             }
             i++;
         }
+        if (produced) {
+            return true;
+        }
     }
     if (token.length() > 0) {
         if (token[0] >= '0' && token[0] <= '9') {
@@ -730,9 +746,19 @@ vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter)
         new_token.lexeme = token;
         new_token.line = program.positions[i - 1].first;
         new_token.column = program.positions[i - 1].second;
-        result.push_back(new_token);
+        token = "";
+        return true;
     }
+    return false;
+}
 
+vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter) {
+    Lexer lexer(program, error_reporter);
+    vector<Token> result;
+    Token token;
+    while (lexer.next(token)) {
+        result.push_back(std::move(token));
+    }
     return result;
 }
 
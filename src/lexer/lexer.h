@@ -141,6 +141,46 @@ struct Token {
     void print() const;
 };
 
+/**
+ * Lexer - Produces the tokens of a preprocessed program on demand
+ *
+ * Each call to next() scans just far enough to produce one token, so a
+ * parser can consume tokens as they are lexed instead of waiting for the
+ * whole sequence (see Parser(Lexer &, ErrorReporter &)).
+ *
+ * Example:
+ *   Lexer lexer(program, error_reporter);
+ *   Token token;
+ *   while (lexer.next(token)) {
+ *       token.print();
+ *   }
+ */
+class Lexer {
+  public:
+    /**
+     * @param program Preprocessed program, must outlive the lexer
+     * @param error_reporter Receives unrecognized characters
+     */
+    Lexer(const Prog &program, ErrorReporter &error_reporter);
+
+    /**
+     * Lex the next token
+     * @return false once the program is exhausted
+     */
+    bool next(Token &token);
+
+  private:
+    const Prog &program_;
+    ErrorReporter &error_reporter_;
+    size_t pos_ = 0;
+    string text_;  // Pending token text
+    bool in_string_ = false;
+    bool in_string2_ = false;
+    size_t in_rstring_ = 0;
+    bool trans_ = false;
+};
+
+// Lex a whole program at once
 vector<Token> lexer_program(const Prog &program, ErrorReporter &error_reporter);
 
 void print_lexer_result(const vector<Token> &tokens);
\ No newline at end of file
@@ -1,63 +1,543 @@
-#include "ir/ir_generator.h"
-#include "lexer/lexer.h"
-#include "parser/parser.h"
-#include "pre_processor/pre_processor.h"
-#include "semantic/semantic.h"
+#include "backend/ir_interpreter.h"
+#include "backend/ir_parser.h"
+#include "compiler/compile_cache.h"
+#include "compiler/compiler.h"
+#include "tool/fd_writer.h"
+#include "tool/thread_pool.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
 
-int main() {
+namespace {
 
-    Prog program = read_program();
-    //std::cerr << "--- Source Code ---" << std::endl;
-    //print_program(program.content);
-    //std::cerr << "\n";
+/**
+ * The diagnostics of a compilation as printed to stderr, one per line
+ */
+std::string format_diagnostics(const CompileResult &result) {
+    std::string text;
+    for (const auto &diagnostic : result.diagnostics) {
+        text += diagnostic.to_string() + "\n";
+    }
+    return text;
+}
+
+/**
+ * Print the diagnostics of a compilation to stderr
+ */
+void print_diagnostics(const CompileResult &result) {
+    std::cerr << format_diagnostics(result) << std::flush;
+}
+
+/**
+ * What the compiler prints for a program: IR is followed by a newline
+ */
+void finish_output(std::string &output, const CompileOptions &options) {
+    if (options.emit == CompileOptions::Emit::LLVM) {
+        output += "\n";
+    }
+}
+
+/**
+ * Parse a non-negative decimal count
+ * @return false if text is not one
+ */
+bool parse_count(const std::string &text, size_t &count) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        count = std::stoull(text);
+    } catch (const std::out_of_range &) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Source files of a batch: the *.rs files of a directory (sorted by name),
+ * or the paths listed in a manifest, one per line. Relative manifest paths
+ * are relative to the manifest; blank lines and lines starting with '#'
+ * are skipped.
+ * @return false if the input cannot be read
+ */
+bool collect_batch_sources(const std::filesystem::path &input,
+                           std::vector<std::filesystem::path> &sources) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    if (fs::is_directory(input, error)) {
+        for (const auto &entry : fs::directory_iterator(input, error)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".rs") {
+                sources.push_back(entry.path());
+            }
+        }
+        std::sort(sources.begin(), sources.end());
+        return !error;
+    }
 
-    ErrorReporter lexer_error_reporter;
-    vector<Token> tokens = lexer_program(program, lexer_error_reporter);
-    //std::cerr << "--- Lexer Result ---" << std::endl;
-    if (lexer_error_reporter.has_errors()) {
-        //std::cerr << "Lexer completed with errors." << std::endl;
+    std::ifstream manifest(input);
+    if (!manifest) {
+        return false;
+    }
+    for (std::string line; std::getline(manifest, line);) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        fs::path source(line);
+        sources.push_back(source.is_relative() ? input.parent_path() / source : source);
+    }
+    return true;
+}
+
+/**
+ * Read the sources of a batch
+ * @return false (after printing why) if the batch cannot be compiled
+ */
+bool read_batch(const std::string &input, std::vector<std::filesystem::path> &sources,
+                std::vector<std::string> &texts) {
+    namespace fs = std::filesystem;
+    if (!collect_batch_sources(input, sources)) {
+        std::cerr << "Cannot read batch input: " << input << std::endl;
+        return false;
+    }
+    std::set<fs::path> stems;
+    for (const auto &source : sources) {
+        if (!stems.insert(source.stem()).second) {
+            std::cerr << "Batch input has two programs named " << source.stem() << std::endl;
+            return false;
+        }
+    }
+    for (const auto &source : sources) {
+        std::ifstream in(source, std::ios::binary);
+        if (!in) {
+            std::cerr << source.string() << ": cannot open" << std::endl;
+            return false;
+        }
+        std::ostringstream text;
+        text << in.rdbuf();
+        texts.push_back(text.str());
+    }
+    return true;
+}
+
+/**
+ * Compile many programs in this process, each to <out_dir>/<stem>.ll (or
+ * .s), then print the aggregate throughput to stderr.
+ *
+ * Process startup and the parser's rule tables are paid once per worker
+ * (one Compiler each); every program still gets its own symbol tables and
+ * generator. A program that fails to compile leaves no output file and
+ * does not stop the batch. Diagnostics and output files follow the input
+ * order whatever the number of jobs.
+ *
+ * @param jobs Number of worker threads, 0 for one per hardware thread
+ * @return 0 if every program compiled, 1 otherwise
+ */
+int run_batch(const std::string &input, const std::string &out_dir,
+              const CompileOptions &options, size_t jobs) {
+    namespace fs = std::filesystem;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<fs::path> sources;
+    std::vector<std::string> texts;
+    if (!read_batch(input, sources, texts)) {
+        return 1;
+    }
+    std::error_code error;
+    fs::create_directories(out_dir, error);
+    if (error) {
+        std::cerr << "Cannot create output directory: " << out_dir << std::endl;
         return 1;
     }
-    //print_lexer_result(tokens);
-    //std::cerr << "\n";
 
-    //std::cerr << "--- Parser Result (AST) ---" << std::endl;
-    ErrorReporter parser_error_reporter;
-    Parser parser(tokens, parser_error_reporter);
+    std::vector<std::string_view> views(texts.begin(), texts.end());
+    std::vector<CompileResult> results = compile_parallel(views, options, jobs);
 
-    std::shared_ptr<Program> ast = parser.parse();
+    size_t failed = 0;
+    uintmax_t source_bytes = 0;
+    uintmax_t output_bytes = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const fs::path &source = sources[i];
+        CompileResult &result = results[i];
+        source_bytes += texts[i].size();
+        print_diagnostics(result);
+        if (!result.ok) {
+            std::cerr << source.string() << ": compilation failed" << std::endl;
+            ++failed;
+            continue;
+        }
+        std::string &output = result.output;
+        finish_output(output, options);
 
-    if (ast && !parser_error_reporter.has_errors()) {
-        //ast->print(//std::cerr);
-        //std::cerr << "\n";
-    } else {
-        if (parser_error_reporter.has_errors()) {
-            //std::cerr << "Parsing failed with errors." << std::endl;
-            return 1;
+        fs::path target = fs::path(out_dir) / source.stem();
+        target += options.emit == CompileOptions::Emit::ASM ? ".s" : ".ll";
+        std::ofstream out(target, std::ios::binary);
+        if (!out.write(output.data(), static_cast<std::streamsize>(output.size()))) {
+            std::cerr << target.string() << ": cannot write" << std::endl;
+            ++failed;
+            continue;
+        }
+        output_bytes += output.size();
+    }
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double rate_seconds = std::max(seconds, 1e-9);
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3) << "batch: " << sources.size()
+           << " programs, " << failed << " failed, " << seconds << " s\n"
+           << std::setprecision(1) << "  " << sources.size() / rate_seconds
+           << " programs/s, " << source_bytes / 1e6 / rate_seconds << " MB/s source, "
+           << output_bytes / 1e6 / rate_seconds << " MB/s output\n";
+    std::cerr << report.str();
+    return failed == 0 ? 0 : 1;
+}
+
+/**
+ * Scaling benchmark: compile the batch in memory with 1, 2, 4, ... worker
+ * threads up to the hardware threads, and print programs/s and the speedup
+ * over one thread for each. Nothing is written; every run must produce the
+ * same output as the single-threaded one.
+ *
+ * @param rounds Times the whole batch is compiled per measurement
+ * @param max_threads Largest thread count, 0 for the hardware threads
+ * @return 0 if every run matched, 1 otherwise
+ */
+int run_scaling(const std::string &input, const CompileOptions &options, size_t rounds,
+                size_t max_threads) {
+    std::vector<std::filesystem::path> sources;
+    std::vector<std::string> texts;
+    if (!read_batch(input, sources, texts)) {
+        return 1;
+    }
+    std::vector<std::string_view> views;
+    for (size_t round = 0; round < rounds; ++round) {
+        views.insert(views.end(), texts.begin(), texts.end());
+    }
+
+    std::vector<size_t> thread_counts;
+    size_t hardware = ThreadPool::hardware_threads();
+    if (max_threads == 0) {
+        max_threads = hardware;
+    }
+    for (size_t threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::vector<CompileResult> reference;
+    double base_rate = 0;
+    bool same = true;
+    std::cerr << "scaling: " << views.size() << " compilations (" << sources.size()
+              << " programs x " << rounds << "), " << hardware << " hardware threads\n";
+    for (size_t threads : thread_counts) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<CompileResult> results = compile_parallel(views, options, threads);
+        double seconds = std::max(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+            1e-9);
+        double rate = views.size() / seconds;
+
+        if (reference.empty()) {
+            reference = std::move(results);
+            base_rate = rate;
+        } else {
+            for (size_t i = 0; i < results.size(); ++i) {
+                if (results[i].ok != reference[i].ok ||
+                    results[i].output != reference[i].output) {
+                    same = false;
+                }
+            }
+        }
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1) << "  " << std::setw(3) << threads
+             << " threads: " << std::setw(10) << rate << " programs/s, speedup "
+             << std::setprecision(2) << rate / base_rate << "x\n";
+        std::cerr << line.str();
+    }
+    if (!same) {
+        std::cerr << "scaling: output differs between thread counts" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // --emit=llvm (default): print LLVM IR, --emit=asm: print x86-64 assembly
+    // --run: interpret the program instead, reading its input from --input=<file>;
+    // --counts: then print dynamic instruction counts to stderr
+    // --instrument-blocks=<file>: count block executions, written to <file> when main returns
+    // --profile=<file>: use such counts for branch weights and hot/cold block layout
+    // --check-threads=N: type check function bodies on N threads (0 = one per hardware thread)
+    // --ir-threads=N: generate the IR of functions on N threads (0 = one per hardware thread)
+    // --batch=<dir|manifest> --out-dir=<dir>: compile many programs, one output file each;
+    // --jobs=N: on N threads (default 1, 0 = one per hardware thread)
+    // --batch=<dir|manifest> --scaling[=rounds]: time the batch on 1, 2, 4, ... threads,
+    // up to the hardware threads or --jobs=N
+    // --cache=<dir>: reuse the output of an identical earlier compilation (same source,
+    // options and compiler build); --cache-max-mb=N: bound of the cache (default 512);
+    // --cache-stats: print the cache's hit/miss counters and size instead of compiling
+    // --incremental=<dir>: keep the IR of each function in <dir> and regenerate only
+    // functions that changed since the last compilation of the program;
+    // --incremental-stats: then print how many functions were reused and generated
+    CompileOptions options;
+    bool run = false;
+    bool print_counts = false;
+    std::string input_path;
+    std::string profile_path;
+    std::string batch_input;
+    std::string out_dir;
+    size_t jobs = 1;
+    bool jobs_given = false;
+    size_t scaling_rounds = 0;
+    std::string cache_dir;
+    size_t cache_max_mb = 512;
+    bool cache_stats = false;
+    bool incremental_stats = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--emit=asm") {
+            options.emit = CompileOptions::Emit::ASM;
+        } else if (arg == "--emit=llvm") {
+            options.emit = CompileOptions::Emit::LLVM;
+        } else if (arg == "--run") {
+            run = true;
+        } else if (arg == "--counts") {
+            print_counts = true;
+        } else if (arg.rfind("--input=", 0) == 0) {
+            input_path = arg.substr(8);
+        } else if (arg.rfind("--instrument-blocks=", 0) == 0) {
+            options.block_counters.output_path = arg.substr(20);
+        } else if (arg.rfind("--profile=", 0) == 0) {
+            profile_path = arg.substr(10);
+        } else if (arg.rfind("--check-threads=", 0) == 0) {
+            if (!parse_count(arg.substr(16), options.check_threads)) {
+                std::cerr << "Invalid thread count: " << arg << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--ir-threads=", 0) == 0) {
+            if (!parse_count(arg.substr(13), options.ir_threads)) {
+                std::cerr << "Invalid thread count: " << arg << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            batch_input = arg.substr(8);
+        } else if (arg.rfind("--out-dir=", 0) == 0) {
+            out_dir = arg.substr(10);
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            if (!parse_count(arg.substr(7), jobs)) {
+                std::cerr << "Invalid job count: " << arg << std::endl;
+                return 1;
+            }
+            jobs_given = true;
+        } else if (arg == "--scaling") {
+            scaling_rounds = 1;
+        } else if (arg.rfind("--scaling=", 0) == 0) {
+            if (!parse_count(arg.substr(10), scaling_rounds) || scaling_rounds == 0) {
+                std::cerr << "Invalid round count: " << arg << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--cache=", 0) == 0) {
+            cache_dir = arg.substr(8);
+        } else if (arg.rfind("--cache-max-mb=", 0) == 0) {
+            if (!parse_count(arg.substr(15), cache_max_mb)) {
+                std::cerr << "Invalid cache size: " << arg << std::endl;
+                return 1;
+            }
+        } else if (arg == "--cache-stats") {
+            cache_stats = true;
+        } else if (arg.rfind("--incremental=", 0) == 0) {
+            options.incremental_dir = arg.substr(14);
+        } else if (arg == "--incremental-stats") {
+            incremental_stats = true;
         } else {
-            //std::cerr << "Parsing produced a null AST without errors." << std::endl;
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
         }
     }
 
-    // Test semantic analysis
-    //std::cerr << "--- Semantic Analysis ---" << std::endl;
-    ErrorReporter error_reporter;
-    Semantic(ast, error_reporter);
-    if (error_reporter.has_errors()) {
-        //std::cerr << "Semantic analysis completed with errors." << std::endl;
+    if (cache_dir.empty() && cache_stats) {
+        std::cerr << "--cache-stats requires --cache" << std::endl;
+        return 1;
+    }
+    if (options.incremental_dir.empty() && incremental_stats) {
+        std::cerr << "--incremental-stats requires --incremental" << std::endl;
         return 1;
+    }
+    if (cache_stats) {
+        CompileCache::Stats stats = CompileCache(cache_dir, 0).stats();
+        uint64_t lookups = stats.hits + stats.misses;
+        std::cerr << "cache: " << stats.hits << " hits, " << stats.misses << " misses";
+        if (lookups > 0) {
+            std::cerr << " (" << std::fixed << std::setprecision(1)
+                      << 100.0 * static_cast<double>(stats.hits) / static_cast<double>(lookups)
+                      << "% hit rate)";
+        }
+        std::cerr << ", " << stats.stores << " stores, " << stats.evictions << " evictions; "
+                  << stats.entries << " entries, " << stats.bytes << " bytes" << std::endl;
+        return 0;
+    }
+
+    if (!batch_input.empty()) {
+        // Counters and profiles are per program, so they do not apply to a batch
+        if (run || !options.block_counters.output_path.empty() || !profile_path.empty() ||
+            !cache_dir.empty() || !options.incremental_dir.empty()) {
+            std::cerr << "--batch only supports --emit, --out-dir, --jobs and --scaling"
+                      << std::endl;
+            return 1;
+        }
+        if (scaling_rounds > 0) {
+            return run_scaling(batch_input, options, scaling_rounds, jobs_given ? jobs : 0);
+        }
+        if (out_dir.empty()) {
+            std::cerr << "--batch requires --out-dir" << std::endl;
+            return 1;
+        }
+        return run_batch(batch_input, out_dir, options, jobs);
+    }
+    if (scaling_rounds > 0) {
+        std::cerr << "--scaling requires --batch" << std::endl;
+        return 1;
+    }
+    if (run && !cache_dir.empty()) {
+        std::cerr << "--cache does not apply to --run" << std::endl;
+        return 1;
+    }
+
+    BlockProfile profile;
+    std::string profile_text; // Part of the cache key
+    if (!profile_path.empty()) {
+        std::ifstream profile_file(profile_path);
+        std::string error;
+        if (!profile_file) {
+            std::cerr << "Cannot open profile: " << profile_path << std::endl;
+            return 1;
+        }
+        std::ostringstream profile_stream;
+        profile_stream << profile_file.rdbuf();
+        profile_text = profile_stream.str();
+        std::istringstream profile_in(profile_text);
+        if (!profile.load(profile_in, error)) {
+            std::cerr << "Invalid profile " << profile_path << ": " << error << std::endl;
+            return 1;
+        }
+        options.profile = &profile;
+    }
+
+    // The source comes from stdin
+    std::string source;
+    {
+        std::ostringstream source_stream;
+        source_stream << std::cin.rdbuf();
+        source = std::move(source_stream).str();
+    }
+    if (run) {
+        options.emit = CompileOptions::Emit::LLVM;
+    }
+
+    // A hit prints what the identical compilation printed and skips every phase
+    std::unique_ptr<CompileCache> cache;
+    std::string cache_key;
+    if (!cache_dir.empty()) {
+        cache = std::make_unique<CompileCache>(cache_dir, uint64_t(cache_max_mb) << 20);
+        cache_key = CompileCache::key(source, options, profile_text);
+        int exit_code = 0;
+        if (cache->lookup(cache_key, exit_code, std::cerr, std::cout)) {
+            std::cerr << std::flush;
+            std::cout << std::flush;
+            return exit_code;
+        }
+    }
+
+    // LLVM IR goes to stdout as it is generated instead of being held whole:
+    // each function is written straight from the generator's buffer, large
+    // ones without passing through another buffer. Only the cache needs a copy
+    bool stream = !run && options.emit == CompileOptions::Emit::LLVM;
+    FdWriter stdout_writer(STDOUT_FILENO);
+    std::string streamed;
+    CompileResult result;
+    // Each diagnostic is printed as soon as it is found, so the ones found
+    // before a crash in a later phase are not lost
+    options.on_diagnostic = [](const Diagnostic &diagnostic) {
+        std::cerr << diagnostic.to_string() << std::endl;
+    };
+    if (stream) {
+        result = compile(source, options, [&](std::string_view text) {
+            stdout_writer.write(text);
+            if (cache) {
+                streamed.append(text);
+            }
+        });
     } else {
-        //std::cerr << "Semantic analysis completed successfully." << std::endl;
+        result = compile(source, options);
+    }
+    std::string diagnostics = format_diagnostics(result);
+    if (incremental_stats && result.ok) {
+        std::cerr << "incremental: " << result.reused_units << " functions reused, "
+                  << result.generated_units << " generated" << std::endl;
+    }
+    std::cerr << std::flush;
+    if (!result.ok) {
+        if (cache) {
+            cache->store(cache_key, 1, diagnostics, "");
+        }
+        return 1;
     }
 
-    // IR Generation
-    //std::cerr << "\n--- IR Generation ---" << std::endl;
-    BuiltinTypes builtin_types;
-    IRGenerator ir_gen(builtin_types);
-    std::string llvm_ir = ir_gen.generate(ast.get());
-    std::cout << llvm_ir << std::endl;
+    if (run) {
+        // The source already consumed stdin, so program input comes from a file
+        std::ifstream input_file;
+        std::istringstream no_input;
+        if (!input_path.empty()) {
+            input_file.open(input_path);
+            if (!input_file) {
+                std::cerr << "Cannot open input file: " << input_path << std::endl;
+                return 1;
+            }
+        }
+        std::istream &input = input_path.empty() ? static_cast<std::istream &>(no_input)
+                                                 : input_file;
+
+        ErrorReporter interpreter_error_reporter;
+        IRModule module;
+        if (!IRParser(interpreter_error_reporter).parse(result.output, module)) {
+            return 1;
+        }
+        IRInterpreter interpreter(module, interpreter_error_reporter);
+        int exit_code = 0;
+        bool ok = interpreter.run(input, std::cout, exit_code);
+        if (print_counts) {
+            interpreter.counts().print(std::cerr);
+        }
+        return ok ? exit_code : 1;
+    }
 
+    std::string &output = stream ? streamed : result.output;
+    if (stream) {
+        stdout_writer.write("\n");
+        output += "\n";
+        if (!stdout_writer.flush()) {
+            std::cerr << "Error: cannot write output" << std::endl;
+            return 1;
+        }
+    } else {
+        finish_output(output, options);
+        std::cout << output;
+    }
+    std::cout << std::flush;
+    if (cache) {
+        cache->store(cache_key, 0, diagnostics, output);
+    }
     return 0;
-}
\ No newline at end of file
+}
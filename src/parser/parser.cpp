@@ -1,6 +1,7 @@
 // parser.cpp
 #include "parser.h"
 
+#include <cassert>
 #include <iostream>
 #include <memory>
 
@@ -8,7 +9,17 @@ using std::string;
 using std::vector;
 
 Parser::Parser(const std::vector<Token> &tokens, ErrorReporter &error_reporter)
-    : tokens_(tokens), error_reporter_(error_reporter) {
+    : error_reporter_(&error_reporter) {
+    register_rules();
+    reset(tokens, error_reporter);
+}
+
+Parser::Parser(Lexer &lexer, ErrorReporter &error_reporter) : error_reporter_(&error_reporter) {
+    register_rules();
+    reset(lexer, error_reporter);
+}
+
+void Parser::register_rules() {
     // Register Pratt parser rules
 
     // Register prefix parsing functions
@@ -316,6 +327,24 @@ Parser::Parser(const std::vector<Token> &tokens, ErrorReporter &error_reporter)
     });
 }
 
+// Point the parser at another program, keeping the rule tables
+void Parser::reset(const std::vector<Token> &tokens, ErrorReporter &error_reporter) {
+    tokens_ = &tokens;
+    lexer_ = nullptr;
+    error_reporter_ = &error_reporter;
+    current_ = 0;
+}
+
+void Parser::reset(Lexer &lexer, ErrorReporter &error_reporter) {
+    tokens_ = nullptr;
+    lexer_ = &lexer;
+    error_reporter_ = &error_reporter;
+    current_ = 0;
+    lexed_ = 0;
+    lexer_done_ = false;
+    rest_.clear();
+}
+
 // Main parsing loop
 std::shared_ptr<Program> Parser::parse() {
     auto program = std::make_shared<Program>();
@@ -481,29 +510,38 @@ std::shared_ptr<Pattern> Parser::parse_struct_pattern_body(std::shared_ptr<Expr>
 
 // Recursive descent implementation
 std::shared_ptr<Item> Parser::parse_item() {
+    size_t begin = current_;
+    std::shared_ptr<Item> item;
 
     if (peek().type == TokenType::FN) {
-        return parse_fn_declaration();
+        item = parse_fn_declaration();
     } else if (peek().type == TokenType::STRUCT) {
-        return parse_struct_declaration();
+        item = parse_struct_declaration();
     } else if (peek().type == TokenType::CONST) {
-        return parse_const_declaration();
+        item = parse_const_declaration();
     } else if (peek().type == TokenType::ENUM) {
-        return parse_enum_declaration();
+        item = parse_enum_declaration();
     } else if (peek().type == TokenType::MOD) {
-        return parse_mod_declaration();
+        item = parse_mod_declaration();
     } else if (peek().type == TokenType::TRAIT) {
-        return parse_trait_declaration();
+        item = parse_trait_declaration();
     } else if (peek().type == TokenType::IMPL) {
-        return parse_impl_block();
+        item = parse_impl_block();
+    } else {
+        report_error(peek(), "Expect a top-level item like 'fn'.");
+        advance();
+        return nullptr;
     }
 
-    report_error(peek(), "Expect a top-level item like 'fn'.");
-    advance();
-    return nullptr;
+    if (item) {
+        item->token_begin = begin;
+        item->token_end = current_;
+    }
+    return item;
 }
 
 std::shared_ptr<FnDecl> Parser::parse_fn_declaration() {
+    size_t begin = current_;
     consume(TokenType::FN, "Expect 'fn'.");
     Token name = consume(TokenType::IDENTIFIER, "Expect function name.");
     consume(TokenType::LEFT_PAREN, "Expect '(' after function name.");
@@ -562,6 +600,7 @@ std::shared_ptr<FnDecl> Parser::parse_fn_declaration() {
     }
 
     std::optional<std::shared_ptr<BlockStmt>> body;
+    size_t body_begin = current_;
     if (peek().type == TokenType::LEFT_BRACE) {
         body = parse_block_statement();
     } else if (match({TokenType::SEMICOLON})) {
@@ -571,8 +610,12 @@ std::shared_ptr<FnDecl> Parser::parse_fn_declaration() {
         return nullptr;
     }
 
-    return std::make_shared<FnDecl>(name, std::move(params), std::move(return_type),
-                                    std::move(body));
+    auto decl = std::make_shared<FnDecl>(name, std::move(params), std::move(return_type),
+                                         std::move(body));
+    decl->token_begin = begin;
+    decl->body_token_begin = decl->body ? body_begin : current_;
+    decl->token_end = current_;
+    return decl;
 }
 
 std::shared_ptr<StructDecl> Parser::parse_struct_declaration() {
@@ -726,7 +769,7 @@ std::shared_ptr<ModDecl> Parser::parse_mod_declaration() {
 std::shared_ptr<TraitDecl> Parser::parse_trait_declaration() {
     consume(TokenType::TRAIT, "Expect 'trait' keyword.");
 
-    error_reporter_.report_error("Trait is not supported now.");
+    error_reporter_->report_error("Trait is not supported now.");
     return nullptr;
 
     Token name = consume(TokenType::IDENTIFIER, "Expect trait name.");
@@ -1076,18 +1119,46 @@ std::shared_ptr<Expr> Parser::parse_path_expression() {
 }
 
 // tools
-bool Parser::is_at_end() {
-    return current_ >= tokens_.size() || peek().type == TokenType::END_OF_FILE;
+const Token &Parser::token_at(size_t index) {
+    if (tokens_) {
+        return index < tokens_->size() ? (*tokens_)[index] : end_token_;
+    }
+    // Pull tokens until index is lexed; a slot is reused TOKEN_WINDOW tokens later
+    while (lexed_ <= index && !lexer_done_) {
+        if (lexer_->next(window_[lexed_ % TOKEN_WINDOW])) {
+            ++lexed_;
+        } else {
+            lexer_done_ = true;
+        }
+    }
+    if (index < lexed_) {
+        // An older token's slot has been overwritten by a newer one
+        assert(index + TOKEN_WINDOW >= lexed_);
+        return window_[index % TOKEN_WINDOW];
+    }
+    return index - lexed_ < rest_.size() ? rest_[index - lexed_] : end_token_;
+}
+// Lex the remaining tokens into rest_, so all lexer errors are reported
+void Parser::lex_rest() {
+    Token token;
+    while (!lexer_done_) {
+        if (lexer_->next(token)) {
+            rest_.push_back(std::move(token));
+        } else {
+            lexer_done_ = true;
+        }
+    }
 }
-const Token &Parser::peek() { return tokens_[current_]; }
+bool Parser::is_at_end() { return peek().type == TokenType::END_OF_FILE; }
+const Token &Parser::peek() { return token_at(current_); }
 const Token &Parser::peekNext() {
     if (is_at_end()) {
-        static Token unknown_token{TokenType::UNKNOWN, "nullptr", 0, 0};
+        static const Token unknown_token{TokenType::UNKNOWN, "nullptr", 0, 0};
         return unknown_token;
     }
-    return tokens_[current_ + 1];
+    return token_at(current_ + 1);
 }
-const Token &Parser::previous() { return tokens_[current_ - 1]; }
+const Token &Parser::previous() { return token_at(current_ - 1); }
 const Token &Parser::advance() {
     if (!is_at_end())
         current_++;
@@ -1127,7 +1198,13 @@ const Token &Parser::consume(TokenType type, const std::string &error_message) {
     return peek(); // Return current token to avoid crash
 }
 void Parser::report_error(const Token &token, const std::string &message) {
-    error_reporter_.report_error(message, token.line, token.column);
+    // A parse error reached while streaming is reported once the lexer has
+    // reported everything, so the caller knows whether the program has
+    // lexer errors when it sees the first parse error
+    if (lexer_) {
+        lex_rest();
+    }
+    error_reporter_->report_error(message, token.line, token.column);
 }
 void Parser::synchronize() {
     advance();
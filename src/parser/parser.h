@@ -4,6 +4,7 @@
 #include "../ast/ast.h"
 #include "../error/error.h"
 
+#include <array>
 #include <functional>
 #include <map>
 #include <vector>
@@ -31,14 +32,38 @@ enum Precedence {
 class Parser {
   public:
     explicit Parser(const std::vector<Token> &tokens, ErrorReporter &error_reporter);
+
+    // Parse tokens as lexer produces them, keeping only the last TOKEN_WINDOW
+    explicit Parser(Lexer &lexer, ErrorReporter &error_reporter);
+
     std::shared_ptr<Program> parse();
 
+    // Parse another token stream with the same rule tables (batch compilation)
+    void reset(const std::vector<Token> &tokens, ErrorReporter &error_reporter);
+    void reset(Lexer &lexer, ErrorReporter &error_reporter);
+
+    // Tokens of a lexer kept for lookahead and backtracking; the parser
+    // looks at most one token ahead and two behind the current one
+    static constexpr size_t TOKEN_WINDOW = 8;
+
   private:
-    // State
-    const std::vector<Token> &tokens_;
-    ErrorReporter &error_reporter_;
+    // State: tokens come from tokens_ or, pulled on demand, from lexer_
+    const std::vector<Token> *tokens_ = nullptr;
+    Lexer *lexer_ = nullptr;
+    ErrorReporter *error_reporter_;
     size_t current_ = 0;
 
+    // Ring buffer of lexer tokens [lexed_ - TOKEN_WINDOW, lexed_), token i
+    // at window_[i % TOKEN_WINDOW]
+    std::array<Token, TOKEN_WINDOW> window_;
+    size_t lexed_ = 0;
+    bool lexer_done_ = false;
+    // Tokens lexed_, lexed_ + 1, ... once the rest of the program was lexed
+    // at the first parse error (see lex_rest)
+    std::vector<Token> rest_;
+    // Returned past the last token
+    const Token end_token_{TokenType::END_OF_FILE, "", 0, 0};
+
     // Pratt parser required types
     using PrefixParseFn = std::function<std::shared_ptr<Expr>()>;
     using InfixParseFn = std::function<std::shared_ptr<Expr>(std::shared_ptr<Expr>)>;
@@ -51,7 +76,13 @@ class Parser {
     void register_prefix(TokenType type, PrefixParseFn fn);
     void register_infix(TokenType type, Precedence prec, InfixParseFn fn);
 
+    void register_rules();
+
     // Utility functions
+    // When streaming, the returned reference is valid only until the next
+    // token_at call, which may reuse its window slot; copy tokens kept longer
+    const Token &token_at(size_t index);
+    void lex_rest();
     bool is_at_end();
     const Token &peek();
     const Token &peekNext();
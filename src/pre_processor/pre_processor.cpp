@@ -1,6 +1,8 @@
 #include "pre_processor.h"
 
-Prog read_program() {
+Prog read_program() { return read_program(std::cin); }
+
+Prog read_program(std::istream &in) {
     string line;
     Prog program;
     program.content = "";
@@ -8,7 +10,7 @@ Prog read_program() {
     bool in_string = 0, in_string2 = 0;
     bool trans = 0;
     int line_num = 0;
-    while (std::getline(std::cin, line)) {
+    while (std::getline(in, line)) {
         string processed_line = "";
         size_t i = 0;
         line_num++;
@@ -15,7 +15,8 @@ struct Prog {
     vector<pair<int, int>> positions; // Store the positions of the comments
 };
 
-Prog read_program();
+Prog read_program(std::istream &in);
+Prog read_program(); // From std::cin
 
 // Print Program in the pre-processor.
 void print_program(const string &program);
\ No newline at end of file
@@ -323,10 +323,15 @@ bool is_any_integer_type(TypeKind kind) {
 }
 
 void Semantic(std::shared_ptr<Program> &ast, ErrorReporter &error_reporter) {
+    BuiltinTypes builtins;
+    Semantic(ast, error_reporter, builtins);
+}
+
+void Semantic(std::shared_ptr<Program> &ast, ErrorReporter &error_reporter,
+              BuiltinTypes &builtins, size_t threads) {
 
     NameResolutionVisitor name_resolver(error_reporter);
     SymbolTable &symbol_table = name_resolver.get_global_symbol_table();
-    BuiltinTypes builtins;
 
     define_builtin_functions(symbol_table, builtins);
     define_builtin_method(symbol_table, builtins);
@@ -342,11 +347,7 @@ void Semantic(std::shared_ptr<Program> &ast, ErrorReporter &error_reporter) {
         // std::cerr << "Name resolution completed successfully." << std::endl;
     }
 
-    TypeCheckVisitor type_checker(symbol_table, builtins, error_reporter);
-
-    for (auto &item : ast->items) {
-        item->accept(&type_checker);
-    }
+    type_check_program(ast.get(), symbol_table, builtins, error_reporter, threads);
     if (error_reporter.has_errors()) {
         // std::cerr << "Type checking completed with errors." << std::endl;
         return;
@@ -582,6 +582,9 @@ class TypeCheckVisitor : public ExprVisitor<std::shared_ptr<Symbol>>,
     void visit(TraitDecl *node) override;
     void visit(ImplBlock *node) override;
 
+    // Trait name and target type of an impl block, without its items
+    void visit_impl_header(ImplBlock *node);
+
     // Pattern visitors
     void visit(IdentifierPattern *node) override;
     void visit(WildcardPattern *node) override;
@@ -604,6 +607,22 @@ class TypeCheckVisitor : public ExprVisitor<std::shared_ptr<Symbol>>,
     void check_main_for_early_exit(BlockStmt *body);
 };
 
+/**
+ * Type check every item of a program, after name resolution.
+ *
+ * Each top-level function and each impl method is a unit checked by its own
+ * TypeCheckVisitor, on `threads` threads (0 for one per hardware thread);
+ * the other items are checked first, on the calling thread. Units collect
+ * their diagnostics, which are then reported in source order, so the result
+ * is the same for any number of threads.
+ */
+void type_check_program(Program *program, SymbolTable &symbol_table, BuiltinTypes &builtins,
+                        ErrorReporter &error_reporter, size_t threads = 1);
+
 void Semantic(std::shared_ptr<Program> &ast, ErrorReporter &error_reporter);
+// Fill builtins with this compilation's primitive types, so later phases share them;
+// threads: type checking threads, see type_check_program
+void Semantic(std::shared_ptr<Program> &ast, ErrorReporter &error_reporter,
+              BuiltinTypes &builtins, size_t threads = 1);
 
 std::optional<std::string> get_name_from_expr(Expr *expr);
\ No newline at end of file
@@ -1097,7 +1097,10 @@ std::shared_ptr<Symbol> TypeCheckVisitor::visit(StructInitializerExpr *node) {
         field_init->value->accept(this);
         auto actual_value_type = field_init->value->type;
 
-        auto expected_field_type = struct_type->fields[field_init->name.lexeme];
+        // find, not operator[]: the struct type is shared with other function bodies
+        auto field_it = struct_type->fields.find(field_init->name.lexeme);
+        auto expected_field_type =
+            field_it != struct_type->fields.end() ? field_it->second : nullptr;
 
         if (actual_value_type && expected_field_type &&
             !is_compatible(actual_value_type.get(), expected_field_type.get())) {
@@ -1253,14 +1256,18 @@ void TypeCheckVisitor::visit(TraitDecl *node) {
 }
 
 void TypeCheckVisitor::visit(ImplBlock *node) {
-    if (node->trait_name)
-        (*node->trait_name)->accept(this);
-    node->target_type->accept(this);
+    visit_impl_header(node);
     for (auto &item : node->implemented_items) {
         item->accept(this);
     }
 }
 
+void TypeCheckVisitor::visit_impl_header(ImplBlock *node) {
+    if (node->trait_name)
+        (*node->trait_name)->accept(this);
+    node->target_type->accept(this);
+}
+
 void TypeCheckVisitor::check_main_for_early_exit(BlockStmt *body) {
     if (!body || body->statements.empty()) {
         return;
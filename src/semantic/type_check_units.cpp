@@ -0,0 +1,131 @@
+#include "../tool/thread_pool.h"
+#include "semantic.h"
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * Part of a program checked by one TypeCheckVisitor
+ *
+ * ITEM: a whole top-level item
+ * IMPL_HEADER: trait name and target type of an impl block
+ * METHOD: one method of an impl block
+ */
+struct TypeCheckUnit {
+    enum class Kind { ITEM, IMPL_HEADER, METHOD };
+
+    Kind kind = Kind::ITEM;
+    Item *item = nullptr;
+    FnDecl *method = nullptr;
+    std::vector<Diagnostic> diagnostics;
+
+    // Function bodies only read global symbols and annotate their own subtree
+    bool is_body() const {
+        return kind == Kind::METHOD || (kind == Kind::ITEM && dynamic_cast<FnDecl *>(item));
+    }
+};
+
+/**
+ * Split a program into units, in the order the serial checker visits them
+ */
+std::vector<TypeCheckUnit> collect_units(Program *program) {
+    std::vector<TypeCheckUnit> units;
+    for (const auto &item : program->items) {
+        auto impl_block = dynamic_cast<ImplBlock *>(item.get());
+        if (!impl_block) {
+            units.push_back({TypeCheckUnit::Kind::ITEM, item.get(), nullptr, {}});
+            continue;
+        }
+        units.push_back({TypeCheckUnit::Kind::IMPL_HEADER, item.get(), nullptr, {}});
+        for (const auto &impl_item : impl_block->implemented_items) {
+            if (auto fn_decl = dynamic_cast<FnDecl *>(impl_item.get())) {
+                units.push_back({TypeCheckUnit::Kind::METHOD, item.get(), fn_decl, {}});
+            } else {
+                units.push_back({TypeCheckUnit::Kind::ITEM, impl_item.get(), nullptr, {}});
+            }
+        }
+    }
+    return units;
+}
+
+/**
+ * Check one unit with a fresh visitor, collecting its diagnostics
+ */
+void check_unit(TypeCheckUnit &unit, SymbolTable &symbol_table, BuiltinTypes &builtins) {
+    ErrorReporter error_reporter(unit.diagnostics);
+    TypeCheckVisitor checker(symbol_table, builtins, error_reporter);
+    switch (unit.kind) {
+    case TypeCheckUnit::Kind::ITEM:
+        unit.item->accept(&checker);
+        break;
+    case TypeCheckUnit::Kind::IMPL_HEADER:
+        checker.visit_impl_header(static_cast<ImplBlock *>(unit.item));
+        break;
+    case TypeCheckUnit::Kind::METHOD:
+        unit.method->accept(&checker);
+        break;
+    }
+}
+
+} // namespace
+
+/**
+ * Type check a program.
+ *
+ * The checker never enters a scope of the symbol table (name resolution has
+ * already bound every name in the AST), so the table is only read; the state
+ * a body needs (return type, loop depth, break types) lives in its own
+ * visitor. Items other than function bodies run first on the calling thread:
+ * const values checked there are then read, never written, by bodies that
+ * evaluate them.
+ *
+ * With one thread the bodies are checked in order on the calling thread;
+ * otherwise a work-stealing ThreadPool takes them.
+ *
+ * @param program The program AST root node
+ * @param symbol_table Global symbol table left by name resolution
+ * @param builtins Primitive types of this compilation
+ * @param error_reporter Receives the diagnostics of all units, in source order
+ * @param threads Threads checking bodies, 0 for one per hardware thread
+ */
+void type_check_program(Program *program, SymbolTable &symbol_table, BuiltinTypes &builtins,
+                        ErrorReporter &error_reporter, size_t threads) {
+    std::vector<TypeCheckUnit> units = collect_units(program);
+
+    std::vector<TypeCheckUnit *> bodies;
+    for (TypeCheckUnit &unit : units) {
+        if (unit.is_body()) {
+            bodies.push_back(&unit);
+        } else {
+            check_unit(unit, symbol_table, builtins);
+        }
+    }
+
+    threads = threads == 0 ? ThreadPool::hardware_threads() : threads;
+    threads = std::min(threads, bodies.size());
+    if (threads <= 1) {
+        for (TypeCheckUnit *unit : bodies) {
+            check_unit(*unit, symbol_table, builtins);
+        }
+    } else {
+        ThreadPool pool(threads);
+        for (TypeCheckUnit *unit : bodies) {
+            pool.submit([unit, &symbol_table, &builtins](size_t) {
+                check_unit(*unit, symbol_table, builtins);
+            });
+        }
+        pool.wait();
+    }
+
+    for (const TypeCheckUnit &unit : units) {
+        for (const Diagnostic &diagnostic : unit.diagnostics) {
+            if (diagnostic.severity == Diagnostic::Severity::ERROR) {
+                error_reporter.report_error(diagnostic.message, diagnostic.line, diagnostic.column);
+            } else {
+                error_reporter.report_warning(diagnostic.message, diagnostic.line,
+                                              diagnostic.column);
+            }
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#include "fd_writer.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+FdWriter::FdWriter(int fd, size_t buffer_size) : fd_(fd), capacity_(buffer_size) {
+    buffer_.reserve(capacity_);
+}
+
+FdWriter::~FdWriter() { flush(); }
+
+void FdWriter::write(std::string_view text) {
+    if (buffer_.size() + text.size() <= capacity_) {
+        buffer_.append(text);
+        return;
+    }
+    flush();
+    if (text.size() >= capacity_) {
+        write_all(text);
+    } else {
+        buffer_.append(text);
+    }
+}
+
+bool FdWriter::flush() {
+    if (!buffer_.empty()) {
+        write_all(buffer_);
+        buffer_.clear();
+    }
+    return ok_;
+}
+
+void FdWriter::write_all(std::string_view text) {
+    while (ok_ && !text.empty()) {
+        ssize_t written = ::write(fd_, text.data(), text.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok_ = false;
+            return;
+        }
+        text.remove_prefix(static_cast<size_t>(written));
+    }
+}
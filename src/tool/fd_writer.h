@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * FdWriter - Buffered writer on a file descriptor
+ *
+ * Small writes are gathered in a fixed buffer; a write at least as large as
+ * the buffer goes to the descriptor directly, without being copied. Used to
+ * stream large outputs (e.g., LLVM IR to stdout) as they are produced.
+ *
+ * Errors are sticky: after a failed write(2) nothing more is written and
+ * flush() returns false.
+ *
+ * Example:
+ *   FdWriter out(STDOUT_FILENO);
+ *   out.write(ir_piece);
+ *   if (!out.flush()) { ... }
+ */
+class FdWriter {
+  public:
+    /**
+     * @param fd Descriptor to write to, not closed by the writer
+     * @param buffer_size Bytes gathered before a write(2)
+     */
+    explicit FdWriter(int fd, size_t buffer_size = 64 * 1024);
+
+    /**
+     * Flushes the buffer
+     */
+    ~FdWriter();
+
+    FdWriter(const FdWriter &) = delete;
+    FdWriter &operator=(const FdWriter &) = delete;
+
+    void write(std::string_view text);
+
+    /**
+     * Write out the buffered bytes
+     * @return false if any write failed
+     */
+    bool flush();
+
+    bool ok() const { return ok_; }
+
+  private:
+    int fd_;
+    std::string buffer_;
+    size_t capacity_;
+    bool ok_ = true;
+
+    void write_all(std::string_view text);
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Sha256 - Incremental SHA-256 (FIPS 180-4)
+ *
+ * Used where a content hash must not collide in practice, e.g. the keys of
+ * the compile cache.
+ *
+ * Example:
+ *   Sha256 hash;
+ *   hash.update(source);
+ *   hash.update(options);
+ *   std::string key = hash.hex_digest(); // 64 lowercase hex digits
+ */
+class Sha256 {
+  public:
+    Sha256();
+
+    void update(std::string_view data);
+
+    /**
+     * Finish the hash; the object must not be updated afterwards
+     */
+    std::array<uint8_t, 32> digest();
+    std::string hex_digest();
+
+  private:
+    std::array<uint32_t, 8> state_;
+    std::array<uint8_t, 64> block_;
+    size_t block_size_ = 0;
+    uint64_t length_ = 0; // Bytes hashed so far
+
+    void compress(const uint8_t *block);
+};
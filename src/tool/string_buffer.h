@@ -0,0 +1,48 @@
+#pragma once
+
+#include <streambuf>
+#include <string>
+#include <utility>
+
+/**
+ * StringBuffer - Stream buffer appending to a std::string
+ *
+ * Does what std::stringbuf does for output, but the text can be read in
+ * place and moved out, where std::stringstream::str() always copies it.
+ *
+ * Example:
+ *   StringBuffer buffer;
+ *   std::ostream out(&buffer);
+ *   out << "define i32 @main() {\n";
+ *   std::string text = buffer.take(); // buffer is empty again
+ */
+class StringBuffer : public std::streambuf {
+  public:
+    const std::string &str() const { return text_; }
+
+    /**
+     * Move the text out, leaving the buffer empty
+     */
+    std::string take() { return std::exchange(text_, std::string()); }
+
+    /**
+     * Empty the buffer, keeping its capacity
+     */
+    void clear() { text_.clear(); }
+
+  protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            text_ += traits_type::to_char_type(ch);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *text, std::streamsize count) override {
+        text_.append(text, static_cast<size_t>(count));
+        return count;
+    }
+
+  private:
+    std::string text_;
+};
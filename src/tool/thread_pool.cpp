@@ -0,0 +1,101 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = hardware_threads();
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::run_worker, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::hardware_threads() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::submit(Task task) {
+    pending_.fetch_add(1);
+    {
+        Queue &queue = *queues_[next_queue_];
+        next_queue_ = (next_queue_ + 1) % queues_.size();
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queued_.fetch_add(1); // Before any worker can take the task
+    }
+    {
+        // A worker checks queued_ under mutex_, so it cannot miss this notify
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    work_available_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    all_done_.wait(lock, [this] { return pending_.load() == 0; });
+}
+
+bool ThreadPool::take(size_t worker, Task &task) {
+    // Own deque: newest first
+    {
+        Queue &own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // Steal: oldest first, starting at the next worker
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        Queue &victim = *queues_[(worker + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run_worker(size_t worker) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_available_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+            if (queued_.load() == 0) {
+                return; // Stopping with nothing left to run
+            }
+        }
+
+        Task task;
+        if (!take(worker, task)) {
+            // Another worker got there first
+            std::this_thread::yield();
+            continue;
+        }
+        queued_.fetch_sub(1);
+        task(worker);
+
+        if (pending_.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            all_done_.notify_all();
+        }
+    }
+}
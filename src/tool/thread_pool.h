@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool - Fixed set of worker threads with work stealing
+ *
+ * Core responsibilities:
+ * 1. Run submitted tasks on a fixed number of workers
+ * 2. Keep one deque per worker: submit deals tasks round-robin, a worker
+ *    takes from the back of its own deque and, when that is empty, steals
+ *    from the front of the others, so uneven task sizes still keep every
+ *    worker busy
+ * 3. Let the caller wait until every submitted task has finished
+ *
+ * A task receives the index of the worker running it (0 .. size() - 1), so
+ * it can use per-worker state without locking, e.g. one Compiler each.
+ *
+ * Example:
+ *   ThreadPool pool(4);
+ *   std::vector<Compiler> compilers(pool.size());
+ *   for (size_t i = 0; i < sources.size(); ++i) {
+ *       pool.submit([&, i](size_t worker) { results[i] = compilers[worker].compile(sources[i]); });
+ *   }
+ *   pool.wait();
+ */
+class ThreadPool {
+  public:
+    using Task = std::function<void(size_t worker)>;
+
+    /**
+     * @param threads Number of workers, 0 for one per hardware thread
+     */
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(Task task);
+
+    /**
+     * Block until every task submitted so far has finished
+     */
+    void wait();
+
+    size_t size() const { return queues_.size(); }
+
+    /**
+     * Number of hardware threads, at least 1
+     */
+    static size_t hardware_threads();
+
+  private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    size_t next_queue_ = 0; // Round-robin position of submit
+
+    std::mutex mutex_; // Guards the waits below
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    std::atomic<size_t> queued_{0};  // Submitted, not yet taken by a worker
+    std::atomic<size_t> pending_{0}; // Submitted, not yet finished
+    bool stopping_ = false;
+
+    void run_worker(size_t worker);
+    bool take(size_t worker, Task &task);
+};
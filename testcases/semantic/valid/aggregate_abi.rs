@@ -0,0 +1,157 @@
+// Aggregates passed and returned by value on both sides of the limit for
+// passing them as scalars: 16 bytes and 4 leaves are flattened, 5 leaves
+// or more than 16 bytes go through memory. A callee that changes its copy
+// must not change the caller's value.
+// Prints 5 505 30, 10 101 210, 75 758, 42, 3412, 4321 110, then 42.
+struct Quad {
+    a: i32,
+    b: i32,
+    c: i32,
+    d: i32,
+}
+
+struct Five {
+    a: i32,
+    b: i32,
+    c: i32,
+    d: i32,
+    flag: bool,
+}
+
+struct SmallFive {
+    a: i32,
+    b: i32,
+    x: bool,
+    y: bool,
+    z: bool,
+}
+
+struct Mixed {
+    on: bool,
+    n: i32,
+    off: bool,
+}
+
+struct Pair {
+    x: i32,
+    y: i32,
+}
+
+struct Nested {
+    pair: Pair,
+    rest: [i32; 2],
+}
+
+struct Wrap {
+    value: i32,
+}
+
+impl Quad {
+    fn sum(self) -> i32 {
+        self.a + self.b + self.c + self.d
+    }
+
+    fn rotate(self) -> Quad {
+        Quad { a: self.b, b: self.c, c: self.d, d: self.a }
+    }
+}
+
+impl Five {
+    fn sum(self) -> i32 {
+        if (self.flag) {
+            self.a + self.b + self.c + self.d
+        } else {
+            0
+        }
+    }
+}
+
+fn bump_quad(mut q: Quad) -> Quad {
+    q.a += 100;
+    q.d += 400;
+    q
+}
+
+fn bump_five(mut f: Five) -> Five {
+    f.a += 100;
+    f.flag = !f.flag;
+    f
+}
+
+fn count_small(s: SmallFive) -> SmallFive {
+    let mut flags: i32 = 0;
+    if (s.x) {
+        flags += 1;
+    }
+    if (s.y) {
+        flags += 2;
+    }
+    if (s.z) {
+        flags += 4;
+    }
+    SmallFive { a: s.a * 10 + flags, b: s.b, x: !s.x, y: s.y, z: !s.z }
+}
+
+fn toggle(m: Mixed) -> Mixed {
+    Mixed { on: !m.on, n: m.n + 1, off: !m.off }
+}
+
+fn swap_nested(n: Nested) -> Nested {
+    Nested { pair: Pair { x: n.rest[0], y: n.rest[1] }, rest: [n.pair.x, n.pair.y] }
+}
+
+fn four(values: [i32; 4]) -> [i32; 4] {
+    [values[3], values[2], values[1], values[0]]
+}
+
+fn five(mut values: [i32; 5]) -> [i32; 5] {
+    values[0] = values[4] * 2;
+    values
+}
+
+fn wrap(value: i32) -> Wrap {
+    Wrap { value: value * 3 }
+}
+
+fn main() {
+    // 16 bytes, 4 leaves: scalars
+    let q: Quad = Quad { a: 1, b: 2, c: 3, d: 4 };
+    let bumped: Quad = bump_quad(q);
+    printlnInt(q.a + q.d);
+    printlnInt(bumped.a + bumped.d);
+    printlnInt(q.rotate().a * 10 + q.sum());
+
+    // 17 bytes of fields (20 with padding), 5 leaves: memory
+    let f: Five = Five { a: 1, b: 2, c: 3, d: 4, flag: true };
+    let g: Five = bump_five(f);
+    printlnInt(f.sum());
+    printlnInt(g.a + g.sum());
+    printlnInt(bump_five(g).sum());
+
+    // 11 bytes of fields but 5 leaves: memory
+    let s: SmallFive = SmallFive { a: 7, b: 8, x: true, y: false, z: true };
+    let t: SmallFive = count_small(s);
+    printlnInt(t.a);
+    printlnInt(count_small(t).a + t.b);
+
+    // Fields reordered by the data layout, 3 leaves
+    let m: Mixed = toggle(Mixed { on: true, n: 41, off: false });
+    if (!m.on && m.off) {
+        printlnInt(m.n);
+    }
+
+    // Nested aggregates with 4 leaves in 16 bytes
+    let n: Nested = swap_nested(Nested { pair: Pair { x: 1, y: 2 }, rest: [3, 4] });
+    printlnInt(n.pair.x * 1000 + n.pair.y * 100 + n.rest[0] * 10 + n.rest[1]);
+
+    // Arrays of 4 and 5 elements
+    let r: [i32; 4] = four([1, 2, 3, 4]);
+    printlnInt(r[0] * 1000 + r[1] * 100 + r[2] * 10 + r[3]);
+    let original: [i32; 5] = [1, 2, 3, 4, 5];
+    let changed: [i32; 5] = five(original);
+    printlnInt(original[0] * 100 + changed[0]);
+
+    // A single leaf is returned directly
+    printlnInt(wrap(14).value);
+    exit(0);
+}
@@ -0,0 +1,77 @@
+// Reads from constant lookup tables, which live in constant globals: an
+// immutable binding reads the global directly, a mutable one gets a copy
+// that can be written without changing the table seen elsewhere.
+// Prints 77 21, 7 170 7 170 7, then 59 198 91.
+struct Point {
+    x: i32,
+    y: i32,
+}
+
+const WEIGHTS: [i32; 5] = [3, 1, 4, 1, 5];
+
+fn prime(i: usize) -> i32 {
+    let primes: [i32; 8] = [2, 3, 5, 7, 11, 13, 17, 19];
+    primes[i]
+}
+
+fn sum_table(table: &[i32; 8]) -> i32 {
+    let mut sum: i32 = 0;
+    let mut i: usize = 0;
+    while (i < 8) {
+        sum += table[i];
+        i += 1;
+    }
+    sum
+}
+
+fn main() {
+    // The same literal in another function, read through a reference
+    let primes: [i32; 8] = [2, 3, 5, 7, 11, 13, 17, 19];
+    printlnInt(sum_table(&primes));
+    printlnInt(prime(0) + prime(7));
+
+    // A mutable copy is written; the next copy and the other function
+    // still see the table's values
+    let mut round: i32 = 0;
+    while (round < 2) {
+        let mut table: [i32; 8] = [2, 3, 5, 7, 11, 13, 17, 19];
+        printlnInt(table[3]);
+        table[3] = 100;
+        printlnInt(sum_table(&table));
+        round += 1;
+    }
+    printlnInt(prime(3));
+
+    // Nested tables and tables of structs, indexed with computed indices
+    let grid: [[i32; 3]; 3] = [[1, 2, 3], [4, 5, 6], [7, 8, 9]];
+    let corners: [Point; 4] = [
+        Point { x: 0, y: 0 },
+        Point { x: 9, y: 0 },
+        Point { x: 0, y: 9 },
+        Point { x: 9, y: 9 },
+    ];
+    let mut diagonal: i32 = 0;
+    let mut edges: i32 = 0;
+    let mut i: usize = 0;
+    while (i < 3) {
+        diagonal += grid[i][i] * grid[2 - i][i];
+        i += 1;
+    }
+    i = 0;
+    while (i < 4) {
+        edges += corners[i].x * 10 + corners[(i + 1) % 4].y;
+        i += 1;
+    }
+    printlnInt(diagonal);
+    printlnInt(edges);
+
+    // A const item used as a table
+    let mut weighted: i32 = 0;
+    i = 0;
+    while (i < 5) {
+        weighted += WEIGHTS[i] * prime(i);
+        i += 1;
+    }
+    printlnInt(weighted);
+    exit(0);
+}
@@ -0,0 +1,29 @@
+// The entry value of a counted while loop must account for writes made
+// by earlier loops. Prints 307, 10, then 5 6 7.
+fn main() {
+    let mut i: i32 = 0;
+    let mut s: i32 = 0;
+    while (i < 3) {
+        s = s + 100;
+        i += 1;
+    }
+    while (i < 10) {
+        s = s + 1;
+        i += 1;
+    }
+    printlnInt(s);
+    printlnInt(i);
+
+    let mut j: i32 = 0;
+    loop {
+        j += 1;
+        if (j == 5) {
+            break;
+        }
+    }
+    while (j < 8) {
+        printlnInt(j);
+        j += 1;
+    }
+    exit(0);
+}
@@ -0,0 +1,85 @@
+// By-value aggregate parameters that the caller also passes by &mut, as a
+// whole or through a part or an enclosing value. The callee writes through
+// the reference and then reads its parameter, which must still hold the
+// value from the time of the call.
+// Prints 7 700, 3 77, 70 0, 7 8, 39 55, then 1005 1000.
+struct Big {
+    v: [i32; 6],
+}
+
+struct Outer {
+    big: Big,
+    tag: i32,
+}
+
+impl Big {
+    fn absorb(&mut self, other: Big) -> i32 {
+        self.v[0] = 1000;
+        other.v[0] + self.v[0]
+    }
+}
+
+fn clear(target: &mut Big) {
+    target.v = [0; 6];
+}
+
+// The same array, by value and by &mut
+fn overwrite_then_read(values: [i32; 6], target: &mut [i32; 6]) -> i32 {
+    target[0] = 100;
+    target[5] = 600;
+    values[0] + values[5]
+}
+
+// One element of the array through &mut
+fn poke_then_read(values: [i32; 6], slot: &mut i32) -> i32 {
+    *slot = 77;
+    values[2]
+}
+
+// The reference is written by another function
+fn clear_then_read(b: Big, target: &mut Big) -> i32 {
+    clear(target);
+    b.v[1] + b.v[4]
+}
+
+// The parameter is part of the value behind the reference
+fn retag_then_read(inner: Big, outer: &mut Outer) -> i32 {
+    outer.big.v[3] = -1;
+    outer.tag = 9;
+    inner.v[3]
+}
+
+// The reference is part of the parameter
+fn inner_then_read(outer: Outer, inner: &mut Big) -> i32 {
+    inner.v[5] = 55;
+    outer.big.v[5] * 10 + outer.tag
+}
+
+// Only read, so it may use the caller's storage in place
+fn read_only(b: Big) -> i32 {
+    b.v[0] + b.v[1] + b.v[2] + b.v[3] + b.v[4] + b.v[5]
+}
+
+fn main() {
+    let mut values: [i32; 6] = [1, 2, 3, 4, 5, 6];
+    printlnInt(overwrite_then_read(values, &mut values));
+    printlnInt(values[0] + values[5]);
+
+    printlnInt(poke_then_read(values, &mut values[2]));
+    printlnInt(values[2]);
+
+    let mut b: Big = Big { v: [10, 20, 30, 40, 50, 60] };
+    printlnInt(clear_then_read(b, &mut b));
+    printlnInt(read_only(b));
+
+    let mut o: Outer = Outer { big: Big { v: [1, 1, 1, 7, 1, 3] }, tag: 2 };
+    printlnInt(retag_then_read(o.big, &mut o));
+    printlnInt(o.big.v[3] + o.tag);
+    printlnInt(inner_then_read(o, &mut o.big));
+    printlnInt(o.big.v[5]);
+
+    let mut c: Big = Big { v: [5, 0, 0, 0, 0, 0] };
+    printlnInt(c.absorb(c));
+    printlnInt(read_only(c));
+    exit(0);
+}
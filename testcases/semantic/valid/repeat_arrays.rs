@@ -0,0 +1,69 @@
+// Repeat arrays [x; N] with zero, non-zero scalar and aggregate elements,
+// nested, of odd lengths, and rebuilt on every loop iteration.
+// Prints 1 2 3, 112 -6 1, 6 12 45 9, 22 21, then 306.
+struct Pair {
+    a: i32,
+    b: i32,
+}
+
+fn make_row(base: i32) -> [i32; 3] {
+    [base, base + 1, base + 2]
+}
+
+fn main() {
+    // Zero elements, nested zeros and zero structs
+    let mut zeros: [i32; 37] = [0; 37];
+    let mut grid: [[i32; 5]; 7] = [[0; 5]; 7];
+    let mut empty: [Pair; 6] = [Pair { a: 0, b: 0 }; 6];
+    zeros[36] += 1;
+    grid[6][4] += 2;
+    empty[5].b += 3;
+    printlnInt(zeros[0] + zeros[35] + zeros[36]);
+    printlnInt(grid[0][0] + grid[6][3] + grid[6][4]);
+    printlnInt(empty[0].a + empty[4].b + empty[5].b);
+
+    // Non-zero scalars below and above the unrolling limit
+    let small: [i32; 16] = [7; 16];
+    let large: [i32; 17] = [-3; 17];
+    let flags: [bool; 9] = [true; 9];
+    let mut sum: i32 = 0;
+    let mut i: usize = 0;
+    while (i < 16) {
+        sum += small[i];
+        i += 1;
+    }
+    printlnInt(sum);
+    printlnInt(large[0] + large[16]);
+    if (flags[0] && flags[8]) {
+        printlnInt(1);
+    }
+
+    // Aggregate elements: built once, then copied in doubling steps
+    let rows: [[i32; 4]; 5] = [[3; 4]; 5];
+    let pairs: [Pair; 7] = [Pair { a: 1, b: 2 }; 7];
+    let nested: [[Pair; 3]; 5] = [[Pair { a: 4, b: 5 }; 3]; 5];
+    let single: [[i32; 2]; 1] = [[9; 2]; 1];
+    printlnInt(rows[0][0] + rows[4][3]);
+    printlnInt(pairs[6].a * 10 + pairs[6].b);
+    printlnInt(nested[4][2].a * 10 + nested[4][2].b);
+    printlnInt(single[0][1]);
+
+    // Elements that are variables or call results
+    let row: [i32; 3] = make_row(10);
+    let copies: [[i32; 3]; 6] = [row; 6];
+    let calls: [[i32; 3]; 3] = [make_row(20); 3];
+    printlnInt(copies[5][0] + copies[5][2]);
+    printlnInt(calls[2][1]);
+
+    // Rebuilt each iteration, so earlier writes do not survive
+    let mut round: i32 = 0;
+    let mut total: i32 = 0;
+    while (round < 3) {
+        let mut fresh: [[i32; 2]; 3] = [[round; 2]; 3];
+        fresh[2][1] += 100;
+        total += fresh[0][0] + fresh[2][1];
+        round += 1;
+    }
+    printlnInt(total);
+    exit(0);
+}
@@ -0,0 +1,80 @@
+// Aggregate stack slots are shared by values whose scopes do not overlap.
+// Values that are still live must keep their own slot: block results,
+// temporaries of one statement, outer arrays updated inside loops, and
+// arrays of enclosing scopes.
+// Prints 13 8, 100 50, 402 333, 60, 2014, then 94.
+struct Vec2 {
+    x: i32,
+    y: i32,
+}
+
+fn make(base: i32) -> [i32; 4] {
+    [base, base * 2, base * 3, base * 4]
+}
+
+fn vec2(x: i32, y: i32) -> Vec2 {
+    Vec2 { x: x, y: y }
+}
+
+fn add(a: Vec2, b: Vec2) -> Vec2 {
+    Vec2 { x: a.x + b.x, y: a.y + b.y }
+}
+
+fn total(values: &[i32; 4]) -> i32 {
+    values[0] + values[1] + values[2] + values[3]
+}
+
+fn main() {
+    // Sibling blocks share a slot; each starts from its own initializer
+    {
+        let mut a: [i32; 4] = [1; 4];
+        a[3] = 10;
+        printlnInt(total(&a));
+    }
+    {
+        let b: [i32; 4] = [2; 4];
+        printlnInt(total(&b));
+    }
+
+    // The value of a block outlives the block
+    let kept: [i32; 4] = {
+        let t: [i32; 4] = make(5);
+        t
+    };
+    {
+        let other: [i32; 4] = make(100);
+        printlnInt(other[0]);
+    }
+    printlnInt(total(&kept));
+
+    // Two temporaries of the same type in one statement
+    printlnInt(make(1)[3] * 100 + make(2)[0]);
+    let sum: Vec2 = add(vec2(1, 2), add(vec2(10, 20), vec2(100, 200)));
+    printlnInt(sum.x + sum.y);
+
+    // An outer array updated in a loop whose body allocates the same type
+    let mut acc: [i32; 4] = [0; 4];
+    let mut i: i32 = 0;
+    while (i < 4) {
+        let row: [i32; 4] = make(i);
+        let mut j: usize = 0;
+        while (j < 4) {
+            acc[j] += row[j];
+            j += 1;
+        }
+        i += 1;
+    }
+    printlnInt(total(&acc));
+
+    // An enclosing scope's array stays live while an inner scope allocates
+    let outer: [i32; 4] = make(7);
+    if (outer[0] == 7) {
+        let inner: [i32; 4] = make(1000);
+        printlnInt(inner[1] + outer[1]);
+    } else {
+        let inner: [i32; 4] = make(2000);
+        printlnInt(inner[1]);
+    }
+    printlnInt(total(&outer) + acc[3]);
+    exit(0);
+}
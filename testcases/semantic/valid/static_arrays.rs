@@ -0,0 +1,74 @@
+// Large local arrays that move to static storage: in main, passed by
+// &mut to callees, re-initialized in loops and in every call, shadowed,
+// and in a recursive function, where they must stay on the stack.
+// Prints 4669 12, 668 1334 2000, 3999, then 17031 17061 6.
+fn fill(values: &mut [i32; 2000], start: usize, step: i32) {
+    let mut i: usize = start;
+    while (i < 2000) {
+        values[i] += step;
+        i += 3;
+    }
+}
+
+fn sum(values: &[i32; 2000]) -> i32 {
+    let mut total: i32 = 0;
+    let mut i: usize = 0;
+    while (i < 2000) {
+        total += values[i];
+        i += 1;
+    }
+    total
+}
+
+// 68 KB: static in a non-recursive function, initialized on every call
+fn scratch_sum(seed: i32) -> i32 {
+    let mut buffer: [i32; 17000] = [1; 17000];
+    buffer[16999] += seed;
+    buffer[0] = buffer[16999] * 2;
+    let mut total: i32 = 0;
+    let mut i: usize = 0;
+    while (i < 17000) {
+        total += buffer[i];
+        i += 1;
+    }
+    total
+}
+
+// Recursive, so each active call needs its own array
+fn depth_sum(depth: i32) -> i32 {
+    let mut frame: [i32; 17000] = [0; 17000];
+    frame[100] = depth;
+    if (depth > 0) {
+        frame[100] += depth_sum(depth - 1);
+    }
+    frame[100]
+}
+
+fn main() {
+    // Zero-initialized once, written by a callee through &mut
+    let mut big: [i32; 2000] = [0; 2000];
+    fill(&mut big, 0, 2);
+    fill(&mut big, 1, 5);
+    printlnInt(sum(&big));
+    printlnInt(big[0] + big[1] + big[2] + big[1999]);
+
+    // Re-initialized on every iteration, even though it is static
+    let mut round: i32 = 0;
+    while (round < 3) {
+        let mut work: [i32; 2000] = [0; 2000];
+        fill(&mut work, 2, round + 1);
+        work[1998] += big[1998];
+        printlnInt(sum(&work));
+        round += 1;
+    }
+
+    // Non-zero initializer, and a shadowed array of the same name
+    let mut big: [i32; 2000] = [3; 2000];
+    fill(&mut big, 0, -3);
+    printlnInt(sum(&big));
+
+    printlnInt(scratch_sum(10));
+    printlnInt(scratch_sum(20));
+    printlnInt(depth_sum(3));
+    exit(0);
+}
@@ -0,0 +1,56 @@
+// Vectorized loops whose trip count is not a multiple of the vector width
+// must finish the last iterations in the scalar loop.
+// Prints -5 4 35 260 275 305, then 0 7 15 11 31 0 201 195, then 8037.
+fn main() {
+    let mut a: [i32; 23] = [0; 23];
+    let mut b: [i32; 23] = [0; 23];
+    let k: i32 = 5;
+
+    // 23 iterations: 16 in the <8 x i32> loop, 7 left
+    let mut i: i32 = 0;
+    while (i < 23) {
+        a[i as usize] = i * 3 - k;
+        i += 1;
+    }
+    // 7 iterations from 2 to 8 inclusive: 4 in the <4 x i32> loop, 3 left
+    i = 2;
+    while (i <= 8) {
+        b[i as usize] = a[i as usize] ^ (i | 4);
+        i += 1;
+    }
+    // 3 iterations: too few for a vector loop
+    i = 20;
+    while (i < 23) {
+        b[i as usize] += -a[i as usize] & 255;
+        i += 1;
+    }
+    // 19 iterations from 4: 16 in the <8 x i32> loop, 3 left
+    i = 4;
+    while (i < 23) {
+        a[i as usize] *= k;
+        i += 1;
+    }
+
+    printlnInt(a[0]);
+    printlnInt(a[3]);
+    printlnInt(a[4]);
+    printlnInt(a[19]);
+    printlnInt(a[20]);
+    printlnInt(a[22]);
+    printlnInt(b[1]);
+    printlnInt(b[2]);
+    printlnInt(b[5]);
+    printlnInt(b[6]);
+    printlnInt(b[8]);
+    printlnInt(b[9]);
+    printlnInt(b[20]);
+    printlnInt(b[22]);
+    let mut sum: i32 = 0;
+    let mut j: usize = 0;
+    while (j < 23) {
+        sum = sum + a[j] + b[j] * 7;
+        j += 1;
+    }
+    printlnInt(sum);
+    exit(0);
+}